@@ -0,0 +1,557 @@
+#include <getopt.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "../client/client.hpp"
+#include "../client/coroutine.hpp"
+#include "../common/histogram.hpp"
+#include "../kernel_module/calc_ops.h"
+#include "../server/bulk_engine.hpp"
+#include "../server/operations.hpp"
+#include "../server/result_cache.hpp"
+#include "../server/server.hpp"
+#include "../transport/inproc_transport.hpp"
+#include "../transport/socketpair_transport.hpp"
+
+/*
+ * Нагрузочный тест клиента, сервера и ретранслятора.
+ *
+ * Режим load: несколько клиентов (--concurrency), у каждого до --depth запросов в полете,
+ * в течение --duration секунд отправляют операции в пропорциях --mix. Транспорт genl требует
+ * загруженного модуля и запущенного ./server; транспорты inproc и socketpair поднимают
+ * отдельный сервер на каждого клиента в этом же процессе. С --api coroutine каждый клиент
+ * запускает --depth корутин, запросы которых планировщик отправляет пачками. С --shm операции
+ * после согласования идут через канал в общей памяти (если сервер его не принял - через транспорт).
+ *
+ * Режим micro: стоимость разбора и вычисления на сервере без транспорта, а также вычисления
+ * над массивами каждой реализацией BulkEngine, поддерживаемой процессором (нс на элемент), и поиск
+ * действия по имени совершенной хеш-функцией и цепочкой сравнений для 3 и 50 действий, и ответ
+ * из кэша (ResultCache) вместо разбора и сериализации, и вычисление ретранслятором в режиме offload
+ * (kernel_module/calc_ops.h).
+ *
+ * Для транспорта genl в результат записывается параметр модуля offload: задержки load с offload=0
+ * и offload=1 показывают, сколько стоит переход к серверу и обратно.
+ *
+ * Результат печатается одной строкой JSON.
+ */
+
+namespace bench {
+
+class ServerBench_Friend {
+   public:
+    static nlohmann::json process_request(netlink::server::Server &server, std::string const &request) { return server.process_request(request); }
+    static netlink::server::BinaryResult process_binary(netlink::server::Server &server, struct nlattr **attrs) { return server.process_binary(attrs); }
+};
+
+} // namespace bench
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using netlink::client::OP;
+
+struct Options {
+    std::string mode = "load";
+    std::string transport = "inproc";
+    std::string protocol = "binary";
+    std::string api = "callback";
+    bool shm = false;
+    std::array<unsigned, 3> mix = {1, 1, 1}; // add, sub, mul
+    std::size_t payload_size = 0;
+    std::size_t concurrency = 1;
+    std::size_t depth = 32;
+    double duration = 5.0;
+    double warmup = 1.0;
+    std::size_t iterations = 1000000;
+};
+
+/**
+ * @brief Результат одного клиента нагрузочного теста.
+ */
+struct Worker {
+    netlink::common::Histogram latency;
+    uint64_t errors = 0;
+    uint64_t busy = 0; // отклонены ретранслятором с EBUSY (входят в errors)
+};
+
+void usage(const char *name) {
+    fprintf(stderr,
+            "Usage: %s [--mode load|micro] [--transport genl|inproc|socketpair] [--protocol binary|json] [--api callback|coroutine] [--shm]\n"
+            "          [--mix add=1,sub=1,mul=1] [--payload-size bytes] [--concurrency clients] [--depth requests]\n"
+            "          [--duration seconds] [--warmup seconds] [--iterations count]\n",
+            name);
+}
+
+bool parse_mix(std::string const &text, std::array<unsigned, 3> &mix) {
+    mix = {0, 0, 0};
+    std::size_t pos = 0;
+    while (pos < text.size()) {
+        std::size_t end = text.find(',', pos);
+        std::string const item = text.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        std::size_t eq = item.find('=');
+        if (eq == std::string::npos) {
+            return false;
+        }
+        std::string const name = item.substr(0, eq);
+        unsigned const weight = static_cast<unsigned>(std::strtoul(item.c_str() + eq + 1, nullptr, 10));
+        if (name == "add") {
+            mix[0] = weight;
+        } else if (name == "sub") {
+            mix[1] = weight;
+        } else if (name == "mul") {
+            mix[2] = weight;
+        } else {
+            return false;
+        }
+        pos = end == std::string::npos ? text.size() : end + 1;
+    }
+    return mix[0] + mix[1] + mix[2] > 0;
+}
+
+bool parse_options(int argc, char *argv[], Options &options) {
+    static const struct option long_options[] = {
+        {"mode", required_argument, nullptr, 'm'},         {"transport", required_argument, nullptr, 't'},
+        {"protocol", required_argument, nullptr, 'p'},     {"api", required_argument, nullptr, 'a'},
+        {"mix", required_argument, nullptr, 'x'},          {"payload-size", required_argument, nullptr, 's'},
+        {"concurrency", required_argument, nullptr, 'c'},  {"depth", required_argument, nullptr, 'd'},
+        {"duration", required_argument, nullptr, 'D'},     {"warmup", required_argument, nullptr, 'w'},
+        {"iterations", required_argument, nullptr, 'n'},   {"shm", no_argument, nullptr, 'S'},
+        {nullptr, 0, nullptr, 0},
+    };
+
+    int opt = 0;
+    while ((opt = getopt_long(argc, argv, "", long_options, nullptr)) != -1) {
+        switch (opt) {
+            case 'm':
+                options.mode = optarg;
+                break;
+            case 't':
+                options.transport = optarg;
+                break;
+            case 'p':
+                options.protocol = optarg;
+                break;
+            case 'a':
+                options.api = optarg;
+                break;
+            case 'S':
+                options.shm = true;
+                break;
+            case 'x':
+                if (!parse_mix(optarg, options.mix)) {
+                    return false;
+                }
+                break;
+            case 's':
+                options.payload_size = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'c':
+                options.concurrency = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'd':
+                options.depth = std::strtoull(optarg, nullptr, 10);
+                break;
+            case 'D':
+                options.duration = std::strtod(optarg, nullptr);
+                break;
+            case 'w':
+                options.warmup = std::strtod(optarg, nullptr);
+                break;
+            case 'n':
+                options.iterations = std::strtoull(optarg, nullptr, 10);
+                break;
+            default:
+                return false;
+        }
+    }
+
+    return (options.mode == "load" || options.mode == "micro") &&
+           (options.transport == "genl" || options.transport == "inproc" || options.transport == "socketpair") &&
+           (options.protocol == "binary" || options.protocol == "json") && (options.api == "callback" || options.api == "coroutine") &&
+           (options.api == "callback" || options.protocol == "binary") && (!options.shm || options.protocol == "binary") && options.concurrency > 0 && options.depth > 0 && options.duration > 0 &&
+           options.warmup >= 0 && options.iterations > 0;
+}
+
+/**
+ * @brief Выбирает операцию по весам смеси (xorshift, чтобы генератор не влиял на измерение).
+ */
+OP next_op(uint64_t &state, std::array<unsigned, 3> const &mix) {
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    unsigned point = static_cast<unsigned>(state % (mix[0] + mix[1] + mix[2]));
+    if (point < mix[0]) {
+        return OP::OP_ADD;
+    }
+    return point < mix[0] + mix[1] ? OP::OP_SUB : OP::OP_MUL;
+}
+
+const char *action_name(OP op) {
+    switch (op) {
+        case OP::OP_ADD:
+            return "add";
+        case OP::OP_SUB:
+            return "sub";
+        default:
+            return "mul";
+    }
+}
+
+/**
+ * @brief JSON-запросы для каждой операции, дополненные полем pad до payload_size байт.
+ */
+std::array<nlohmann::json, 3> make_requests(std::size_t payload_size) {
+    std::array<nlohmann::json, 3> requests;
+    for (int i = 0; i < 3; ++i) {
+        auto op = static_cast<OP>(i + 1);
+        nlohmann::json request = {{"action", action_name(op)}, {"arg1", 1234}, {"arg2", 5678}};
+        std::size_t const size = request.dump().size();
+        // Поле "pad" добавляет 9 байт разметки: ,"pad":""
+        if (payload_size > size + 9) {
+            request["pad"] = std::string(payload_size - size - 9, 'x');
+        }
+        requests[i] = request;
+    }
+    return requests;
+}
+
+/**
+ * @brief Одна корутина нагрузочного клиента: отправляет операции по очереди до срока.
+ */
+netlink::client::Task<void> run_coroutine(netlink::client::Scheduler &scheduler, Options const &options, Clock::time_point measure_start,
+                                          Clock::time_point deadline, Worker &worker, uint64_t state) {
+    while (true) {
+        Clock::time_point const start = Clock::now();
+        if (start >= deadline) {
+            break;
+        }
+        netlink::client::Response const response = co_await scheduler.calc(next_op(state, options.mix), 1234, 5678);
+        if (start < measure_start) {
+            continue;
+        }
+        worker.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+        if (response.error != 0) {
+            ++worker.errors;
+            worker.busy += response.error == EBUSY;
+        }
+    }
+}
+
+void run_client(Options const &options, std::unique_ptr<netlink::transport::Transport> transport, Clock::time_point measure_start,
+                Clock::time_point deadline, Worker &worker) {
+    std::unique_ptr<netlink::client::Client> client = transport ? std::make_unique<netlink::client::Client>(std::move(transport), options.depth)
+                                                                : std::make_unique<netlink::client::Client>(options.depth);
+    if (options.shm && !client->enable_shm(options.depth)) {
+        fprintf(stderr, "Shared memory channel was not accepted, using the transport\n");
+    }
+    if (options.api == "coroutine") {
+        netlink::client::Scheduler scheduler(*client);
+        for (std::size_t i = 0; i < options.depth; ++i) {
+            scheduler.spawn(run_coroutine(scheduler, options, measure_start, deadline, worker, (reinterpret_cast<uintptr_t>(&worker) + i) | 1));
+        }
+        scheduler.run();
+        return;
+    }
+
+    auto const requests = make_requests(options.payload_size);
+    uint64_t state = reinterpret_cast<uintptr_t>(&worker) | 1;
+
+    while (true) {
+        Clock::time_point const start = Clock::now();
+        if (start >= deadline) {
+            break;
+        }
+        OP const op = next_op(state, options.mix);
+        auto on_response = [&worker, start, measure_start](netlink::client::Response const &response) {
+            if (start < measure_start) {
+                return;
+            }
+            worker.latency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+            if (response.error != 0) {
+                ++worker.errors;
+                worker.busy += response.error == EBUSY;
+            }
+        };
+
+        // calc_async и send_request_async сами обрабатывают ответы, когда в полете depth запросов
+        if (options.protocol == "binary") {
+            client->calc_async(op, 1234, 5678, on_response);
+        } else {
+            client->send_request_async(requests[static_cast<int>(op) - 1], on_response);
+        }
+    }
+    client->wait_for_response();
+}
+
+/**
+ * @brief Параметр offload загруженного модуля (null, если модуль не загружен).
+ */
+nlohmann::json module_offload() {
+    std::unique_ptr<FILE, int (*)(FILE *)> file(std::fopen("/sys/module/calc_module/parameters/offload", "r"), std::fclose);
+    if (!file) {
+        return nullptr;
+    }
+    return std::fgetc(file.get()) == 'Y';
+}
+
+nlohmann::json run_load(Options const &options) {
+    std::vector<Worker> workers(options.concurrency);
+    std::vector<std::unique_ptr<netlink::transport::Transport>> client_transports(options.concurrency);
+    std::vector<std::unique_ptr<netlink::server::Server>> servers;
+
+    // Для внутрипроцессных транспортов у каждого клиента свой сервер
+    if (options.transport != "genl") {
+        for (auto &client_transport : client_transports) {
+            if (options.transport == "inproc") {
+                auto [client, server] = netlink::transport::InProcessTransport::create_pair();
+                client_transport = std::move(client);
+                servers.push_back(std::make_unique<netlink::server::Server>(std::move(server)));
+            } else {
+                auto [client, server] = netlink::transport::SocketpairTransport::create_pair();
+                client_transport = std::move(client);
+                servers.push_back(std::make_unique<netlink::server::Server>(std::move(server)));
+            }
+        }
+    }
+    // Журнал на каждый запрос измерял бы журнал, а не путь запроса
+    netlink::common::Logger::set_level(LOG_WARNING);
+
+    std::vector<std::thread> server_threads;
+    for (auto &server : servers) {
+        server_threads.emplace_back([server = server.get()]() { server->wait_for_response(); });
+    }
+
+    Clock::time_point const start = Clock::now();
+    Clock::time_point const measure_start = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmup));
+    Clock::time_point const deadline = measure_start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.duration));
+
+    std::vector<std::thread> client_threads;
+    std::atomic<std::size_t> failed_clients = 0;
+    for (std::size_t i = 0; i < options.concurrency; ++i) {
+        client_threads.emplace_back([&, i]() {
+            try {
+                run_client(options, std::move(client_transports[i]), measure_start, deadline, workers[i]);
+            } catch (std::exception &ex) {
+                fprintf(stderr, "Client %zu failed: %s\n", i, ex.what());
+                ++failed_clients;
+            }
+        });
+    }
+    for (auto &thread : client_threads) {
+        thread.join();
+    }
+    // Клиенты закрыли транспорты, серверы выходят из цикла приема
+    for (auto &thread : server_threads) {
+        thread.join();
+    }
+
+    netlink::common::Histogram latency;
+    uint64_t errors = 0;
+    uint64_t busy = 0;
+    for (auto const &worker : workers) {
+        latency.merge(worker.latency);
+        errors += worker.errors;
+        busy += worker.busy;
+    }
+    double const elapsed = std::chrono::duration<double>(Clock::now() - measure_start).count();
+
+    return {
+        {"mode", "load"},
+        {"transport", options.transport},
+        {"protocol", options.protocol},
+        {"api", options.api},
+        {"shm", options.shm},
+        {"offload", options.transport == "genl" ? module_offload() : nlohmann::json(nullptr)},
+        {"mix", {{"add", options.mix[0]}, {"sub", options.mix[1]}, {"mul", options.mix[2]}}},
+        {"payload_size", options.payload_size},
+        {"concurrency", options.concurrency},
+        {"depth", options.depth},
+        {"duration_s", elapsed},
+        {"failed_clients", failed_clients.load()},
+        {"requests", latency.count()},
+        {"errors", errors},
+        {"busy", busy},
+        {"throughput_ops", elapsed > 0 ? static_cast<double>(latency.count()) / elapsed : 0.0},
+        {"latency_ns",
+         {{"min", latency.min()},
+          {"mean", latency.mean()},
+          {"p50", latency.percentile(50)},
+          {"p99", latency.percentile(99)},
+          {"p999", latency.percentile(99.9)},
+          {"max", latency.max()}}},
+    };
+}
+
+template <typename F>
+double measure(F operation, std::size_t iterations) {
+    // Прогрев
+    for (std::size_t i = 0; i < iterations / 10 + 1; ++i) {
+        operation(i);
+    }
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        operation(i);
+    }
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(iterations);
+}
+
+// Имена действий для измерения поиска: первые три - действия калькулятора
+constexpr std::array<std::string_view, 50> M_ACTION_NAMES = {
+    "add", "sub", "mul", "div", "mod", "pow", "min", "max", "abs", "neg",
+    "and", "or", "xor", "not", "shl", "shr", "rol", "ror", "gcd", "lcm",
+    "sqrt", "cbrt", "exp", "log", "log2", "log10", "sin", "cos", "tan", "asin",
+    "acos", "atan", "sinh", "cosh", "tanh", "floor", "ceil", "round", "trunc", "sign",
+    "clamp", "avg", "median", "sum", "prod", "inc", "dec", "cmp", "hypot", "fma",
+};
+
+/**
+ * @brief Время поиска действия среди N имен (нс): совершенная хеш-функция и цепочка сравнений строк.
+ */
+template <std::size_t N>
+nlohmann::json measure_dispatch(std::size_t iterations, volatile int64_t &sink) {
+    static constexpr auto M_NAMES = [] {
+        std::array<std::string_view, N> names{};
+        std::copy_n(M_ACTION_NAMES.begin(), N, names.begin());
+        return names;
+    }();
+    static constexpr netlink::server::PerfectHash<N> M_HASH{M_NAMES};
+    // Имена запросов - отдельные строки, как действие из разобранного запроса
+    std::vector<std::string> const queries(M_NAMES.begin(), M_NAMES.end());
+
+    double const hash_ns = measure([&](std::size_t i) { sink = sink + M_HASH.find(queries[i % N]); }, iterations);
+    double const chain_ns = measure(
+        [&](std::size_t i) {
+            std::string_view const action = queries[i % N];
+            int index = netlink::server::PerfectHash<N>::M_NOT_FOUND;
+            for (std::size_t k = 0; k < N; ++k) {
+                if (action == M_NAMES[k]) {
+                    index = static_cast<int>(k);
+                    break;
+                }
+            }
+            sink = sink + index;
+        },
+        iterations);
+    return {{"perfect_hash", hash_ns}, {"if_chain", chain_ns}};
+}
+
+nlohmann::json run_micro(Options const &options) {
+    auto [client, server_transport] = netlink::transport::InProcessTransport::create_pair();
+    netlink::server::Server server(std::move(server_transport));
+    netlink::common::Logger::set_level(LOG_WARNING);
+
+    std::string const request = make_requests(options.payload_size)[0].dump();
+    volatile int64_t sink = 0;
+
+    double const process_request_ns = measure(
+        [&](std::size_t) { sink = sink + bench::ServerBench_Friend::process_request(server, request).at("result").get<int64_t>(); }, options.iterations);
+
+    double const request_parser_ns = measure(
+        [&](std::size_t) {
+            netlink::server::ParsedRequest parsed;
+            char response[netlink::server::RequestParser::M_RESULT_BUFFER_SIZE];
+            if (netlink::server::RequestParser::parse(request, parsed) == netlink::server::RequestParser::Status::OK) {
+                sink = sink + static_cast<int64_t>(netlink::server::RequestParser::format_result(parsed.arg1 + parsed.arg2, response, sizeof(response)));
+            }
+        },
+        options.iterations);
+
+    netlink::server::ResultCache cache(1024);
+    cache.insert(request, bench::ServerBench_Friend::process_request(server, request).dump(), netlink::server::OP::OP_ADD, false);
+    double const cache_hit_ns = measure(
+        [&](std::size_t) {
+            char reply[netlink::server::ResultCache::M_VALUE_SIZE + 1];
+            sink = sink + static_cast<int64_t>(cache.find(request, reply).size);
+        },
+        options.iterations);
+
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(msg.get(), NL_AUTO_PORT, 1, netlink::transport::InProcessTransport::FAMILY_ID, 0, 0, 1, 2);
+    nla_put_u8(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_OP), static_cast<uint8_t>(netlink::server::OP::OP_ADD));
+    nla_put_s64(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_ARG1), 1234);
+    nla_put_s64(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_ARG2), 5678);
+    double const process_binary_ns = measure(
+        [&](std::size_t) {
+            struct nlattr *attrs[static_cast<int>(netlink::server::ATTR::ATTR_MAX) + 1];
+            genlmsg_parse(nlmsg_hdr(msg.get()), 0, attrs, static_cast<int>(netlink::server::ATTR::ATTR_MAX), nullptr);
+            sink = sink + bench::ServerBench_Friend::process_binary(server, attrs).value;
+        },
+        options.iterations);
+
+    double const offload_ns = measure(
+        [&](std::size_t i) {
+            calc_ops_result result;
+            calc_ops_compute(CALC_OP_ADD, static_cast<int64_t>(i), 5678, &result);
+            sink = sink + result.value;
+        },
+        options.iterations);
+
+    // Массивы по 4096 элементов: помещаются в L1/L2, измеряется вычисление, а не память
+    constexpr std::size_t M_ARRAY_SIZE = 4096;
+    std::vector<int64_t> array1(M_ARRAY_SIZE), array2(M_ARRAY_SIZE), results(M_ARRAY_SIZE);
+    for (std::size_t i = 0; i < M_ARRAY_SIZE; ++i) {
+        array1[i] = static_cast<int64_t>(i * 7919);
+        array2[i] = static_cast<int64_t>(i) - 1000;
+    }
+    nlohmann::json bulk_ns;
+    for (auto isa : netlink::server::BulkEngine::supported()) {
+        double const ns = measure(
+            [&](std::size_t) {
+                netlink::server::BulkEngine::compute(isa, netlink::server::OP::OP_MUL, array1.data(), array2.data(), results.data(), M_ARRAY_SIZE);
+                sink = sink + results[M_ARRAY_SIZE - 1];
+            },
+            std::max<std::size_t>(options.iterations / M_ARRAY_SIZE, 1));
+        bulk_ns[netlink::server::BulkEngine::name(isa)] = ns / M_ARRAY_SIZE;
+    }
+
+    nlohmann::json const dispatch_ns = {
+        {"ops_3", measure_dispatch<3>(options.iterations, sink)},
+        {"ops_50", measure_dispatch<M_ACTION_NAMES.size()>(options.iterations, sink)},
+    };
+
+    return {
+        {"mode", "micro"},
+        {"iterations", options.iterations},
+        {"payload_size", request.size()},
+        {"process_request_ns", process_request_ns},
+        {"request_parser_ns", request_parser_ns},
+        {"cache_hit_ns", cache_hit_ns},
+        {"process_binary_ns", process_binary_ns},
+        {"offload_ns", offload_ns},
+        {"bulk_mul_ns_per_element", bulk_ns},
+        {"bulk_isa", netlink::server::BulkEngine::name(netlink::server::BulkEngine::isa())},
+        {"dispatch_ns", dispatch_ns},
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        usage(argv[0]);
+        return -1;
+    }
+
+    try {
+        nlohmann::json result = options.mode == "load" ? run_load(options) : run_micro(options);
+        printf("%s\n", result.dump().c_str());
+    } catch (std::exception &ex) {
+        fprintf(stderr, "Error: %s\n", ex.what());
+        return -1;
+    }
+    return 0;
+}
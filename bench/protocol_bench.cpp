@@ -0,0 +1,138 @@
+#include <netlink/genl/genl.h>
+#include <netlink/netlink.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <string>
+
+/*
+ * Сравнение стоимости одной операции для JSON (ATTR_MSG) и бинарного (ATTR_OP/ATTR_ARG1/ATTR_ARG2) протоколов.
+ *
+ * Измеряется полный путь сообщения в userspace без сокетов: клиент формирует запрос,
+ * сервер разбирает его, вычисляет и формирует ответ, клиент разбирает ответ.
+ * Форматы сообщений совпадают с client.cpp и server.cpp.
+ */
+
+namespace {
+
+enum ATTR : int {
+    ATTR_UNSPEC,
+    ATTR_MSG,
+    ATTR_BATCH,
+    ATTR_OP,
+    ATTR_ARG1,
+    ATTR_ARG2,
+    ATTR_RESULT,
+    ATTR_ERRNO,
+    ATTR_ARRAY1,
+    ATTR_ARRAY2,
+    ATTR_RESULTS,
+    ATTR_OFFSET,
+    ATTR_STREAM,
+    ATTR_CHUNK,
+    ATTR_EOS,
+    ATTR_DATA,
+    ATTR_MAX,
+};
+
+constexpr int FAMILY_ID = 0x20;
+constexpr uint8_t OP_ADD = 1;
+
+using nl_msg_ptr = std::unique_ptr<nl_msg, void (*)(nl_msg *)>;
+
+nl_msg_ptr new_message() {
+    nl_msg_ptr msg(nlmsg_alloc_size(256), nlmsg_free);
+    if (!msg || !genlmsg_put(msg.get(), NL_AUTO_PORT, 1, FAMILY_ID, 0, 0, 1, 1)) {
+        fprintf(stderr, "Failed to create Netlink message\n");
+        exit(1);
+    }
+    return msg;
+}
+
+int64_t json_round_trip(int64_t arg1, int64_t arg2) {
+    struct nlattr *attrs[ATTR_MAX + 1];
+
+    // Клиент: сериализация запроса
+    nlohmann::json request;
+    request["action"] = "add";
+    request["arg1"] = arg1;
+    request["arg2"] = arg2;
+    nl_msg_ptr request_msg = new_message();
+    nla_put_string(request_msg.get(), ATTR_MSG, request.dump().c_str());
+
+    // Сервер: разбор, вычисление, сериализация ответа
+    genlmsg_parse(nlmsg_hdr(request_msg.get()), 0, attrs, ATTR_MAX, nullptr);
+    nlohmann::json parsed = nlohmann::json::parse(std::string(nla_get_string(attrs[ATTR_MSG])));
+    nlohmann::json response;
+    if (parsed.at("action").get<std::string>() == "add") {
+        response["result"] = parsed.at("arg1").get<int64_t>() + parsed.at("arg2").get<int64_t>();
+    }
+    nl_msg_ptr response_msg = new_message();
+    nla_put_string(response_msg.get(), ATTR_MSG, response.dump().c_str());
+
+    // Клиент: разбор ответа
+    genlmsg_parse(nlmsg_hdr(response_msg.get()), 0, attrs, ATTR_MAX, nullptr);
+    return nlohmann::json::parse(std::string(nla_get_string(attrs[ATTR_MSG]))).at("result").get<int64_t>();
+}
+
+int64_t binary_round_trip(int64_t arg1, int64_t arg2) {
+    struct nlattr *attrs[ATTR_MAX + 1];
+
+    // Клиент: сериализация запроса
+    nl_msg_ptr request_msg = new_message();
+    nla_put_u8(request_msg.get(), ATTR_OP, OP_ADD);
+    nla_put_s64(request_msg.get(), ATTR_ARG1, arg1);
+    nla_put_s64(request_msg.get(), ATTR_ARG2, arg2);
+
+    // Сервер: разбор, вычисление, сериализация ответа
+    genlmsg_parse(nlmsg_hdr(request_msg.get()), 0, attrs, ATTR_MAX, nullptr);
+    int64_t result = 0;
+    if (nla_get_u8(attrs[ATTR_OP]) == OP_ADD) {
+        result = nla_get_s64(attrs[ATTR_ARG1]) + nla_get_s64(attrs[ATTR_ARG2]);
+    }
+    nl_msg_ptr response_msg = new_message();
+    nla_put_s64(response_msg.get(), ATTR_RESULT, result);
+
+    // Клиент: разбор ответа
+    genlmsg_parse(nlmsg_hdr(response_msg.get()), 0, attrs, ATTR_MAX, nullptr);
+    return nla_get_s64(attrs[ATTR_RESULT]);
+}
+
+template <typename F>
+double measure(F round_trip, std::size_t iterations) {
+    int64_t checksum = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        checksum += round_trip(static_cast<int64_t>(i), 42);
+    }
+    auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    if (checksum == 0) {
+        fprintf(stderr, "Unexpected checksum\n");
+    }
+    return elapsed / static_cast<double>(iterations);
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+    std::size_t iterations = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+    if (iterations == 0) {
+        fprintf(stderr, "Usage: %s [iterations]\n", argv[0]);
+        return -1;
+    }
+
+    // Прогрев
+    measure(json_round_trip, iterations / 10 + 1);
+    measure(binary_round_trip, iterations / 10 + 1);
+
+    double json_ns = measure(json_round_trip, iterations);
+    double binary_ns = measure(binary_round_trip, iterations);
+
+    printf("{\"iterations\": %zu, \"json_ns_per_op\": %.1f, \"binary_ns_per_op\": %.1f, \"speedup\": %.2f}\n", iterations, json_ns, binary_ns,
+           json_ns / binary_ns);
+    return 0;
+}
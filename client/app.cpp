@@ -24,9 +24,9 @@ int main() {
         request_err["arg1"] = -59;
         request_err["arg2"] = 100;
 
-        // client.send_request(request_add);
-        // client.send_request(request_mul);
-        // client.send_request(request_sub);
+        client.send_request(request_add);
+        client.send_request(request_mul);
+        client.send_request(request_sub);
         client.send_request(request_err);
         client.wait_for_response();
     } catch (const std::exception &e) {
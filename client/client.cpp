@@ -1,101 +1,1106 @@
 #include "client.hpp"
 
+#include <poll.h>
+
+#include <algorithm>
+
+#include "../common/json_writer.hpp"
+#include "../common/string_attribute.hpp"
+#include "../transport/genl_transport.hpp"
+
 //@todo: не нравиться что логирование и исключение надо что то одно оставить, сделать красиво надо
-netlink::client::Client::Client() {
+netlink::client::Client::Client(std::size_t max_in_flight) : Client(std::make_unique<transport::GenlTransport>(), max_in_flight) {}
+
+netlink::client::Client::Client(std::unique_ptr<transport::Transport> transport, std::size_t max_in_flight)
+    : m_transport(std::move(transport)), m_max_in_flight(max_in_flight == 0 ? 1 : max_in_flight) {
     openlog("NetlinkClient", LOG_PID | LOG_CONS, LOG_USER);
-    syslog(LOG_INFO, "Initializing the Netlink client");
+    NETLINK_LOG(LOG_INFO, "Initializing the Netlink client");
 
-    m_sock = nl_socket_alloc();
-    if (!m_sock) {
-        syslog(LOG_ERR, "Failed to allocate Netlink socket");
-        throw std::runtime_error("Failed to allocate Netlink socket");
+    m_rx_buffer.resize(M_RX_BUFFER_SIZE * M_RX_BATCH);
+    for (std::size_t i = 0; i < M_RX_BATCH; ++i) {
+        m_rx_datagrams[i] = {m_rx_buffer.data() + i * M_RX_BUFFER_SIZE, M_RX_BUFFER_SIZE, 0};
     }
+    m_version = m_transport->version();
+    NETLINK_LOG(LOG_INFO, "Netlink family version %d, %s protocol selected", m_version, m_version >= BINARY_PROTOCOL_VERSION ? "binary" : "JSON");
+
+    NETLINK_LOG(LOG_INFO, "Netlink client initialized successfully");
+}
+
+netlink::client::Client::~Client() {
+    detach();
+    NETLINK_LOG(LOG_INFO, "Netlink client socket closed and resources released");
+    closelog();
+}
 
-    nl_socket_disable_seq_check(m_sock);
+void netlink::client::Client::send_request(const nlohmann::json &request_json) {
+    send_request_async(request_json, [](Response const &response) {
+        if (response.error != 0) {
+            NETLINK_LOG(LOG_ERR, "Request failed: %s", strerror(response.error));
+            printf("Request failed: %s\n", strerror(response.error));
+        } else {
+            NETLINK_LOG(LOG_INFO, "Received message: %s", response.payload.c_str());
+            printf("Received message: %s\n", response.payload.c_str());
+        }
+    });
+}
 
-    if (genl_connect(m_sock)) {
-        syslog(LOG_ERR, "Failed to establish a connection to Netlink");
-        throw std::runtime_error("Failed to establish a connection to Netlink");
+uint32_t netlink::client::Client::send_request_async(const nlohmann::json &request_json, ResponseHandler on_response, uint32_t topic) {
+    if (topic != 0 && m_version < MULTICAST_PROTOCOL_VERSION) {
+        NETLINK_LOG(LOG_ERR, "Netlink family version %d does not support published replies", m_version);
+        throw std::runtime_error("Netlink family does not support published replies");
     }
+    admit();
+    std::string const payload = request_json.dump();
+    NETLINK_LOG(LOG_DEBUG, "Sending request: %s", payload.c_str());
+
+    uint32_t seq = 0;
+    nl_msg_ptr msg = create_message(seq, nlmsg_total_size(GENL_HDRLEN + nla_total_size(payload.size() + 1) + nla_total_size(sizeof(uint32_t))));
 
-    m_family_id = genl_ctrl_resolve(m_sock, M_FAMILY_NAME);
-    if (m_family_id < 0) {
-        syslog(LOG_ERR, "Failed to resolve the Netlink family name");
-        throw std::runtime_error("Failed to resolve the Netlink family name");
+    if (nla_put_string(msg.get(), static_cast<int>(ATTR::ATTR_MSG), payload.c_str()) ||
+        (topic != 0 && nla_put_u32(msg.get(), static_cast<int>(ATTR::ATTR_TOPIC), topic))) {
+        NETLINK_LOG(LOG_ERR, "Failed to attach JSON payload to Netlink message");
+        throw std::runtime_error("Failed to attach JSON payload to Netlink message");
     }
+    send_json_message(std::move(msg), seq, std::move(on_response));
+    return seq;
+}
 
-    nl_socket_modify_cb(m_sock, NL_CB_MSG_IN, NL_CB_CUSTOM, receive_message, nullptr);
+void netlink::client::Client::send_json_message(nl_msg_ptr msg, uint32_t seq, ResponseHandler on_response) {
+    auto handler = std::make_shared<ResponseHandler>(std::move(on_response));
+    send_message(
+        std::move(msg), seq,
+        [handler](int error, struct nlattr **attrs) {
+            if (error != 0) {
+                (*handler)(Response{error, {}});
+            } else if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+                (*handler)(Response{0, get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)])});
+            } else if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+                // Ошибка от ретранслятора вместо ответа сервера (например, ECONNRESET - сервер завершился)
+                (*handler)(Response{nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]), {}});
+            } else {
+                (*handler)(Response{EPROTO, {}});
+            }
+        },
+        [handler](int, struct nlattr **attrs) {
+            if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+                (*handler)(Response{0, get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)]), 0, true});
+            }
+        });
+}
+
+void netlink::client::Client::send_batch_async(std::vector<nlohmann::json> const &requests, BatchHandler on_response) {
+    admit();
+    auto handler = std::make_shared<BatchHandler>(std::move(on_response));
+    nl_msg_ptr msg(nullptr, nlmsg_free);
+    struct nlattr *batch = nullptr;
+    uint32_t seq = 0;
+    std::size_t offset = 0;
+    std::size_t count = 0;
+    std::size_t size = 0;
+
+    auto flush = [&]() {
+        nla_nest_end(msg.get(), batch);
+        NETLINK_LOG(LOG_DEBUG, "Sending batch of %zu requests (%zu bytes)", count, size);
+        send_message(std::move(msg), seq, [handler, offset, count](int error, struct nlattr **attrs) {
+            std::size_t index = 0;
+            if (error == 0 && attrs[static_cast<int>(ATTR::ATTR_BATCH)]) {
+                struct nlattr *entry = nullptr;
+                int rem = 0;
+                nla_for_each_nested(entry, attrs[static_cast<int>(ATTR::ATTR_BATCH)], rem) {
+                    if (index == count) {
+                        break;
+                    }
+                    (*handler)(offset + index++, Response{0, get_string(entry)});
+                }
+            } else if (error == 0 && attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+                // Ответ на весь пакет одним сообщением (например, сервер еще не зарегистрирован)
+                std::string const payload = get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)]);
+                for (; index < count; ++index) {
+                    (*handler)(offset + index, Response{0, payload});
+                }
+            } else if (error == 0 && attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+                error = nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]);
+            }
+            for (; index < count; ++index) {
+                (*handler)(offset + index, Response{error != 0 ? error : EPROTO, {}});
+            }
+        });
+        offset += count;
+        count = 0;
+        size = 0;
+    };
+
+    for (auto const &request : requests) {
+        std::string const payload = request.dump();
+        if (payload.size() + 1 > M_MAX_PAYLOAD_SIZE) {
+            NETLINK_LOG(LOG_ERR, "Batch entry of %zu bytes exceeds the payload limit", payload.size());
+            throw std::runtime_error("Batch entry exceeds the payload limit");
+        }
+
+        std::size_t const entry_size = nla_total_size(payload.size() + 1);
+        if (msg && size + entry_size > M_MAX_BATCH_SIZE) {
+            flush();
+        }
+        if (!msg) {
+            msg = create_message(seq, nlmsg_total_size(GENL_HDRLEN + nla_total_size(M_MAX_BATCH_SIZE)));
+            batch = nla_nest_start(msg.get(), static_cast<int>(ATTR::ATTR_BATCH));
+            if (!batch) {
+                NETLINK_LOG(LOG_ERR, "Failed to start batch attribute");
+                throw std::runtime_error("Failed to start batch attribute");
+            }
+        }
+
+        if (nla_put_string(msg.get(), static_cast<int>(ATTR::ATTR_MSG), payload.c_str())) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach JSON payload to batch");
+            throw std::runtime_error("Failed to attach JSON payload to batch");
+        }
+        size += entry_size;
+        ++count;
+    }
 
-    syslog(LOG_INFO, "Netlink client initialized successfully");
+    if (msg) {
+        flush();
+    }
 }
 
-netlink::client::Client::~Client() {
-    syslog(LOG_INFO, "Netlink client socket closed and resources released");
-    //@todo: переделать на uniq
-    nl_socket_free(m_sock);
-    closelog();
+uint32_t netlink::client::Client::calc_async(OP op, int64_t arg1, int64_t arg2, ResponseHandler on_response) {
+    const char *action = action_name(op);
+    if (!action) {
+        NETLINK_LOG(LOG_ERR, "Unsupported operation %d", static_cast<int>(op));
+        throw std::runtime_error("Unsupported operation");
+    }
+    admit();
+
+    if (m_shm) {
+        // Окно ограничено и емкостью очереди канала: место в очереди запросов всегда есть
+        while (m_shm && (in_flight() >= m_max_in_flight || m_shm_pending.size() >= m_shm->capacity())) {
+            if (m_admission == Admission::REJECT) {
+                throw BusyError("Shared memory request queue is full");
+            }
+            process_responses();
+        }
+    }
+    if (m_shm) {
+        transport::ShmRequest request;
+        request.id = next_seq();
+        request.op = static_cast<uint8_t>(op);
+        request.arg1 = arg1;
+        request.arg2 = arg2;
+        if (m_shm->push_requests(&request, 1) != 1) {
+            NETLINK_LOG(LOG_ERR, "Shared memory request queue is full");
+            throw std::runtime_error("Shared memory request queue is full");
+        }
+        m_shm_pending.push_back({std::move(on_response), request.id});
+        return request.id;
+    }
+
+    if (m_version < BINARY_PROTOCOL_VERSION) {
+        // Запрос записывается прямо в сообщение, в том же виде, что nlohmann::json::dump
+        uint32_t seq = 0;
+        nl_msg_ptr msg = create_message(seq, nlmsg_total_size(GENL_HDRLEN + nla_total_size(M_CALC_REQUEST_SIZE + 1)));
+        common::StringAttribute request(msg.get(), static_cast<int>(ATTR::ATTR_MSG), M_CALC_REQUEST_SIZE);
+        if (!request) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach JSON payload to Netlink message");
+            throw std::runtime_error("Failed to attach JSON payload to Netlink message");
+        }
+        common::JsonWriter writer(request.data(), request.capacity());
+        writer.begin_object().key("action").value(action).key("arg1").value(arg1).key("arg2").value(arg2).end_object();
+        request.finish(writer.size());
+        NETLINK_LOG(LOG_DEBUG, "Sending request: %s", request.data());
+        send_json_message(std::move(msg), seq, [handler = std::move(on_response)](Response const &response) {
+            Response result = response;
+            if (result.error == 0) {
+                // Сервер отвечает JSON с полем result, ошибкой вычисления {"errno", "error"} или текстом ошибки
+                nlohmann::json reply = nlohmann::json::parse(result.payload, nullptr, false);
+                if (!reply.is_discarded() && reply.is_object() && reply.contains("result") && reply["result"].is_number_integer()) {
+                    result.result = reply["result"].get<int64_t>();
+                } else if (!reply.is_discarded() && reply.is_object() && reply.contains("errno") && reply["errno"].is_number_integer()) {
+                    result.error = reply["errno"].get<int>();
+                } else {
+                    result.error = EINVAL;
+                }
+            }
+            handler(result);
+        });
+        return seq;
+    }
+
+    uint32_t seq = 0;
+    nl_msg_ptr msg = create_message(seq, nlmsg_total_size(GENL_HDRLEN + nla_total_size(sizeof(uint8_t)) + 2 * nla_total_size(sizeof(int64_t))));
+
+    if (nla_put_u8(msg.get(), static_cast<int>(ATTR::ATTR_OP), static_cast<uint8_t>(op)) ||
+        nla_put_s64(msg.get(), static_cast<int>(ATTR::ATTR_ARG1), arg1) || nla_put_s64(msg.get(), static_cast<int>(ATTR::ATTR_ARG2), arg2)) {
+        NETLINK_LOG(LOG_ERR, "Failed to attach binary request to Netlink message");
+        throw std::runtime_error("Failed to attach binary request to Netlink message");
+    }
+
+    send_message(std::move(msg), seq, [handler = std::move(on_response)](int error, struct nlattr **attrs) {
+        if (error != 0) {
+            handler(Response{error, {}, 0});
+        } else if (attrs[static_cast<int>(ATTR::ATTR_RESULT)]) {
+            handler(Response{0, {}, nla_get_s64(attrs[static_cast<int>(ATTR::ATTR_RESULT)])});
+        } else if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+            handler(Response{nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]), {}, 0});
+        } else if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+            // Текстовый ответ на бинарный запрос (например, сервер еще не зарегистрирован)
+            handler(Response{EPROTO, get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)]), 0});
+        } else {
+            handler(Response{EPROTO, {}, 0});
+        }
+    });
+    return seq;
 }
 
-void netlink::client::Client::send_request(const nlohmann::json &request_json) {
-    auto deleter_msg = [](nl_msg *msg) {
-        if (msg) {
-            nlmsg_free(msg);
+void netlink::client::Client::calc_array_async(OP op, std::span<int64_t const> arg1, std::span<int64_t const> arg2, ArrayHandler on_response) {
+    const char *action = action_name(op);
+    if (!action) {
+        NETLINK_LOG(LOG_ERR, "Unsupported operation %d", static_cast<int>(op));
+        throw std::runtime_error("Unsupported operation");
+    }
+    if (op == OP::OP_DIV || op == OP::OP_MOD) {
+        NETLINK_LOG(LOG_ERR, "Operation %s is not supported for arrays", action);
+        throw std::runtime_error("Unsupported operation");
+    }
+    if (arg1.size() != arg2.size()) {
+        NETLINK_LOG(LOG_ERR, "Array lengths differ: %zu and %zu", arg1.size(), arg2.size());
+        throw std::runtime_error("Array lengths differ");
+    }
+    admit();
+
+    // Общее состояние запросов одной операции: обработчик вызывается после ответа на последний запрос
+    struct State {
+        ArrayHandler handler;
+        std::vector<int64_t> results;
+        std::size_t remaining = 0;
+        int error = 0;
+
+        void fail(int code) {
+            if (error == 0) {
+                error = code;
+            }
+        }
+        // Записывает часть результатов запроса, начинающегося с base; выход за границы запроса - ошибка протокола
+        void store(std::size_t base, std::size_t size, std::size_t offset, int64_t const *values, std::size_t count) {
+            if (offset > size || count > size - offset) {
+                fail(EPROTO);
+                return;
+            }
+            std::copy(values, values + count, results.begin() + static_cast<std::ptrdiff_t>(base + offset));
+        }
+        void finish() {
+            if (--remaining == 0) {
+                handler(error, results);
+            }
         }
     };
-    std::unique_ptr<nl_msg, decltype(deleter_msg)> msg(nlmsg_alloc(), deleter_msg);
+    auto state = std::make_shared<State>();
+    state->handler = std::move(on_response);
+    state->results.resize(arg1.size());
+    if (arg1.empty()) {
+        state->handler(0, state->results);
+        return;
+    }
 
-    syslog(LOG_DEBUG, "Sending request: %s", request_json.dump().c_str());
+    bool const binary = m_version >= ARRAY_PROTOCOL_VERSION;
+    std::size_t const chunk = binary ? M_ARRAY_CHUNK : M_JSON_ARRAY_CHUNK;
+    state->remaining = (arg1.size() + chunk - 1) / chunk;
 
-    if (!genlmsg_put(msg.get(), NL_AUTO_PORT, NL_AUTO_SEQ, m_family_id, 0, 0, M_COMMAND_CLIENT, 1)) {
-        syslog(LOG_ERR, "Failed to create Netlink message header");
+    for (std::size_t base = 0; base < arg1.size(); base += chunk) {
+        std::size_t const size = std::min(chunk, arg1.size() - base);
+
+        if (!binary) {
+            nlohmann::json request_json;
+            request_json["action"] = action;
+            request_json["arg1"] = std::vector<int64_t>(arg1.begin() + static_cast<std::ptrdiff_t>(base), arg1.begin() + static_cast<std::ptrdiff_t>(base + size));
+            request_json["arg2"] = std::vector<int64_t>(arg2.begin() + static_cast<std::ptrdiff_t>(base), arg2.begin() + static_cast<std::ptrdiff_t>(base + size));
+            send_request_async(request_json, [state, base, size](Response const &response) {
+                if (response.error != 0) {
+                    state->fail(response.error);
+                } else {
+                    // Каждая часть ответа: {"offset": N, "result": [...]}, либо текст ошибки
+                    nlohmann::json reply = nlohmann::json::parse(response.payload, nullptr, false);
+                    if (reply.is_object() && reply.contains("offset") && reply["offset"].is_number_unsigned() && reply.contains("result") &&
+                        reply["result"].is_array()) {
+                        std::vector<int64_t> values;
+                        for (auto const &value : reply["result"]) {
+                            values.push_back(value.is_number_integer() ? value.get<int64_t>() : 0);
+                        }
+                        state->store(base, size, reply["offset"].get<std::size_t>(), values.data(), values.size());
+                    } else {
+                        state->fail(EINVAL);
+                    }
+                }
+                if (!response.more) {
+                    state->finish();
+                }
+            });
+            continue;
+        }
+
+        uint32_t seq = 0;
+        int const bytes = static_cast<int>(size * sizeof(int64_t));
+        nl_msg_ptr msg = create_message(seq, nlmsg_total_size(GENL_HDRLEN + nla_total_size(sizeof(uint8_t)) + 2 * nla_total_size(bytes)));
+        if (nla_put_u8(msg.get(), static_cast<int>(ATTR::ATTR_OP), static_cast<uint8_t>(op)) ||
+            nla_put(msg.get(), static_cast<int>(ATTR::ATTR_ARRAY1), bytes, arg1.data() + base) ||
+            nla_put(msg.get(), static_cast<int>(ATTR::ATTR_ARRAY2), bytes, arg2.data() + base)) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach array request to Netlink message");
+            throw std::runtime_error("Failed to attach array request to Netlink message");
+        }
+
+        // Часть ответа: смещение внутри запроса и результаты (данные атрибута выровнены на 4 байта)
+        auto on_part = [state, base, size](int error, struct nlattr **attrs) {
+            if (error != 0) {
+                state->fail(error);
+            } else if (attrs[static_cast<int>(ATTR::ATTR_RESULTS)] && attrs[static_cast<int>(ATTR::ATTR_OFFSET)]) {
+                struct nlattr *results = attrs[static_cast<int>(ATTR::ATTR_RESULTS)];
+                std::size_t const count = static_cast<std::size_t>(nla_len(results)) / sizeof(int64_t);
+                std::vector<int64_t> values(count);
+                std::memcpy(values.data(), nla_data(results), count * sizeof(int64_t));
+                state->store(base, size, nla_get_u32(attrs[static_cast<int>(ATTR::ATTR_OFFSET)]), values.data(), count);
+            } else if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+                state->fail(nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]));
+            } else {
+                state->fail(EPROTO);
+            }
+        };
+        send_message(
+            std::move(msg), seq,
+            [state, on_part](int error, struct nlattr **attrs) {
+                on_part(error, attrs);
+                state->finish();
+            },
+            on_part);
+    }
+}
+
+void netlink::client::Client::send_stream_async(std::string_view payload, ResponseHandler on_response) {
+    if (m_version < STREAM_PROTOCOL_VERSION) {
+        NETLINK_LOG(LOG_ERR, "Netlink family version %d does not support streams", m_version);
+        throw std::runtime_error("Netlink family does not support streams");
+    }
+    admit();
+
+    // Общее состояние фрагментов потока: первая ошибка прерывает отправку, ответ собирается по частям
+    struct State {
+        ResponseHandler handler;
+        std::string response;
+        uint32_t next_part = 0;
+        int error = 0;
+
+        void fail(int code) {
+            if (error == 0) {
+                error = code;
+            }
+        }
+        void append(struct nlattr **attrs) {
+            struct nlattr *data = attrs[static_cast<int>(ATTR::ATTR_DATA)];
+            struct nlattr *chunk = attrs[static_cast<int>(ATTR::ATTR_CHUNK)];
+            if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+                fail(nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]));
+            } else if (!data || !chunk || nla_get_u32(chunk) != next_part++) {
+                fail(EPROTO);
+            } else if (error == 0) {
+                response.append(static_cast<const char *>(nla_data(data)), static_cast<std::size_t>(nla_len(data)));
+            }
+        }
+    };
+    auto state = std::make_shared<State>();
+    state->handler = std::move(on_response);
+
+    uint32_t const stream = ++m_next_stream;
+    std::size_t offset = 0;
+    uint32_t chunk = 0;
+    bool last = false;
+    do {
+        // create_message обрабатывает ответы, пока окно заполнено: ошибка могла прийти за это время
+        uint32_t seq = 0;
+        std::size_t part = std::min(M_STREAM_CHUNK, payload.size() - offset);
+        nl_msg_ptr msg = create_message(seq, nlmsg_total_size(GENL_HDRLEN + 2 * nla_total_size(sizeof(uint32_t)) + nla_total_size(part) + nla_total_size(0)));
+        if (state->error != 0) {
+            part = 0;
+            last = true;
+        } else {
+            last = offset + part == payload.size();
+        }
+        if (nla_put_u32(msg.get(), static_cast<int>(ATTR::ATTR_STREAM), stream) || nla_put_u32(msg.get(), static_cast<int>(ATTR::ATTR_CHUNK), chunk) ||
+            (part > 0 && nla_put(msg.get(), static_cast<int>(ATTR::ATTR_DATA), static_cast<int>(part), payload.data() + offset)) ||
+            (last && nla_put_flag(msg.get(), static_cast<int>(ATTR::ATTR_EOS)))) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach stream chunk to Netlink message");
+            throw std::runtime_error("Failed to attach stream chunk to Netlink message");
+        }
+
+        if (!last) {
+            // Подтверждение фрагмента: ATTR_STREAM или ATTR_ERRNO
+            send_message(std::move(msg), seq, [state](int error, struct nlattr **attrs) {
+                if (error != 0) {
+                    state->fail(error);
+                } else if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+                    state->fail(nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]));
+                } else if (!attrs[static_cast<int>(ATTR::ATTR_STREAM)]) {
+                    state->fail(EPROTO);
+                }
+            });
+        } else {
+            send_message(
+                std::move(msg), seq,
+                [state](int error, struct nlattr **attrs) {
+                    if (error != 0) {
+                        state->fail(error);
+                    } else if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+                        // Текстовый ответ ретранслятора (например, сервер еще не зарегистрирован)
+                        state->fail(EPROTO);
+                    } else {
+                        state->append(attrs);
+                    }
+                    if (state->error != 0) {
+                        state->handler(Response{state->error, {}});
+                    } else {
+                        state->handler(Response{0, std::move(state->response)});
+                    }
+                },
+                [state](int, struct nlattr **attrs) { state->append(attrs); });
+        }
+        offset += part;
+        ++chunk;
+    } while (!last);
+}
+
+netlink::client::Client::nl_msg_ptr netlink::client::Client::create_message(uint32_t &seq, std::size_t size) {
+    while (in_flight() >= m_max_in_flight) {
+        process_responses();
+        if (m_corked) {
+            // Освобождается сразу несколько мест, и следующие запросы снова накапливаются
+            process_available();
+        }
+    }
+
+    nl_msg_ptr msg(nlmsg_alloc_size(size), nlmsg_free);
+    if (!msg) {
+        NETLINK_LOG(LOG_ERR, "Failed to allocate Netlink message");
+        throw std::runtime_error("Failed to allocate Netlink message");
+    }
+
+    seq = next_seq();
+    if (!genlmsg_put(msg.get(), NL_AUTO_PORT, seq, m_transport->family_id(), 0, NLM_F_REQUEST, M_COMMAND_CLIENT, 1)) {
+        NETLINK_LOG(LOG_ERR, "Failed to create Netlink message header");
         throw std::runtime_error("Failed to create Netlink message header");
     }
+    return msg;
+}
 
-    if (nla_put_string(msg.get(), static_cast<int>(ATTR::ATTR_MSG), request_json.dump().c_str())) {
-        syslog(LOG_ERR, "Failed to attach JSON payload to Netlink message");
-        throw std::runtime_error("Failed to attach JSON payload to Netlink message");
+void netlink::client::Client::admit() const {
+    if (m_admission == Admission::REJECT && in_flight() >= m_max_in_flight) {
+        NETLINK_LOG_RATELIMITED(LOG_WARNING, "Request rejected: %zu requests in flight", in_flight());
+        throw BusyError("Too many requests in flight");
+    }
+}
+
+uint32_t netlink::client::Client::next_seq() {
+    // Номер 0 не используется, чтобы ответ нельзя было спутать с сообщением без номера
+    uint32_t seq = m_next_seq++;
+    if (seq == 0) {
+        seq = m_next_seq++;
+    }
+    return seq;
+}
+
+void netlink::client::Client::send_message(nl_msg_ptr msg, uint32_t seq, MessageHandler handler, MessageHandler on_part) {
+    struct nlmsghdr *nlh = nlmsg_hdr(msg.get());
+    if (m_corked) {
+        std::size_t const len = NLMSG_ALIGN(nlh->nlmsg_len);
+        if (m_tx_buffer.size() + len > M_TX_BUFFER_SIZE) {
+            flush();
+        }
+        m_tx_buffer.insert(m_tx_buffer.end(), reinterpret_cast<char const *>(nlh), reinterpret_cast<char const *>(nlh) + nlh->nlmsg_len);
+        m_tx_buffer.resize(m_tx_buffer.size() + len - nlh->nlmsg_len);
+        m_tx_seqs.push_back(seq);
+    } else {
+        int ret = m_transport->send(nlh, nlh->nlmsg_len);
+        if (ret < 0) {
+            NETLINK_LOG(LOG_ERR, "Failed to send Netlink message: %s", strerror(-ret));
+            throw std::runtime_error("Failed to send Netlink message");
+        }
+    }
+
+    common::EventLoop::TimerId timer = 0;
+    if (m_loop && m_timeout.count() > 0) {
+        timer = m_loop->add_timer(m_timeout, [this, seq]() { expire(seq); });
     }
+    m_pending.emplace(seq, Pending{std::move(handler), std::move(on_part), timer});
+    NETLINK_LOG(LOG_DEBUG, "Message sent successfully with sequence number: %u", seq);
+}
+
+void netlink::client::Client::subscribe(uint32_t topic, ResponseHandler on_result) {
+    if (topic == 0) {
+        NETLINK_LOG(LOG_ERR, "Topic 0 means no publishing and cannot be subscribed to");
+        throw std::runtime_error("Invalid topic");
+    }
+    if (m_version < MULTICAST_PROTOCOL_VERSION) {
+        NETLINK_LOG(LOG_ERR, "Netlink family version %d does not support published replies", m_version);
+        throw std::runtime_error("Netlink family does not support published replies");
+    }
+    if (!m_joined) {
+        int ret = m_transport->open_subscription(m_subscription);
+        if (ret < 0) {
+            NETLINK_LOG(LOG_ERR, "Failed to join the multicast group: %s", strerror(-ret));
+            throw std::runtime_error("Failed to join the multicast group");
+        }
+        if (m_subscription && m_loop) {
+            m_loop->add(m_subscription->fd(), EPOLLIN, [this](uint32_t) { on_published(); });
+        }
+        m_joined = true;
+    }
+    m_subscriptions[topic] = std::move(on_result);
+}
+
+bool netlink::client::Client::unsubscribe(uint32_t topic) { return m_subscriptions.erase(topic) != 0; }
+
+bool netlink::client::Client::cancel(uint32_t seq) {
+    auto it = m_pending.find(seq);
+    if (it == m_pending.end()) {
+        // Место операции в очереди общей памяти сохраняется до ответа сервера
+        auto shm = std::find_if(m_shm_pending.begin(), m_shm_pending.end(), [seq](ShmPending const &pending) { return pending.seq == seq; });
+        if (shm == m_shm_pending.end() || !shm->handler) {
+            return false;
+        }
+        shm->handler = nullptr;
+        ++m_shm_cancelled;
+        return true;
+    }
+    if (it->second.timer != 0 && m_loop) {
+        m_loop->cancel_timer(it->second.timer);
+    }
+    m_pending.erase(it);
+    return true;
+}
 
-    int ret = nl_send_auto(m_sock, msg.get());
+void netlink::client::Client::cork(bool enabled) {
+    m_corked = enabled;
+    if (enabled) {
+        m_tx_buffer.reserve(M_TX_BUFFER_SIZE);
+    } else {
+        flush();
+    }
+}
+
+void netlink::client::Client::flush() {
+    if (m_tx_buffer.empty()) {
+        return;
+    }
+    int ret = m_transport->send(m_tx_buffer.data(), m_tx_buffer.size());
+    m_tx_buffer.clear();
     if (ret < 0) {
-        syslog(LOG_ERR, "Failed to send Netlink message");
+        // Обработчики могут отправлять новые запросы, поэтому номера забираются из буфера заранее
+        std::vector<uint32_t> seqs;
+        seqs.swap(m_tx_seqs);
+        NETLINK_LOG(LOG_ERR, "Failed to send %zu Netlink messages: %s", seqs.size(), strerror(-ret));
+        for (uint32_t seq : seqs) {
+            complete(seq, -ret, nullptr);
+        }
         throw std::runtime_error("Failed to send Netlink message");
-    } else {
-        struct nlmsghdr *nlh = nlmsg_hdr(msg.get());
-        syslog(LOG_INFO, "Message sent successfully with sequence number: %d", nlh->nlmsg_seq);
     }
+    NETLINK_LOG(LOG_DEBUG, "Flushed %zu messages in one datagram", m_tx_seqs.size());
+    m_tx_seqs.clear();
 }
 
-void netlink::client::Client::wait_for_response() {
-    syslog(LOG_INFO, "Waiting for responses from the kernel");
-    while (true) {
-        int ret = nl_recvmsgs_default(m_sock);
+void netlink::client::Client::process_responses() {
+    flush();
+    if (!m_shm_pending.empty()) {
+        wait_shm();
+        return;
+    }
+    if (m_subscription) {
+        // Сообщения приходят в два сокета: блокирующий прием из основного пропустил бы рассылку
+        while (process_available() == 0) {
+            wait_readable();
+        }
+        return;
+    }
+    while (receive_datagrams() == 0) {
+        if (m_overflowed) {
+            // Дочитываем очередь сокета, после чего запросы с потерянными ответами завершаются
+            process_available();
+            return;
+        }
+        // Неблокирующий транспорт: ждем готовности дескриптора
+        wait_readable();
+    }
+}
+
+void netlink::client::Client::wait_readable() {
+    struct pollfd pfds[2] = {{m_transport->fd(), POLLIN, 0}, {m_subscription ? m_subscription->fd() : -1, POLLIN, 0}};
+    if (pfds[0].fd < 0 || (poll(pfds, 2, -1) < 0 && errno != EINTR)) {
+        NETLINK_LOG(LOG_ERR, "Failed to wait for the transport: %s", strerror(errno));
+        throw std::runtime_error("Failed to wait for the transport");
+    }
+}
+
+std::size_t netlink::client::Client::process_available() {
+    std::size_t const replies = receive_shm();
+    if (m_pending.empty() && m_subscriptions.empty() && !m_overflowed) {
+        // Ответов и рассылок из Netlink не ждем: переключение режима транспорта не нужно
+        return replies;
+    }
+    // В цикле событий транспорт уже неблокирующий
+    if (!m_loop) {
+        int ret = m_transport->set_nonblocking(true);
         if (ret < 0) {
-            syslog(LOG_ERR, "Error while receiving message from kernel: %s", nl_geterror(ret));
+            NETLINK_LOG(LOG_ERR, "Failed to switch the transport to non-blocking mode: %s", strerror(-ret));
+            throw std::runtime_error("Failed to switch the transport to non-blocking mode");
+        }
+    }
+    std::size_t datagrams = 0;
+    try {
+        for (std::size_t received = 0; (received = receive_datagrams()) != 0 || m_overflowed;) {
+            datagrams += received;
+        }
+        datagrams += receive_subscription();
+    } catch (...) {
+        if (!m_loop) {
+            m_transport->set_nonblocking(false);
+        }
+        throw;
+    }
+    if (!m_loop) {
+        m_transport->set_nonblocking(false);
+    }
+    return datagrams + replies;
+}
+
+std::size_t netlink::client::Client::receive_datagrams() {
+    int received = m_transport->receive_batch(m_rx_datagrams.data(), m_rx_datagrams.size());
+    if (received == -EAGAIN) {
+        if (m_overflowed) {
+            recover_lost();
+        }
+        return 0;
+    }
+    if (received == 0) {
+        NETLINK_LOG(LOG_ERR, "The transport was closed by the other side");
+        throw std::runtime_error("The transport was closed by the other side");
+    }
+    if (received < 0) {
+        if (received == -ENOBUFS) {
+            // Соединение пригодно, но часть ответов потеряна: какие именно, станет ясно, когда очередь опустеет
+            ++m_overflows;
+            m_overflowed = true;
+            m_overflow_seq = m_next_seq;
+            NETLINK_LOG_RATELIMITED(LOG_WARNING, "Netlink receive buffer overflow, some responses were dropped");
+            return 0;
+        }
+        NETLINK_LOG(LOG_ERR, "Error while receiving message from kernel: %s", strerror(-received));
+        throw std::runtime_error("Error while receiving message from kernel");
+    }
+
+    for (int i = 0; i < received; ++i) {
+        ssize_t const len = m_rx_datagrams[i].length;
+        if (static_cast<std::size_t>(len) > M_RX_BUFFER_SIZE) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Dropping truncated message of %zd bytes", len);
+            continue;
+        }
+        int remaining = static_cast<int>(len);
+        for (auto *nlh = static_cast<struct nlmsghdr *>(m_rx_datagrams[i].data); nlmsg_ok(nlh, remaining); nlh = nlmsg_next(nlh, &remaining)) {
+            receive_message(nlh);
+        }
+    }
+    return static_cast<std::size_t>(received);
+}
+
+std::size_t netlink::client::Client::receive_subscription() {
+    std::size_t datagrams = 0;
+    while (m_subscription) {
+        int received = m_subscription->receive_batch(m_rx_datagrams.data(), m_rx_datagrams.size());
+        if (received == -EAGAIN) {
             break;
         }
+        if (received == -ENOBUFS) {
+            // Потеряны только разосланные ответы: ответы на запросы принимает основной транспорт
+            ++m_published_overflows;
+            NETLINK_LOG_RATELIMITED(LOG_WARNING, "Netlink subscription buffer overflow, some published replies were dropped");
+            continue;
+        }
+        if (received == 0) {
+            NETLINK_LOG(LOG_ERR, "The subscription socket was closed");
+            throw std::runtime_error("The subscription socket was closed");
+        }
+        if (received < 0) {
+            NETLINK_LOG(LOG_ERR, "Error while receiving published replies: %s", strerror(-received));
+            throw std::runtime_error("Error while receiving published replies");
+        }
+        for (int i = 0; i < received; ++i) {
+            ssize_t const len = m_rx_datagrams[i].length;
+            if (static_cast<std::size_t>(len) > M_RX_BUFFER_SIZE) {
+                NETLINK_LOG_RATELIMITED(LOG_ERR, "Dropping truncated published message of %zd bytes", len);
+                continue;
+            }
+            int remaining = static_cast<int>(len);
+            for (auto *nlh = static_cast<struct nlmsghdr *>(m_rx_datagrams[i].data); nlmsg_ok(nlh, remaining); nlh = nlmsg_next(nlh, &remaining)) {
+                receive_published(nlh);
+            }
+        }
+        datagrams += static_cast<std::size_t>(received);
     }
-    syslog(LOG_INFO, "Client operations completed");
+    return datagrams;
 }
 
-int netlink::client::Client::receive_message(struct nl_msg *msg, void *arg) {
-    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+void netlink::client::Client::recover_lost() {
+    m_overflowed = false;
+    std::vector<uint32_t> lost;
+    std::size_t waiting = 0;
+    for (auto const &[seq, pending] : m_pending) {
+        // Сравнение с учетом переполнения номеров; накопленные, но не отправленные запросы не теряются
+        if (static_cast<int32_t>(seq - m_overflow_seq) >= 0 || std::find(m_tx_seqs.begin(), m_tx_seqs.end(), seq) != m_tx_seqs.end()) {
+            continue;
+        }
+        // Ответ мог быть не потерян, а еще не отправлен сервером: запрос со сроком дождется ответа или истечения срока
+        if (pending.timer != 0) {
+            ++waiting;
+        } else {
+            lost.push_back(seq);
+        }
+    }
+    if (waiting != 0) {
+        NETLINK_LOG(LOG_WARNING, "%zu requests may have lost their responses in a receive buffer overflow, waiting for their deadline", waiting);
+    }
+    if (lost.empty()) {
+        return;
+    }
+    NETLINK_LOG(LOG_WARNING, "%zu requests lost their responses in a receive buffer overflow", lost.size());
+    for (uint32_t seq : lost) {
+        complete(seq, ENOBUFS, nullptr);
+    }
+}
+
+bool netlink::client::Client::enable_shm(std::size_t capacity) {
+    if (m_shm) {
+        return true;
+    }
+    if (m_loop) {
+        NETLINK_LOG(LOG_WARNING, "The shared memory channel can not be used with an event loop");
+        return false;
+    }
+    std::unique_ptr<transport::ShmChannel> channel;
+    try {
+        channel = transport::ShmChannel::create(capacity);
+    } catch (std::exception &ex) {
+        NETLINK_LOG(LOG_WARNING, "Shared memory channel is unavailable (%s), using Netlink", ex.what());
+        return false;
+    }
+
+    bool done = false;
+    std::string declined;
+    uint32_t seq = send_request_async({{"shm", channel->name()}}, [&done, &declined](Response const &response) {
+        done = true;
+        nlohmann::json reply = nlohmann::json::parse(response.payload, nullptr, false);
+        if (response.error != 0) {
+            declined = strerror(response.error);
+        } else if (reply.is_discarded() || !reply.is_object() || !reply.contains("result") || reply.at("result") != 0) {
+            // Старый сервер отвечает на неизвестный запрос текстом ошибки
+            declined = response.payload;
+        }
+    });
+    try {
+        while (!done) {
+            process_responses();
+        }
+    } catch (...) {
+        cancel(seq);
+        throw;
+    }
+    if (!declined.empty()) {
+        NETLINK_LOG(LOG_WARNING, "Server declined the shared memory channel (%s), using Netlink", declined.c_str());
+        return false;
+    }
+    m_shm = std::move(channel);
+    NETLINK_LOG(LOG_INFO, "Shared memory channel %s enabled (%zu records)", m_shm->name().c_str(), m_shm->capacity());
+    return true;
+}
+
+std::size_t netlink::client::Client::receive_shm() {
+    std::size_t processed = 0;
+    while (m_shm) {
+        if (m_shm_reply_pos == m_shm_reply_count) {
+            m_shm_reply_pos = 0;
+            m_shm_reply_count = m_shm->pop_replies(m_shm_replies.data(), m_shm_replies.size());
+            if (m_shm_reply_count == 0) {
+                break;
+            }
+        }
+        transport::ShmReply const reply = m_shm_replies[m_shm_reply_pos++];
+        if (m_shm_pending.empty() || m_shm_pending.front().seq != reply.id) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Dropping out of order shared memory reply %u", reply.id);
+            continue;
+        }
+        // Обработчик извлекается до вызова, чтобы он мог отправлять новые запросы
+        ResponseHandler handler = std::move(m_shm_pending.front().handler);
+        m_shm_pending.pop_front();
+        ++processed;
+        if (!handler) {
+            --m_shm_cancelled;
+            continue;
+        }
+        try {
+            handler(Response{reply.error, {}, reply.result});
+        } catch (std::exception &ex) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Response handler for sequence number %u failed: %s", reply.id, ex.what());
+        }
+    }
+    return processed;
+}
+
+void netlink::client::Client::wait_shm() {
+    while (receive_shm() == 0) {
+        if (!m_shm) {
+            return;
+        }
+        // Ответы из общей памяти не пробуждают poll, поэтому при смешанной нагрузке Netlink опрашивается между ожиданиями
+        if ((!m_pending.empty() || m_overflowed) && process_available() != 0) {
+            return;
+        }
+        if (!m_shm->wait(std::chrono::milliseconds(m_pending.empty() ? 100 : 1)) && m_shm->peer_closed() && receive_shm() == 0) {
+            close_shm(ECONNRESET);
+            return;
+        }
+    }
+}
+
+void netlink::client::Client::close_shm(int error) {
+    NETLINK_LOG(LOG_ERR, "The shared memory channel was closed by the server, %zu operations failed", m_shm_pending.size() - m_shm_cancelled);
+    m_shm.reset();
+    std::deque<ShmPending> pending;
+    pending.swap(m_shm_pending);
+    m_shm_cancelled = 0;
+    m_shm_reply_pos = 0;
+    m_shm_reply_count = 0;
+    for (auto &operation : pending) {
+        if (!operation.handler) {
+            continue;
+        }
+        try {
+            operation.handler(Response{error, {}, 0});
+        } catch (std::exception &ex) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Response handler for sequence number %u failed: %s", operation.seq, ex.what());
+        }
+    }
+}
+
+void netlink::client::Client::attach(common::EventLoop &loop) {
+    if (m_shm) {
+        NETLINK_LOG(LOG_ERR, "The shared memory channel can not be used with an event loop");
+        throw std::runtime_error("The shared memory channel can not be used with an event loop");
+    }
+    detach();
+    int const fd = m_transport->fd();
+    int ret = fd < 0 ? -EOPNOTSUPP : m_transport->set_nonblocking(true);
+    if (ret < 0) {
+        NETLINK_LOG(LOG_ERR, "The transport can not be used with an event loop: %s", strerror(-ret));
+        throw std::runtime_error("The transport can not be used with an event loop");
+    }
+    loop.add(fd, EPOLLIN, [this](uint32_t) { on_readable(); });
+    if (m_subscription) {
+        loop.add(m_subscription->fd(), EPOLLIN, [this](uint32_t) { on_published(); });
+    }
+    m_loop = &loop;
+}
+
+void netlink::client::Client::detach() {
+    if (!m_loop) {
+        return;
+    }
+    for (auto &[seq, pending] : m_pending) {
+        if (pending.timer != 0) {
+            m_loop->cancel_timer(pending.timer);
+            pending.timer = 0;
+        }
+    }
+    m_loop->remove(m_transport->fd());
+    if (m_subscription) {
+        m_loop->remove(m_subscription->fd());
+    }
+    m_transport->set_nonblocking(false);
+    m_loop = nullptr;
+}
+
+void netlink::client::Client::on_readable() {
+    try {
+        while (receive_datagrams() != 0 || m_overflowed) {
+        }
+    } catch (std::exception &ex) {
+        // Транспорт больше непригоден: ожидающие запросы завершаются ошибкой
+        NETLINK_LOG(LOG_ERR, "Detaching the client from the event loop: %s", ex.what());
+        detach();
+        while (!m_pending.empty()) {
+            complete(m_pending.begin()->first, ECONNRESET, nullptr);
+        }
+    }
+}
+
+void netlink::client::Client::on_published() {
+    try {
+        receive_subscription();
+    } catch (std::exception &ex) {
+        // Запросы в полете не затрагиваются; следующая подписка откроет сокет рассылки заново
+        NETLINK_LOG(LOG_ERR, "Closing the subscription socket: %s", ex.what());
+        m_loop->remove(m_subscription->fd());
+        m_subscription.reset();
+        m_joined = false;
+    }
+}
+
+void netlink::client::Client::expire(uint32_t seq) {
+    auto it = m_pending.find(seq);
+    if (it == m_pending.end()) {
+        return;
+    }
+    it->second.timer = 0;
+    NETLINK_LOG_RATELIMITED(LOG_WARNING, "Request with sequence number %u timed out", seq);
+    complete(seq, ETIMEDOUT, nullptr);
+}
+
+void netlink::client::Client::wait_for_response() {
+    NETLINK_LOG(LOG_INFO, "Waiting for responses from the kernel");
+    while (in_flight() != 0) {
+        try {
+            process_responses();
+        } catch (std::exception &) {
+            break;
+        }
+    }
+    NETLINK_LOG(LOG_INFO, "Client operations completed");
+}
+
+void netlink::client::Client::complete(uint32_t seq, int error, struct nlattr **attrs) {
+    auto it = m_pending.find(seq);
+    if (it == m_pending.end()) {
+        NETLINK_LOG(LOG_DEBUG, "No pending request with sequence number %u", seq);
+        return;
+    }
+    // Обработчик извлекается до вызова, чтобы он мог отправлять новые запросы
+    MessageHandler handler = std::move(it->second.handler);
+    if (it->second.timer != 0 && m_loop) {
+        m_loop->cancel_timer(it->second.timer);
+    }
+    m_pending.erase(it);
+
+    try {
+        handler(error, attrs);
+    } catch (std::exception &ex) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Response handler for sequence number %u failed: %s", seq, ex.what());
+    }
+}
+
+void netlink::client::Client::receive_message(struct nlmsghdr *nlh) {
     struct nlattr *attrs[static_cast<int>(ATTR::ATTR_MAX) + 1];
 
-    int ret = genlmsg_parse(nlh, 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr);
+    // Номер 0 не выдается запросам: такое сообщение разослано ретранслятором подписчикам
+    if (nlh->nlmsg_seq == 0 && m_joined) {
+        receive_published(nlh);
+        return;
+    }
+    // Замена встроенной проверки libnl, которая допускает только один запрос в полете
+    if (m_pending.find(nlh->nlmsg_seq) == m_pending.end()) {
+        NETLINK_LOG(LOG_DEBUG, "Dropping message with unexpected sequence number %u", nlh->nlmsg_seq);
+        return;
+    }
+
+    if (nlh->nlmsg_type == NLMSG_ERROR) {
+        auto *err = static_cast<struct nlmsgerr *>(nlmsg_data(nlh));
+        // Подтверждения не запрашиваются, нулевой код ошибки не завершает запрос
+        if (err->error != 0) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Kernel reported error for sequence number %u: %s", nlh->nlmsg_seq, strerror(-err->error));
+            complete(nlh->nlmsg_seq, -err->error, nullptr);
+        }
+        return;
+    }
+    if (nlh->nlmsg_type < NLMSG_MIN_TYPE) {
+        return;
+    }
+
+    int ret = genlmsg_parse(nlh, 0, attrs, static_cast<int>(ATTR::ATTR_MAX), M_POLICY.data());
     if (ret < 0) {
-        syslog(LOG_ERR, "Failed to parse received Netlink message");
-        return ret;
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Failed to parse received Netlink message");
+        complete(nlh->nlmsg_seq, EPROTO, nullptr);
+        return;
     }
 
-    if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
-        const char *data = nla_get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)]);
-        syslog(LOG_INFO, "Received message: %s", data);
-        printf("Received message: %s\n", data);
-        exit(0);
+    if (!attrs[static_cast<int>(ATTR::ATTR_MSG)] && !attrs[static_cast<int>(ATTR::ATTR_BATCH)] && !attrs[static_cast<int>(ATTR::ATTR_RESULT)] &&
+        !attrs[static_cast<int>(ATTR::ATTR_ERRNO)] && !attrs[static_cast<int>(ATTR::ATTR_RESULTS)]) {
+        NETLINK_LOG(LOG_DEBUG, "Received message with no payload");
     } else {
-        syslog(LOG_DEBUG, "Received message with no payload");
+        NETLINK_LOG(LOG_DEBUG, "Received message with sequence number %u", nlh->nlmsg_seq);
+    }
+    if (nlh->nlmsg_flags & NLM_F_MULTI) {
+        // Промежуточная часть ответа: запрос остается в полете до последней части
+        auto it = m_pending.find(nlh->nlmsg_seq);
+        if (!it->second.on_part) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Unexpected multipart reply for sequence number %u", nlh->nlmsg_seq);
+            return;
+        }
+        // Копия: обработчик может отменить запрос
+        MessageHandler on_part = it->second.on_part;
+        try {
+            on_part(0, attrs);
+        } catch (std::exception &ex) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Response handler for sequence number %u failed: %s", nlh->nlmsg_seq, ex.what());
+        }
+        return;
     }
+    complete(nlh->nlmsg_seq, 0, attrs);
+}
 
-    return NL_OK;
-}
\ No newline at end of file
+void netlink::client::Client::receive_published(struct nlmsghdr *nlh) {
+    struct nlattr *attrs[static_cast<int>(ATTR::ATTR_MAX) + 1];
+
+    if (nlh->nlmsg_type < NLMSG_MIN_TYPE || genlmsg_parse(nlh, 0, attrs, static_cast<int>(ATTR::ATTR_MAX), M_POLICY.data()) < 0 ||
+        !attrs[static_cast<int>(ATTR::ATTR_TOPIC)]) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Dropping malformed published message");
+        return;
+    }
+    uint32_t const topic = nla_get_u32(attrs[static_cast<int>(ATTR::ATTR_TOPIC)]);
+    auto it = m_subscriptions.find(topic);
+    if (it == m_subscriptions.end()) {
+        NETLINK_LOG(LOG_DEBUG, "Dropping published reply on topic %u without subscription", topic);
+        return;
+    }
+
+    Response response;
+    response.more = (nlh->nlmsg_flags & NLM_F_MULTI) != 0;
+    if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+        response.payload = get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)]);
+    }
+    if (attrs[static_cast<int>(ATTR::ATTR_RESULT)]) {
+        response.result = static_cast<int64_t>(nla_get_s64(attrs[static_cast<int>(ATTR::ATTR_RESULT)]));
+    }
+    if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+        response.error = nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]);
+    }
+    // Копия: обработчик может отменить подписку
+    ResponseHandler handler = it->second;
+    try {
+        handler(response);
+    } catch (std::exception &ex) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Subscription handler for topic %u failed: %s", topic, ex.what());
+    }
+}
+
+std::string netlink::client::Client::get_string(struct nlattr *attr) {
+    auto const *data = static_cast<const char *>(nla_data(attr));
+    return std::string(data, strnlen(data, nla_len(attr)));
+}
+
+const char *netlink::client::Client::action_name(OP op) {
+    switch (op) {
+        case OP::OP_ADD:
+            return "add";
+        case OP::OP_SUB:
+            return "sub";
+        case OP::OP_MUL:
+            return "mul";
+        case OP::OP_DIV:
+            return "div";
+        case OP::OP_MOD:
+            return "mod";
+        default:
+            return nullptr;
+    }
+}
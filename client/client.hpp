@@ -1,38 +1,152 @@
 #pragma once
 #include <netlink/genl/ctrl.h>
+#include <netlink/genl/family.h>
 #include <netlink/genl/genl.h>
 #include <netlink/netlink.h>
-#include <syslog.h>
 #include <unistd.h>
 
+#include <array>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/event_loop.hpp"
+#include "../common/logger.hpp"
+#include "../transport/shm_channel.hpp"
+#include "../transport/transport.hpp"
 
 static_assert(sizeof(int) == 4);
 
 //@todo: по хорошему надо сделать свои исключения
-//@todo: по хорошему надо сделать свой логгер
 
 namespace netlink::client {
 
 enum class ATTR : int {
     ATTR_UNSPEC,
     ATTR_MSG,
+    ATTR_BATCH,
+    ATTR_OP,
+    ATTR_ARG1,
+    ATTR_ARG2,
+    ATTR_RESULT,
+    ATTR_ERRNO,
+    ATTR_ARRAY1,
+    ATTR_ARRAY2,
+    ATTR_RESULTS,
+    ATTR_OFFSET,
+    ATTR_STREAM,
+    ATTR_CHUNK,
+    ATTR_EOS,
+    ATTR_DATA,
+    ATTR_CREDITS,
+    ATTR_TOPIC,
     ATTR_MAX,
 };
 
+/**
+ * @brief Операции калькулятора.
+ *
+ * Значения передаются в атрибуте ATTR_OP бинарного протокола.
+ */
+enum class OP : uint8_t {
+    OP_UNSPEC,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_MAX,
+};
+
+/**
+ * @brief Реакция клиента на заполненное окно запросов в полете.
+ *
+ * Окно проверяется в клиенте до отправки, поэтому отказ синхронный (BusyError). Отказ ретранслятора,
+ * у серверов которого нет свободных мест, приходит позже как ответ: обработчик получает
+ * Response::error == EBUSY в любом режиме. Повторять операцию нужно в обоих случаях.
+ */
+enum class Admission {
+    BLOCK,  /**< Обрабатывать ответы, пока не освободится место (по умолчанию). */
+    REJECT, /**< Сразу отклонять операцию исключением BusyError. */
+};
+
+/**
+ * @brief Операция отклонена: окно запросов в полете заполнено (режим Admission::REJECT).
+ *
+ * Запрос не отправлен, обработчик не будет вызван; операцию можно повторить позже.
+ */
+class BusyError final : public std::runtime_error {
+   public:
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief Ответ на запрос клиента.
+ */
+struct Response {
+    int error = 0;       /**< 0 при успехе или код ошибки (errno), который вернуло ядро или сервер (EBUSY - у серверов нет мест). */
+    std::string payload; /**< Полезная нагрузка ответа (JSON или текст ошибки от сервера). */
+    int64_t result = 0;  /**< Результат операции (заполняется для запросов calc_async). */
+    bool more = false;   /**< Часть потокового ответа (NLM_F_MULTI): за ней последуют другие части. */
+};
+
+/**
+ * @brief Обработчик завершения запроса.
+ *
+ * Вызывается из контекста receive-цикла клиента, поэтому не должен блокироваться.
+ */
+using ResponseHandler = std::function<void(Response const &)>;
+/**
+ * @brief Обработчик завершения операции из пакета.
+ *
+ * Получает индекс операции в исходном пакете и ответ на неё.
+ */
+using BatchHandler = std::function<void(std::size_t index, Response const &)>;
+/**
+ * @brief Обработчик завершения операции над массивами.
+ *
+ * Получает 0 или код ошибки (errno) и результаты (при ошибке часть элементов может быть не заполнена).
+ */
+using ArrayHandler = std::function<void(int error, std::vector<int64_t> const &results)>;
+
 class Client final {
    public:
+    static constexpr std::size_t DEFAULT_MAX_IN_FLIGHT = 256;
+    static constexpr uint8_t BINARY_PROTOCOL_VERSION = 2;
+    static constexpr uint8_t ARRAY_PROTOCOL_VERSION = 3;
+    static constexpr uint8_t STREAM_PROTOCOL_VERSION = 4;
+    static constexpr uint8_t MULTICAST_PROTOCOL_VERSION = 7;
     /**
      * @brief Конструктор клиента Netlink.
      *
-     * Инициализирует клиент Netlink: выделяет сокет, устанавливает соединение,
-     * разрешает имя семейства Netlink и настраивает callback для обработки сообщений.
+     * Инициализирует клиент Netlink поверх транспорта Generic Netlink (GenlTransport):
+     * выделяет сокет, устанавливает соединение и разрешает имя семейства Netlink.
+     *
+     * @param max_in_flight Максимальное количество запросов, ожидающих ответа одновременно.
      *
      * @throw std::runtime_error Если не удалось выделить сокет, установить соединение или разрешить имя семейства.
      */
-    Client();
+    explicit Client(std::size_t max_in_flight = DEFAULT_MAX_IN_FLIGHT);
+    /**
+     * @brief Конструктор клиента поверх заданного транспорта.
+     *
+     * Версия протокола (JSON или бинарный) определяется по транспорту.
+     *
+     * @param transport Транспорт для отправки запросов и приема ответов.
+     * @param max_in_flight Максимальное количество запросов, ожидающих ответа одновременно.
+     */
+    explicit Client(std::unique_ptr<transport::Transport> transport, std::size_t max_in_flight = DEFAULT_MAX_IN_FLIGHT);
     Client(Client const &) = delete;
     Client(Client &&) = delete;
     Client &operator=(Client const &) = delete;
@@ -48,33 +162,460 @@ class Client final {
      * @throw std::runtime_error Если не удалось создать сообщение, прикрепить данные, или если отправка завершилась ошибкой.
      */
     void send_request(const nlohmann::json &request_json);
+    /**
+     * @brief Асинхронно отправляет запрос в Netlink.
+     *
+     * Запрос получает собственный номер последовательности, по которому ответ сопоставляется
+     * с обработчиком. Если количество запросов в полете достигло лимита, метод обрабатывает
+     * входящие ответы, пока не освободится место. Если сервер отвечает частями (например,
+     * на запрос над массивами), обработчик вызывается для каждой части, у всех частей кроме
+     * последней Response::more равен true.
+     *
+     * Если задана тема, ретранслятор рассылает ответ сервера, кроме этого клиента, всем подписчикам
+     * темы (subscribe): запрос, нужный многим процессам, вычисляется один раз.
+     *
+     * @param request_json JSON-объект с запросом.
+     * @param on_response Обработчик, который будет вызван при получении ответа или ошибки.
+     * @param topic Тема рассылки ответа (0 - ответ получает только этот клиент).
+     *
+     * @return Номер последовательности отправленного сообщения.
+     *
+     * @throw std::runtime_error Если не удалось создать сообщение, прикрепить данные, если отправка завершилась ошибкой
+     *                           или задана тема, а семейство не поддерживает рассылку (версия ниже MULTICAST_PROTOCOL_VERSION).
+     * @throw BusyError Если включен режим Admission::REJECT и окно запросов в полете заполнено.
+     */
+    uint32_t send_request_async(const nlohmann::json &request_json, ResponseHandler on_response, uint32_t topic = 0);
+    /**
+     * @brief Асинхронно отправляет пакет запросов.
+     *
+     * Операции упаковываются во вложенный атрибут ATTR_BATCH, так что одно сообщение Netlink
+     * несет сотни операций. Если пакет не помещается в M_MAX_BATCH_SIZE байт, он автоматически
+     * разбивается на несколько сообщений; каждое из них занимает одно место в окне запросов в полете.
+     *
+     * @param requests Список JSON-запросов.
+     * @param on_response Обработчик, который будет вызван для каждой операции пакета.
+     *
+     * @throw std::runtime_error Если запрос длиннее M_MAX_PAYLOAD_SIZE, не удалось создать или отправить сообщение.
+     * @throw BusyError Если включен режим Admission::REJECT и окно запросов в полете заполнено.
+     */
+    void send_batch_async(std::vector<nlohmann::json> const &requests, BatchHandler on_response);
+    /**
+     * @brief Асинхронно выполняет операцию калькулятора.
+     *
+     * Если включен канал в общей памяти (enable_shm), операция передается через него.
+     * Иначе, если модуль ядра поддерживает бинарный протокол (версия семейства не ниже
+     * BINARY_PROTOCOL_VERSION), операция и аргументы передаются атрибутами ATTR_OP, ATTR_ARG1,
+     * ATTR_ARG2 без JSON. Иначе запрос отправляется в формате JSON, а ответ разбирается в Response::result.
+     *
+     * @param op Операция.
+     * @param arg1 Первый аргумент.
+     * @param arg2 Второй аргумент.
+     * @param on_response Обработчик, который получит результат в Response::result или код ошибки
+     *                    (ERANGE - переполнение int64, EDOM - деление на ноль).
+     *
+     * @return Номер последовательности отправленного сообщения.
+     *
+     * @throw std::runtime_error Если операция неизвестна, не удалось создать или отправить сообщение.
+     * @throw BusyError Если включен режим Admission::REJECT и окно запросов в полете заполнено.
+     */
+    uint32_t calc_async(OP op, int64_t arg1, int64_t arg2, ResponseHandler on_response);
+    /**
+     * @brief Асинхронно выполняет операцию над массивами: results[i] = arg1[i] op arg2[i].
+     *
+     * Массивы любой длины разбиваются на запросы до M_ARRAY_CHUNK элементов (атрибуты ATTR_ARRAY1,
+     * ATTR_ARRAY2; при версии семейства ниже ARRAY_PROTOCOL_VERSION - JSON-запросы до M_JSON_ARRAY_CHUNK
+     * элементов). Сервер возвращает результат каждого запроса частями, которые записываются в общий
+     * массив результатов по смещению. Каждый запрос занимает одно место в окне запросов в полете.
+     *
+     * @param on_response Обработчик, вызываемый один раз после ответов на все запросы.
+     *
+     * Вычисление выполняется по модулю 2^64 (без проверки переполнения), div и mod не поддерживаются.
+     *
+     * @throw std::runtime_error Если операция неизвестна или не поддерживается для массивов, длины массивов различаются,
+     *                           не удалось создать или отправить сообщение.
+     * @throw BusyError Если включен режим Admission::REJECT и окно запросов в полете заполнено.
+     */
+    void calc_array_async(OP op, std::span<int64_t const> arg1, std::span<int64_t const> arg2, ArrayHandler on_response);
+    /**
+     * @brief Асинхронно отправляет JSON-запрос любого размера потоком фрагментов.
+     *
+     * Запрос делится на фрагменты до M_STREAM_CHUNK байт (ATTR_STREAM, ATTR_CHUNK, ATTR_DATA,
+     * у последнего ATTR_EOS), каждый фрагмент - отдельное сообщение в окне запросов в полете,
+     * поэтому в памяти ядра и сокетов одновременно находится не больше окна фрагментов.
+     * Ретранслятор направляет все фрагменты потока одному серверу, сервер собирает запрос
+     * и отвечает так же частями. Если фрагмент отклонен, оставшиеся не отправляются:
+     * поток завершается пустым фрагментом с ATTR_EOS.
+     *
+     * @param payload Запрос; данные копируются в сообщения, буфер можно освободить после возврата.
+     * @param on_response Обработчик, вызываемый один раз с собранным ответом или ошибкой.
+     *
+     * @throw std::runtime_error Если семейство не поддерживает потоки (версия ниже STREAM_PROTOCOL_VERSION),
+     *                           не удалось создать или отправить сообщение.
+     * @throw BusyError Если включен режим Admission::REJECT и окно запросов в полете заполнено.
+     */
+    void send_stream_async(std::string_view payload, ResponseHandler on_response);
+    /**
+     * @brief Отменяет ожидание ответа на запрос: обработчик больше не будет вызван.
+     *
+     * Если ответ придет позже, он будет отброшен как сообщение с неизвестным номером
+     * (ответ из общей памяти - как ответ отмененной операции).
+     *
+     * @return true если запрос ожидал ответа.
+     */
+    bool cancel(uint32_t seq);
+    /**
+     * @brief Подписывается на ответы, которые ретранслятор рассылает по теме.
+     *
+     * При первой подписке транспорт открывает отдельный сокет в группе рассылки "results" семейства:
+     * переполнение его буфера теряет только разосланные ответы (см. published_overflows), но не ответы
+     * на свои запросы. Разосланные ответы принимаются теми же методами, что и ответы на свои запросы
+     * (process_responses, process_available, цикл событий), и не занимают места в окне запросов
+     * в полете. Повторная подписка заменяет обработчик.
+     *
+     * @param topic Тема (не 0).
+     * @param on_result Обработчик каждого разосланного ответа: ATTR_MSG - в Response::payload, ATTR_RESULT -
+     *                  в Response::result, ATTR_ERRNO - в Response::error; у промежуточных частей Response::more равен true.
+     *
+     * @throw std::runtime_error Если тема равна 0, семейство не поддерживает рассылку (версия ниже
+     *                           MULTICAST_PROTOCOL_VERSION) или транспорт не смог вступить в группу.
+     */
+    void subscribe(uint32_t topic, ResponseHandler on_result);
+    /**
+     * @brief Отменяет подписку на тему (сокет рассылки остается в группе, ответы темы отбрасываются).
+     *
+     * @return true если подписка была.
+     */
+    bool unsubscribe(uint32_t topic);
+    /**
+     * @brief Включает или выключает накопление отправляемых сообщений.
+     *
+     * Пока накопление включено, новые запросы не отправляются сразу, а дописываются в буфер
+     * и уходят одной датаграммой при вызове flush. Буфер также сбрасывается автоматически,
+     * когда он заполнен, окно запросов в полете исчерпано или клиент начинает ждать ответы.
+     * При выключении накопленные сообщения отправляются.
+     */
+    void cork(bool enabled);
+    /**
+     * @brief Отправляет накопленные сообщения одной датаграммой.
+     *
+     * @throw std::runtime_error Если отправка завершилась ошибкой (запросы из буфера завершаются с этой ошибкой).
+     */
+    void flush();
+    /**
+     * @brief Принимает и обрабатывает очередную порцию ответов.
+     *
+     * Блокируется до получения хотя бы одной датаграммы из транспорта. Накопленные
+     * сообщения перед этим отправляются.
+     *
+     * @throw std::runtime_error Если при получении сообщения произошла ошибка или транспорт закрыт.
+     */
+    void process_responses();
+    /**
+     * @brief Обрабатывает все уже принятые транспортом ответы, не блокируясь.
+     *
+     * @return Количество обработанных датаграмм и ответов из общей памяти.
+     *
+     * @throw std::runtime_error Если при получении сообщения произошла ошибка или транспорт закрыт.
+     */
+    std::size_t process_available();
     /**
      * @brief Ожидает ответы от Netlink.
      *
      * Блокирующий метод, который слушает входящие сообщения от Netlink
-     * до возникновения ошибки или завершения работы.
+     * до получения ответов на все отправленные запросы или до возникновения ошибки.
      */
     void wait_for_response();
+    /**
+     * @brief Подключает клиента к циклу событий.
+     *
+     * Транспорт переводится в неблокирующий режим, ответы обрабатываются циклом по готовности
+     * дескриптора, а запросы с истекшим сроком (set_timeout) завершаются ошибкой ETIMEDOUT.
+     * Цикл должен пережить клиента или отключение через detach. Блокирующие методы
+     * (process_responses, wait_for_response) продолжают работать, ожидая готовности через poll.
+     *
+     * @throw std::runtime_error Если у транспорта нет дескриптора, его не удалось перевести в неблокирующий режим
+     * или включен канал в общей памяти (его ответы не пробуждают цикл событий).
+     */
+    void attach(common::EventLoop &loop);
+    /**
+     * @brief Отключает клиента от цикла событий (сроки уже отправленных запросов отменяются).
+     */
+    void detach();
+    /**
+     * @brief Срок ожидания ответа для новых запросов в режиме цикла событий (0 - без срока).
+     */
+    void set_timeout(std::chrono::milliseconds timeout) { m_timeout = timeout; }
+    /**
+     * @brief Реакция на заполненное окно запросов в полете для новых операций.
+     *
+     * В режиме Admission::REJECT операция, для первого сообщения которой в окне нет места,
+     * отклоняется исключением BusyError, не дожидаясь ответов. Остальные сообщения уже принятой
+     * операции (пакета, массивов, потока) ожидают места, как в режиме Admission::BLOCK.
+     */
+    void set_admission(Admission admission) { m_admission = admission; }
+    /**
+     * @brief Включает обмен операциями calc_async через общую память.
+     *
+     * Создает канал ShmChannel и передает его имя серверу обычным JSON-запросом {"shm": имя}.
+     * Если сервер принял канал, операции калькулятора передаются записями фиксированного размера
+     * напрямую серверу, минуя ядро; остальные запросы по-прежнему идут через Netlink. Если сервер
+     * отказал (например, старая версия или другая машина), клиент продолжает работать через Netlink.
+     * Не поддерживается в режиме цикла событий.
+     *
+     * @param capacity Емкость очередей канала в записях.
+     *
+     * @return true если канал включен.
+     *
+     * @throw std::runtime_error Если при ожидании ответа сервера произошла ошибка транспорта.
+     */
+    bool enable_shm(std::size_t capacity = transport::ShmChannel::DEFAULT_CAPACITY);
+    /**
+     * @brief Включен ли канал в общей памяти.
+     */
+    bool shm_enabled() const { return m_shm != nullptr; }
+    /**
+     * @brief Количество запросов, ожидающих ответа.
+     */
+    std::size_t in_flight() const { return m_pending.size() + m_shm_pending.size() - m_shm_cancelled; }
+    /**
+     * @brief Количество переполнений буфера приема (ENOBUFS), о которых сообщил транспорт.
+     */
+    uint64_t overflows() const { return m_overflows; }
+    /**
+     * @brief Количество переполнений буфера сокета рассылки: часть разосланных ответов потеряна.
+     */
+    uint64_t published_overflows() const { return m_published_overflows; }
+    /**
+     * @brief Версия семейства Netlink, определенная при подключении.
+     */
+    uint8_t protocol_version() const { return m_version; }
 
    private:
+    using nl_msg_ptr = std::unique_ptr<nl_msg, void (*)(nl_msg *)>;
+    /**
+     * @brief Внутренний обработчик ответа.
+     *
+     * Получает код ошибки и разобранные атрибуты ответа (nullptr, если ответа нет).
+     */
+    using MessageHandler = std::function<void(int error, struct nlattr **attrs)>;
+    /**
+     * @brief Запрос, ожидающий ответа.
+     */
+    struct Pending {
+        MessageHandler handler;               // 32
+        MessageHandler on_part;               // 32 обработчик частей потокового ответа (NLM_F_MULTI) или пустой
+        common::EventLoop::TimerId timer = 0; // 8 таймер срока ответа или 0
+    };
+    /**
+     * @brief Операция, отправленная через общую память. Сервер отвечает в порядке запросов.
+     */
+    struct ShmPending {
+        ResponseHandler handler; // 32 пустой для отмененной операции
+        uint32_t seq;            // 4
+    };
+
+    /**
+     * @brief Выделяет номер последовательности (0 не используется).
+     */
+    uint32_t next_seq();
+    /**
+     * @brief Проверяет, можно ли начать новую операцию.
+     *
+     * @throw BusyError Если включен режим Admission::REJECT и окно запросов в полете заполнено.
+     */
+    void admit() const;
+
+    /**
+     * @brief Создает сообщение с новым номером последовательности.
+     *
+     * Если окно запросов в полете заполнено, сначала обрабатывает входящие ответы.
+     *
+     * @param seq Номер последовательности созданного сообщения.
+     * @param size Размер буфера сообщения.
+     *
+     * @throw std::runtime_error Если не удалось создать сообщение или заголовок.
+     */
+    nl_msg_ptr create_message(uint32_t &seq, std::size_t size);
+    /**
+     * @brief Отправляет сообщение и регистрирует обработчик ответа.
+     *
+     * @param handler Обработчик последнего (или единственного) сообщения ответа или ошибки.
+     * @param on_part Обработчик частей ответа, помеченных NLM_F_MULTI (запрос остается в полете).
+     *
+     * @throw std::runtime_error Если отправка завершилась ошибкой.
+     */
+    void send_message(nl_msg_ptr msg, uint32_t seq, MessageHandler handler, MessageHandler on_part = {});
+    /**
+     * @brief Отправляет сообщение с JSON-запросом и передает обработчику ответ ATTR_MSG и его части.
+     *
+     * @throw std::runtime_error Если отправка завершилась ошибкой.
+     */
+    void send_json_message(nl_msg_ptr msg, uint32_t seq, ResponseHandler on_response);
+    /**
+     * @brief Обработчик сообщения, принятого из транспорта.
+     *
+     * Находит ожидающий запрос по номеру последовательности (сообщения с неизвестным номером
+     * отбрасываются), разбирает полезную нагрузку или сообщение об ошибке (NLMSG_ERROR)
+     * и передает результат обработчику запроса.
+     *
+     * @param nlh Заголовок сообщения Netlink в буфере приема.
+     */
+    void receive_message(struct nlmsghdr *nlh);
     /**
-     * @brief Callback для получения сообщений от Netlink.
+     * @brief Передает разосланный ответ (номер последовательности 0, ATTR_TOPIC) обработчику подписки.
+     *
+     * Ответы тем без подписки отбрасываются.
+     *
+     * @param nlh Заголовок сообщения Netlink в буфере приема.
+     */
+    void receive_published(struct nlmsghdr *nlh);
+    /**
+     * @brief Принимает все разосланные ответы, уже лежащие в сокете рассылки (не блокируется).
+     *
+     * Переполнение сокета рассылки (ENOBUFS) только учитывается в published_overflows:
+     * запросы в полете ждут ответы в основном транспорте и не затрагиваются.
+     *
+     * @return Количество принятых датаграмм (0 - сокета рассылки нет или датаграмм нет).
+     *
+     * @throw std::runtime_error Если при получении произошла ошибка или сокет закрыт.
+     */
+    std::size_t receive_subscription();
+    /**
+     * @brief Принимает до M_RX_BATCH датаграмм за один вызов транспорта и обрабатывает их сообщения.
+     *
+     * При переполнении буфера приема (ENOBUFS) запоминает, что ответы на уже отправленные
+     * запросы могли быть потеряны; когда очередь сокета опустеет (EAGAIN), такие запросы
+     * без срока ответа завершаются ошибкой ENOBUFS (см. recover_lost).
+     *
+     * @return Количество принятых датаграмм, 0 если датаграмм нет (EAGAIN) или сообщено о переполнении.
+     *
+     * @throw std::runtime_error Если при получении произошла ошибка или транспорт закрыт.
+     */
+    std::size_t receive_datagrams();
+    /**
+     * @brief Завершает ошибкой ENOBUFS запросы без срока ответа, отправленные до переполнения и оставшиеся без ответа.
+     *
+     * Ответ такого запроса мог быть не потерян, а еще не отправлен сервером. Запросы со сроком
+     * (set_timeout в цикле событий) остаются в полете: их завершит ответ или истечение срока (ETIMEDOUT).
+     */
+    void recover_lost();
+    /**
+     * @brief Обрабатывает ответы, уже лежащие в очереди канала общей памяти.
+     *
+     * Ответы извлекаются порциями в m_shm_replies, поэтому вложенный вызов из обработчика
+     * продолжает ту же порцию и порядок ответов сохраняется.
      *
-     * Обрабатывает входящее сообщение: разбирает его, получает полезную нагрузку и выводит её в лог.
+     * @return Количество обработанных ответов.
+     */
+    std::size_t receive_shm();
+    /**
+     * @brief Ожидает ответы из общей памяти (при смешанной нагрузке - попеременно с Netlink).
+     */
+    void wait_shm();
+    /**
+     * @brief Закрывает канал общей памяти и завершает его операции ошибкой.
+     */
+    void close_shm(int error);
+    /**
+     * @brief Обработчик готовности дескриптора в цикле событий: принимает все доступные датаграммы.
+     */
+    void on_readable();
+    /**
+     * @brief Обработчик готовности сокета рассылки в цикле событий.
+     */
+    void on_published();
+    /**
+     * @brief Ожидает готовности основного транспорта или сокета рассылки (poll).
      *
-     * @note Callback выполняется автоматически при получении сообщения.
+     * @throw std::runtime_error Если у транспорта нет дескриптора или poll завершился ошибкой.
+     */
+    void wait_readable();
+    /**
+     * @brief Завершает запрос, срок ответа на который истек, ошибкой ETIMEDOUT.
+     */
+    void expire(uint32_t seq);
+    /**
+     * @brief Завершает ожидающий запрос и вызывает его обработчик.
      *
-     * @param msg Указатель на сообщение Netlink.
-     * @param arg Дополнительный аргумент, который можно использовать при обработке (не используется здесь).
+     * @param seq Номер последовательности запроса.
+     * @param error 0 или код ошибки (errno).
+     * @param attrs Разобранные атрибуты ответа или nullptr.
+     */
+    void complete(uint32_t seq, int error, struct nlattr **attrs);
+    /**
+     * @brief Извлекает строку из атрибута, не выходя за его границы.
+     */
+    static std::string get_string(struct nlattr *attr);
+    /**
+     * @brief Имя действия JSON-запроса для операции.
      *
-     * @return NL_OK при успешной обработке сообщения или код ошибки в противном случае.
+     * @return Имя действия или nullptr для неизвестной операции.
+     */
+    static const char *action_name(OP op);
+
+    /**
+     * @brief Политика проверки атрибутов ответа (типы повторяют calc_policy модуля ядра).
      */
-    static int receive_message(struct nl_msg *msg, void *arg);
+    static constexpr std::array<nla_policy, static_cast<int>(ATTR::ATTR_MAX) + 1> M_POLICY = [] {
+        std::array<nla_policy, static_cast<int>(ATTR::ATTR_MAX) + 1> policy{};
+        policy[static_cast<int>(ATTR::ATTR_MSG)] = {NLA_STRING, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_BATCH)] = {NLA_NESTED, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_OP)] = {NLA_U8, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARG1)] = {NLA_S64, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARG2)] = {NLA_S64, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_RESULT)] = {NLA_S64, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ERRNO)] = {NLA_S32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARRAY1)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARRAY2)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_RESULTS)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_OFFSET)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_STREAM)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_CHUNK)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_EOS)] = {NLA_FLAG, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_DATA)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_CREDITS)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_TOPIC)] = {NLA_U32, 0, 0};
+        return policy;
+    }();
 
-    struct nl_sock *m_sock = nullptr;                                 // 8
-    static constexpr const char *const M_FAMILY_NAME = "calc_family"; // 8
+    static constexpr std::size_t M_MAX_PAYLOAD_SIZE = 1024;           // 8
+    static constexpr std::size_t M_CALC_REQUEST_SIZE = 96;            // 8 JSON-запрос calc_async: действие и два int64
+    static constexpr std::size_t M_MAX_BATCH_SIZE = 16384;            // 8
+    static constexpr std::size_t M_RX_BUFFER_SIZE = 65536;            // 8
+    static constexpr std::size_t M_RX_BATCH = 8;                      // 8 датаграмм за один вызов приема
+    static constexpr std::size_t M_TX_BUFFER_SIZE = 32768;            // 8
+    static constexpr std::size_t M_SHM_BATCH = 64;                    // 8 ответов из общей памяти за одно извлечение
+    static constexpr std::size_t M_ARRAY_CHUNK = 2048;                // 8 элементов в одном запросе над массивами
+    static constexpr std::size_t M_JSON_ARRAY_CHUNK = 16;             // 8 помещается в ограничение ATTR_MSG модуля
+    static constexpr std::size_t M_STREAM_CHUNK = 16384;              // 8 байт во фрагменте потока (DATA_MAX_LEN модуля)
+    std::unordered_map<uint32_t, Pending> m_pending;                  // 56
+    std::unordered_map<uint32_t, ResponseHandler> m_subscriptions;    // 56 тема -> обработчик разосланных ответов
+    std::deque<ShmPending> m_shm_pending;                             // 80
+    std::array<transport::ShmReply, M_SHM_BATCH> m_shm_replies;       // 1024
+    std::unique_ptr<transport::ShmChannel> m_shm;                     // 8
+    std::vector<char> m_rx_buffer;                                    // 24 M_RX_BATCH буферов по M_RX_BUFFER_SIZE
+    std::array<transport::Datagram, M_RX_BATCH> m_rx_datagrams;       // 192
+    std::vector<char> m_tx_buffer;                                    // 24 накопленные сообщения
+    std::vector<uint32_t> m_tx_seqs;                                  // 24 номера накопленных сообщений
+    std::unique_ptr<transport::Transport> m_transport;                // 8
+    std::unique_ptr<transport::Transport> m_subscription;             // 8 сокет рассылки (nullptr - рассылка приходит в m_transport)
+    std::size_t m_max_in_flight = DEFAULT_MAX_IN_FLIGHT;              // 8
+    common::EventLoop *m_loop = nullptr;                              // 8
+    std::chrono::milliseconds m_timeout{0};                           // 8
+    uint64_t m_overflows = 0;                                         // 8
+    uint64_t m_published_overflows = 0;                               // 8
+    std::size_t m_shm_cancelled = 0;                                  // 8 отмененные операции в m_shm_pending
+    std::size_t m_shm_reply_pos = 0;                                  // 8 следующий ответ в m_shm_replies
+    std::size_t m_shm_reply_count = 0;                                // 8
     static constexpr int M_COMMAND_CLIENT = 1;                        // 4
-    int m_family_id = 0;                                              // 4
+    uint32_t m_next_seq = 1;                                          // 4
+    uint32_t m_overflow_seq = 0;                                      // 4 запросы с меньшими номерами могли потерять ответ
+    uint32_t m_next_stream = 0;                                       // 4 последний идентификатор потока фрагментов
+    Admission m_admission = Admission::BLOCK;                         // 4
+    uint8_t m_version = 1;                                            // 1
+    bool m_corked = false;                                            // 1
+    bool m_overflowed = false;                                        // 1 ожидается восстановление после переполнения
+    bool m_joined = false;                                            // 1 клиент вступил в группу рассылки
 };
 
 } // namespace netlink::client
\ No newline at end of file
@@ -0,0 +1,76 @@
+#include "coroutine.hpp"
+
+#include <algorithm>
+
+void netlink::client::Scheduler::Operation::await_suspend(std::coroutine_handle<> handle) {
+    // Исключение из calc_async пробрасывается в ожидающую корутину
+    m_seq = m_scheduler.m_client.calc_async(m_op, m_arg1, m_arg2, [this, handle](Response const &response) {
+        m_seq = 0;
+        m_response = response;
+        m_scheduler.m_ready.push_back(handle);
+    });
+}
+
+netlink::client::Scheduler::Operation::~Operation() {
+    if (m_seq != 0) {
+        m_scheduler.m_client.cancel(m_seq);
+    }
+}
+
+netlink::client::Scheduler::Scheduler(Client &client) : m_client(client) { m_client.cork(true); }
+
+netlink::client::Scheduler::~Scheduler() {
+    // Кадры незавершенных задач уничтожаются вместе с m_tasks и отменяют ожидание своих ответов
+    try {
+        m_client.cork(false);
+    } catch (std::exception &ex) {
+        NETLINK_LOG(LOG_ERR, "Failed to flush pending requests: %s", ex.what());
+    }
+}
+
+void netlink::client::Scheduler::spawn(Task<void> task) {
+    if (task.done()) {
+        return;
+    }
+    m_ready.push_back(task.handle());
+    m_tasks.push_back(std::move(task));
+}
+
+void netlink::client::Scheduler::run() {
+    while (poll() != 0) {
+        if (m_ready.empty()) {
+            if (m_client.in_flight() == 0) {
+                NETLINK_LOG(LOG_ERR, "%zu coroutines are suspended without requests in flight", m_tasks.size());
+                throw std::runtime_error("Coroutines are suspended without requests in flight");
+            }
+            // Ответы, пришедшие за время ожидания, обрабатываются вместе, чтобы их запросы ушли одной датаграммой
+            m_client.process_responses();
+            m_client.process_available();
+        }
+    }
+}
+
+std::size_t netlink::client::Scheduler::poll() {
+    resume_ready();
+    m_client.flush();
+    return m_tasks.size();
+}
+
+void netlink::client::Scheduler::resume_ready() {
+    while (!m_ready.empty()) {
+        std::coroutine_handle<> handle = m_ready.front();
+        m_ready.pop_front();
+        handle.resume();
+    }
+
+    auto finished = std::partition(m_tasks.begin(), m_tasks.end(), [](Task<void> const &task) { return !task.done(); });
+    if (finished == m_tasks.end()) {
+        return;
+    }
+    // Задачи удаляются до проброса исключения, чтобы следующий run продолжил остальные
+    std::vector<Task<void>> done(std::make_move_iterator(finished), std::make_move_iterator(m_tasks.end()));
+    m_tasks.erase(finished, m_tasks.end());
+    for (auto &task : done) {
+        task.handle().promise().result();
+    }
+}
@@ -0,0 +1,242 @@
+#pragma once
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "client.hpp"
+
+namespace netlink::client {
+
+template <typename T = void>
+class Task;
+
+namespace detail {
+
+/**
+ * @brief Общая часть promise_type для Task: ленивый старт и возврат управления ожидающей корутине.
+ */
+class PromiseBase {
+   public:
+    /**
+     * @brief Возобновляет корутину, которая ожидала завершения задачи (или возвращает управление планировщику).
+     */
+    struct FinalAwaiter {
+        bool await_ready() const noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept {
+            return handle.promise().m_continuation;
+        }
+        void await_resume() const noexcept {}
+    };
+
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+    void unhandled_exception() noexcept { m_exception = std::current_exception(); }
+    void set_continuation(std::coroutine_handle<> continuation) noexcept { m_continuation = continuation; }
+    /**
+     * @brief Пробрасывает исключение, которым завершилась задача.
+     */
+    void rethrow() const {
+        if (m_exception) {
+            std::rethrow_exception(m_exception);
+        }
+    }
+
+   private:
+    std::coroutine_handle<> m_continuation = std::noop_coroutine(); // 8
+    std::exception_ptr m_exception;                                 // 8
+};
+
+template <typename T>
+class Promise final : public PromiseBase {
+   public:
+    Task<T> get_return_object() noexcept;
+    void return_value(T value) { m_value.emplace(std::move(value)); }
+    T result() {
+        rethrow();
+        return std::move(*m_value);
+    }
+
+   private:
+    std::optional<T> m_value;
+};
+
+template <>
+class Promise<void> final : public PromiseBase {
+   public:
+    Task<void> get_return_object() noexcept;
+    void return_void() const noexcept {}
+    void result() const { rethrow(); }
+};
+
+} // namespace detail
+
+/**
+ * @brief Корутина, возвращающая значение типа T.
+ *
+ * Запускается лениво: тело начинает выполняться, когда задачу ожидают через co_await
+ * или передают планировщику (Scheduler::spawn). Владеет кадром корутины.
+ */
+template <typename T>
+class [[nodiscard]] Task final {
+   public:
+    using promise_type = detail::Promise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    Task() = default;
+    explicit Task(handle_type handle) noexcept : m_handle(handle) {}
+    Task(Task const &) = delete;
+    Task(Task &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Task &operator=(Task const &) = delete;
+    Task &operator=(Task &&other) noexcept {
+        if (this != &other) {
+            reset();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    ~Task() { reset(); }
+
+    bool await_ready() const noexcept { return !m_handle || m_handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        m_handle.promise().set_continuation(awaiting);
+        return m_handle;
+    }
+    T await_resume() { return m_handle.promise().result(); }
+
+    /**
+     * @brief Дескриптор кадра корутины.
+     */
+    handle_type handle() const noexcept { return m_handle; }
+    /**
+     * @brief Завершилась ли корутина.
+     */
+    bool done() const noexcept { return !m_handle || m_handle.done(); }
+
+   private:
+    void reset() noexcept {
+        if (m_handle) {
+            m_handle.destroy();
+            m_handle = {};
+        }
+    }
+
+    handle_type m_handle; // 8
+};
+
+template <typename T>
+Task<T> detail::Promise<T>::get_return_object() noexcept {
+    return Task<T>(Task<T>::handle_type::from_promise(*this));
+}
+
+inline Task<void> detail::Promise<void>::get_return_object() noexcept { return Task<void>(Task<void>::handle_type::from_promise(*this)); }
+
+/**
+ * @brief Однопоточный планировщик корутин поверх клиента Netlink.
+ *
+ * Корутины ожидают ответы через co_await calc/add/sub/mul. За одну итерацию планировщик
+ * возобновляет все корутины, ответы для которых готовы, и отправляет все запросы, созданные
+ * ими за итерацию, одной датаграммой (см. Client::cork). Затем блокируется до следующей
+ * порции ответов. Ответы не возобновляют корутины изнутри receive-цикла клиента, поэтому
+ * корутины могут свободно отправлять новые запросы.
+ *
+ * Планировщик не потокобезопасен: клиент и все корутины должны использоваться из одного потока.
+ */
+class Scheduler final {
+   public:
+    /**
+     * @brief Ожидание ответа на операцию калькулятора.
+     *
+     * Запрос отправляется при приостановке корутины, результат co_await - Response.
+     */
+    class Operation final {
+       public:
+        Operation(Scheduler &scheduler, OP op, int64_t arg1, int64_t arg2) noexcept
+            : m_scheduler(scheduler), m_arg1(arg1), m_arg2(arg2), m_op(op) {}
+        Operation(Operation const &) = delete;
+        Operation(Operation &&) = delete;
+        Operation &operator=(Operation const &) = delete;
+        Operation &operator=(Operation &&) = delete;
+        /**
+         * @brief Если кадр корутины уничтожается до ответа, ожидание ответа отменяется.
+         */
+        ~Operation();
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> handle);
+        Response await_resume() noexcept { return std::move(m_response); }
+
+       private:
+        Response m_response;     // 48
+        Scheduler &m_scheduler;  // 8
+        int64_t m_arg1;          // 8
+        int64_t m_arg2;          // 8
+        uint32_t m_seq = 0;      // 4 номер запроса, пока ответ не получен
+        OP m_op;                 // 1
+    };
+
+    /**
+     * @brief Конструктор планировщика.
+     *
+     * Включает накопление отправляемых сообщений клиента на время жизни планировщика.
+     *
+     * @param client Клиент, через который отправляются запросы. Должен пережить планировщик.
+     */
+    explicit Scheduler(Client &client);
+    Scheduler(Scheduler const &) = delete;
+    Scheduler(Scheduler &&) = delete;
+    Scheduler &operator=(Scheduler const &) = delete;
+    Scheduler &operator=(Scheduler &&) = delete;
+    ~Scheduler();
+
+    /**
+     * @brief Асинхронно выполняет операцию калькулятора.
+     */
+    Operation calc(OP op, int64_t arg1, int64_t arg2) noexcept { return Operation(*this, op, arg1, arg2); }
+    Operation add(int64_t arg1, int64_t arg2) noexcept { return calc(OP::OP_ADD, arg1, arg2); }
+    Operation sub(int64_t arg1, int64_t arg2) noexcept { return calc(OP::OP_SUB, arg1, arg2); }
+    Operation mul(int64_t arg1, int64_t arg2) noexcept { return calc(OP::OP_MUL, arg1, arg2); }
+    Operation div(int64_t arg1, int64_t arg2) noexcept { return calc(OP::OP_DIV, arg1, arg2); }
+    Operation mod(int64_t arg1, int64_t arg2) noexcept { return calc(OP::OP_MOD, arg1, arg2); }
+
+    /**
+     * @brief Передает задачу планировщику. Задача начнет выполняться в run или poll.
+     */
+    void spawn(Task<void> task);
+    /**
+     * @brief Выполняет задачи, пока все они не завершатся.
+     *
+     * @throw std::runtime_error Если задачи ожидают, но запросов в полете нет, или при ошибке клиента.
+     * @throw Исключение, которым завершилась одна из задач (остальные задачи продолжат работу при следующем вызове).
+     */
+    void run();
+    /**
+     * @brief Неблокирующая итерация: возобновляет готовые корутины и отправляет их запросы.
+     *
+     * Предназначена для клиента, подключенного к циклу событий (Client::attach): вызывается
+     * после каждой итерации EventLoop::run_once.
+     *
+     * @return Количество незавершенных задач.
+     */
+    std::size_t poll();
+    /**
+     * @brief Количество незавершенных задач.
+     */
+    std::size_t active() const { return m_tasks.size(); }
+
+   private:
+    /**
+     * @brief Возобновляет готовые корутины и удаляет завершенные задачи.
+     */
+    void resume_ready();
+
+    std::deque<std::coroutine_handle<>> m_ready; // 80 корутины, ответы для которых получены
+    std::vector<Task<void>> m_tasks;             // 24
+    Client &m_client;                            // 8
+};
+
+} // namespace netlink::client
@@ -0,0 +1,187 @@
+#include "event_loop.hpp"
+
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <stdexcept>
+
+#include "logger.hpp"
+
+netlink::common::EventLoop::EventLoop() : m_wheel(M_WHEEL_SIZE), m_current_tick(now_tick()) {
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (m_epoll_fd < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to create epoll: %s", strerror(errno));
+        throw std::runtime_error("Failed to create epoll");
+    }
+
+    m_wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (m_wakeup_fd < 0) {
+        close(m_epoll_fd);
+        NETLINK_LOG(LOG_ERR, "Failed to create eventfd: %s", strerror(errno));
+        throw std::runtime_error("Failed to create eventfd");
+    }
+    add(m_wakeup_fd, EPOLLIN, [this](uint32_t) {
+        uint64_t value = 0;
+        while (read(m_wakeup_fd, &value, sizeof(value)) > 0) {
+        }
+    });
+}
+
+netlink::common::EventLoop::~EventLoop() {
+    if (m_signal_fd >= 0) {
+        close(m_signal_fd);
+    }
+    close(m_wakeup_fd);
+    close(m_epoll_fd);
+}
+
+void netlink::common::EventLoop::add(int fd, uint32_t events, Callback callback) {
+    struct epoll_event event {};
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, fd, &event) < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to add descriptor %d to epoll: %s", fd, strerror(errno));
+        throw std::runtime_error("Failed to add descriptor to epoll");
+    }
+    m_callbacks[fd] = std::make_shared<Callback>(std::move(callback));
+}
+
+void netlink::common::EventLoop::remove(int fd) {
+    if (m_callbacks.erase(fd) != 0) {
+        epoll_ctl(m_epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+    }
+}
+
+netlink::common::EventLoop::TimerId netlink::common::EventLoop::add_timer(std::chrono::milliseconds delay, TimerCallback callback) {
+    // Таймер срабатывает не раньше задержки: +1 тик на неполный текущий
+    uint64_t const expiry = now_tick() + static_cast<uint64_t>(delay.count() > 0 ? delay.count() : 0) + 1;
+    TimerId const id = m_next_timer++;
+    m_timers.emplace(id, Timer{expiry, std::move(callback)});
+    m_wheel[expiry % M_WHEEL_SIZE].push_back(id);
+    return id;
+}
+
+bool netlink::common::EventLoop::cancel_timer(TimerId id) {
+    // Идентификатор в ячейке колеса удаляется лениво, при её обходе
+    return m_timers.erase(id) != 0;
+}
+
+void netlink::common::EventLoop::stop_on_signals(std::initializer_list<int> signals) {
+    sigset_t mask;
+    sigemptyset(&mask);
+    for (int signal : signals) {
+        sigaddset(&mask, signal);
+    }
+    pthread_sigmask(SIG_BLOCK, &mask, nullptr);
+
+    m_signal_fd = signalfd(-1, &mask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (m_signal_fd < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to create signalfd: %s", strerror(errno));
+        throw std::runtime_error("Failed to create signalfd");
+    }
+    add(m_signal_fd, EPOLLIN, [this](uint32_t) {
+        struct signalfd_siginfo info {};
+        while (read(m_signal_fd, &info, sizeof(info)) == static_cast<ssize_t>(sizeof(info))) {
+            NETLINK_LOG(LOG_INFO, "Received signal %u, stopping", info.ssi_signo);
+            stop();
+        }
+    });
+}
+
+void netlink::common::EventLoop::run() {
+    while (!stopped()) {
+        run_once();
+    }
+}
+
+std::size_t netlink::common::EventLoop::run_once(int timeout_ms) {
+    int const next = next_timeout();
+    if (timeout_ms < 0 || (next >= 0 && next < timeout_ms)) {
+        timeout_ms = next;
+    }
+
+    struct epoll_event events[M_MAX_EVENTS];
+    int ready = epoll_wait(m_epoll_fd, events, M_MAX_EVENTS, timeout_ms);
+    if (ready < 0) {
+        if (errno != EINTR) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "epoll_wait failed: %s", strerror(errno));
+        }
+        ready = 0;
+    }
+
+    std::size_t handled = 0;
+    for (int i = 0; i < ready; ++i) {
+        auto it = m_callbacks.find(events[i].data.fd);
+        // Дескриптор мог быть удален обработчиком предыдущего события
+        if (it == m_callbacks.end()) {
+            continue;
+        }
+        std::shared_ptr<Callback> callback = it->second;
+        (*callback)(events[i].events);
+        ++handled;
+    }
+    return handled + expire_timers();
+}
+
+void netlink::common::EventLoop::stop() {
+    m_stopped.store(true, std::memory_order_release);
+    uint64_t const value = 1;
+    if (write(m_wakeup_fd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        NETLINK_LOG(LOG_ERR, "Failed to wake up the event loop: %s", strerror(errno));
+    }
+}
+
+uint64_t netlink::common::EventLoop::now_tick() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+std::size_t netlink::common::EventLoop::expire_timers() {
+    uint64_t const now = now_tick();
+    std::size_t fired = 0;
+    // За один проход достаточно обойти колесо один раз, даже если цикл долго не вызывался
+    uint64_t const first = now - m_current_tick >= M_WHEEL_SIZE ? now - M_WHEEL_SIZE + 1 : m_current_tick + 1;
+    for (uint64_t tick = first; tick <= now; ++tick) {
+        std::vector<TimerId> &slot = m_wheel[tick % M_WHEEL_SIZE];
+        for (std::size_t i = 0; i < slot.size();) {
+            auto it = m_timers.find(slot[i]);
+            if (it != m_timers.end() && it->second.expiry_tick > now) {
+                ++i;
+                continue;
+            }
+            slot[i] = slot.back();
+            slot.pop_back();
+            if (it == m_timers.end()) {
+                continue;
+            }
+            // Обработчик может запускать и отменять таймеры, поэтому запись удаляется до вызова
+            TimerCallback callback = std::move(it->second.callback);
+            m_timers.erase(it);
+            callback();
+            ++fired;
+        }
+    }
+    m_current_tick = now;
+    return fired;
+}
+
+int netlink::common::EventLoop::next_timeout() const {
+    if (m_timers.empty()) {
+        return -1;
+    }
+    uint64_t const now = now_tick();
+    // Ячейка tick содержит таймеры со сроком tick, tick + M_WHEEL_SIZE, ...: ближайший - первый со сроком не позже tick
+    for (uint64_t tick = m_current_tick + 1; tick <= m_current_tick + M_WHEEL_SIZE; ++tick) {
+        for (TimerId id : m_wheel[tick % M_WHEEL_SIZE]) {
+            auto it = m_timers.find(id);
+            if (it != m_timers.end() && it->second.expiry_tick <= tick) {
+                return it->second.expiry_tick <= now ? 0 : static_cast<int>(it->second.expiry_tick - now);
+            }
+        }
+    }
+    // Все таймеры дальше одного оборота колеса
+    return static_cast<int>(M_WHEEL_SIZE);
+}
@@ -0,0 +1,132 @@
+#pragma once
+#include <sys/epoll.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace netlink::common {
+
+/**
+ * @brief Однопоточный цикл событий на epoll с таймерами.
+ *
+ * Обслуживает файловые дескрипторы (сокеты транспортов), таймеры (колесо таймеров с шагом
+ * 1 мс) и остановку по eventfd или сигналам (signalfd). Методы, кроме stop, вызываются
+ * из потока цикла. Цикл можно встроить в другой реактор: fd() готов к чтению, когда
+ * есть события, и тогда достаточно вызвать run_once(0).
+ */
+class EventLoop final {
+   public:
+    /**
+     * @brief Обработчик готовности дескриптора, получает маску событий epoll.
+     */
+    using Callback = std::function<void(uint32_t events)>;
+    using TimerCallback = std::function<void()>;
+    using TimerId = uint64_t;
+
+    /**
+     * @brief Создает epoll и eventfd для остановки.
+     *
+     * @throw std::runtime_error Если не удалось создать дескрипторы.
+     */
+    EventLoop();
+    EventLoop(EventLoop const &) = delete;
+    EventLoop(EventLoop &&) = delete;
+    EventLoop &operator=(EventLoop const &) = delete;
+    EventLoop &operator=(EventLoop &&) = delete;
+    ~EventLoop();
+
+    /**
+     * @brief Начинает отслеживать дескриптор.
+     *
+     * @throw std::runtime_error Если дескриптор не удалось добавить в epoll.
+     */
+    void add(int fd, uint32_t events, Callback callback);
+    /**
+     * @brief Перестает отслеживать дескриптор. Можно вызывать из его обработчика.
+     */
+    void remove(int fd);
+    /**
+     * @brief Запускает таймер.
+     *
+     * @param delay Задержка (округляется вверх до шага колеса, 1 мс).
+     * @param callback Обработчик, вызывается один раз из потока цикла.
+     *
+     * @return Идентификатор таймера (не 0).
+     */
+    TimerId add_timer(std::chrono::milliseconds delay, TimerCallback callback);
+    /**
+     * @brief Отменяет таймер.
+     *
+     * @return true если таймер еще не сработал.
+     */
+    bool cancel_timer(TimerId id);
+    /**
+     * @brief Останавливает цикл при получении сигналов.
+     *
+     * Блокирует сигналы в вызывающем потоке (потоки, созданные после вызова, наследуют маску)
+     * и принимает их через signalfd.
+     *
+     * @throw std::runtime_error Если не удалось создать signalfd.
+     */
+    void stop_on_signals(std::initializer_list<int> signals);
+    /**
+     * @brief Обрабатывает события до вызова stop.
+     */
+    void run();
+    /**
+     * @brief Одна итерация: ожидание событий не дольше timeout_ms (-1 - до ближайшего таймера) и сработавшие таймеры.
+     *
+     * @return Количество обработанных событий и таймеров.
+     */
+    std::size_t run_once(int timeout_ms = -1);
+    /**
+     * @brief Просит цикл остановиться. Можно вызывать из любого потока.
+     */
+    void stop();
+    bool stopped() const { return m_stopped.load(std::memory_order_acquire); }
+    /**
+     * @brief Дескриптор epoll для встраивания в другой реактор.
+     */
+    int fd() const { return m_epoll_fd; }
+
+   private:
+    struct Timer {
+        uint64_t expiry_tick;   // 8
+        TimerCallback callback; // 32
+    };
+
+    /**
+     * @brief Текущее время в тиках колеса.
+     */
+    static uint64_t now_tick();
+    /**
+     * @brief Вызывает таймеры, срок которых наступил.
+     */
+    std::size_t expire_timers();
+    /**
+     * @brief Время до ближайшего таймера в миллисекундах или -1, если таймеров нет.
+     */
+    int next_timeout() const;
+
+    static constexpr std::size_t M_WHEEL_SIZE = 512;
+    static constexpr int M_MAX_EVENTS = 64;
+
+    std::unordered_map<int, std::shared_ptr<Callback>> m_callbacks;        // 56
+    std::unordered_map<TimerId, Timer> m_timers;                           // 56
+    std::vector<std::vector<TimerId>> m_wheel;                             // 24
+    uint64_t m_current_tick = 0;                                           // 8
+    TimerId m_next_timer = 1;                                              // 8
+    std::atomic<bool> m_stopped = false;                                   // 1
+    int m_epoll_fd = -1;                                                   // 4
+    int m_wakeup_fd = -1;                                                  // 4
+    int m_signal_fd = -1;                                                  // 4
+};
+
+} // namespace netlink::common
@@ -0,0 +1,72 @@
+#include "histogram.hpp"
+
+#include <bit>
+#include <cmath>
+
+void netlink::common::Histogram::record(uint64_t value) {
+    add(m_counts[index(value)], 1);
+    add(m_sum, value);
+    if (value < m_min.load(std::memory_order_relaxed)) {
+        m_min.store(value, std::memory_order_relaxed);
+    }
+    if (value > m_max.load(std::memory_order_relaxed)) {
+        m_max.store(value, std::memory_order_relaxed);
+    }
+    // Счетчик обновляется последним, чтобы читатель не видел count больше суммы корзин
+    m_count.store(m_count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+}
+
+void netlink::common::Histogram::merge(Histogram const &other) {
+    uint64_t const count = other.m_count.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        add(m_counts[i], other.m_counts[i].load(std::memory_order_relaxed));
+    }
+    add(m_count, count);
+    add(m_sum, other.m_sum.load(std::memory_order_relaxed));
+    if (count != 0) {
+        uint64_t const min = other.m_min.load(std::memory_order_relaxed);
+        uint64_t const max = other.m_max.load(std::memory_order_relaxed);
+        m_min.store(min < m_min.load(std::memory_order_relaxed) ? min : m_min.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        m_max.store(max > m_max.load(std::memory_order_relaxed) ? max : m_max.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    }
+}
+
+uint64_t netlink::common::Histogram::percentile(double percentile) const {
+    uint64_t const count = m_count.load(std::memory_order_acquire);
+    if (count == 0) {
+        return 0;
+    }
+
+    // Ранг значения, до которого нужно дойти (не меньше 1, чтобы 0-й перцентиль был минимумом)
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100.0 * static_cast<double>(count)));
+    rank = rank == 0 ? 1 : (rank > count ? count : rank);
+
+    uint64_t const max = m_max.load(std::memory_order_relaxed);
+    uint64_t seen = 0;
+    for (std::size_t i = 0; i < BUCKETS; ++i) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            uint64_t value = upper_bound(i);
+            return value < max ? value : max;
+        }
+    }
+    return max;
+}
+
+std::size_t netlink::common::Histogram::index(uint64_t value) {
+    if (value < (uint64_t{1} << SUB_BITS)) {
+        return static_cast<std::size_t>(value);
+    }
+    unsigned const shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BITS;
+    return (static_cast<std::size_t>(shift + 1) << SUB_BITS) + static_cast<std::size_t>((value >> shift) & ((uint64_t{1} << SUB_BITS) - 1));
+}
+
+uint64_t netlink::common::Histogram::upper_bound(std::size_t index) {
+    if (index < (std::size_t{1} << SUB_BITS)) {
+        return index;
+    }
+    unsigned const shift = static_cast<unsigned>(index >> SUB_BITS) - 1;
+    uint64_t const mantissa = (index & ((std::size_t{1} << SUB_BITS) - 1)) | (uint64_t{1} << SUB_BITS);
+    // Для последней корзины сдвиг дает 0, и беззнаковое вычитание возвращает UINT64_MAX
+    return ((mantissa + 1) << shift) - 1;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace netlink::common {
+
+/**
+ * @brief Гистограмма значений (например, задержек в наносекундах) с логарифмическими корзинами.
+ *
+ * Значения меньше 2^SUB_BITS хранятся точно, каждая следующая степень двойки делится
+ * на 2^SUB_BITS корзин, так что относительная погрешность перцентилей не превышает 1/2^SUB_BITS.
+ * Память фиксирована, запись значения не выделяет память.
+ *
+ * Писать в гистограмму может только один поток (каждый поток ведет свою), поэтому запись
+ * обходится без атомарных read-modify-write. Читать (percentile, merge в другую гистограмму)
+ * можно из любого потока в любой момент: счетчики атомарные, снимок согласован с точностью
+ * до записей, выполняемых во время чтения.
+ */
+class Histogram final {
+   public:
+    Histogram() = default;
+    Histogram(Histogram const &) = delete;
+    Histogram &operator=(Histogram const &) = delete;
+
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr std::size_t BUCKETS = (64 - SUB_BITS + 1) << SUB_BITS;
+
+    /**
+     * @brief Добавляет значение.
+     */
+    void record(uint64_t value);
+    /**
+     * @brief Добавляет все значения другой гистограммы.
+     */
+    void merge(Histogram const &other);
+    /**
+     * @brief Значение перцентиля.
+     *
+     * @param percentile Перцентиль от 0 до 100.
+     *
+     * @return Верхняя граница корзины, в которую попал перцентиль (не больше max()), или 0 для пустой гистограммы.
+     */
+    uint64_t percentile(double percentile) const;
+    uint64_t count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t min() const { return count() ? m_min.load(std::memory_order_relaxed) : 0; }
+    uint64_t max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const { return count() ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / static_cast<double>(count()) : 0.0; }
+
+   private:
+    /**
+     * @brief Номер корзины для значения.
+     */
+    static std::size_t index(uint64_t value);
+    /**
+     * @brief Наибольшее значение, попадающее в корзину.
+     */
+    static uint64_t upper_bound(std::size_t index);
+
+    /**
+     * @brief Увеличение счетчика единственным писателем: обычные load и store вместо fetch_add.
+     */
+    static void add(std::atomic<uint64_t> &counter, uint64_t value) {
+        counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+
+    std::array<std::atomic<uint64_t>, BUCKETS> m_counts{}; // 15360
+    std::atomic<uint64_t> m_count = 0;                     // 8
+    std::atomic<uint64_t> m_sum = 0;                       // 8
+    std::atomic<uint64_t> m_min = UINT64_MAX;              // 8
+    std::atomic<uint64_t> m_max = 0;                       // 8
+};
+
+} // namespace netlink::common
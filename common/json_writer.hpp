@@ -0,0 +1,116 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace netlink::common {
+
+/**
+ * @brief Запись JSON в готовый буфер без выделения памяти.
+ *
+ * Числа форматируются std::to_chars, разделители расставляются автоматически. Вывод совпадает
+ * с nlohmann::json::dump() для тех же объектов при том же порядке ключей (dump сортирует ключи).
+ * Если буфер переполнился, ok() возвращает false, а содержимое буфера не определено.
+ */
+class JsonWriter final {
+   public:
+    JsonWriter(char *buffer, std::size_t size) : m_begin(buffer), m_pos(buffer), m_end(buffer + size) {}
+
+    JsonWriter &begin_object() { return open('{'); }
+    JsonWriter &end_object() { return close('}'); }
+    JsonWriter &begin_array() { return open('['); }
+    JsonWriter &end_array() { return close(']'); }
+    /**
+     * @brief Ключ следующего значения объекта.
+     */
+    JsonWriter &key(std::string_view name) {
+        separate();
+        string(name);
+        put(':');
+        m_comma = false;
+        return *this;
+    }
+    JsonWriter &value(int64_t number) {
+        separate();
+        if (m_ok) {
+            auto [end, ec] = std::to_chars(m_pos, m_end, number);
+            m_ok = ec == std::errc();
+            m_pos = m_ok ? end : m_pos;
+        }
+        m_comma = true;
+        return *this;
+    }
+    JsonWriter &value(std::string_view text) {
+        separate();
+        string(text);
+        m_comma = true;
+        return *this;
+    }
+    JsonWriter &value(const char *text) { return value(std::string_view(text)); }
+
+    bool ok() const { return m_ok; }
+    /**
+     * @brief Длина записанного текста в байтах.
+     */
+    std::size_t size() const { return static_cast<std::size_t>(m_pos - m_begin); }
+
+   private:
+    JsonWriter &open(char bracket) {
+        separate();
+        put(bracket);
+        m_comma = false;
+        return *this;
+    }
+    JsonWriter &close(char bracket) {
+        put(bracket);
+        m_comma = true;
+        return *this;
+    }
+    void separate() {
+        if (m_comma) {
+            put(',');
+        }
+    }
+    void put(char c) {
+        if (m_pos == m_end) {
+            m_ok = false;
+            return;
+        }
+        *m_pos++ = c;
+    }
+    void string(std::string_view text) {
+        static constexpr char M_HEX[] = "0123456789abcdef";
+        put('"');
+        for (char c : text) {
+            auto const byte = static_cast<unsigned char>(c);
+            if (c == '"' || c == '\\') {
+                put('\\');
+                put(c);
+            } else if (byte < 0x20) {
+                // Управляющие символы - как в nlohmann::json::dump
+                char const *escape = c == '\n' ? "\\n" : c == '\t' ? "\\t" : c == '\r' ? "\\r" : c == '\b' ? "\\b" : c == '\f' ? "\\f" : nullptr;
+                if (escape) {
+                    put(escape[0]);
+                    put(escape[1]);
+                } else {
+                    for (char e : {'\\', 'u', '0', '0', M_HEX[byte >> 4], M_HEX[byte & 0xf]}) {
+                        put(e);
+                    }
+                }
+            } else {
+                put(c);
+            }
+        }
+        put('"');
+    }
+
+    char *m_begin;        // 8
+    char *m_pos;          // 8
+    char *m_end;          // 8
+    bool m_ok = true;     // 1
+    bool m_comma = false; // 1 перед следующим элементом нужна запятая
+};
+
+} // namespace netlink::common
@@ -0,0 +1,140 @@
+#include "logger.hpp"
+
+#include <algorithm>
+#include <cstdarg>
+#include <cstdio>
+#include <ctime>
+
+namespace {
+
+uint64_t clock_ns(clockid_t clock) {
+    struct timespec ts {};
+    clock_gettime(clock, &ts);
+    return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+}
+
+} // namespace
+
+bool netlink::common::RateLimiter::allow(uint64_t &suppressed) {
+    uint64_t const now = clock_ns(CLOCK_MONOTONIC_COARSE);
+    uint64_t start = m_window_start.load(std::memory_order_relaxed);
+    // Новый интервал открывает тот поток, которому удалось сдвинуть его начало
+    if (now - start >= m_interval_ns && m_window_start.compare_exchange_strong(start, now, std::memory_order_relaxed)) {
+        m_count.store(0, std::memory_order_relaxed);
+    }
+
+    if (m_count.fetch_add(1, std::memory_order_relaxed) < m_burst) {
+        suppressed = m_suppressed.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+    m_suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+netlink::common::Logger::Logger() {
+    m_pending.reserve(RING_SIZE);
+    m_thread = std::thread([this]() { run(); });
+}
+
+netlink::common::Logger::~Logger() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cv.notify_one();
+    m_thread.join();
+}
+
+netlink::common::Logger &netlink::common::Logger::instance() {
+    static Logger logger;
+    return logger;
+}
+
+void netlink::common::Logger::write(int level, const char *format, ...) {
+    Buffer &buffer = local_buffer();
+    std::size_t const head = buffer.m_head.load(std::memory_order_relaxed);
+    if (head - buffer.m_tail.load(std::memory_order_acquire) >= RING_SIZE) {
+        buffer.m_dropped.store(buffer.m_dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record &record = buffer.m_records[head % RING_SIZE];
+    record.time_ns = clock_ns(CLOCK_REALTIME);
+    record.level = level;
+    va_list args;
+    va_start(args, format);
+    vsnprintf(record.message, sizeof(record.message), format, args);
+    va_end(args);
+    buffer.m_head.store(head + 1, std::memory_order_release);
+}
+
+void netlink::common::Logger::flush() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    drain();
+}
+
+void netlink::common::Logger::set_sink(Sink sink) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    drain();
+    m_sink = std::move(sink);
+}
+
+netlink::common::Logger::Buffer &netlink::common::Logger::local_buffer() {
+    // Буфер живет, пока фоновый поток не заберет из него записи, даже если поток-владелец завершился
+    struct Handle {
+        std::shared_ptr<Buffer> buffer;
+        ~Handle() { buffer->m_orphaned.store(true, std::memory_order_release); }
+    };
+    thread_local Handle handle = [this]() {
+        auto buffer = std::make_shared<Buffer>();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_buffers.push_back(buffer);
+        return Handle{buffer};
+    }();
+    return *handle.buffer;
+}
+
+void netlink::common::Logger::drain() {
+    m_pending.clear();
+    for (auto it = m_buffers.begin(); it != m_buffers.end();) {
+        Buffer &buffer = **it;
+        bool const orphaned = buffer.m_orphaned.load(std::memory_order_acquire);
+        std::size_t const head = buffer.m_head.load(std::memory_order_acquire);
+        std::size_t tail = buffer.m_tail.load(std::memory_order_relaxed);
+        for (; tail != head; ++tail) {
+            m_pending.push_back(buffer.m_records[tail % RING_SIZE]);
+        }
+        buffer.m_tail.store(tail, std::memory_order_release);
+
+        uint64_t const dropped = buffer.m_dropped.load(std::memory_order_relaxed);
+        if (dropped != buffer.m_reported_dropped) {
+            Record &record = m_pending.emplace_back();
+            record.time_ns = clock_ns(CLOCK_REALTIME);
+            record.level = LOG_WARNING;
+            snprintf(record.message, sizeof(record.message), "%llu log messages dropped, the logging thread could not keep up",
+                     static_cast<unsigned long long>(dropped - buffer.m_reported_dropped));
+            buffer.m_reported_dropped = dropped;
+        }
+
+        it = orphaned ? m_buffers.erase(it) : it + 1;
+    }
+
+    // Записи разных потоков выводятся в порядке времени
+    std::stable_sort(m_pending.begin(), m_pending.end(), [](Record const &a, Record const &b) { return a.time_ns < b.time_ns; });
+    for (Record const &record : m_pending) {
+        if (m_sink) {
+            m_sink(record.level, record.message);
+        } else {
+            syslog(record.level, "%s", record.message);
+        }
+    }
+}
+
+void netlink::common::Logger::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop) {
+        m_cv.wait_for(lock, M_FLUSH_INTERVAL);
+        drain();
+    }
+    drain();
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <syslog.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Наиболее подробный уровень журнала, который попадает в сборку (уровни syslog).
+ *
+ * Вызовы NETLINK_LOG с более подробным уровнем удаляются компилятором вместе с вычислением аргументов.
+ */
+#ifndef NETLINK_LOG_LEVEL
+#define NETLINK_LOG_LEVEL LOG_DEBUG
+#endif
+
+/**
+ * @brief Записывает сообщение в журнал.
+ *
+ * Если уровень отключен при сборке или во время работы (Logger::set_level), аргументы
+ * не вычисляются и сообщение не форматируется. Иначе сообщение форматируется в кольцевой
+ * буфер вызывающего потока без блокировок, а в syslog его выводит фоновый поток.
+ */
+#define NETLINK_LOG(level, ...)                                                   \
+    do {                                                                          \
+        if constexpr ((level) <= NETLINK_LOG_LEVEL) {                             \
+            if (::netlink::common::Logger::enabled(level)) {                      \
+                ::netlink::common::Logger::instance().write((level), __VA_ARGS__); \
+            }                                                                     \
+        }                                                                         \
+    } while (0)
+
+/**
+ * @brief Записывает сообщение в журнал не чаще RateLimiter::DEFAULT_BURST раз в секунду для места вызова.
+ *
+ * Для ошибок, которые могут повторяться на каждый запрос. Количество подавленных сообщений
+ * выводится вместе со следующим пропущенным сообщением.
+ */
+#define NETLINK_LOG_RATELIMITED(level, ...)                                                                                         \
+    do {                                                                                                                            \
+        if constexpr ((level) <= NETLINK_LOG_LEVEL) {                                                                               \
+            if (::netlink::common::Logger::enabled(level)) {                                                                        \
+                static ::netlink::common::RateLimiter netlink_log_limiter;                                                          \
+                uint64_t netlink_log_suppressed = 0;                                                                                \
+                if (netlink_log_limiter.allow(netlink_log_suppressed)) {                                                            \
+                    if (netlink_log_suppressed != 0) {                                                                              \
+                        ::netlink::common::Logger::instance().write((level), "%llu similar messages suppressed",                    \
+                                                                    static_cast<unsigned long long>(netlink_log_suppressed));       \
+                    }                                                                                                               \
+                    ::netlink::common::Logger::instance().write((level), __VA_ARGS__);                                              \
+                }                                                                                                                   \
+            }                                                                                                                       \
+        }                                                                                                                           \
+    } while (0)
+
+namespace netlink::common {
+
+/**
+ * @brief Ограничитель частоты сообщений: не больше burst сообщений за interval.
+ *
+ * Потокобезопасный, без блокировок.
+ */
+class RateLimiter final {
+   public:
+    static constexpr uint32_t DEFAULT_BURST = 10;
+    static constexpr uint64_t DEFAULT_INTERVAL_NS = 1000000000;
+
+    explicit RateLimiter(uint32_t burst = DEFAULT_BURST, uint64_t interval_ns = DEFAULT_INTERVAL_NS) : m_interval_ns(interval_ns), m_burst(burst) {}
+
+    /**
+     * @brief Проверяет, можно ли вывести сообщение.
+     *
+     * @param suppressed Количество сообщений, подавленных в прошлых интервалах (сбрасывается при выдаче).
+     *
+     * @return true если сообщение можно вывести.
+     */
+    bool allow(uint64_t &suppressed);
+
+   private:
+    std::atomic<uint64_t> m_window_start{0}; // 8
+    std::atomic<uint64_t> m_suppressed{0};   // 8
+    uint64_t m_interval_ns;                  // 8
+    std::atomic<uint32_t> m_count{0};        // 4
+    uint32_t m_burst;                        // 4
+};
+
+/**
+ * @brief Асинхронный журнал.
+ *
+ * Каждый поток пишет в собственный кольцевой буфер (SPSC, без блокировок). Фоновый поток
+ * периодически забирает записи из всех буферов, упорядочивает их по времени и передает
+ * в приемник (по умолчанию syslog). Если буфер потока переполнен, запись отбрасывается,
+ * а количество потерянных записей выводится позже: поток обработки запросов никогда
+ * не ждет журнал.
+ */
+class Logger final {
+   public:
+    /**
+     * @brief Приемник записей: уровень и текст сообщения.
+     */
+    using Sink = std::function<void(int level, const char *message)>;
+
+    static constexpr std::size_t RING_SIZE = 256;
+    static constexpr std::size_t MESSAGE_SIZE = 240;
+
+    Logger(Logger const &) = delete;
+    Logger(Logger &&) = delete;
+    Logger &operator=(Logger const &) = delete;
+    Logger &operator=(Logger &&) = delete;
+    /**
+     * @brief Останавливает фоновый поток и выводит оставшиеся записи.
+     */
+    ~Logger();
+
+    static Logger &instance();
+
+    /**
+     * @brief Включен ли уровень во время работы.
+     */
+    static bool enabled(int level) { return level <= s_level.load(std::memory_order_relaxed); }
+    /**
+     * @brief Задает наиболее подробный уровень, который выводится во время работы (по умолчанию LOG_INFO).
+     */
+    static void set_level(int level) { s_level.store(level, std::memory_order_relaxed); }
+    static int level() { return s_level.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Форматирует сообщение в буфер вызывающего потока (формат printf, длинные сообщения обрезаются).
+     */
+    void write(int level, const char *format, ...) __attribute__((format(printf, 3, 4)));
+    /**
+     * @brief Синхронно выводит все записи, сделанные до вызова.
+     */
+    void flush();
+    /**
+     * @brief Заменяет приемник записей (пустой приемник возвращает syslog).
+     */
+    void set_sink(Sink sink);
+
+   private:
+    struct Record {
+        uint64_t time_ns;            // 8
+        int level;                   // 4
+        char message[MESSAGE_SIZE];  // 240
+    };
+
+    /**
+     * @brief Кольцевой буфер одного потока.
+     */
+    struct Buffer {
+        std::array<Record, RING_SIZE> m_records;          // 64512
+        alignas(64) std::atomic<std::size_t> m_head = 0;  // 8 пишет поток-владелец
+        alignas(64) std::atomic<std::size_t> m_tail = 0;  // 8 пишет фоновый поток
+        std::atomic<uint64_t> m_dropped = 0;              // 8 пишет поток-владелец
+        uint64_t m_reported_dropped = 0;                  // 8 пишет фоновый поток
+        std::atomic<bool> m_orphaned = false;             // 1 поток-владелец завершился
+    };
+
+    Logger();
+
+    /**
+     * @brief Буфер вызывающего потока (регистрируется при первом обращении).
+     */
+    Buffer &local_buffer();
+    /**
+     * @brief Забирает записи из всех буферов и передает их приемнику. Вызывается под m_mutex.
+     */
+    void drain();
+    /**
+     * @brief Цикл фонового потока.
+     */
+    void run();
+
+    static constexpr auto M_FLUSH_INTERVAL = std::chrono::milliseconds(10);
+    static inline std::atomic<int> s_level = LOG_INFO;
+
+    std::mutex m_mutex;                            // 40
+    std::condition_variable m_cv;                  // 48
+    std::vector<std::shared_ptr<Buffer>> m_buffers; // 24
+    std::vector<Record> m_pending;                 // 24 записи текущего вывода, переиспользуется
+    Sink m_sink;                                   // 32
+    std::thread m_thread;                          // 8
+    bool m_stop = false;                           // 1
+};
+
+} // namespace netlink::common
@@ -0,0 +1,54 @@
+#pragma once
+#include <netlink/attr.h>
+#include <netlink/msg.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace netlink::common {
+
+/**
+ * @brief Строковый атрибут, который заполняется на месте в буфере сообщения Netlink.
+ *
+ * Конструктор резервирует атрибут наибольшего размера (nla_reserve), текст записывается
+ * прямо в data(), а finish укорачивает атрибут и сообщение до фактической длины. Так ответ
+ * формируется в сообщении один раз, без промежуточной строки и копирования nla_put_string.
+ * Атрибут должен оставаться последним в сообщении до вызова finish.
+ */
+class StringAttribute final {
+   public:
+    /**
+     * @param capacity Наибольшая длина текста без завершающего нуля.
+     */
+    StringAttribute(struct nl_msg *msg, int type, std::size_t capacity)
+        : m_msg(msg), m_attr(nla_reserve(msg, type, static_cast<int>(capacity + 1))), m_capacity(capacity) {}
+
+    /**
+     * @brief Атрибут зарезервирован (в сообщении хватило места).
+     */
+    explicit operator bool() const { return m_attr != nullptr; }
+    char *data() const { return static_cast<char *>(nla_data(m_attr)); }
+    std::size_t capacity() const { return m_capacity; }
+    /**
+     * @brief Завершает текст нулем и укорачивает атрибут и сообщение.
+     *
+     * @param size Длина записанного текста (не больше capacity()).
+     */
+    void finish(std::size_t size) {
+        char *text = data();
+        int const length = NLA_HDRLEN + static_cast<int>(size) + 1;
+        // Выравнивание заполняется нулями: буфер сообщения переиспользуется и содержит прежние данные
+        std::memset(text + size, 0, static_cast<std::size_t>(NLA_ALIGN(length) - length) + 1);
+        m_attr->nla_len = static_cast<uint16_t>(length);
+        struct nlmsghdr *nlh = nlmsg_hdr(m_msg);
+        nlh->nlmsg_len = static_cast<uint32_t>(reinterpret_cast<char *>(m_attr) - reinterpret_cast<char *>(nlh) + NLA_ALIGN(length));
+    }
+
+   private:
+    struct nl_msg *m_msg;   // 8
+    struct nlattr *m_attr;  // 8
+    std::size_t m_capacity; // 8
+};
+
+} // namespace netlink::common
@@ -1,11 +1,25 @@
 #include <linux/kernel.h>
 #include <linux/module.h>
 #include <linux/netlink.h>
+#include <linux/percpu.h>
+#include <linux/rcupdate.h>
+#include <linux/slab.h>
+#include <linux/workqueue.h>
 #include <net/genetlink.h>
 
+#include "calc_ops.h"
+#include "calc_route.h"
+#include "calc_server.h"
+
 #define FAMILY_NAME "calc_family"
 #define COMMAND_CLIENT 1
 #define COMMAND_SERVER 2
+#define COMMAND_REGISTER 3   /**< Регистрация сервера (с версии 6 - с емкостью ATTR_CREDITS). */
+#define COMMAND_UNREGISTER 4 /**< Отмена регистрации: сервер перестает получать запросы и отвечает на принятые. */
+#define FAMILY_VERSION 7 /**< 1 - только JSON (ATTR_MSG), 2 - добавлен бинарный протокол (ATTR_OP, ATTR_ARG1, ATTR_ARG2), 3 - массивы (ATTR_ARRAY1, ATTR_ARRAY2), 4 - потоки фрагментов (ATTR_STREAM), 5 - COMMAND_REGISTER и COMMAND_UNREGISTER, 6 - емкость сервера ATTR_CREDITS, 7 - рассылка ответов по темам (ATTR_TOPIC). */
+#define MSG_MAX_LEN 1024 /**< Максимальная длина строки ATTR_MSG, в том числе внутри пакета ATTR_BATCH. */
+#define ARRAY_MAX_LEN 16384 /**< Максимальный размер ATTR_ARRAY1, ATTR_ARRAY2 и ATTR_RESULTS в байтах (2048 значений s64). */
+#define DATA_MAX_LEN 16384 /**< Максимальный размер фрагмента потока ATTR_DATA в байтах. */
 
 /**
  * @brief Определение атрибутов для Generic Netlink.
@@ -13,16 +27,82 @@
  * Содержит список атрибутов, используемых в Netlink-сообщениях.
  */
 enum {
-    ATTR_UNSPEC, /**< Неопределенный атрибут, используется как заглушка. */
-    ATTR_MSG,    /**< Основной атрибут, содержащий полезную нагрузку сообщения (строка). */
-    __ATTR_MAX,  /**< Максимальное значение для атрибутов (служебный элемент). */
+    ATTR_UNSPEC,  /**< Неопределенный атрибут, используется как заглушка. */
+    ATTR_MSG,     /**< Основной атрибут, содержащий полезную нагрузку сообщения (строка). */
+    ATTR_BATCH,   /**< Пакет операций: вложенный массив атрибутов ATTR_MSG. */
+    ATTR_OP,      /**< Операция бинарного протокола (u8). */
+    ATTR_ARG1,    /**< Первый аргумент бинарного протокола (s64). */
+    ATTR_ARG2,    /**< Второй аргумент бинарного протокола (s64). */
+    ATTR_RESULT,  /**< Результат операции бинарного протокола (s64). */
+    ATTR_ERRNO,   /**< Код ошибки операции бинарного протокола (s32). */
+    ATTR_ARRAY1,  /**< Первые аргументы операции над массивами (массив s64). */
+    ATTR_ARRAY2,  /**< Вторые аргументы операции над массивами (массив s64). */
+    ATTR_RESULTS, /**< Часть результатов операции над массивами (массив s64). */
+    ATTR_OFFSET,  /**< Индекс первого элемента ATTR_RESULTS в массиве результатов (u32). */
+    ATTR_STREAM,  /**< Идентификатор потока фрагментов (u32). */
+    ATTR_CHUNK,   /**< Номер фрагмента в потоке, начиная с 0 (u32). */
+    ATTR_EOS,     /**< Последний фрагмент потока (флаг). */
+    ATTR_DATA,    /**< Данные фрагмента потока (двоичные, до DATA_MAX_LEN байт). */
+    ATTR_CREDITS, /**< Емкость сервера в COMMAND_REGISTER: наибольшее число запросов в полете (u32, 0 - без ограничения). */
+    ATTR_TOPIC,   /**< Тема рассылки ответа подписчикам группы CALC_GROUP_RESULTS (u32, 0 - без рассылки). */
+    __ATTR_MAX,   /**< Максимальное значение для атрибутов (служебный элемент). */
 };
 #define ATTR_MAX (__ATTR_MAX - 1) /**< Корректное определение верхней границы атрибутов. */
 
-static __u32 pid_client = 0;
-static __u32 pid_server = 0;
-static int seq_client = 0;
-static int seq_server = 0;
+/**
+ * @brief Группы рассылки семейства.
+ */
+enum {
+    CALC_GROUP_RESULTS, /**< Ответы на запросы с ATTR_TOPIC: каждый подписчик получает копию ответа сервера. */
+};
+
+/*
+ * Семейство помечено parallel_ops: обработчики выполняются без genl_mutex, одновременно на разных CPU.
+ * Таблица маршрутов не требует блокировок (calc_route.h), реестр серверов читается под RCU и
+ * заменяется копией под servers_lock, счетчики и курсоры идентификаторов у каждого CPU свои.
+ * Таблицу потоков защищает спинлок: фрагменты потоков редки по сравнению с одиночными запросами.
+ * Журнал каждого запроса - pr_debug (включается через dynamic debug): printk на каждое сообщение
+ * снова сериализовал бы обработчики.
+ */
+static struct calc_route_table routes; /**< Маршруты запросов в полете: id ретранслятора -> клиент и его seq. */
+static struct calc_stream_table streams; /**< Потоки фрагментов: поток клиента -> сервер, собирающий его. */
+static DEFINE_SPINLOCK(streams_lock);    /**< Защищает streams. */
+
+static struct calc_servers __rcu *servers; /**< Текущий снимок реестра (calc_server.h; NULL - серверов нет). */
+static DEFINE_MUTEX(servers_lock);         /**< Сериализует изменения реестра. */
+
+/**
+ * @brief Счетчики ретранслятора одного CPU.
+ */
+struct calc_stats {
+    u64 requests;          /**< Запросы клиентов, переданные серверам. */
+    u64 offloaded;         /**< Запросы, на которые ответил модуль (offload). */
+    u64 replies;           /**< Ответы серверов, переданные клиентам (включая промежуточные части). */
+    u64 busy;              /**< Запросы, отклоненные с -EBUSY (таблица маршрутов заполнена или у серверов нет свободных мест). */
+    u64 failed;            /**< Запросы, завершенные ECONNRESET: сервер завершился, не ответив. */
+    u64 published;         /**< Ответы, разосланные подписчикам группы CALC_GROUP_RESULTS. */
+    u64 publish_overflows; /**< Разосланные ответы, которые не поместились в буфер хотя бы одного подписчика. */
+};
+static DEFINE_PER_CPU(struct calc_stats, relay_stats);
+static DEFINE_PER_CPU(unsigned int, next_server); /**< Индекс сервера для следующего запроса этого CPU (round-robin). */
+static DEFINE_PER_CPU(__u32, route_cursor);       /**< Курсор идентификаторов запросов этого CPU. */
+
+static bool offload = false; /**< Вычислять простые бинарные операции в модуле, не передавая их серверу. */
+module_param(offload, bool, 0644);
+MODULE_PARM_DESC(offload, "Answer simple binary operations (ATTR_OP) in the module without a server hop");
+
+/**
+ * @brief Выводит сумму счетчиков всех CPU и количество запросов в полете (параметр stats).
+ *
+ * @param buffer Буфер sysfs.
+ * @param kp Описание параметра.
+ *
+ * @return Длина выведенного текста.
+ */
+static int stats_get(char *buffer, const struct kernel_param *kp);
+static const struct kernel_param_ops stats_ops = {.get = stats_get};
+module_param_cb(stats, &stats_ops, NULL, 0444);
+MODULE_PARM_DESC(stats, "Relay counters summed over all CPUs (read-only)");
 
 /**
  * @brief Отправляет сообщение через Netlink.
@@ -37,11 +117,202 @@ static int seq_server = 0;
  * @return 0 при успешной отправке, отрицательное значение кода ошибки в случае сбоя.
  */
 static int send_message(const char *msg, int pid, int seq);
+/**
+ * @brief Пересылает атрибуты полученного сообщения через Netlink.
+ *
+ * Копирует все атрибуты входящего сообщения (ATTR_MSG, пакет ATTR_BATCH или бинарный запрос/ответ)
+ * одним блоком в новое сообщение. Размер sk_buff вычисляется по размеру атрибутов,
+ * поэтому пакет из сотен операций пересылается одним сообщением.
+ *
+ * @param info Структура с информацией о входящем сообщении.
+ * @param pid PID получателя сообщения.
+ * @param seq Номер последовательности для сообщения.
+ * @param flags Флаги заголовка сообщения (NLM_F_MULTI для промежуточной части ответа).
+ * @param stream Идентификатор потока ретранслятора, который заменяет ATTR_STREAM клиента (0 - не заменять).
+ *
+ * @return 0 при успешной отправке, отрицательное значение кода ошибки в случае сбоя.
+ */
+static int forward_message(struct genl_info *info, int pid, int seq, int flags, __u32 stream);
+/**
+ * @brief Рассылает ответ сервера подписчикам группы CALC_GROUP_RESULTS.
+ *
+ * Копирует атрибуты ответа и добавляет ATTR_TOPIC; сообщение без номера последовательности
+ * один раз ставится в очереди всех подписанных сокетов (genlmsg_multicast), подписчики
+ * выбирают ответы своих тем. Если подписчиков нет, сообщение не создается.
+ *
+ * @param info Структура с информацией о входящем сообщении сервера.
+ * @param topic Тема ответа.
+ * @param flags Флаги заголовка (NLM_F_MULTI для промежуточной части ответа).
+ *
+ * @return 0 при успешной рассылке или если подписчиков нет, отрицательное значение кода ошибки в случае сбоя.
+ */
+static int publish_message(struct genl_info *info, __u32 topic, int flags);
+/**
+ * @brief Выбирает сервер для фрагмента потока.
+ *
+ * Первый фрагмент (ATTR_CHUNK 0) открывает поток на следующем по очереди сервере, остальные
+ * направляются тому же серверу. Фрагменты не накапливаются в ядре: каждый пересылается
+ * сразу, сервер собирает запрос сам.
+ *
+ * @param info Структура с информацией о входящем сообщении.
+ * @param stream Поток ретранслятора.
+ *
+ * @return 0, -ENOENT если поток не открыт, -ESRCH если нет серверов.
+ */
+static int route_stream(struct genl_info *info, struct calc_stream *stream);
+/**
+ * @brief Проверяет пакет операций.
+ *
+ * Политика атрибутов не проверяет содержимое вложенного атрибута, поэтому каждый элемент
+ * пакета проверяется здесь по тем же правилам, что и одиночный ATTR_MSG.
+ *
+ * @param batch Атрибут ATTR_BATCH.
+ *
+ * @return 0 если пакет корректен, -EINVAL в противном случае.
+ */
+static int validate_batch(const struct nlattr *batch);
+/**
+ * @brief Проверяет, зарегистрирован ли сервер (чтение реестра под RCU).
+ *
+ * Сервер, отменивший регистрацию, остается известным, пока не закроет сокет: его ответы пересылаются.
+ *
+ * @param pid PID (port id) сервера.
+ *
+ * @return true, если сервер зарегистрирован.
+ */
+static bool is_server(__u32 pid);
+/**
+ * @brief Регистрирует сервер.
+ *
+ * Копирует текущий снимок реестра с добавленным сервером и публикует копию; прежний снимок
+ * освобождается после периода ожидания RCU, когда его больше не читает ни один обработчик.
+ * Повторная регистрация сервера, отменившего ее, снова направляет ему запросы и обновляет емкость.
+ *
+ * @param pid PID (port id) сервера.
+ * @param credits Емкость сервера: наибольшее число запросов в полете (0 - без ограничения).
+ *
+ * @return 0 при успешной регистрации (или если сервер уже зарегистрирован), -ENOSPC если серверов
+ *         CALC_MAX_SERVERS, -ENOMEM если не удалось выделить снимок.
+ */
+static int register_server(__u32 pid, int credits);
+/**
+ * @brief Отменяет регистрацию сервера.
+ *
+ * Сервер перестает получать новые запросы, но остается в реестре: его ответы на принятые
+ * запросы пересылаются клиентам. Из реестра его удаляет закрытие сокета (NETLINK_URELEASE).
+ *
+ * @param pid PID (port id) сервера.
+ *
+ * @return 0 или -ENOENT, если сервер не зарегистрирован.
+ */
+static int unregister_server(__u32 pid);
+/**
+ * @brief Помечает сервер завершившимся и планирует reap_servers.
+ *
+ * Вызывается из уведомления NETLINK_URELEASE и при -ECONNREFUSED от genlmsg_unicast;
+ * помеченный сервер сразу перестает получать запросы.
+ *
+ * @param pid PID (port id) сервера.
+ */
+static void mark_server_dead(__u32 pid);
+/**
+ * @brief Удаляет завершившиеся серверы из реестра и завершает их запросы ошибкой.
+ *
+ * Выполняется в рабочей очереди: клиенты запросов, на которые сервер не ответил, получают
+ * ATTR_ERRNO ECONNRESET, потоки фрагментов сервера закрываются.
+ *
+ * @param work Задание reap_work.
+ */
+static void reap_servers(struct work_struct *work);
+/**
+ * @brief Отвечает ECONNRESET клиенту запроса завершившегося сервера (обработчик calc_server_fail_routes).
+ *
+ * @param route Маршрут запроса, на который сервер не ответил.
+ * @param context Не используется.
+ */
+static void fail_route(const struct calc_route *route, void *context);
+/**
+ * @brief Уведомление о закрытии сокета Netlink (NETLINK_URELEASE).
+ *
+ * @param nb Блок уведомления.
+ * @param event Событие.
+ * @param ptr struct netlink_notify закрытого сокета.
+ *
+ * @return NOTIFY_DONE.
+ */
+static int calc_netlink_event(struct notifier_block *nb, unsigned long event, void *ptr);
+/**
+ * @brief Учитывает начало или завершение запроса на сервере (calc_server_track под RCU).
+ *
+ * @param pid PID (port id) сервера.
+ * @param delta 1 - запрос передан серверу, -1 - запрос завершен.
+ */
+static void track_server(__u32 pid, int delta);
+/**
+ * @brief Отправляет клиенту ответ с кодом ошибки ATTR_ERRNO.
+ *
+ * @param pid PID клиента.
+ * @param seq Номер последовательности запроса клиента.
+ * @param error Положительный код ошибки, как в ответах сервера.
+ *
+ * @return 0 при успешной отправке, отрицательное значение кода ошибки в случае сбоя.
+ */
+static int send_error(__u32 pid, __u32 seq, int error);
+/**
+ * @brief Передает запрос клиента серверу: создает маршрут и пересылает сообщение.
+ *
+ * Место на сервере уже занято (pick_server или route_stream); если запрос не передан, место
+ * освобождается. Если сокет сервера уже закрыт (-ECONNREFUSED), сервер помечается завершившимся.
+ *
+ * @param info Структура с информацией о входящем сообщении.
+ * @param pid_server PID сервера.
+ * @param stream Поток ретранслятора (0 - запрос не из потока).
+ *
+ * @return 0 при успешной пересылке, -EBUSY если таблица маршрутов заполнена, иначе ошибка пересылки.
+ */
+static int route_request(struct genl_info *info, __u32 pid_server, __u32 stream);
+/**
+ * @brief Закрывает поток фрагментов под streams_lock.
+ *
+ * @param id Идентификатор потока ретранслятора (0 - ничего не делать).
+ */
+static void close_stream(__u32 id);
+/**
+ * @brief Выбирает сервер для очередного запроса клиента и занимает на нем место.
+ *
+ * Выбор - calc_server_pick под RCU. Просмотр начинается с индекса, который у каждого CPU свой
+ * и сдвигается на каждый запрос, поэтому равно загруженные серверы получают запросы по кругу.
+ *
+ * @param pid PID выбранного сервера.
+ *
+ * @return 0, -ESRCH если ни один сервер не зарегистрирован, -EBUSY если места нет ни на одном сервере.
+ */
+static int pick_server(__u32 *pid);
+/**
+ * @brief Отвечает на бинарный запрос клиента, не передавая его серверу.
+ *
+ * В режиме offload одиночная операция (ATTR_OP, ATTR_ARG1, ATTR_ARG2) вычисляется
+ * calc_ops_compute и ответ с ATTR_RESULT или ATTR_ERRNO отправляется клиенту genlmsg_reply
+ * с его номером последовательности. Маршрут запроса не создается.
+ *
+ * @param info Структура с информацией о входящем сообщении.
+ *
+ * @return 0 если ответ отправлен или не удался, -EOPNOTSUPP если запрос нужно передать серверу
+ *         (режим выключен, запрос не бинарный, рассылается по теме или операция неизвестна модулю).
+ */
+static int offload_request(struct genl_info *info);
 /**
  * @brief Обработчик команд от клиента.
  *
- * Обрабатывает сообщения, полученные от клиента, и перенаправляет их серверу
- * (если сервер зарегистрирован). Если сервер не зарегистрирован, отправляется сообщение об ошибке клиенту.
+ * Обрабатывает сообщения, полученные от клиента, и перенаправляет их одному из серверов
+ * (если хотя бы один сервер зарегистрирован). Если сервер не зарегистрирован, отправляется сообщение об ошибке клиенту.
+ * Для каждого запроса в таблице маршрутов запоминаются PID клиента и исходный номер
+ * последовательности, а сервер получает запрос с идентификатором, назначенным ретранслятором.
+ * Если таблица маршрутов заполнена или у всех серверов исчерпана емкость, клиенту сразу
+ * возвращается -EBUSY (NLMSG_ERROR с текстом extack): запрос не ставится в очередь сокета
+ * сервера, где он мог бы потеряться при переполнении. Ответ на запрос с ATTR_TOPIC, кроме
+ * клиента, получают подписчики темы (publish_message). В режиме offload простые
+ * бинарные операции вычисляются в модуле (offload_request) и до сервера не доходят.
  *
  * @param skb Указатель на структуру sk_buff, содержащую сообщение.
  * @param info Структура, содержащая информацию о параметрах сообщения.
@@ -49,12 +320,36 @@ static int send_message(const char *msg, int pid, int seq);
  * @return 0 при успешной обработке, отрицательное значение кода ошибки в случае сбоя.
  */
 static int calc_cmd_client(struct sk_buff *skb, struct genl_info *info);
+/**
+ * @brief Обработчик команды регистрации сервера (COMMAND_REGISTER).
+ *
+ * Сервер версии 6 и выше сообщает емкость атрибутом ATTR_CREDITS, без него емкость не ограничена.
+ *
+ * @param skb Указатель на структуру sk_buff, содержащую сообщение.
+ * @param info Структура, содержащая информацию о параметрах сообщения.
+ *
+ * @return 0 при успешной регистрации, отрицательное значение кода ошибки в случае сбоя.
+ */
+static int calc_cmd_register(struct sk_buff *skb, struct genl_info *info);
+/**
+ * @brief Обработчик команды отмены регистрации сервера (COMMAND_UNREGISTER).
+ *
+ * @param skb Указатель на структуру sk_buff, содержащую сообщение.
+ * @param info Структура, содержащая информацию о параметрах сообщения.
+ *
+ * @return 0 или -ENOENT, если сервер не зарегистрирован.
+ */
+static int calc_cmd_unregister(struct sk_buff *skb, struct genl_info *info);
 /**
  * @brief Обработчик команд от сервера.
  *
- * Обрабатывает сообщения, полученные от сервера, и отправляет их клиенту
- * (если клиент зарегистрирован). Если сервер еще не зарегистрирован,
- * он регистрируется и сообщение отправляется самому серверу.
+ * Обрабатывает сообщения, полученные от сервера, и отправляет их клиенту, которого
+ * находит в таблице маршрутов по номеру последовательности ответа (идентификатору запроса),
+ * восстанавливая исходный номер последовательности клиента. Ответ принимается только от сервера,
+ * которому передан запрос. Если запрос клиента содержал ATTR_TOPIC, ответ (и каждая его часть)
+ * также рассылается подписчикам. Если сервер еще не зарегистрирован, он регистрируется и сообщение
+ * отправляется самому серверу (регистрация серверов версий до COMMAND_REGISTER). Каждый рабочий
+ * поток сервера регистрируется отдельно со своим сокетом.
  *
  * @param skb Указатель на структуру sk_buff, содержащую сообщение.
  * @param info Структура, содержащая информацию о параметрах сообщения.
@@ -67,17 +362,33 @@ static int calc_cmd_server(struct sk_buff *skb, struct genl_info *info);
  * @brief Политика проверки атрибутов для Generic Netlink.
  *
  * Определяет правила валидации атрибутов, которые используются в сообщениях Netlink.
- * Здесь задается тип и ограничения атрибута `ATTR_MSG`.
+ * Здесь задается тип и ограничения атрибутов `ATTR_MSG`, `ATTR_BATCH` и атрибутов бинарного протокола.
  */
 static const struct nla_policy calc_policy[ATTR_MAX + 1] = {
     [ATTR_MSG] =
         {
             .type = NLA_STRING, /**< Тип атрибута - строка. */
-            .len = 1024,        /**< Максимальная длина строки - 1024 байта. */
+            .len = MSG_MAX_LEN, /**< Максимальная длина строки - 1024 байта. */
         },
-};
-static const struct nla_policy calc_policy[ATTR_MAX + 1] = {
-    [ATTR_MSG] = {.type = NLA_STRING, .len = 1024},
+    [ATTR_BATCH] =
+        {
+            .type = NLA_NESTED, /**< Тип атрибута - вложенный массив ATTR_MSG (проверяется в validate_batch). */
+        },
+    [ATTR_OP] = {.type = NLA_U8},
+    [ATTR_ARG1] = {.type = NLA_S64},
+    [ATTR_ARG2] = {.type = NLA_S64},
+    [ATTR_RESULT] = {.type = NLA_S64},
+    [ATTR_ERRNO] = {.type = NLA_S32},
+    [ATTR_ARRAY1] = {.type = NLA_BINARY, .len = ARRAY_MAX_LEN},
+    [ATTR_ARRAY2] = {.type = NLA_BINARY, .len = ARRAY_MAX_LEN},
+    [ATTR_RESULTS] = {.type = NLA_BINARY, .len = ARRAY_MAX_LEN},
+    [ATTR_OFFSET] = {.type = NLA_U32},
+    [ATTR_STREAM] = {.type = NLA_U32},
+    [ATTR_CHUNK] = {.type = NLA_U32},
+    [ATTR_EOS] = {.type = NLA_FLAG},
+    [ATTR_DATA] = {.type = NLA_BINARY, .len = DATA_MAX_LEN},
+    [ATTR_CREDITS] = {.type = NLA_U32},
+    [ATTR_TOPIC] = {.type = NLA_U32},
 };
 
 /**
@@ -100,6 +411,32 @@ static const struct genl_ops calc_ops[] = {
         .doit = calc_cmd_server, /**< Указатель на функцию-обработчик команды сервера. */
         .dumpit = NULL,          /**< Поле для функции выгрузки (не используется). */
     },
+    {
+        .cmd = COMMAND_REGISTER,   /**< Регистрация сервера. */
+        .flags = 0,                /**< Флаги для команды (нет специальных флагов). */
+        .policy = calc_policy,     /**< Политика валидации атрибутов команды. */
+        .doit = calc_cmd_register, /**< Указатель на функцию-обработчик регистрации. */
+        .dumpit = NULL,            /**< Поле для функции выгрузки (не используется). */
+    },
+    {
+        .cmd = COMMAND_UNREGISTER,   /**< Отмена регистрации сервера. */
+        .flags = 0,                  /**< Флаги для команды (нет специальных флагов). */
+        .policy = calc_policy,       /**< Политика валидации атрибутов команды. */
+        .doit = calc_cmd_unregister, /**< Указатель на функцию-обработчик отмены регистрации. */
+        .dumpit = NULL,              /**< Поле для функции выгрузки (не используется). */
+    },
+};
+
+/**
+ * @brief Группы рассылки: подписчик разрешает имя группы через контроллер Generic Netlink.
+ */
+static const struct genl_multicast_group calc_mcgrps[] = {
+    [CALC_GROUP_RESULTS] = {.name = "results"},
+};
+
+static DECLARE_WORK(reap_work, reap_servers); /**< Удаление завершившихся серверов. */
+static struct notifier_block calc_netlink_notifier = {
+    .notifier_call = calc_netlink_event, /**< Обработчик закрытия сокетов Netlink. */
 };
 
 /**
@@ -108,17 +445,27 @@ static const struct genl_ops calc_ops[] = {
  * Определяет параметры семейства Netlink (имя, версию, операции, и пр.).
  */
 static struct genl_family calc_family = {
-    .name = FAMILY_NAME,           /**< Название семейства Netlink. */
-    .version = 1,                  /**< Версия семейства Netlink. */
-    .maxattr = ATTR_MAX,           /**< Максимальное количество поддерживаемых атрибутов. */
-    .module = THIS_MODULE,         /**< Указатель на текущий модуль ядра. */
-    .ops = calc_ops,               /**< Список операций (команд), поддерживаемых семейством. */
-    .n_ops = ARRAY_SIZE(calc_ops), /**< Количество операций, объявленных в calc_ops. */
+    .name = FAMILY_NAME,                 /**< Название семейства Netlink. */
+    .version = FAMILY_VERSION,           /**< Версия семейства Netlink (клиент выбирает протокол по ней). */
+    .maxattr = ATTR_MAX,                 /**< Максимальное количество поддерживаемых атрибутов. */
+    .module = THIS_MODULE,               /**< Указатель на текущий модуль ядра. */
+    .ops = calc_ops,                     /**< Список операций (команд), поддерживаемых семейством. */
+    .n_ops = ARRAY_SIZE(calc_ops),       /**< Количество операций, объявленных в calc_ops. */
+    .mcgrps = calc_mcgrps,               /**< Группы рассылки ответов. */
+    .n_mcgrps = ARRAY_SIZE(calc_mcgrps), /**< Количество групп рассылки. */
+    .parallel_ops = true,                /**< Обработчики выполняются без genl_mutex (состояние синхронизировано само). */
 };
 static int __init calc_init(void) {
     int ret;
+    unsigned int cpu;
 
     pr_info("Initializing Generic Netlink family \"%s\"\n", FAMILY_NAME);
+    calc_route_init(&routes);
+    calc_stream_init(&streams);
+    // Курсоры CPU начинают с разных участков таблицы и не конкурируют за одни слоты
+    for_each_possible_cpu(cpu) {
+        per_cpu(route_cursor, cpu) = cpu * CALC_ROUTE_TABLE_SIZE / nr_cpu_ids;
+    }
 
     ret = genl_register_family(&calc_family);
     if (ret) {
@@ -126,13 +473,32 @@ static int __init calc_init(void) {
         return ret;
     }
     pr_info("Generic Netlink family \"%s\" registered successfully with family ID: %d\n", FAMILY_NAME, calc_family.id);
+
+    ret = netlink_register_notifier(&calc_netlink_notifier);
+    if (ret) {
+        pr_err("Failed to register Netlink notifier: %d\n", ret);
+        genl_unregister_family(&calc_family);
+        return ret;
+    }
     return 0;
 }
 
 static void __exit calc_exit(void) {
+    struct calc_servers *registry = NULL;
+    int i;
+
     pr_info("Unregistering Generic Netlink family \"%s\"\n", FAMILY_NAME);
 
+    netlink_unregister_notifier(&calc_netlink_notifier);
     genl_unregister_family(&calc_family);
+    cancel_work_sync(&reap_work);
+    // Обработчиков больше нет: дожидаемся освобождения прежних снимков и освобождаем текущий
+    rcu_barrier();
+    registry = rcu_dereference_protected(servers, true);
+    for (i = 0; registry && i < registry->count; i++) {
+        kfree(registry->list[i]);
+    }
+    kfree(registry);
 
     pr_info("Generic Netlink family \"%s\" unregistered successfully\n", FAMILY_NAME);
 }
@@ -159,7 +525,7 @@ static int send_message(const char *msg, int pid, int seq) {
         return -EINVAL;
     }
 
-    skb = genlmsg_new(NLMSG_GOODSIZE, GFP_KERNEL);
+    skb = genlmsg_new(nla_total_size(strlen(msg) + 1), GFP_KERNEL);
     if (!skb) {
         pr_err("Failed to allocate sk_buff.\n");
         return -ENOMEM;
@@ -189,34 +555,492 @@ static int send_message(const char *msg, int pid, int seq) {
     return ret;
 }
 
+static int send_error(__u32 pid, __u32 seq, int error) {
+    struct sk_buff *skb = NULL;
+    void *hdr = NULL;
+
+    skb = genlmsg_new(nla_total_size(sizeof(__s32)), GFP_KERNEL);
+    if (!skb) {
+        pr_err("Failed to allocate sk_buff.\n");
+        return -ENOMEM;
+    }
+
+    hdr = genlmsg_put(skb, 0, seq, &calc_family, 0, COMMAND_SERVER);
+    if (!hdr) {
+        pr_err("Failed to create Generic Netlink header.\n");
+        kfree_skb(skb);
+        return -ENOMEM;
+    }
+
+    if (nla_put_s32(skb, ATTR_ERRNO, error)) {
+        pr_err("Failed to add error code.\n");
+        kfree_skb(skb);
+        return -EMSGSIZE;
+    }
+
+    genlmsg_end(skb, hdr);
+
+    return genlmsg_unicast(&init_net, skb, pid);
+}
+
+static int forward_message(struct genl_info *info, int pid, int seq, int flags, __u32 stream) {
+    struct sk_buff *skb = NULL;
+    void *hdr = NULL;
+    void *data = NULL;
+    struct nlattr *attr = NULL;
+    int len = genlmsg_len(info->genlhdr);
+
+    if (pid == 0) {
+        pr_err("Invalid PID specified.\n");
+        return -EINVAL;
+    }
+
+    skb = genlmsg_new(len, GFP_KERNEL);
+    if (!skb) {
+        pr_err("Failed to allocate sk_buff.\n");
+        return -ENOMEM;
+    }
+
+    hdr = genlmsg_put(skb, 0, seq, &calc_family, flags, COMMAND_SERVER);
+    if (!hdr) {
+        pr_err("Failed to create Generic Netlink header.\n");
+        kfree_skb(skb);
+        return -ENOMEM;
+    }
+
+    data = skb_put_data(skb, genlmsg_data(info->genlhdr), len);
+    if (stream != 0) {
+        // Идентификаторы потоков разных клиентов могут совпадать: сервер получает идентификатор ретранслятора
+        attr = nla_find(data, len, ATTR_STREAM);
+        if (attr) {
+            *(__u32 *)nla_data(attr) = stream;
+        }
+    }
+    genlmsg_end(skb, hdr);
+
+    int ret = genlmsg_unicast(&init_net, skb, pid);
+    if (ret) {
+        pr_err("Failed to forward message to PID %d, seq %d. Error: %d\n", pid, seq, ret);
+    } else {
+        pr_debug("Message forwarded to PID %d with sequence number %d (%d bytes)\n", pid, seq, len);
+    }
+    return ret;
+}
+
+static int publish_message(struct genl_info *info, __u32 topic, int flags) {
+    struct sk_buff *skb = NULL;
+    void *hdr = NULL;
+    int len = genlmsg_len(info->genlhdr);
+    int ret = 0;
+
+    if (!genl_has_listeners(&calc_family, &init_net, CALC_GROUP_RESULTS)) {
+        return 0;
+    }
+
+    skb = genlmsg_new(len + nla_total_size(sizeof(__u32)), GFP_KERNEL);
+    if (!skb) {
+        pr_err("Failed to allocate sk_buff.\n");
+        return -ENOMEM;
+    }
+
+    hdr = genlmsg_put(skb, 0, 0, &calc_family, flags, COMMAND_SERVER);
+    if (!hdr) {
+        pr_err("Failed to create Generic Netlink header.\n");
+        kfree_skb(skb);
+        return -ENOMEM;
+    }
+
+    skb_put_data(skb, genlmsg_data(info->genlhdr), len);
+    if (nla_put_u32(skb, ATTR_TOPIC, topic)) {
+        pr_err("Failed to add topic to published message.\n");
+        kfree_skb(skb);
+        return -EMSGSIZE;
+    }
+    genlmsg_end(skb, hdr);
+
+    ret = genlmsg_multicast(&calc_family, skb, 0, CALC_GROUP_RESULTS, GFP_KERNEL);
+    if (ret == -ESRCH) {
+        // Подписчики ушли после проверки genl_has_listeners: ответ никому не доставлен
+        return 0;
+    }
+    if (ret == -ENOBUFS) {
+        // Подписчик с переполненным буфером пропускает сообщение (ENOBUFS на его сокете), остальные его получили
+        this_cpu_inc(relay_stats.publish_overflows);
+        pr_debug("Published reply on topic %u dropped by a subscriber with a full buffer\n", topic);
+        ret = 0;
+    }
+    if (ret) {
+        pr_err("Failed to publish reply on topic %u. Error: %d\n", topic, ret);
+        return ret;
+    }
+    this_cpu_inc(relay_stats.published);
+    pr_debug("Reply published on topic %u (%d bytes)\n", topic, len);
+    return 0;
+}
+
+static int validate_batch(const struct nlattr *batch) {
+    const struct nlattr *entry = NULL;
+    int rem = 0;
+
+    nla_for_each_nested(entry, batch, rem) {
+        if (nla_type(entry) != ATTR_MSG || nla_len(entry) == 0 || nla_len(entry) > MSG_MAX_LEN) {
+            pr_err("Invalid batch entry: type %d, length %d\n", nla_type(entry), nla_len(entry));
+            return -EINVAL;
+        }
+        if (((const char *)nla_data(entry))[nla_len(entry) - 1] != '\0') {
+            pr_err("Batch entry is not a NUL-terminated string\n");
+            return -EINVAL;
+        }
+    }
+    if (rem > 0) {
+        pr_err("Batch has %d bytes of trailing data\n", rem);
+        return -EINVAL;
+    }
+    return 0;
+}
+
+static bool is_server(__u32 pid) {
+    bool found = false;
+
+    rcu_read_lock();
+    found = calc_server_lookup(rcu_dereference(servers), pid) != NULL;
+    rcu_read_unlock();
+    return found;
+}
+
+static int register_server(__u32 pid, int credits) {
+    struct calc_servers *registry = NULL;
+    struct calc_servers *updated = NULL;
+    struct calc_server *server = NULL;
+    int count = 0;
+
+    // Port id закрытого сокета может достаться новому серверу раньше, чем reap_servers удалит прежний
+    flush_work(&reap_work);
+
+    mutex_lock(&servers_lock);
+    registry = rcu_dereference_protected(servers, lockdep_is_held(&servers_lock));
+    count = registry ? registry->count : 0;
+    server = calc_server_lookup(registry, pid);
+    if (server) {
+        calc_server_renew(server, credits);
+        mutex_unlock(&servers_lock);
+        return 0;
+    }
+    if (count == CALC_MAX_SERVERS) {
+        mutex_unlock(&servers_lock);
+        return -ENOSPC;
+    }
+    server = kzalloc(sizeof(*server), GFP_KERNEL);
+    updated = kmalloc(struct_size(updated, list, count + 1), GFP_KERNEL);
+    if (!server || !updated) {
+        mutex_unlock(&servers_lock);
+        kfree(server);
+        kfree(updated);
+        return -ENOMEM;
+    }
+    calc_server_init(server, pid, credits);
+    calc_servers_add(registry, updated, server);
+    rcu_assign_pointer(servers, updated);
+    mutex_unlock(&servers_lock);
+
+    if (registry) {
+        kfree_rcu(registry, rcu);
+    }
+    pr_info("Registered server with PID %u, %d credits (%d servers)\n", pid, credits, count + 1);
+    return 0;
+}
+
+static int unregister_server(__u32 pid) {
+    struct calc_server *server = NULL;
+
+    mutex_lock(&servers_lock);
+    server = calc_server_lookup(rcu_dereference_protected(servers, lockdep_is_held(&servers_lock)), pid);
+    if (server) {
+        WRITE_ONCE(server->draining, true);
+    }
+    mutex_unlock(&servers_lock);
+    return server ? 0 : -ENOENT;
+}
+
+static void mark_server_dead(__u32 pid) {
+    rcu_read_lock();
+    if (calc_server_mark_dead(rcu_dereference(servers), pid)) {
+        schedule_work(&reap_work);
+    }
+    rcu_read_unlock();
+}
+
+static void fail_route(const struct calc_route *route, void *context) {
+    send_error(route->client_pid, route->client_seq, ECONNRESET);
+}
+
+static void reap_servers(struct work_struct *work) {
+    struct calc_servers *registry = NULL;
+    struct calc_servers *updated = NULL;
+    struct calc_server *dead[CALC_MAX_SERVERS];
+    int n_dead = 0;
+    int count = 0;
+    int failed = 0;
+    int i;
+
+    mutex_lock(&servers_lock);
+    registry = rcu_dereference_protected(servers, lockdep_is_held(&servers_lock));
+    count = registry ? registry->count : 0;
+    updated = kmalloc(struct_size(updated, list, count), GFP_KERNEL);
+    if (!updated) {
+        // Помеченные серверы уже не получают запросы; удаление повторит следующее уведомление
+        mutex_unlock(&servers_lock);
+        pr_err("Failed to allocate the server registry\n");
+        return;
+    }
+    n_dead = calc_servers_remove_dead(registry, updated, dead);
+    if (n_dead == 0) {
+        mutex_unlock(&servers_lock);
+        kfree(updated);
+        return;
+    }
+    count = updated->count;
+    rcu_assign_pointer(servers, updated);
+    mutex_unlock(&servers_lock);
+    kfree_rcu(registry, rcu);
+
+    for (i = 0; i < n_dead; i++) {
+        failed = calc_server_fail_routes(&routes, dead[i]->pid, fail_route, NULL);
+        this_cpu_add(relay_stats.failed, failed);
+        spin_lock(&streams_lock);
+        calc_stream_close_server(&streams, dead[i]->pid);
+        spin_unlock(&streams_lock);
+        pr_info("Server with PID %u is gone, %d requests in flight failed (%d servers)\n", dead[i]->pid, failed, count);
+        kfree_rcu(dead[i], rcu);
+    }
+}
+
+static int calc_netlink_event(struct notifier_block *nb, unsigned long event, void *ptr) {
+    struct netlink_notify *notify = ptr;
+
+    if (event == NETLINK_URELEASE && notify->protocol == NETLINK_GENERIC && net_eq(notify->net, &init_net)) {
+        mark_server_dead(notify->portid);
+    }
+    return NOTIFY_DONE;
+}
+
+static void track_server(__u32 pid, int delta) {
+    rcu_read_lock();
+    calc_server_track(rcu_dereference(servers), pid, delta);
+    rcu_read_unlock();
+}
+
+static int pick_server(__u32 *pid) {
+    const struct calc_servers *registry = NULL;
+    unsigned int start = 0;
+    int result = 0;
+
+    rcu_read_lock();
+    registry = rcu_dereference(servers);
+    if (registry && registry->count) {
+        start = this_cpu_inc_return(next_server);
+    }
+    result = calc_server_pick(registry, start, pid);
+    rcu_read_unlock();
+    return result;
+}
+
+static void close_stream(__u32 id) {
+    if (id == 0) {
+        return;
+    }
+    spin_lock(&streams_lock);
+    calc_stream_close(&streams, id);
+    spin_unlock(&streams_lock);
+}
+
+static int stats_get(char *buffer, const struct kernel_param *kp) {
+    struct calc_stats total = {0};
+    unsigned int cpu;
+
+    for_each_possible_cpu(cpu) {
+        const struct calc_stats *cpu_stats = per_cpu_ptr(&relay_stats, cpu);
+        total.requests += READ_ONCE(cpu_stats->requests);
+        total.offloaded += READ_ONCE(cpu_stats->offloaded);
+        total.replies += READ_ONCE(cpu_stats->replies);
+        total.busy += READ_ONCE(cpu_stats->busy);
+        total.failed += READ_ONCE(cpu_stats->failed);
+        total.published += READ_ONCE(cpu_stats->published);
+        total.publish_overflows += READ_ONCE(cpu_stats->publish_overflows);
+    }
+    return sysfs_emit(buffer, "requests %llu\noffloaded %llu\nreplies %llu\nbusy %llu\nfailed %llu\npublished %llu\npublish_overflows %llu\n"
+                      "in_flight %u\n",
+                      total.requests, total.offloaded, total.replies, total.busy, total.failed, total.published, total.publish_overflows,
+                      calc_route_count(&routes));
+}
+
+static int route_stream(struct genl_info *info, struct calc_stream *stream) {
+    __u32 client_stream = nla_get_u32(info->attrs[ATTR_STREAM]);
+    __u32 chunk = info->attrs[ATTR_CHUNK] ? nla_get_u32(info->attrs[ATTR_CHUNK]) : 0;
+    int ret = 0;
+
+    if (chunk != 0) {
+        spin_lock(&streams_lock);
+        ret = calc_stream_find(&streams, info->snd_portid, client_stream, stream);
+        spin_unlock(&streams_lock);
+        // Емкость проверяется при открытии потока: принятый поток сервер получает целиком
+        if (ret == 0) {
+            track_server(stream->server_pid, 1);
+        }
+        return ret;
+    }
+    ret = pick_server(&stream->server_pid);
+    if (ret) {
+        return ret;
+    }
+    spin_lock(&streams_lock);
+    stream->id = calc_stream_open(&streams, info->snd_portid, client_stream, stream->server_pid);
+    spin_unlock(&streams_lock);
+    stream->client_pid = info->snd_portid;
+    stream->client_stream = client_stream;
+    return 0;
+}
+
+static int offload_request(struct genl_info *info) {
+    struct sk_buff *skb = NULL;
+    void *hdr = NULL;
+    struct calc_ops_result result;
+    int ret;
+
+    if (!READ_ONCE(offload) || !info->attrs[ATTR_OP] || !info->attrs[ATTR_ARG1] || !info->attrs[ATTR_ARG2] || info->attrs[ATTR_MSG] ||
+        info->attrs[ATTR_BATCH] || info->attrs[ATTR_ARRAY1] || info->attrs[ATTR_STREAM] || info->attrs[ATTR_TOPIC]) {
+        return -EOPNOTSUPP;
+    }
+    if (calc_ops_compute(nla_get_u8(info->attrs[ATTR_OP]), nla_get_s64(info->attrs[ATTR_ARG1]), nla_get_s64(info->attrs[ATTR_ARG2]),
+                         &result)) {
+        return -EOPNOTSUPP;
+    }
+
+    skb = genlmsg_new(nla_total_size_64bit(sizeof(__s64)), GFP_KERNEL);
+    if (!skb) {
+        pr_err("Failed to allocate sk_buff.\n");
+        return -ENOMEM;
+    }
+
+    hdr = genlmsg_put(skb, info->snd_portid, info->snd_seq, &calc_family, 0, COMMAND_SERVER);
+    if (!hdr) {
+        pr_err("Failed to create Generic Netlink header.\n");
+        kfree_skb(skb);
+        return -ENOMEM;
+    }
+
+    ret = result.error ? nla_put_s32(skb, ATTR_ERRNO, result.error) : nla_put_s64(skb, ATTR_RESULT, result.value, ATTR_UNSPEC);
+    if (ret) {
+        pr_err("Failed to add offloaded result.\n");
+        kfree_skb(skb);
+        return -EMSGSIZE;
+    }
+
+    genlmsg_end(skb, hdr);
+
+    ret = genlmsg_reply(skb, info);
+    if (ret) {
+        pr_err("Failed to send offloaded reply to PID %u, seq %u. Error: %d\n", info->snd_portid, info->snd_seq, ret);
+    } else {
+        this_cpu_inc(relay_stats.offloaded);
+        pr_debug("Request %u from PID %u answered in the module\n", info->snd_seq, info->snd_portid);
+    }
+    return ret;
+}
+
+static int route_request(struct genl_info *info, __u32 pid_server, __u32 stream) {
+    struct calc_route route;
+    __u32 *cursor = NULL;
+    __u32 topic = info->attrs[ATTR_TOPIC] ? nla_get_u32(info->attrs[ATTR_TOPIC]) : 0;
+    __u32 id = 0;
+    int result = 0;
+
+    cursor = get_cpu_ptr(&route_cursor);
+    id = calc_route_add(&routes, cursor, calc_route_base(smp_processor_id()), info->snd_portid, info->snd_seq, pid_server, topic);
+    put_cpu_ptr(&route_cursor);
+    if (id == 0) {
+        pr_err("Too many requests in flight, request from PID %u rejected\n", info->snd_portid);
+        track_server(pid_server, -1);
+        NL_SET_ERR_MSG(info->extack, "Too many requests in flight");
+        this_cpu_inc(relay_stats.busy);
+        return -EBUSY;
+    }
+    this_cpu_inc(relay_stats.requests);
+    pr_debug("Request %u from PID %u routed to server %u as %u\n", info->snd_seq, info->snd_portid, pid_server, id);
+
+    result = forward_message(info, pid_server, id, 0, stream);
+    if (result != 0) {
+        pr_err("Failed to forward client message to server. Error: %d\n", result);
+        if (calc_route_take(&routes, id, &route) == 0) {
+            track_server(pid_server, -1);
+        }
+        if (result == -ECONNREFUSED) {
+            mark_server_dead(pid_server);
+        }
+    }
+    return result;
+}
+
 static int calc_cmd_client(struct sk_buff *skb, struct genl_info *info) {
     struct nlattr *na = NULL;
     char *msg = NULL;
     char const *message_pass = "No server registered yet. Message will be dropped";
+    __u32 pid_server = 0;
+    struct calc_stream stream = {0};
     int result = -EINVAL;
 
     na = info->attrs[ATTR_MSG];
-    if (!na) {
+    if (!na && !info->attrs[ATTR_BATCH] && !info->attrs[ATTR_OP] && !info->attrs[ATTR_STREAM]) {
         pr_err("Received a message with no payload.\n");
         return result;
     }
 
-    //@todo: не самое хорошее решение, сходу не могу придумать, как красиво сделать
-    pid_client = info->snd_portid;
-    seq_client = nlmsg_hdr(skb)->nlmsg_seq;
-    pr_info("Registered client with PID %d and sequence number %d\n", pid_client, seq_client);
+    result = offload_request(info);
+    if (result != -EOPNOTSUPP) {
+        return result;
+    }
 
-    msg = nla_data(na);
-    pr_info("Message from client (PID %d): %s\n", pid_client, msg);
+    if (info->attrs[ATTR_BATCH]) {
+        result = validate_batch(info->attrs[ATTR_BATCH]);
+        if (result) {
+            return result;
+        }
+    }
 
-    if (pid_server != 0) {
-        result = send_message(msg, pid_server, seq_server);
-        if (result != 0) {
-            pr_err("Failed to forward client message to server. Error: %d\n", result);
+    if (na) {
+        msg = nla_data(na);
+        pr_debug("Message from client (PID %u): %s\n", info->snd_portid, msg);
+    }
+
+    if (info->attrs[ATTR_STREAM]) {
+        result = route_stream(info, &stream);
+        if (result == -ENOENT) {
+            pr_err("Chunk of unknown stream %u from PID %u\n", nla_get_u32(info->attrs[ATTR_STREAM]), info->snd_portid);
+            return result;
+        }
+        pid_server = stream.server_pid;
+    } else {
+        result = pick_server(&pid_server);
+    }
+    if (result == -EBUSY) {
+        pr_debug("All servers are out of credits, request %u from PID %u rejected\n", info->snd_seq, info->snd_portid);
+        NL_SET_ERR_MSG(info->extack, "All servers are out of credits");
+        this_cpu_inc(relay_stats.busy);
+        return result;
+    }
+    if (result == 0) {
+        result = route_request(info, pid_server, stream.id);
+        // Сервер завершился, а уведомление о закрытии его сокета еще не обработано: запрос получает другой сервер
+        if (result == -ECONNREFUSED && !info->attrs[ATTR_STREAM] && pick_server(&pid_server) == 0) {
+            result = route_request(info, pid_server, 0);
+        }
+        // Поток закрывается последним фрагментом; после ошибки пересылки сервер не получит его целиком
+        if (result != 0 || info->attrs[ATTR_EOS]) {
+            close_stream(stream.id);
         }
     } else {
         pr_info("%s\n", message_pass);
-        result = send_message(message_pass, pid_client, seq_client);
+        result = send_message(message_pass, info->snd_portid, info->snd_seq);
         if (result != 0) {
             pr_err("Failed to sending error message. Error: %d\n", result);
         }
@@ -226,38 +1050,79 @@ static int calc_cmd_client(struct sk_buff *skb, struct genl_info *info) {
     return result;
 }
 
-//@todo: из описания задания не понятно как надо обрабатывать разрыв соединия,
-// в текущей реализации надо выгружать и загружать модуль ядра, если сервер разъединился
+static int calc_cmd_register(struct sk_buff *skb, struct genl_info *info) {
+    __u32 credits = info->attrs[ATTR_CREDITS] ? nla_get_u32(info->attrs[ATTR_CREDITS]) : 0;
+    int result = register_server(info->snd_portid, min_t(__u32, credits, INT_MAX));
+
+    if (result) {
+        pr_err("Failed to register server with PID %u. Error: %d\n", info->snd_portid, result);
+    }
+    return result;
+}
+
+static int calc_cmd_unregister(struct sk_buff *skb, struct genl_info *info) {
+    int result = unregister_server(info->snd_portid);
+
+    if (result) {
+        pr_err("Server with PID %u is not registered\n", info->snd_portid);
+    } else {
+        pr_info("Server with PID %u unregistered, replies to its requests in flight are still forwarded\n", info->snd_portid);
+    }
+    return result;
+}
+
 static int calc_cmd_server(struct sk_buff *skb, struct genl_info *info) {
     struct nlattr *na = NULL;
     char *msg = NULL;
+    struct calc_route route;
+    int more = info->nlhdr->nlmsg_flags & NLM_F_MULTI;
     int result = -EINVAL;
 
     na = info->attrs[ATTR_MSG];
-    if (!na) {
+    if (!na && !info->attrs[ATTR_BATCH] && !info->attrs[ATTR_RESULT] && !info->attrs[ATTR_ERRNO] && !info->attrs[ATTR_RESULTS] &&
+        !info->attrs[ATTR_STREAM]) {
         pr_err("Received a message with no payload.\n");
         return result;
     }
 
-    msg = nla_data(na);
-
-    //@todo: не самое хорошее решение, сходу не могу придумать, как красиво сделать
-    if (pid_server == 0) {
-        pid_server = info->snd_portid;
-        seq_server = nlmsg_hdr(skb)->nlmsg_seq;
-        pr_info("Registered server with PID %d and sequence number %d\n", pid_server, seq_server);
+    if (!is_server(info->snd_portid)) {
+        if (!na) {
+            pr_err("Server registration message has no payload.\n");
+            return result;
+        }
+        result = register_server(info->snd_portid, 0);
+        if (result) {
+            pr_err("Failed to register server with PID %u. Error: %d\n", info->snd_portid, result);
+            return result;
+        }
+        msg = nla_data(na);
 
-        result = send_message(msg, pid_server, seq_server);
+        result = send_message(msg, info->snd_portid, info->snd_seq);
         if (result) {
             pr_err("Failed to send initial server message. Error: %d\n", result);
         }
         return result;
     } else {
-        result = send_message(msg, pid_client, seq_client);
+        // Промежуточные части ответа идут тому же клиенту, маршрут освобождает последняя часть
+        if (calc_route_find(&routes, info->snd_seq, &route) || route.server_pid != info->snd_portid ||
+            (!more && calc_route_take(&routes, info->snd_seq, &route))) {
+            pr_err("No request %u in flight for reply from server %u\n", info->snd_seq, info->snd_portid);
+            return -ENOENT;
+        }
+        if (!more) {
+            track_server(route.server_pid, -1);
+        }
+
+        // Подписчики получают ответ, даже если клиент, запросивший его, уже закрыл сокет
+        if (route.topic != 0) {
+            publish_message(info, route.topic, more);
+        }
+        result = forward_message(info, route.client_pid, route.client_seq, more, 0);
         if (result) {
             pr_err("Failed to forward server message to client. Error: %d\n", result);
         } else {
-            pr_info("Message from server forwarded to client.\n");
+            this_cpu_inc(relay_stats.replies);
+            pr_debug("Message from server forwarded to client %u with sequence number %u.\n", route.client_pid, route.client_seq);
         }
         return result;
     }
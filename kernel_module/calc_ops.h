@@ -0,0 +1,102 @@
+#ifndef CALC_OPS_H
+#define CALC_OPS_H
+
+/*
+ * Вычисление простых операций бинарного протокола в ретрансляторе (параметр offload).
+ *
+ * Коды операций, результаты и ошибки (ERANGE, EDOM) повторяют реестр операций сервера:
+ * клиент не отличает ответ модуля от ответа сервера. Неизвестная операция передается серверу.
+ */
+
+#include <linux/types.h>
+
+#ifdef __KERNEL__
+#include <linux/errno.h>
+#include <linux/math64.h>
+#else
+#include <errno.h>
+#endif
+
+/*
+ * Коды операций ATTR_OP (совпадают с netlink::server::OP).
+ */
+#define CALC_OP_ADD 1
+#define CALC_OP_SUB 2
+#define CALC_OP_MUL 3
+#define CALC_OP_DIV 4
+#define CALC_OP_MOD 5
+
+/**
+ * @brief Результат операции: значение или код ошибки, как в ответе сервера.
+ */
+struct calc_ops_result {
+    __s32 error; /**< 0 при успехе, ERANGE - переполнение, EDOM - деление на ноль (положительные, как ATTR_ERRNO сервера). */
+    __s64 value; /**< Результат операции (при ошибке 0). */
+};
+
+/**
+ * @brief Частное с округлением к нулю; на 32-битных архитектурах ядра деление s64 - через div64_s64.
+ */
+static inline __s64 calc_ops_quotient(__s64 arg1, __s64 arg2) {
+#ifdef __KERNEL__
+    return div64_s64(arg1, arg2);
+#else
+    return arg1 / arg2;
+#endif
+}
+
+/**
+ * @brief Вычисляет операцию с проверкой переполнения.
+ *
+ * Правила совпадают с netlink::server::arithmetic: переполнение дает ERANGE, деление и остаток
+ * на ноль - EDOM, остаток от деления на -1 равен 0.
+ *
+ * @param op Код операции ATTR_OP.
+ * @param arg1 Первый аргумент.
+ * @param arg2 Второй аргумент.
+ * @param result Результат операции.
+ *
+ * @return 0, если операция вычислена, -EOPNOTSUPP, если операция неизвестна (запрос передается серверу).
+ */
+static inline int calc_ops_compute(__u8 op, __s64 arg1, __s64 arg2, struct calc_ops_result *result) {
+    int overflow = 0;
+
+    result->error = 0;
+    result->value = 0;
+    switch (op) {
+        case CALC_OP_ADD:
+            overflow = __builtin_add_overflow(arg1, arg2, &result->value);
+            break;
+        case CALC_OP_SUB:
+            overflow = __builtin_sub_overflow(arg1, arg2, &result->value);
+            break;
+        case CALC_OP_MUL:
+            overflow = __builtin_mul_overflow(arg1, arg2, &result->value);
+            break;
+        case CALC_OP_DIV:
+        case CALC_OP_MOD:
+            if (arg2 == 0) {
+                result->error = EDOM;
+                return 0;
+            }
+            if (arg2 == -1) {
+                // Единственное переполнение деления - минимальное значение на -1
+                overflow = op == CALC_OP_DIV && __builtin_sub_overflow((__s64)0, arg1, &result->value);
+                break;
+            }
+            result->value = calc_ops_quotient(arg1, arg2);
+            if (op == CALC_OP_MOD) {
+                result->value = arg1 - result->value * arg2;
+            }
+            break;
+        default:
+            return -EOPNOTSUPP;
+    }
+    if (overflow) {
+        result->error = ERANGE;
+        result->value = 0;
+    }
+    return 0;
+}
+
+#endif /* CALC_OPS_H */
@@ -0,0 +1,352 @@
+#ifndef CALC_ROUTE_H
+#define CALC_ROUTE_H
+
+/*
+ * Таблицы ретранслятора: маршруты запросов в полете (запрос сервера -> клиент и его номер)
+ * и потоки фрагментов (поток клиента -> сервер, который его собирает).
+ *
+ * Примитивы ядра (cmpxchg, smp_load_acquire, READ_ONCE) вызываются через обертки calc_*,
+ * которые вне ядра заменяются встроенными атомарными операциями компилятора.
+ */
+
+#include <linux/types.h>
+
+#ifdef __KERNEL__
+#include <linux/atomic.h>
+#include <linux/errno.h>
+#include <linux/string.h>
+#define calc_cmpxchg(ptr, old, new) cmpxchg(ptr, old, new)
+#define calc_load_acquire(ptr) smp_load_acquire(ptr)
+#define calc_store_release(ptr, value) smp_store_release(ptr, value)
+#define calc_read_once(value) READ_ONCE(value)
+#define calc_rmb() smp_rmb()
+#else
+#include <errno.h>
+#include <string.h>
+/** Возвращает прежнее значение *ptr, как cmpxchg ядра. */
+static inline __u32 calc_cmpxchg(__u32 *ptr, __u32 expected, __u32 desired) {
+    __atomic_compare_exchange_n(ptr, &expected, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE);
+    return expected;
+}
+#define calc_load_acquire(ptr) __atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+#define calc_store_release(ptr, value) __atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+#define calc_read_once(value) __atomic_load_n(&(value), __ATOMIC_RELAXED)
+#define calc_rmb() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#endif
+
+#define CALC_ROUTE_TABLE_SIZE 4096 /**< Максимальное количество запросов в полете (степень двойки). */
+#define CALC_ROUTE_TABLE_MASK (CALC_ROUTE_TABLE_SIZE - 1)
+#define CALC_ROUTE_CPU_SHIFT 22 /**< Старшие 10 бит идентификатора запроса - номер CPU, выдавшего его. */
+#define CALC_ROUTE_ID_MASK ((1u << CALC_ROUTE_CPU_SHIFT) - 1)
+
+/**
+ * @brief Маршрут одного запроса в полете.
+ */
+struct calc_route {
+    __u32 id;         /**< Идентификатор запроса, назначенный ретранслятором (0 - маршрут не опубликован). */
+    __u32 busy;       /**< Слот занят: захватывается cmpxchg до заполнения, освобождается после снятия id. */
+    __u32 client_pid; /**< PID (port id) клиента. */
+    __u32 client_seq; /**< Исходный номер последовательности запроса клиента. */
+    __u32 server_pid; /**< PID сервера, которому передан запрос. */
+    __u32 topic;      /**< Тема, подписчикам которой рассылается ответ (0 - ответ только клиенту). */
+};
+
+/**
+ * @brief Таблица маршрутов запросов в полете.
+ *
+ * Идентификатор запроса определяет слот (id & CALC_ROUTE_TABLE_MASK), поэтому поиск
+ * выполняется за O(1) без пробирования: при выдаче идентификатора пропускаются те,
+ * чей слот занят.
+ *
+ * Таблица не требует блокировок: слот захватывается cmpxchg поля busy, маршрут публикуется
+ * записью id с release-семантикой, а освобождает его тот, кто первым сбросил id cmpxchg.
+ * Идентификаторы выдаются курсорами вызывающего (в модуле - свой курсор на каждом CPU),
+ * поэтому общий счетчик, за строку кэша которого конкурировали бы CPU, не нужен.
+ */
+struct calc_route_table {
+    struct calc_route routes[CALC_ROUTE_TABLE_SIZE];
+};
+
+/**
+ * @brief Инициализирует пустую таблицу.
+ */
+static inline void calc_route_init(struct calc_route_table *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @brief Старшие биты идентификаторов, которые выдает CPU.
+ *
+ * Идентификаторы разных CPU не совпадают, даже если их курсоры проходят одни и те же слоты.
+ */
+static inline __u32 calc_route_base(unsigned int cpu) {
+    return (__u32)cpu << CALC_ROUTE_CPU_SHIFT;
+}
+
+/**
+ * @brief Добавляет маршрут запроса.
+ *
+ * @param table Таблица маршрутов.
+ * @param cursor Курсор выдачи идентификаторов (не разделяется между потоками).
+ * @param base Старшие биты идентификатора (calc_route_base).
+ * @param client_pid PID клиента.
+ * @param client_seq Номер последовательности запроса клиента.
+ * @param server_pid PID сервера, которому будет передан запрос.
+ * @param topic Тема рассылки ответа (0 - без рассылки).
+ *
+ * @return Идентификатор запроса (номер последовательности для сервера) или 0, если таблица заполнена.
+ */
+static inline __u32 calc_route_add(struct calc_route_table *table, __u32 *cursor, __u32 base, __u32 client_pid, __u32 client_seq,
+                                   __u32 server_pid, __u32 topic) {
+    struct calc_route *route = NULL;
+    __u32 id = 0;
+    int tries = 0;
+
+    for (tries = 0; tries < CALC_ROUTE_TABLE_SIZE; tries++) {
+        id = base | (++*cursor & CALC_ROUTE_ID_MASK);
+        if (id == 0) {
+            id = base | (++*cursor & CALC_ROUTE_ID_MASK);
+        }
+        route = &table->routes[id & CALC_ROUTE_TABLE_MASK];
+        if (calc_read_once(route->busy) == 0 && calc_cmpxchg(&route->busy, 0, 1) == 0) {
+            route->client_pid = client_pid;
+            route->client_seq = client_seq;
+            route->server_pid = server_pid;
+            route->topic = topic;
+            calc_store_release(&route->id, id);
+            return id;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Количество запросов в полете (просмотр всей таблицы, для статистики и тестов).
+ */
+static inline __u32 calc_route_count(const struct calc_route_table *table) {
+    __u32 count = 0;
+    int i;
+
+    for (i = 0; i < CALC_ROUTE_TABLE_SIZE; i++) {
+        count += calc_read_once(table->routes[i].id) != 0;
+    }
+    return count;
+}
+
+/**
+ * @brief Находит маршрут запроса, не освобождая слот (промежуточная часть ответа NLM_F_MULTI).
+ *
+ * @param table Таблица маршрутов.
+ * @param id Идентификатор запроса (номер последовательности ответа сервера).
+ * @param route Найденный маршрут.
+ *
+ * @return 0 если маршрут найден, -ENOENT в противном случае.
+ */
+static inline int calc_route_find(const struct calc_route_table *table, __u32 id, struct calc_route *route) {
+    const struct calc_route *slot = &table->routes[id & CALC_ROUTE_TABLE_MASK];
+
+    if (id == 0 || calc_load_acquire(&slot->id) != id) {
+        return -ENOENT;
+    }
+    route->id = id;
+    route->client_pid = calc_read_once(slot->client_pid);
+    route->client_seq = calc_read_once(slot->client_seq);
+    route->server_pid = calc_read_once(slot->server_pid);
+    route->topic = calc_read_once(slot->topic);
+    // Последняя часть ответа могла освободить слот, а новый запрос - заполнить его заново
+    calc_rmb();
+    return calc_read_once(slot->id) == id ? 0 : -ENOENT;
+}
+
+/**
+ * @brief Извлекает маршрут запроса и освобождает его слот.
+ *
+ * Из нескольких одновременных извлечений одного маршрута (повторный ответ сервера)
+ * успешно только одно.
+ *
+ * @param table Таблица маршрутов.
+ * @param id Идентификатор запроса (номер последовательности ответа сервера).
+ * @param route Найденный маршрут.
+ *
+ * @return 0 если маршрут найден, -ENOENT в противном случае.
+ */
+static inline int calc_route_take(struct calc_route_table *table, __u32 id, struct calc_route *route) {
+    struct calc_route *slot = &table->routes[id & CALC_ROUTE_TABLE_MASK];
+
+    if (id == 0 || calc_load_acquire(&slot->id) != id) {
+        return -ENOENT;
+    }
+    // Пока id опубликован, поля слота не меняются: их перезаписывает только следующий захват busy
+    *route = *slot;
+    if (calc_cmpxchg(&slot->id, id, 0) != id) {
+        return -ENOENT;
+    }
+    calc_store_release(&slot->busy, 0);
+    return 0;
+}
+
+/**
+ * @brief Извлекает очередной маршрут запроса, переданного серверу (сервер завершился).
+ *
+ * @param table Таблица маршрутов.
+ * @param server_pid PID сервера.
+ * @param position Слот, с которого продолжается просмотр (0 в начале).
+ * @param route Извлеченный маршрут.
+ *
+ * @return 0 если маршрут извлечен, -ENOENT если маршрутов сервера больше нет.
+ */
+static inline int calc_route_take_server(struct calc_route_table *table, __u32 server_pid, int *position, struct calc_route *route) {
+    while (*position < CALC_ROUTE_TABLE_SIZE) {
+        const struct calc_route *slot = &table->routes[(*position)++];
+        __u32 id = calc_load_acquire(&slot->id);
+        if (id != 0 && calc_read_once(slot->server_pid) == server_pid && calc_route_take(table, id, route) == 0) {
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+#define CALC_STREAM_TABLE_SIZE 256 /**< Максимальное количество одновременно передаваемых потоков. */
+
+/**
+ * @brief Поток фрагментов одного запроса: все фрагменты направляются одному серверу.
+ */
+struct calc_stream {
+    __u32 id;            /**< Идентификатор потока, назначенный ретранслятором (0 - слот свободен). */
+    __u32 client_pid;    /**< PID (port id) клиента. */
+    __u32 client_stream; /**< Идентификатор потока, выбранный клиентом (уникален только у этого клиента). */
+    __u32 server_pid;    /**< PID сервера, который собирает поток. */
+    __u32 last_used;     /**< Значение часов таблицы при последнем фрагменте: вытесняется давно не обновлявшийся поток. */
+};
+
+/**
+ * @brief Таблица потоков, для которых еще не пришел последний фрагмент.
+ *
+ * Поиск по (PID клиента, поток клиента) выполняется перебором: таблица мала, а фрагмент
+ * потока (до десятков килобайт) копируется дольше, чем просматривается таблица.
+ * Таблица не синхронизирована: в модуле ее защищает спинлок.
+ */
+struct calc_stream_table {
+    struct calc_stream streams[CALC_STREAM_TABLE_SIZE];
+    __u32 next_id; /**< Последний выданный идентификатор. */
+    __u32 count;   /**< Количество занятых слотов. */
+    __u32 clock;   /**< Часы таблицы: увеличиваются при каждом открытии и поиске потока. */
+};
+
+/**
+ * @brief Инициализирует пустую таблицу потоков.
+ */
+static inline void calc_stream_init(struct calc_stream_table *table) {
+    memset(table, 0, sizeof(*table));
+}
+
+/**
+ * @brief Находит поток клиента и отмечает его использованным.
+ *
+ * @param table Таблица потоков.
+ * @param client_pid PID клиента.
+ * @param client_stream Идентификатор потока клиента.
+ * @param stream Найденный поток.
+ *
+ * @return 0 если поток найден, -ENOENT в противном случае.
+ */
+static inline int calc_stream_find(struct calc_stream_table *table, __u32 client_pid, __u32 client_stream, struct calc_stream *stream) {
+    int i;
+
+    for (i = 0; i < CALC_STREAM_TABLE_SIZE; i++) {
+        struct calc_stream *slot = &table->streams[i];
+        if (slot->id != 0 && slot->client_pid == client_pid && slot->client_stream == client_stream) {
+            slot->last_used = ++table->clock;
+            *stream = *slot;
+            return 0;
+        }
+    }
+    return -ENOENT;
+}
+
+/**
+ * @brief Закрывает поток (последний фрагмент передан или поток прерван).
+ *
+ * @param table Таблица потоков.
+ * @param id Идентификатор потока ретранслятора.
+ */
+static inline void calc_stream_close(struct calc_stream_table *table, __u32 id) {
+    int i;
+
+    for (i = 0; i < CALC_STREAM_TABLE_SIZE; i++) {
+        if (id != 0 && table->streams[i].id == id) {
+            table->streams[i].id = 0;
+            table->count--;
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Закрывает все потоки, которые собирает сервер (сервер завершился).
+ *
+ * @param table Таблица потоков.
+ * @param server_pid PID сервера.
+ */
+static inline void calc_stream_close_server(struct calc_stream_table *table, __u32 server_pid) {
+    int i;
+
+    for (i = 0; i < CALC_STREAM_TABLE_SIZE; i++) {
+        if (table->streams[i].id != 0 && table->streams[i].server_pid == server_pid) {
+            table->streams[i].id = 0;
+            table->count--;
+        }
+    }
+}
+
+/**
+ * @brief Открывает поток клиента (первый фрагмент) или начинает его заново.
+ *
+ * Если таблица заполнена, вытесняется поток, фрагменты которого дольше всех не приходили:
+ * клиент, завершившийся без последнего фрагмента, не занимает слот навсегда, а долгий,
+ * но активный поток не вытесняется раньше брошенных. Следующий фрагмент вытесненного
+ * потока получит -ENOENT.
+ *
+ * @param table Таблица потоков.
+ * @param client_pid PID клиента.
+ * @param client_stream Идентификатор потока клиента.
+ * @param server_pid PID сервера, которому будут направляться фрагменты.
+ *
+ * @return Идентификатор потока ретранслятора (уникален среди всех клиентов).
+ */
+static inline __u32 calc_stream_open(struct calc_stream_table *table, __u32 client_pid, __u32 client_stream, __u32 server_pid) {
+    struct calc_stream existing;
+    struct calc_stream *slot = NULL;
+    __u32 idle = 0;
+    int i;
+
+    if (calc_stream_find(table, client_pid, client_stream, &existing) == 0) {
+        calc_stream_close(table, existing.id);
+    }
+
+    for (i = 0; i < CALC_STREAM_TABLE_SIZE; i++) {
+        struct calc_stream *candidate = &table->streams[i];
+        if (candidate->id == 0) {
+            slot = candidate;
+            table->count++;
+            break;
+        }
+        // Разность с учетом переполнения часов
+        if (table->clock - candidate->last_used >= idle) {
+            idle = table->clock - candidate->last_used;
+            slot = candidate;
+        }
+    }
+
+    if (++table->next_id == 0) {
+        ++table->next_id;
+    }
+    slot->id = table->next_id;
+    slot->client_pid = client_pid;
+    slot->client_stream = client_stream;
+    slot->server_pid = server_pid;
+    slot->last_used = ++table->clock;
+    return slot->id;
+}
+
+#endif /* CALC_ROUTE_H */
@@ -0,0 +1,284 @@
+#ifndef CALC_SERVER_H
+#define CALC_SERVER_H
+
+/*
+ * Реестр серверов ретранслятора: выбор сервера, емкость и удаление завершившихся серверов.
+ *
+ * Функции заголовка получают снимок реестра, который вызывающий читает под rcu_read_lock
+ * или изменяет под servers_lock; выделение снимков и их освобождение после периода RCU
+ * выполняет модуль.
+ */
+
+#include <linux/types.h>
+
+#include "calc_route.h"
+
+#ifdef __KERNEL__
+#include <linux/atomic.h>
+typedef atomic_t calc_atomic_t;
+#define calc_atomic_read(v) atomic_read(v)
+#define calc_atomic_set(v, i) atomic_set(v, i)
+#define calc_atomic_add(i, v) atomic_add(i, v)
+#define calc_atomic_try_cmpxchg(v, old, new) atomic_try_cmpxchg(v, old, new)
+#define calc_write_once(x, value) WRITE_ONCE(x, value)
+#else
+#include <stdbool.h>
+typedef struct {
+    int counter;
+} calc_atomic_t;
+/** Заглушка struct rcu_head ядра: в userspace снимки освобождает вызывающий. */
+struct rcu_head {
+    struct rcu_head *next;
+    void (*func)(struct rcu_head *head);
+};
+static inline int calc_atomic_read(const calc_atomic_t *v) {
+    return __atomic_load_n(&v->counter, __ATOMIC_RELAXED);
+}
+static inline void calc_atomic_set(calc_atomic_t *v, int i) {
+    __atomic_store_n(&v->counter, i, __ATOMIC_RELAXED);
+}
+static inline void calc_atomic_add(int i, calc_atomic_t *v) {
+    __atomic_fetch_add(&v->counter, i, __ATOMIC_RELAXED);
+}
+/** При неудаче записывает в *old текущее значение, как atomic_try_cmpxchg ядра. */
+static inline bool calc_atomic_try_cmpxchg(calc_atomic_t *v, int *old, int desired) {
+    return __atomic_compare_exchange_n(&v->counter, old, desired, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#define calc_write_once(x, value) __atomic_store_n(&(x), value, __ATOMIC_RELAXED)
+#endif
+
+#define CALC_MAX_SERVERS 64 /**< Максимальное количество зарегистрированных серверов (рабочих потоков). */
+
+/**
+ * @brief Зарегистрированный сервер.
+ */
+struct calc_server {
+    struct rcu_head rcu;       /**< Освобождение после периода ожидания RCU. */
+    __u32 pid;                 /**< PID (port id) сервера. */
+    calc_atomic_t outstanding; /**< Запросы в полете на этом сервере: новый запрос получает наименее загруженный. */
+    int credits;               /**< Емкость сервера: наибольшее число запросов в полете (0 - без ограничения). */
+    bool draining;             /**< Регистрация отменена: новые запросы не направляются, ответы на принятые пересылаются. */
+    bool dead;                 /**< Сокет сервера закрыт: calc_servers_remove_dead удалит сервер из реестра. */
+};
+
+/**
+ * @brief Снимок реестра серверов: список не изменяется после публикации, изменение заменяет его копией.
+ */
+struct calc_servers {
+    struct rcu_head rcu;        /**< Освобождение снимка после периода ожидания RCU. */
+    int count;                  /**< Количество серверов в списке. */
+    struct calc_server *list[]; /**< Зарегистрированные серверы (в том числе draining и dead до удаления). */
+};
+
+/**
+ * @brief Инициализирует новый сервер.
+ *
+ * @param server Сервер.
+ * @param pid PID (port id) сервера.
+ * @param credits Емкость сервера (0 - без ограничения).
+ */
+static inline void calc_server_init(struct calc_server *server, __u32 pid, int credits) {
+    memset(server, 0, sizeof(*server));
+    server->pid = pid;
+    server->credits = credits;
+    calc_atomic_set(&server->outstanding, 0);
+}
+
+/**
+ * @brief Повторная регистрация сервера: он снова получает запросы, емкость обновляется.
+ *
+ * @param server Сервер из текущего снимка.
+ * @param credits Емкость сервера (0 - без ограничения).
+ */
+static inline void calc_server_renew(struct calc_server *server, int credits) {
+    calc_write_once(server->credits, credits);
+    calc_write_once(server->draining, false);
+}
+
+/**
+ * @brief Ищет сервер в снимке реестра.
+ *
+ * @param registry Снимок реестра (может быть NULL).
+ * @param pid PID (port id) сервера.
+ *
+ * @return Сервер, сокет которого не закрыт, или NULL.
+ */
+static inline struct calc_server *calc_server_lookup(const struct calc_servers *registry, __u32 pid) {
+    int i;
+
+    for (i = 0; registry && i < registry->count; i++) {
+        if (registry->list[i]->pid == pid && !calc_read_once(registry->list[i]->dead)) {
+            return registry->list[i];
+        }
+    }
+    return NULL;
+}
+
+/**
+ * @brief Заполняет копию снимка с добавленным сервером.
+ *
+ * @param registry Текущий снимок (может быть NULL).
+ * @param updated Новый снимок на registry->count + 1 серверов.
+ * @param server Добавляемый сервер.
+ */
+static inline void calc_servers_add(const struct calc_servers *registry, struct calc_servers *updated, struct calc_server *server) {
+    int count = registry ? registry->count : 0;
+
+    if (count) {
+        memcpy(updated->list, registry->list, count * sizeof(updated->list[0]));
+    }
+    updated->list[count] = server;
+    updated->count = count + 1;
+}
+
+/**
+ * @brief Помечает сервер завершившимся: он сразу перестает получать запросы и не находится calc_server_lookup.
+ *
+ * @param registry Снимок реестра.
+ * @param pid PID (port id) сервера.
+ *
+ * @return true, если сервер найден и помечен (нужно удалить его из реестра).
+ */
+static inline bool calc_server_mark_dead(const struct calc_servers *registry, __u32 pid) {
+    struct calc_server *server = calc_server_lookup(registry, pid);
+
+    if (!server) {
+        return false;
+    }
+    calc_write_once(server->dead, true);
+    return true;
+}
+
+/**
+ * @brief Заполняет копию снимка без завершившихся серверов.
+ *
+ * @param registry Текущий снимок (может быть NULL).
+ * @param updated Новый снимок на registry->count серверов.
+ * @param dead Массив на CALC_MAX_SERVERS серверов: удаленные серверы, которые освобождает вызывающий.
+ *
+ * @return Количество удаленных серверов (0 - снимок не изменился, updated не нужен).
+ */
+static inline int calc_servers_remove_dead(const struct calc_servers *registry, struct calc_servers *updated, struct calc_server **dead) {
+    int n_dead = 0;
+    int i;
+
+    updated->count = 0;
+    for (i = 0; registry && i < registry->count; i++) {
+        if (calc_read_once(registry->list[i]->dead)) {
+            dead[n_dead++] = registry->list[i];
+        } else {
+            updated->list[updated->count++] = registry->list[i];
+        }
+    }
+    return n_dead;
+}
+
+/**
+ * @brief Извлекает маршруты запросов завершившегося сервера и передает их обработчику.
+ *
+ * @param routes Таблица маршрутов.
+ * @param pid PID (port id) сервера.
+ * @param fail Обработчик маршрута (в модуле - ответ клиенту ECONNRESET).
+ * @param context Аргумент обработчика.
+ *
+ * @return Количество извлеченных маршрутов.
+ */
+static inline int calc_server_fail_routes(struct calc_route_table *routes, __u32 pid, void (*fail)(const struct calc_route *route, void *context),
+                                          void *context) {
+    struct calc_route route;
+    int position = 0;
+    int failed = 0;
+
+    while (calc_route_take_server(routes, pid, &position, &route) == 0) {
+        fail(&route, context);
+        failed++;
+    }
+    return failed;
+}
+
+/**
+ * @brief Учитывает начало или завершение запроса на сервере.
+ *
+ * @param registry Снимок реестра.
+ * @param pid PID (port id) сервера.
+ * @param delta 1 - запрос передан серверу, -1 - запрос завершен.
+ */
+static inline void calc_server_track(const struct calc_servers *registry, __u32 pid, int delta) {
+    struct calc_server *server = calc_server_lookup(registry, pid);
+
+    if (server) {
+        calc_atomic_add(delta, &server->outstanding);
+    }
+}
+
+/**
+ * @brief Занимает место на сервере, если емкость сервера это позволяет.
+ *
+ * Проверка и увеличение outstanding - один cmpxchg: из одновременных вызовов последнее
+ * свободное место получает только один.
+ *
+ * @param server Сервер из текущего снимка реестра.
+ *
+ * @return true, если место занято (outstanding увеличен).
+ */
+static inline bool calc_server_take_credit(struct calc_server *server) {
+    int credits = calc_read_once(server->credits);
+    int load = calc_atomic_read(&server->outstanding);
+
+    do {
+        if (credits && load >= credits) {
+            return false;
+        }
+    } while (!calc_atomic_try_cmpxchg(&server->outstanding, &load, load + 1));
+    return true;
+}
+
+/**
+ * @brief Выбирает сервер для очередного запроса и занимает на нем место.
+ *
+ * Запрос получает сервер с наименьшим числом запросов в полете среди зарегистрированных
+ * (не draining и не dead), у которого есть свободное место. Просмотр начинается с индекса start,
+ * поэтому при сдвиге start равно загруженные серверы получают запросы по кругу. Если место
+ * на выбранном сервере успели занять другие вызовы, просмотр повторяется (не больше числа серверов).
+ *
+ * @param registry Снимок реестра (может быть NULL).
+ * @param start Индекс сервера, с которого начинается просмотр.
+ * @param pid PID выбранного сервера.
+ *
+ * @return 0, -ESRCH если ни один сервер не зарегистрирован, -EBUSY если места нет ни на одном сервере.
+ */
+static inline int calc_server_pick(const struct calc_servers *registry, unsigned int start, __u32 *pid) {
+    struct calc_server *best = NULL;
+    int result = -ESRCH;
+    int best_load = 0;
+    int attempt;
+    int i;
+
+    for (attempt = 0; registry && attempt < registry->count; attempt++) {
+        best = NULL;
+        for (i = 0; i < registry->count; i++) {
+            struct calc_server *server = registry->list[(start + i) % registry->count];
+            int load = calc_atomic_read(&server->outstanding);
+            int credits = calc_read_once(server->credits);
+            if (calc_read_once(server->draining) || calc_read_once(server->dead)) {
+                continue;
+            }
+            result = -EBUSY;
+            if ((credits && load >= credits) || (best && load >= best_load)) {
+                continue;
+            }
+            best = server;
+            best_load = load;
+        }
+        if (!best) {
+            break;
+        }
+        if (calc_server_take_credit(best)) {
+            *pid = best->pid;
+            return 0;
+        }
+    }
+    return result;
+}
+
+#endif /* CALC_SERVER_H */
@@ -1,12 +1,23 @@
-#include "server.hpp"
+#include "pool.hpp"
 
-int main() {
+int main(int argc, char *argv[]) {
     try {
-        netlink::server::Server server;
-        server.wait_for_response();
+        // Количество рабочих потоков: первый аргумент или количество ядер
+        std::size_t workers = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 0;
+        // Сокет статистики: второй аргумент ("-" - без сокета)
+        std::string stats_path = argc > 2 ? argv[2] : "/tmp/calc_server_stats.sock";
+        // Размер буферов сокета Netlink в байтах: третий аргумент (0 - системный)
+        int socket_buffer = argc > 3 ? std::atoi(argv[3]) : netlink::transport::GenlTransport::DEFAULT_BUFFER_SIZE;
+        // Записей в кэше ответов на повторяющиеся JSON-запросы: четвертый аргумент (0 - без кэша)
+        std::size_t cache_capacity = argc > 4 ? std::strtoul(argv[4], nullptr, 10) : 0;
+        // Емкость каждого рабочего потока в запросах: пятый аргумент (0 - без ограничения)
+        uint32_t credits = argc > 5 ? static_cast<uint32_t>(std::strtoul(argv[5], nullptr, 10)) : netlink::server::Server::DEFAULT_CREDITS;
+        netlink::server::Pool pool(workers, stats_path == "-" ? std::string() : stats_path, socket_buffer, cache_capacity, credits);
+        printf("Started %zu workers\n", pool.size());
+        pool.run();
     } catch (std::exception &ex) {
         printf("Error: %s\n", ex.what());
         return -1;
     }
     return 0;
-}
\ No newline at end of file
+}
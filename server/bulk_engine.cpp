@@ -0,0 +1,195 @@
+#include "bulk_engine.hpp"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+using netlink::server::OP;
+
+/**
+ * @brief Скалярная реализация; также обрабатывает хвост массивов векторных реализаций.
+ *
+ * Вычисление в uint64_t: переполнение определено и совпадает с векторными инструкциями.
+ */
+void compute_scalar(OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count) {
+    for (std::size_t i = 0; i < count; ++i) {
+        auto const a = static_cast<uint64_t>(arg1[i]);
+        auto const b = static_cast<uint64_t>(arg2[i]);
+        uint64_t value = 0;
+        switch (op) {
+            case OP::OP_ADD:
+                value = a + b;
+                break;
+            case OP::OP_SUB:
+                value = a - b;
+                break;
+            case OP::OP_MUL:
+                value = a * b;
+                break;
+            default:
+                break;
+        }
+        result[i] = static_cast<int64_t>(value);
+    }
+}
+
+#if defined(__x86_64__)
+
+/**
+ * @brief Младшие 64 бита произведения: в SSE2 нет умножения 64x64, оно собирается из трех 32x32.
+ */
+inline __m128i mul_epi64_sse2(__m128i a, __m128i b) {
+    __m128i const low = _mm_mul_epu32(a, b);
+    __m128i const cross = _mm_add_epi64(_mm_mul_epu32(_mm_srli_epi64(a, 32), b), _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+    return _mm_add_epi64(low, _mm_slli_epi64(cross, 32));
+}
+
+void compute_sse2(OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count) {
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128i const a = _mm_loadu_si128(reinterpret_cast<__m128i const *>(arg1 + i));
+        __m128i const b = _mm_loadu_si128(reinterpret_cast<__m128i const *>(arg2 + i));
+        __m128i value;
+        switch (op) {
+            case OP::OP_ADD:
+                value = _mm_add_epi64(a, b);
+                break;
+            case OP::OP_SUB:
+                value = _mm_sub_epi64(a, b);
+                break;
+            case OP::OP_MUL:
+                value = mul_epi64_sse2(a, b);
+                break;
+            default:
+                value = _mm_setzero_si128();
+                break;
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(result + i), value);
+    }
+    compute_scalar(op, arg1 + i, arg2 + i, result + i, count - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i mul_epi64_avx2(__m256i a, __m256i b) {
+    __m256i const low = _mm256_mul_epu32(a, b);
+    __m256i const cross = _mm256_add_epi64(_mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(low, _mm256_slli_epi64(cross, 32));
+}
+
+__attribute__((target("avx2"))) void compute_avx2(OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count) {
+    std::size_t i = 0;
+    // Выбор операции вне цикла: каждый цикл компилятор разворачивает отдельно
+    switch (op) {
+        case OP::OP_ADD:
+            for (; i + 4 <= count; i += 4) {
+                __m256i const a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(arg1 + i));
+                __m256i const b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(arg2 + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), _mm256_add_epi64(a, b));
+            }
+            break;
+        case OP::OP_SUB:
+            for (; i + 4 <= count; i += 4) {
+                __m256i const a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(arg1 + i));
+                __m256i const b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(arg2 + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), _mm256_sub_epi64(a, b));
+            }
+            break;
+        case OP::OP_MUL:
+            for (; i + 4 <= count; i += 4) {
+                __m256i const a = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(arg1 + i));
+                __m256i const b = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(arg2 + i));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), mul_epi64_avx2(a, b));
+            }
+            break;
+        default:
+            break;
+    }
+    compute_scalar(op, arg1 + i, arg2 + i, result + i, count - i);
+}
+
+#elif defined(__aarch64__)
+
+void compute_neon(OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count) {
+    std::size_t i = 0;
+    // В NEON нет умножения 64x64: mul выполняется скалярным циклом (компилятор использует mul/madd)
+    if (op == OP::OP_ADD || op == OP::OP_SUB) {
+        for (; i + 2 <= count; i += 2) {
+            int64x2_t const a = vld1q_s64(arg1 + i);
+            int64x2_t const b = vld1q_s64(arg2 + i);
+            vst1q_s64(result + i, op == OP::OP_ADD ? vaddq_s64(a, b) : vsubq_s64(a, b));
+        }
+    }
+    compute_scalar(op, arg1 + i, arg2 + i, result + i, count - i);
+}
+
+#endif
+
+netlink::server::BulkEngine::Isa detect() {
+#if defined(__x86_64__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? netlink::server::BulkEngine::Isa::AVX2 : netlink::server::BulkEngine::Isa::SSE2;
+#elif defined(__aarch64__)
+    return netlink::server::BulkEngine::Isa::NEON;
+#else
+    return netlink::server::BulkEngine::Isa::SCALAR;
+#endif
+}
+
+} // namespace
+
+void netlink::server::BulkEngine::compute(Isa isa, OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count) {
+    switch (isa) {
+#if defined(__x86_64__)
+        case Isa::AVX2:
+            compute_avx2(op, arg1, arg2, result, count);
+            return;
+        case Isa::SSE2:
+            compute_sse2(op, arg1, arg2, result, count);
+            return;
+#elif defined(__aarch64__)
+        case Isa::NEON:
+            compute_neon(op, arg1, arg2, result, count);
+            return;
+#endif
+        default:
+            compute_scalar(op, arg1, arg2, result, count);
+            return;
+    }
+}
+
+netlink::server::BulkEngine::Isa netlink::server::BulkEngine::isa() {
+    static Isa const selected = [] {
+        Isa isa = detect();
+        NETLINK_LOG(LOG_INFO, "Bulk arithmetic uses the %s implementation", name(isa));
+        return isa;
+    }();
+    return selected;
+}
+
+std::vector<netlink::server::BulkEngine::Isa> netlink::server::BulkEngine::supported() {
+    std::vector<Isa> isas = {Isa::SCALAR};
+#if defined(__x86_64__)
+    isas.push_back(Isa::SSE2);
+#endif
+    Isa const best = detect();
+    if (best != Isa::SCALAR && best != Isa::SSE2) {
+        isas.push_back(best);
+    }
+    return isas;
+}
+
+const char *netlink::server::BulkEngine::name(Isa isa) {
+    switch (isa) {
+        case Isa::SSE2:
+            return "sse2";
+        case Isa::AVX2:
+            return "avx2";
+        case Isa::NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "server.hpp"
+
+namespace netlink::server {
+
+/**
+ * @brief Векторное вычисление операций калькулятора над массивами.
+ *
+ * Реализация выбирается один раз во время выполнения по возможностям процессора:
+ * AVX2 (если поддерживается), иначе SSE2 на x86-64, NEON на AArch64, скалярный цикл
+ * на остальных платформах. Арифметика выполняется по модулю 2^64 одинаково во всех
+ * реализациях, поэтому результат не зависит от выбранного набора инструкций.
+ */
+class BulkEngine final {
+   public:
+    /**
+     * @brief Набор инструкций реализации.
+     */
+    enum class Isa : uint8_t {
+        SCALAR,
+        SSE2,
+        AVX2,
+        NEON,
+    };
+
+    /**
+     * @brief Вычисляет result[i] = arg1[i] op arg2[i] реализацией, выбранной для этого процессора.
+     *
+     * @param op Операция (не OP_UNSPEC).
+     * @param count Количество элементов; массивы не должны перекрываться, кроме result == arg1 или result == arg2.
+     */
+    static void compute(OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count) {
+        compute(isa(), op, arg1, arg2, result, count);
+    }
+    /**
+     * @brief Вычисляет операцию заданной реализацией (для тестов и бенчмарков).
+     *
+     * @param isa Реализация из supported().
+     */
+    static void compute(Isa isa, OP op, int64_t const *arg1, int64_t const *arg2, int64_t *result, std::size_t count);
+    /**
+     * @brief Реализация, выбранная для этого процессора.
+     */
+    static Isa isa();
+    /**
+     * @brief Реализации, которые поддерживает этот процессор.
+     */
+    static std::vector<Isa> supported();
+    /**
+     * @brief Имя реализации для журнала и результатов бенчмарка.
+     */
+    static const char *name(Isa isa);
+};
+
+} // namespace netlink::server
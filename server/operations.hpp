@@ -0,0 +1,250 @@
+#pragma once
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "stats.hpp"
+
+namespace netlink::server {
+
+/**
+ * @brief Операции калькулятора.
+ *
+ * Значения передаются в атрибуте ATTR_OP бинарного протокола.
+ */
+enum class OP : uint8_t {
+    OP_UNSPEC,
+    OP_ADD,
+    OP_SUB,
+    OP_MUL,
+    OP_DIV,
+    OP_MOD,
+    OP_MAX,
+};
+
+/**
+ * @brief Результат операции с проверкой: значение или код ошибки.
+ */
+template <typename T>
+struct CheckedResult {
+    int error = 0; /**< 0 при успехе, ERANGE - переполнение, EDOM - деление на ноль, EINVAL - неизвестная операция. */
+    T value{};     /**< Результат операции (при ошибке 0). */
+};
+
+/**
+ * @brief Результат операции бинарного протокола.
+ */
+using BinaryResult = CheckedResult<int64_t>;
+
+/**
+ * @brief 128-битные операнды JSON-запросов с "type": "int128".
+ */
+using Int128 = __int128;
+
+/**
+ * @brief Арифметика операций с проверкой переполнения.
+ *
+ * Шаблоны по типу операндов (int64_t, Int128): переполнение проверяют встроенные функции
+ * компилятора, которые для целых фиксированной ширины сводятся к флагу переполнения
+ * арифметической инструкции, без вызовов и без неопределенного поведения.
+ */
+namespace arithmetic {
+
+template <typename T>
+constexpr CheckedResult<T> add(T arg1, T arg2) {
+    CheckedResult<T> result;
+    if (__builtin_add_overflow(arg1, arg2, &result.value)) {
+        result = {ERANGE, T{}};
+    }
+    return result;
+}
+
+template <typename T>
+constexpr CheckedResult<T> sub(T arg1, T arg2) {
+    CheckedResult<T> result;
+    if (__builtin_sub_overflow(arg1, arg2, &result.value)) {
+        result = {ERANGE, T{}};
+    }
+    return result;
+}
+
+template <typename T>
+constexpr CheckedResult<T> mul(T arg1, T arg2) {
+    CheckedResult<T> result;
+    if (__builtin_mul_overflow(arg1, arg2, &result.value)) {
+        result = {ERANGE, T{}};
+    }
+    return result;
+}
+
+template <typename T>
+constexpr CheckedResult<T> div(T arg1, T arg2) {
+    if (arg2 == 0) {
+        return {EDOM, T{}};
+    }
+    // Единственное переполнение деления - минимальное значение на -1
+    return arg2 == T(-1) ? sub(T(0), arg1) : CheckedResult<T>{0, arg1 / arg2};
+}
+
+template <typename T>
+constexpr CheckedResult<T> mod(T arg1, T arg2) {
+    if (arg2 == 0) {
+        return {EDOM, T{}};
+    }
+    // Остаток от деления на -1 всегда 0, а arg1 % -1 для минимального значения - неопределенное поведение
+    return {0, arg2 == T(-1) ? T{} : arg1 % arg2};
+}
+
+} // namespace arithmetic
+
+/**
+ * @brief Операция реестра.
+ */
+struct Operation {
+    std::string_view name;                              /**< Имя действия JSON-запроса. */
+    OP op;                                              /**< Код операции бинарного протокола. */
+    Counter counter;                                    /**< Счетчик запросов операции. */
+    bool bulk;                                          /**< Поддерживается над массивами (BulkEngine, по модулю 2^64). */
+    CheckedResult<int64_t> (*int64)(int64_t, int64_t); /**< Вычисление над int64_t. */
+    CheckedResult<Int128> (*int128)(Int128, Int128);   /**< Вычисление над Int128. */
+};
+
+/**
+ * @brief Реестр операций.
+ *
+ * Новая операция добавляется кодом в OP, счетчиком в Counter и строкой этой таблицы; разбор
+ * имени, учет в статистике и вычисление берут ее отсюда. Строки идут в порядке кодов OP.
+ */
+inline constexpr std::array M_OPERATIONS = {
+    Operation{"add", OP::OP_ADD, Counter::REQUESTS_ADD, true, arithmetic::add<int64_t>, arithmetic::add<Int128>},
+    Operation{"sub", OP::OP_SUB, Counter::REQUESTS_SUB, true, arithmetic::sub<int64_t>, arithmetic::sub<Int128>},
+    Operation{"mul", OP::OP_MUL, Counter::REQUESTS_MUL, true, arithmetic::mul<int64_t>, arithmetic::mul<Int128>},
+    Operation{"div", OP::OP_DIV, Counter::REQUESTS_DIV, false, arithmetic::div<int64_t>, arithmetic::div<Int128>},
+    Operation{"mod", OP::OP_MOD, Counter::REQUESTS_MOD, false, arithmetic::mod<int64_t>, arithmetic::mod<Int128>},
+};
+
+static_assert(M_OPERATIONS.size() + 1 == static_cast<std::size_t>(OP::OP_MAX), "Every operation code needs an entry in M_OPERATIONS");
+static_assert(
+    [] {
+        for (std::size_t i = 0; i < M_OPERATIONS.size(); ++i) {
+            if (static_cast<std::size_t>(M_OPERATIONS[i].op) != i + 1) {
+                return false;
+            }
+        }
+        return true;
+    }(),
+    "M_OPERATIONS must be ordered by operation code");
+
+/**
+ * @brief Совершенная хеш-функция над набором строк, построенная во время компиляции.
+ *
+ * Конструктор подбирает затравку хеша FNV-1a, при которой все ключи попадают в разные ячейки
+ * таблицы из не менее чем 4N ячеек. Поиск - один хеш, одна ячейка и одно сравнение строк,
+ * независимо от количества ключей. Если затравку подобрать не удалось (например, ключи повторяются),
+ * ошибка возникает при компиляции.
+ *
+ * @tparam N Количество ключей (меньше 255).
+ */
+template <std::size_t N>
+class PerfectHash final {
+   public:
+    static constexpr int M_NOT_FOUND = -1;
+
+    consteval explicit PerfectHash(std::array<std::string_view, N> const &keys) : m_keys(keys) {
+        for (uint32_t seed = 0; seed < M_MAX_SEED; ++seed) {
+            if (place(seed)) {
+                m_seed = seed;
+                return;
+            }
+        }
+        throw "PerfectHash: no collision-free seed for these keys";
+    }
+
+    /**
+     * @brief Индекс ключа в исходном массиве или M_NOT_FOUND.
+     */
+    constexpr int find(std::string_view key) const {
+        uint8_t const index = m_slots[hash(key, m_seed) & (M_SLOTS - 1)];
+        return index != M_EMPTY && m_keys[index] == key ? index : M_NOT_FOUND;
+    }
+
+   private:
+    static constexpr std::size_t M_SLOTS = std::bit_ceil(N * 4);
+    static constexpr uint8_t M_EMPTY = 0xff;
+    static constexpr uint32_t M_MAX_SEED = 4096;
+    static_assert(N > 0 && N < M_EMPTY);
+
+    static constexpr uint32_t hash(std::string_view key, uint32_t seed) {
+        uint32_t value = 2166136261u ^ (seed * 0x9e3779b9u);
+        for (char c : key) {
+            value = (value ^ static_cast<uint8_t>(c)) * 16777619u;
+        }
+        return value ^ (value >> 16);
+    }
+
+    consteval bool place(uint32_t seed) {
+        m_slots.fill(M_EMPTY);
+        for (std::size_t i = 0; i < N; ++i) {
+            uint8_t &slot = m_slots[hash(m_keys[i], seed) & (M_SLOTS - 1)];
+            if (slot != M_EMPTY) {
+                return false;
+            }
+            slot = static_cast<uint8_t>(i);
+        }
+        return true;
+    }
+
+    std::array<std::string_view, N> m_keys{};
+    std::array<uint8_t, M_SLOTS> m_slots{};
+    uint32_t m_seed = 0;
+};
+
+/**
+ * @brief Индекс имен действий реестра.
+ */
+inline constexpr PerfectHash<M_OPERATIONS.size()> M_ACTIONS{[] {
+    std::array<std::string_view, M_OPERATIONS.size()> names{};
+    for (std::size_t i = 0; i < M_OPERATIONS.size(); ++i) {
+        names[i] = M_OPERATIONS[i].name;
+    }
+    return names;
+}()};
+
+/**
+ * @brief Операция по имени действия JSON-запроса или nullptr.
+ */
+constexpr Operation const *find_operation(std::string_view action) {
+    int const index = M_ACTIONS.find(action);
+    return index == M_ACTIONS.M_NOT_FOUND ? nullptr : &M_OPERATIONS[index];
+}
+
+/**
+ * @brief Операция по коду бинарного протокола или nullptr (OP_UNSPEC и коды вне диапазона).
+ */
+constexpr Operation const *find_operation(OP op) {
+    return op > OP::OP_UNSPEC && op < OP::OP_MAX ? &M_OPERATIONS[static_cast<std::size_t>(op) - 1] : nullptr;
+}
+
+/**
+ * @brief Перечень действий реестра для сообщений об ошибках: "'add', 'sub', ...".
+ *
+ * @param bulk Только операции, поддерживаемые над массивами.
+ */
+inline std::string supported_actions(bool bulk = false) {
+    std::string list;
+    for (auto const &operation : M_OPERATIONS) {
+        if (bulk && !operation.bulk) {
+            continue;
+        }
+        list += list.empty() ? "'" : ", '";
+        list += operation.name;
+        list += '\'';
+    }
+    return list;
+}
+
+} // namespace netlink::server
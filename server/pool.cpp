@@ -0,0 +1,80 @@
+#include "pool.hpp"
+
+#include <pthread.h>
+#include <sched.h>
+
+#include <algorithm>
+#include <csignal>
+
+netlink::server::Pool::Pool(std::size_t workers, std::string const &stats_path, int socket_buffer, std::size_t cache_capacity, uint32_t credits) {
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    NETLINK_LOG(LOG_INFO, "Starting %zu Netlink server workers", workers);
+    std::shared_ptr<ResultCache> cache = cache_capacity > 0 ? std::make_shared<ResultCache>(cache_capacity) : nullptr;
+    m_servers.reserve(workers);
+    m_loops.reserve(workers);
+    for (std::size_t i = 0; i < workers; ++i) {
+        m_servers.push_back(std::make_unique<Server>(std::make_unique<transport::GenlTransport>(socket_buffer), credits));
+        m_servers.back()->set_result_cache(cache);
+        m_loops.push_back(std::make_unique<common::EventLoop>());
+        m_servers.back()->attach(*m_loops.back());
+    }
+
+    if (!stats_path.empty()) {
+        m_stats_endpoint = std::make_unique<StatsEndpoint>(stats_path, [this]() { return stats(); });
+    }
+}
+
+void netlink::server::Pool::run() {
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+
+    // Сигналы блокируются до запуска потоков, чтобы их получал только управляющий цикл
+    m_control.stop_on_signals({SIGINT, SIGTERM});
+
+    m_threads.reserve(m_servers.size());
+    for (std::size_t i = 0; i < m_servers.size(); ++i) {
+        m_threads.emplace_back([loop = m_loops[i].get()]() { loop->run(); });
+
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(i % cores, &cpuset);
+        int ret = pthread_setaffinity_np(m_threads.back().native_handle(), sizeof(cpuset), &cpuset);
+        if (ret != 0) {
+            NETLINK_LOG(LOG_WARNING, "Failed to pin worker %zu to core %zu: %s", i, i % cores, strerror(ret));
+        }
+    }
+
+    m_control.run();
+    // Модуль перестает направлять запросы серверам, а рабочие потоки успевают ответить на принятые
+    bool draining = false;
+    for (auto &server : m_servers) {
+        draining = server->unregister() || draining;
+    }
+    if (draining) {
+        std::this_thread::sleep_for(M_DRAIN_TIME);
+    }
+    NETLINK_LOG(LOG_INFO, "Stopping Netlink server workers");
+    for (auto &loop : m_loops) {
+        loop->stop();
+    }
+    for (auto &thread : m_threads) {
+        thread.join();
+    }
+    m_threads.clear();
+    NETLINK_LOG(LOG_INFO, "All Netlink server workers stopped");
+}
+
+void netlink::server::Pool::stop() {
+    m_control.stop();
+}
+
+nlohmann::json netlink::server::Pool::stats() const {
+    std::vector<Stats const *> workers;
+    workers.reserve(m_servers.size());
+    for (auto const &server : m_servers) {
+        workers.push_back(&server->stats());
+    }
+    return Stats::to_json(workers);
+}
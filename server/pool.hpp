@@ -0,0 +1,81 @@
+#pragma once
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/event_loop.hpp"
+#include "../transport/genl_transport.hpp"
+#include "server.hpp"
+#include "stats_endpoint.hpp"
+
+namespace netlink::server {
+
+/**
+ * @brief Пул рабочих потоков Netlink-сервера.
+ *
+ * Каждый рабочий поток владеет собственным экземпляром Server, то есть собственным
+ * сокетом Netlink и port id, и регистрируется в модуле ядра отдельно. Модуль ядра
+ * распределяет запросы клиентов между зарегистрированными серверами, поэтому потоки
+ * не разделяют никакого состояния, кроме необязательного кэша ответов (ResultCache).
+ *
+ * Каждый рабочий поток обслуживает свой сервер в собственном цикле событий, что позволяет
+ * завершать их по SIGINT/SIGTERM или вызову stop без ожидания очередного запроса.
+ */
+class Pool final {
+   public:
+    /**
+     * @brief Конструктор пула.
+     *
+     * Создает серверы для всех рабочих потоков в вызывающем потоке, чтобы ошибки
+     * подключения к Netlink обнаруживались до запуска потоков.
+     *
+     * @param workers Количество рабочих потоков (0 - по количеству ядер).
+     * @param stats_path Путь к Unix-сокету для выгрузки статистики (пустая строка - без сокета).
+     * @param socket_buffer Размер буферов приема и отправки сокета Netlink каждого сервера (0 - системный).
+     * @param cache_capacity Записей в кэше ответов, общем для всех рабочих потоков (0 - без кэша).
+     * @param credits Емкость каждого сервера, сообщаемая ретранслятору (0 - без ограничения).
+     *
+     * @throw std::runtime_error Если не удалось создать один из серверов или сокет статистики.
+     */
+    explicit Pool(std::size_t workers = 0, std::string const &stats_path = {}, int socket_buffer = transport::GenlTransport::DEFAULT_BUFFER_SIZE,
+                  std::size_t cache_capacity = 0, uint32_t credits = Server::DEFAULT_CREDITS);
+    Pool(Pool const &) = delete;
+    Pool(Pool &&) = delete;
+    Pool &operator=(Pool const &) = delete;
+    Pool &operator=(Pool &&) = delete;
+    ~Pool() = default;
+    /**
+     * @brief Запускает рабочие потоки и ожидает их завершения.
+     *
+     * Поток i закрепляется за ядром i по модулю количества ядер. Вызывающий поток блокирует
+     * SIGINT и SIGTERM (маска наследуется рабочими потоками) и ожидает сигнала или вызова stop,
+     * после чего отменяет регистрацию серверов в модуле, в течение M_DRAIN_TIME отвечает на уже
+     * принятые запросы, останавливает циклы рабочих потоков и дожидается их завершения.
+     */
+    void run();
+    /**
+     * @brief Завершает run. Может вызываться из любого потока.
+     */
+    void stop();
+    /**
+     * @brief Количество рабочих потоков.
+     */
+    std::size_t size() const { return m_servers.size(); }
+    /**
+     * @brief Сводная статистика всех рабочих потоков (см. Stats::to_json).
+     */
+    nlohmann::json stats() const;
+
+   private:
+    static constexpr std::chrono::milliseconds M_DRAIN_TIME{500}; // 8 ответы на принятые запросы после отмены регистрации
+    std::vector<std::unique_ptr<common::EventLoop>> m_loops; // 24 удаляются после серверов
+    std::vector<std::unique_ptr<Server>> m_servers;          // 24
+    common::EventLoop m_control;                             // 168 ожидание сигналов и stop
+    std::vector<std::thread> m_threads;                      // 24
+    std::unique_ptr<StatsEndpoint> m_stats_endpoint;         // 8 удаляется первым, пока серверы живы
+};
+
+} // namespace netlink::server
@@ -0,0 +1,128 @@
+#include "request_parser.hpp"
+
+#include <charconv>
+#include <cstring>
+
+netlink::server::RequestParser::Status netlink::server::RequestParser::parse(std::string_view json, ParsedRequest &request) {
+    bool has_action = false;
+    bool has_arg1 = false;
+    bool has_arg2 = false;
+    ParsedRequest parsed;
+    std::size_t pos = 0;
+
+    skip_whitespace(json, pos);
+    if (pos >= json.size() || json[pos] != '{') {
+        return Status::FALLBACK;
+    }
+    ++pos;
+
+    while (true) {
+        std::string_view key;
+        skip_whitespace(json, pos);
+        if (!parse_string(json, pos, key)) {
+            return Status::FALLBACK;
+        }
+        skip_whitespace(json, pos);
+        if (pos >= json.size() || json[pos] != ':') {
+            return Status::FALLBACK;
+        }
+        ++pos;
+        skip_whitespace(json, pos);
+
+        bool ok = false;
+        if (key == "action" && !has_action) {
+            ok = has_action = parse_string(json, pos, parsed.action);
+        } else if (key == "arg1" && !has_arg1) {
+            ok = has_arg1 = parse_int(json, pos, parsed.arg1);
+        } else if (key == "arg2" && !has_arg2) {
+            ok = has_arg2 = parse_int(json, pos, parsed.arg2);
+        }
+        if (!ok) {
+            return Status::FALLBACK;
+        }
+
+        skip_whitespace(json, pos);
+        if (pos >= json.size()) {
+            return Status::FALLBACK;
+        }
+        if (json[pos] == ',') {
+            ++pos;
+            continue;
+        }
+        if (json[pos] == '}') {
+            ++pos;
+            break;
+        }
+        return Status::FALLBACK;
+    }
+
+    skip_whitespace(json, pos);
+    if (pos != json.size() || !has_action || !has_arg1 || !has_arg2) {
+        return Status::FALLBACK;
+    }
+    request = parsed;
+    return Status::OK;
+}
+
+std::size_t netlink::server::RequestParser::format_result(long long result, char *buffer, std::size_t size) {
+    static constexpr char prefix[] = "{\"result\":";
+    constexpr std::size_t prefix_size = sizeof(prefix) - 1;
+    if (size < prefix_size + 1) {
+        return 0;
+    }
+
+    std::memcpy(buffer, prefix, prefix_size);
+    auto [end, ec] = std::to_chars(buffer + prefix_size, buffer + size - 1, result);
+    if (ec != std::errc() || end + 2 > buffer + size) {
+        return 0;
+    }
+    *end++ = '}';
+    *end = '\0';
+    return static_cast<std::size_t>(end - buffer);
+}
+
+void netlink::server::RequestParser::skip_whitespace(std::string_view json, std::size_t &pos) {
+    while (pos < json.size() && (json[pos] == ' ' || json[pos] == '\t' || json[pos] == '\n' || json[pos] == '\r')) {
+        ++pos;
+    }
+}
+
+bool netlink::server::RequestParser::parse_string(std::string_view json, std::size_t &pos, std::string_view &value) {
+    if (pos >= json.size() || json[pos] != '"') {
+        return false;
+    }
+    std::size_t begin = ++pos;
+    while (pos < json.size() && json[pos] != '"') {
+        // Escape-последовательности и управляющие символы оставляем полному парсеру
+        if (json[pos] == '\\' || static_cast<unsigned char>(json[pos]) < 0x20) {
+            return false;
+        }
+        ++pos;
+    }
+    if (pos >= json.size()) {
+        return false;
+    }
+    value = json.substr(begin, pos - begin);
+    ++pos;
+    return true;
+}
+
+bool netlink::server::RequestParser::parse_int(std::string_view json, std::size_t &pos, int64_t &value) {
+    std::size_t begin = pos;
+    if (pos < json.size() && json[pos] == '-') {
+        ++pos;
+    }
+    std::size_t digits = pos;
+    while (pos < json.size() && json[pos] >= '0' && json[pos] <= '9') {
+        ++pos;
+    }
+    // Ведущие нули, дробные числа и экспоненту оставляем полному парсеру
+    if (pos == digits || (json[digits] == '0' && pos - digits > 1)) {
+        return false;
+    }
+    if (pos < json.size() && (json[pos] == '.' || json[pos] == 'e' || json[pos] == 'E')) {
+        return false;
+    }
+    auto [end, ec] = std::from_chars(json.data() + begin, json.data() + pos, value);
+    return ec == std::errc() && end == json.data() + pos;
+}
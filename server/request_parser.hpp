@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace netlink::server {
+
+/**
+ * @brief Запрос, разобранный без выделения памяти.
+ *
+ * action указывает в буфер исходного сообщения и действителен, пока жив этот буфер.
+ */
+struct ParsedRequest {
+    std::string_view action; /**< Имя действия. */
+    int64_t arg1 = 0;        /**< Первый аргумент. */
+    int64_t arg2 = 0;        /**< Второй аргумент. */
+};
+
+/**
+ * @brief Разбор JSON-запроса без выделения памяти.
+ *
+ * Понимает только плоский объект вида {"action": "add", "arg1": 4, "arg2": 5}
+ * с целыми аргументами в диапазоне int64 и строкой действия без escape-последовательностей.
+ * Всё остальное (дополнительные или отсутствующие поля, другие типы, синтаксические ошибки)
+ * не отклоняется, а возвращается как FALLBACK, чтобы вызывающий код разобрал запрос
+ * через nlohmann::json и получил те же результаты и сообщения об ошибках.
+ */
+class RequestParser final {
+   public:
+    enum class Status {
+        OK,       /**< Запрос разобран. */
+        FALLBACK, /**< Запрос нужно разобрать полным JSON-парсером. */
+    };
+
+    /**
+     * @brief Разбирает JSON-запрос.
+     *
+     * @param json Текст запроса.
+     * @param request Результат разбора (заполняется только при Status::OK).
+     *
+     * @return Status::OK или Status::FALLBACK.
+     */
+    static Status parse(std::string_view json, ParsedRequest &request);
+    /**
+     * @brief Форматирует ответ {"result":N} в буфер вызывающего кода.
+     *
+     * Результат совпадает с nlohmann::json::dump() для того же ответа.
+     *
+     * @param result Результат операции.
+     * @param buffer Буфер для ответа.
+     * @param size Размер буфера (достаточно M_RESULT_BUFFER_SIZE).
+     *
+     * @return Длина ответа без завершающего нуля или 0, если буфер слишком мал.
+     */
+    static std::size_t format_result(long long result, char *buffer, std::size_t size);
+
+    static constexpr std::size_t M_RESULT_BUFFER_SIZE = 40;
+
+   private:
+    static void skip_whitespace(std::string_view json, std::size_t &pos);
+    static bool parse_string(std::string_view json, std::size_t &pos, std::string_view &value);
+    static bool parse_int(std::string_view json, std::size_t &pos, int64_t &value);
+};
+
+} // namespace netlink::server
@@ -0,0 +1,104 @@
+#include "result_cache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#include "../common/logger.hpp"
+
+/**
+ * @brief Запись кэша: 256 байт, запрос и ответ хранятся в самой записи.
+ */
+struct netlink::server::ResultCache::Entry {
+    uint64_t hash = 0;        // 8
+    uint16_t key_size = 0;    // 2 0 - свободная запись
+    uint8_t value_size = 0;   // 1
+    OP op = OP::OP_UNSPEC;    // 1
+    bool error = false;       // 1
+    bool referenced = false;  // 1 бит обращения CLOCK
+    char key[M_KEY_SIZE];     // 160
+    char value[M_VALUE_SIZE]; // 80
+};
+
+static_assert(netlink::server::ResultCache::M_VALUE_SIZE <= UINT8_MAX);
+
+netlink::server::ResultCache::ResultCache(std::size_t capacity) : m_sets(std::bit_ceil(std::max(capacity, M_WAYS)) / M_WAYS) {
+    m_entries = std::make_unique<Entry[]>(m_sets * M_WAYS);
+    m_hands = std::make_unique<uint8_t[]>(m_sets);
+    m_locks = std::make_unique<std::mutex[]>(M_LOCKS);
+    NETLINK_LOG(LOG_INFO, "Result cache of %zu entries (%zu bytes)", this->capacity(), this->capacity() * sizeof(Entry));
+}
+
+netlink::server::ResultCache::~ResultCache() = default;
+
+uint64_t netlink::server::ResultCache::hash(std::string_view request) {
+    uint64_t value = 14695981039346656037ull;
+    for (char c : request) {
+        value = (value ^ static_cast<uint8_t>(c)) * 1099511628211ull;
+    }
+    return value ^ (value >> 32);
+}
+
+netlink::server::ResultCache::Hit netlink::server::ResultCache::find(std::string_view request, char *value) {
+    if (request.empty() || request.size() > M_KEY_SIZE) {
+        return {};
+    }
+    uint64_t const key_hash = hash(request);
+    std::size_t const set = key_hash & (m_sets - 1);
+    Entry *entries = &m_entries[set * M_WAYS];
+
+    std::lock_guard<std::mutex> lock(m_locks[set % M_LOCKS]);
+    for (std::size_t way = 0; way < M_WAYS; ++way) {
+        Entry &entry = entries[way];
+        if (entry.hash == key_hash && entry.key_size == request.size() && std::memcmp(entry.key, request.data(), request.size()) == 0) {
+            entry.referenced = true;
+            std::memcpy(value, entry.value, entry.value_size);
+            value[entry.value_size] = '\0';
+            return {entry.value_size, entry.op, entry.error};
+        }
+    }
+    return {};
+}
+
+bool netlink::server::ResultCache::insert(std::string_view request, std::string_view value, OP op, bool error) {
+    if (request.empty() || request.size() > M_KEY_SIZE || value.empty() || value.size() > M_VALUE_SIZE) {
+        return false;
+    }
+    uint64_t const key_hash = hash(request);
+    std::size_t const set = key_hash & (m_sets - 1);
+    Entry *entries = &m_entries[set * M_WAYS];
+
+    std::lock_guard<std::mutex> lock(m_locks[set % M_LOCKS]);
+    Entry *target = nullptr;
+    bool evicted = false;
+    for (std::size_t way = 0; way < M_WAYS && !target; ++way) {
+        Entry &entry = entries[way];
+        // Тот же запрос мог вставить другой поток, пока этот вычислял ответ
+        if (entry.key_size == 0 ||
+            (entry.hash == key_hash && entry.key_size == request.size() && std::memcmp(entry.key, request.data(), request.size()) == 0)) {
+            target = &entry;
+        }
+    }
+    // CLOCK: стрелка снимает биты обращения, пока не найдет запись без него (не больше двух оборотов)
+    uint8_t &hand = m_hands[set];
+    while (!target) {
+        Entry &entry = entries[hand];
+        hand = static_cast<uint8_t>((hand + 1) % M_WAYS);
+        if (entry.referenced) {
+            entry.referenced = false;
+        } else {
+            target = &entry;
+            evicted = true;
+        }
+    }
+
+    target->hash = key_hash;
+    target->key_size = static_cast<uint16_t>(request.size());
+    target->value_size = static_cast<uint8_t>(value.size());
+    target->op = op;
+    target->error = error;
+    target->referenced = false;
+    std::memcpy(target->key, request.data(), request.size());
+    std::memcpy(target->value, value.data(), value.size());
+    return evicted;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+
+#include "operations.hpp"
+
+namespace netlink::server {
+
+/**
+ * @brief Кэш ответов на одиночные JSON-запросы, общий для рабочих потоков сервера.
+ *
+ * Ключ - исходные байты ATTR_MSG: при попадании запрос не разбирается и ответ не сериализуется,
+ * а копируется готовым. Ответы детерминированы (чистая арифметика), поэтому инвалидация не нужна.
+ *
+ * Кэш множественно-ассоциативный: хеш ключа выбирает набор из M_WAYS записей, вытеснение внутри
+ * набора - CLOCK (бит обращения сбрасывается стрелкой, вытесняется первая запись без него).
+ * Записи фиксированного размера выделяются один раз в конструкторе, поиск и вставка не выделяют
+ * память. Наборы защищены M_LOCKS мьютексами по модулю номера набора, поэтому потоки,
+ * обращающиеся к разным наборам, почти не конкурируют.
+ */
+class ResultCache final {
+   public:
+    static constexpr std::size_t M_KEY_SIZE = 160;  /**< Самый длинный кэшируемый запрос. */
+    static constexpr std::size_t M_VALUE_SIZE = 80; /**< Самый длинный кэшируемый ответ. */
+    static constexpr std::size_t M_WAYS = 4;        /**< Записей в наборе. */
+    static constexpr std::size_t M_LOCKS = 64;      /**< Мьютексов на все наборы. */
+
+    /**
+     * @brief Ответ, найденный в кэше.
+     */
+    struct Hit {
+        std::size_t size = 0;  /**< Длина ответа, 0 - промах. */
+        OP op = OP::OP_UNSPEC; /**< Операция запроса (для статистики по действиям). */
+        bool error = false;    /**< Ответ - ошибка вычисления. */
+    };
+
+    /**
+     * @brief Конструктор кэша.
+     *
+     * @param capacity Количество записей; округляется вверх до степени двойки, не меньше M_WAYS.
+     */
+    explicit ResultCache(std::size_t capacity);
+    ResultCache(ResultCache const &) = delete;
+    ResultCache &operator=(ResultCache const &) = delete;
+    ~ResultCache();
+
+    /**
+     * @brief Ищет ответ на запрос.
+     *
+     * @param request Исходные байты запроса.
+     * @param value Буфер не меньше M_VALUE_SIZE + 1 байт; при попадании в него копируется ответ с нулем в конце.
+     */
+    Hit find(std::string_view request, char *value);
+    /**
+     * @brief Запоминает ответ на запрос.
+     *
+     * Запросы длиннее M_KEY_SIZE и ответы длиннее M_VALUE_SIZE не кэшируются.
+     *
+     * @return true если для записи пришлось вытеснить другой ответ.
+     */
+    bool insert(std::string_view request, std::string_view value, OP op, bool error);
+    /**
+     * @brief Количество записей.
+     */
+    std::size_t capacity() const { return m_sets * M_WAYS; }
+
+   private:
+    struct Entry;
+
+    static uint64_t hash(std::string_view request);
+
+    std::unique_ptr<Entry[]> m_entries;    // 8 m_sets * M_WAYS записей
+    std::unique_ptr<uint8_t[]> m_hands;    // 8 стрелка CLOCK каждого набора
+    std::unique_ptr<std::mutex[]> m_locks; // 8 M_LOCKS мьютексов
+    std::size_t m_sets = 0;                // 8 степень двойки
+};
+
+} // namespace netlink::server
@@ -1,152 +1,817 @@
 #include "server.hpp"
 
-//@todo: не нравиться что логирование и исключение надо что то одно оставить, сделать красиво надо
-netlink::server::Server::Server() {
-    openlog("NetlinkServer", LOG_PID | LOG_CONS, LOG_USER);
-    syslog(LOG_INFO, "Starting the Netlink server");
+#include <poll.h>
+
+#include <algorithm>
+#include <chrono>
+
+#include "../common/json_writer.hpp"
+#include "../transport/genl_transport.hpp"
+#include "bulk_engine.hpp"
+#include "shm_session.hpp"
+
+namespace {
+
+using netlink::server::Int128;
 
-    m_sock = nl_socket_alloc();
-    if (!m_sock) {
-        syslog(LOG_ERR, "Failed to allocate the Netlink socket");
-        throw std::runtime_error("Failed to allocate the Netlink socket");
+/**
+ * @brief Читает аргумент int64: целое число JSON; значения вне диапазона int64 отклоняются.
+ */
+int64_t read_int64(nlohmann::json const &value) {
+    if (value.is_number_unsigned() && value.get<uint64_t>() > static_cast<uint64_t>(INT64_MAX)) {
+        throw std::runtime_error("Invalid input. Arguments are out of range of the type");
     }
+    return value.get<int64_t>();
+}
 
-    nl_socket_disable_seq_check(m_sock);
+/**
+ * @brief Читает аргумент int128: целое число JSON или десятичная строка со знаком.
+ */
+Int128 read_int128(nlohmann::json const &value) {
+    if (!value.is_string()) {
+        return value.is_number_unsigned() ? static_cast<Int128>(value.get<uint64_t>()) : static_cast<Int128>(value.get<int64_t>());
+    }
+    std::string const &text = value.get_ref<std::string const &>();
+    bool const negative = !text.empty() && text[0] == '-';
+    std::size_t pos = negative ? 1 : 0;
+    if (pos == text.size()) {
+        throw std::runtime_error("Invalid input. Arguments must be integers or decimal strings");
+    }
+    // Накопление отрицательного значения: модуль минимального значения не помещается в положительное
+    Int128 result = 0;
+    for (; pos < text.size(); ++pos) {
+        if (text[pos] < '0' || text[pos] > '9') {
+            throw std::runtime_error("Invalid input. Arguments must be integers or decimal strings");
+        }
+        if (__builtin_mul_overflow(result, 10, &result) || __builtin_sub_overflow(result, text[pos] - '0', &result)) {
+            throw std::runtime_error("Invalid input. Arguments are out of range of the type");
+        }
+    }
+    if (!negative && __builtin_sub_overflow(Int128(0), result, &result)) {
+        throw std::runtime_error("Invalid input. Arguments are out of range of the type");
+    }
+    return result;
+}
 
-    if (genl_connect(m_sock)) {
-        syslog(LOG_ERR, "Failed to establish a connection to Netlink");
-        throw std::runtime_error("Failed to establish a connection to Netlink");
+std::string to_string(Int128 value) {
+    char buffer[48];
+    char *end = buffer + sizeof(buffer);
+    char *begin = end;
+    // Цифры отрицательного значения: остаток от деления отрицательного числа неположителен
+    Int128 rest = value;
+    do {
+        int digit = static_cast<int>(rest % 10);
+        *--begin = static_cast<char>('0' + (digit < 0 ? -digit : digit));
+        rest /= 10;
+    } while (rest != 0);
+    if (value < 0) {
+        *--begin = '-';
     }
+    return std::string(begin, end);
+}
+
+} // namespace
+
+//@todo: не нравиться что логирование и исключение надо что то одно оставить, сделать красиво надо
+netlink::server::Server::Server() : Server(std::make_unique<transport::GenlTransport>()) {}
 
-    m_family_id = genl_ctrl_resolve(m_sock, M_FAMILY_NAME);
-    if (m_family_id < 0) {
-        syslog(LOG_ERR, "Failed to resolve the Netlink family");
-        throw std::runtime_error("Failed to resolve the Netlink family");
+netlink::server::Server::Server(std::unique_ptr<transport::Transport> transport, uint32_t credits) : m_transport(std::move(transport)) {
+    openlog("NetlinkServer", LOG_PID | LOG_CONS, LOG_USER);
+    NETLINK_LOG(LOG_INFO, "Starting the Netlink server");
+
+    m_reply.reset(nlmsg_alloc_size(M_REPLY_SIZE));
+    if (!m_reply) {
+        NETLINK_LOG(LOG_ERR, "Failed to allocate the reply message");
+        throw std::runtime_error("Failed to allocate the reply message");
+    }
+    m_rx_buffer.resize(M_RX_BUFFER_SIZE * M_RX_BATCH);
+    for (std::size_t i = 0; i < M_RX_BATCH; ++i) {
+        m_rx_datagrams[i] = {m_rx_buffer.data() + i * M_RX_BUFFER_SIZE, M_RX_BUFFER_SIZE, 0};
     }
 
-    nl_socket_modify_cb(m_sock, NL_CB_MSG_IN, NL_CB_CUSTOM, receive_message, this);
+    // Без ретранслятора регистрироваться негде
+    if (!m_transport->relayed()) {
+        return;
+    }
+
+    if (m_transport->version() >= LIFECYCLE_PROTOCOL_VERSION) {
+        // Модуль версии 5 не знает ATTR_CREDITS и отклонил бы регистрацию с ним
+        int ret = send_command(M_COMMAND_REGISTER, m_transport->version() >= BACKPRESSURE_PROTOCOL_VERSION ? credits : 0);
+        if (ret < 0) {
+            NETLINK_LOG(LOG_ERR, "Failed to register in the relay: %s", strerror(-ret));
+            throw std::runtime_error("Failed to register in the relay");
+        }
+        return;
+    }
 
     //@todo: не было полного описания задачи, поэтому пока так
     nlohmann::json request_json;
     request_json["message"] = "Hello";
 
-    send_message(request_json.dump());
+    send_message(request_json.dump().c_str());
 }
 
 netlink::server::Server::~Server() {
-    syslog(LOG_INFO, "Shutting down the Netlink server");
-    //@todo: переделать на uniq
-    nl_socket_free(m_sock);
+    detach();
+    NETLINK_LOG(LOG_INFO, "Shutting down the Netlink server");
     closelog();
 }
 
-int netlink::server::Server::receive_message(struct nl_msg *msg, void *arg) {
-    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+bool netlink::server::Server::unregister() {
+    if (!m_transport->relayed() || m_transport->version() < LIFECYCLE_PROTOCOL_VERSION) {
+        return false;
+    }
+    int ret = send_command(M_COMMAND_UNREGISTER);
+    if (ret < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to unregister from the relay: %s", strerror(-ret));
+        return false;
+    }
+    NETLINK_LOG(LOG_INFO, "Unregistered from the relay, finishing requests in flight");
+    return true;
+}
+
+int netlink::server::Server::send_command(int command, uint32_t credits) {
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc_size(nlmsg_total_size(GENL_HDRLEN + nla_total_size(sizeof(uint32_t)))), nlmsg_free);
+    if (!msg || !genlmsg_put(msg.get(), NL_AUTO_PORT, 0, m_transport->family_id(), 0, NLM_F_REQUEST, static_cast<uint8_t>(command), 1)) {
+        return -ENOMEM;
+    }
+    if (credits != 0 && nla_put_u32(msg.get(), static_cast<int>(ATTR::ATTR_CREDITS), credits)) {
+        return -EMSGSIZE;
+    }
+    struct nlmsghdr *nlh = nlmsg_hdr(msg.get());
+    return m_transport->send(nlh, nlh->nlmsg_len);
+}
+
+void netlink::server::Server::receive_message(struct nlmsghdr *nlh) {
     struct nlattr *attrs[static_cast<int>(ATTR::ATTR_MAX) + 1];
 
-    int ret = genlmsg_parse(nlh, 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr);
+    if (nlh->nlmsg_type == NLMSG_ERROR) {
+        auto *err = static_cast<struct nlmsgerr *>(nlmsg_data(nlh));
+        if (err->error != 0) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Kernel reported error for sequence number %u: %s", err->msg.nlmsg_seq, strerror(-err->error));
+        }
+        return;
+    }
+    if (nlh->nlmsg_type < NLMSG_MIN_TYPE) {
+        return;
+    }
+
+    int ret = genlmsg_parse(nlh, 0, attrs, static_cast<int>(ATTR::ATTR_MAX), M_POLICY.data());
     if (ret < 0) {
-        syslog(LOG_ERR, "Failed to parse Generic Netlink message");
-        return ret;
+        m_stats.add(Counter::PARSE_ERRORS);
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Failed to parse Generic Netlink message");
+        return;
     }
-    syslog(LOG_INFO, "Message received with sequence number: %d", nlh->nlmsg_seq);
+    NETLINK_LOG(LOG_DEBUG, "Message received with sequence number: %u", nlh->nlmsg_seq);
 
-    if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+    if (attrs[static_cast<int>(ATTR::ATTR_OP)] && (attrs[static_cast<int>(ATTR::ATTR_ARRAY1)] || attrs[static_cast<int>(ATTR::ATTR_ARRAY2)])) {
+        m_stats.add(Counter::REQUESTS_BINARY);
+        m_stats.add(Counter::REQUESTS_ARRAY);
+        process_array(attrs, nlh->nlmsg_seq);
+    } else if (attrs[static_cast<int>(ATTR::ATTR_STREAM)]) {
+        process_stream(attrs, nlh->nlmsg_seq);
+    } else if (attrs[static_cast<int>(ATTR::ATTR_OP)]) {
+        m_stats.add(Counter::REQUESTS_BINARY);
+        send_result(process_binary(attrs), nlh->nlmsg_seq);
+    } else if (attrs[static_cast<int>(ATTR::ATTR_MSG)]) {
+        m_stats.add(Counter::REQUESTS_JSON);
         const char *data = nla_get_string(attrs[static_cast<int>(ATTR::ATTR_MSG)]);
-        syslog(LOG_INFO, "Message received from kernel: %s", data);
+        NETLINK_LOG(LOG_DEBUG, "Message received from kernel: %s", data);
+
+        if (reply_from_cache(data, nlh->nlmsg_seq) || process_request_fast(data, nlh->nlmsg_seq)) {
+            return;
+        }
 
         nlohmann::json result_json{};
+        OP op = OP::OP_UNSPEC;
         try {
-            result_json = static_cast<Server *>(arg)->process_request(data);
+            result_json = process_request(data, op);
             if (result_json.empty()) {
-                syslog(LOG_DEBUG, "Processed JSON is empty");
-                return NL_OK;
+                NETLINK_LOG(LOG_DEBUG, "Processed JSON is empty");
+                return;
             }
         } catch (std::exception &ex) {
-            syslog(LOG_ERR, "Error occurred: %s", ex.what());
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Error occurred: %s", ex.what());
             //@todo@: тут может быть проблема, для быстроты реализации пока так
-            static_cast<Server *>(arg)->send_message(ex.what());
-            return NL_OK;
+            send_message(ex.what(), nlh->nlmsg_seq);
+            return;
         }
 
-        if (result_json.contains("result")) {
-            static_cast<Server *>(arg)->send_message(result_json.dump());
+        if (result_json.contains("result") && result_json["result"].is_array()) {
+            send_json_array(result_json["result"], nlh->nlmsg_seq);
+        } else {
+            std::string const reply = result_json.dump();
+            send_message(reply.c_str(), nlh->nlmsg_seq);
+            if (op != OP::OP_UNSPEC) {
+                cache_reply(data, reply, op, result_json.contains("errno"));
+            }
         }
+    } else if (attrs[static_cast<int>(ATTR::ATTR_BATCH)]) {
+        m_stats.add(Counter::REQUESTS_BATCH);
+        send_batch(process_batch(attrs[static_cast<int>(ATTR::ATTR_BATCH)]), nlh->nlmsg_seq);
+    } else {
+        NETLINK_LOG(LOG_DEBUG, "Message with sequence number %u has no payload", nlh->nlmsg_seq);
+    }
+}
+
+bool netlink::server::Server::process_request_fast(std::string_view request_json, uint32_t seq) {
+    ParsedRequest request;
+    if (RequestParser::parse(request_json, request) != RequestParser::Status::OK) {
+        return false;
+    }
+
+    OP op = parse_action(request.action);
+    count_action(op);
+    if (op == OP::OP_UNSPEC) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Error occurred: Invalid action");
+        send_message(("Invalid action. Supported actions are " + supported_actions()).c_str(), seq);
+        return true;
+    }
+
+    // Ответ форматируется сразу в сообщение, без промежуточного буфера
+    BinaryResult const result = calculate<int64_t>(op, request.arg1, request.arg2);
+    common::StringAttribute reply = prepare_message(seq, M_SCALAR_REPLY_SIZE);
+    std::size_t size = 0;
+    if (result.error != 0) {
+        m_stats.add(Counter::ARITHMETIC_ERRORS);
+        size = format_arithmetic_error(result.error, reply.data(), reply.capacity());
     } else {
-        syslog(LOG_DEBUG, "Message with sequence number %d has no payload", nlh->nlmsg_seq);
+        size = RequestParser::format_result(result.value, reply.data(), reply.capacity() + 1);
+    }
+    if (size == 0) {
+        return false;
+    }
+    reply.finish(size);
+    send_reply();
+    cache_reply(request_json, std::string_view(reply.data(), size), op, result.error != 0);
+    return true;
+}
+
+bool netlink::server::Server::reply_from_cache(std::string_view request_json, uint32_t seq) {
+    if (!m_cache) {
+        return false;
+    }
+    // Ответ копируется из кэша прямо в сообщение; при промахе сообщение перезапишет следующий ответ
+    common::StringAttribute reply = prepare_message(seq, ResultCache::M_VALUE_SIZE);
+    ResultCache::Hit const hit = m_cache->find(request_json, reply.data());
+    if (hit.size == 0) {
+        m_stats.add(Counter::CACHE_MISSES);
+        return false;
+    }
+    m_stats.add(Counter::CACHE_HITS);
+    count_action(hit.op);
+    if (hit.error) {
+        m_stats.add(Counter::ARITHMETIC_ERRORS);
+    }
+    reply.finish(hit.size);
+    send_reply();
+    return true;
+}
+
+void netlink::server::Server::cache_reply(std::string_view request_json, std::string_view reply, OP op, bool error) {
+    if (m_cache && m_cache->insert(request_json, reply, op, error)) {
+        m_stats.add(Counter::CACHE_EVICTIONS);
+    }
+}
+
+struct nl_msg *netlink::server::Server::prepare_reply(uint32_t seq, int flags) {
+    // Сообщение переиспользуется: достаточно сбросить длину до пустого заголовка
+    nlmsg_hdr(m_reply.get())->nlmsg_len = NLMSG_HDRLEN;
+    if (!genlmsg_put(m_reply.get(), NL_AUTO_PORT, seq, m_transport->family_id(), 0, NLM_F_REQUEST | flags, M_COMMAND_SERVER, 1)) {
+        NETLINK_LOG(LOG_ERR, "Failed to create Netlink message header");
+        throw std::runtime_error("Failed to create Netlink message header");
     }
+    return m_reply.get();
+}
 
-    return NL_OK;
+netlink::common::StringAttribute netlink::server::Server::prepare_message(uint32_t seq, std::size_t capacity, int flags) {
+    common::StringAttribute reply(prepare_reply(seq, flags), static_cast<int>(ATTR::ATTR_MSG), capacity);
+    if (!reply) {
+        NETLINK_LOG(LOG_ERR, "Failed to reserve the JSON payload");
+        throw std::runtime_error("Failed to reserve the JSON payload");
+    }
+    return reply;
 }
 
-void netlink::server::Server::send_message(const std::string &payload) {
-    syslog(LOG_DEBUG, "Sending message: %s", payload.c_str());
+void netlink::server::Server::send_reply() { transmit(m_reply.get(), "message"); }
+
+void netlink::server::Server::transmit(struct nl_msg *msg, const char *what) {
+    struct nlmsghdr *nlh = nlmsg_hdr(msg);
+    int ret = m_transport->send(nlh, nlh->nlmsg_len);
+    if (ret < 0) {
+        m_stats.add(Counter::SEND_FAILURES);
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Failed to send %s: %s", what, strerror(-ret));
+        throw std::runtime_error(std::string("Failed to send ") + what);
+    }
+    m_stats.add(Counter::MESSAGES_OUT);
+    m_stats.add(Counter::BYTES_OUT, nlh->nlmsg_len);
+    NETLINK_LOG(LOG_DEBUG, "The %s sent successfully with sequence number: %u", what, nlh->nlmsg_seq);
+}
+
+void netlink::server::Server::send_message(const char *payload, uint32_t seq, int flags) {
+    NETLINK_LOG(LOG_DEBUG, "Sending message: %s", payload);
+
+    struct nl_msg *msg = prepare_reply(seq, flags);
+    if (nla_put_string(msg, static_cast<int>(ATTR::ATTR_MSG), payload)) {
+        NETLINK_LOG(LOG_ERR, "Failed to attach the JSON payload");
+        throw std::runtime_error("Failed to attach the JSON payload");
+    }
+    send_reply();
+}
+
+void netlink::server::Server::send_batch(std::vector<std::string> const &payloads, uint32_t seq) {
+    NETLINK_LOG(LOG_DEBUG, "Sending batch of %zu responses", payloads.size());
+
+    std::size_t size = 0;
+    for (auto const &payload : payloads) {
+        size += nla_total_size(payload.size() + 1);
+    }
 
     auto deleter_msg = [](nl_msg *msg) {
         if (msg) {
             nlmsg_free(msg);
         }
     };
-    std::unique_ptr<nl_msg, decltype(deleter_msg)> msg(nlmsg_alloc(), deleter_msg);
+    std::unique_ptr<nl_msg, decltype(deleter_msg)> msg(nlmsg_alloc_size(nlmsg_total_size(GENL_HDRLEN + nla_total_size(size))), deleter_msg);
+    if (!msg) {
+        NETLINK_LOG(LOG_ERR, "Failed to allocate Netlink message");
+        throw std::runtime_error("Failed to allocate Netlink message");
+    }
 
-    if (!genlmsg_put(msg.get(), NL_AUTO_PORT, NL_AUTO_SEQ, m_family_id, 0, 0, M_COMMAND_SERVER, 1)) {
-        syslog(LOG_ERR, "Failed to create Netlink message header");
+    if (!genlmsg_put(msg.get(), NL_AUTO_PORT, seq, m_transport->family_id(), 0, NLM_F_REQUEST, M_COMMAND_SERVER, 1)) {
+        NETLINK_LOG(LOG_ERR, "Failed to create Netlink message header");
         throw std::runtime_error("Failed to create Netlink message header");
     }
 
-    if (nla_put_string(msg.get(), static_cast<int>(ATTR::ATTR_MSG), payload.c_str())) {
-        syslog(LOG_ERR, "Failed to attach the JSON payload");
-        throw std::runtime_error("Failed to attach the JSON payload");
+    struct nlattr *batch = nla_nest_start(msg.get(), static_cast<int>(ATTR::ATTR_BATCH));
+    if (!batch) {
+        NETLINK_LOG(LOG_ERR, "Failed to start the batch attribute");
+        throw std::runtime_error("Failed to start the batch attribute");
+    }
+    for (auto const &payload : payloads) {
+        if (nla_put_string(msg.get(), static_cast<int>(ATTR::ATTR_MSG), payload.c_str())) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach the JSON payload to the batch");
+            throw std::runtime_error("Failed to attach the JSON payload to the batch");
+        }
     }
+    nla_nest_end(msg.get(), batch);
 
-    int ret = nl_send_auto(m_sock, msg.get());
-    if (ret < 0) {
-        syslog(LOG_ERR, "Failed to send message");
-        throw std::runtime_error("Failed to send message");
-    } else {
-        nlmsghdr *nlh = nlmsg_hdr(msg.get());
-        syslog(LOG_DEBUG, "Message sent successfully with sequence number: %d", nlh->nlmsg_seq);
+    transmit(msg.get(), "batch");
+}
+
+std::vector<std::string> netlink::server::Server::process_batch(struct nlattr *batch) {
+    std::vector<std::string> payloads;
+    struct nlattr *entry = nullptr;
+    int rem = 0;
+
+    nla_for_each_nested(entry, batch, rem) {
+        if (nla_type(entry) != static_cast<int>(ATTR::ATTR_MSG)) {
+            payloads.emplace_back("Invalid batch entry");
+            continue;
+        }
+        auto const *data = static_cast<const char *>(nla_data(entry));
+        try {
+            nlohmann::json result_json = process_request(std::string(data, strnlen(data, nla_len(entry))));
+            payloads.emplace_back(result_json.empty() ? "{}" : result_json.dump());
+        } catch (std::exception &ex) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Error occurred in batch entry: %s", ex.what());
+            payloads.emplace_back(ex.what());
+        }
     }
+    return payloads;
 }
 
-nlohmann::json netlink::server::Server::process_request(std::string const &request_json) {
-    syslog(LOG_DEBUG, "Processing the request: %s", request_json.c_str());
-    nlohmann::json request = nlohmann::json::parse(request_json);
-    if (request.contains("message")) {
-        return {};
+nlohmann::json netlink::server::Server::process_request(std::string const &request_json, OP &op) {
+    NETLINK_LOG(LOG_DEBUG, "Processing the request: %s", request_json.c_str());
+    std::string action;
+    std::string shm;
+    std::string type = "int64";
+    int64_t arg1 = 0;
+    int64_t arg2 = 0;
+    Int128 wide1 = 0;
+    Int128 wide2 = 0;
+    std::vector<int64_t> array1;
+    std::vector<int64_t> array2;
+    bool array = false;
+    try {
+        nlohmann::json request = nlohmann::json::parse(request_json);
+        if (request.contains("message")) {
+            return {};
+        }
+        if (request.contains("shm")) {
+            shm = request.at("shm").get<std::string>();
+        } else if (!request.contains("action") || !request.contains("arg1") || !request.contains("arg2")) {
+            throw std::runtime_error("Invalid input. Missing fields 'action', 'arg1', or 'arg2'");
+        } else {
+            action = request.at("action").get<std::string>();
+            if (request.contains("type")) {
+                type = request.at("type").get<std::string>();
+            }
+            array = request.at("arg1").is_array() || request.at("arg2").is_array();
+            if (type != "int64" && type != "int128") {
+                throw std::runtime_error("Invalid type. Supported types are 'int64', 'int128'");
+            } else if (array && type != "int64") {
+                throw std::runtime_error("Invalid input. Arrays support only the 'int64' type");
+            } else if (array) {
+                array1 = request.at("arg1").get<std::vector<int64_t>>();
+                array2 = request.at("arg2").get<std::vector<int64_t>>();
+                if (array1.size() != array2.size()) {
+                    throw std::runtime_error("Invalid input. Arrays 'arg1' and 'arg2' must have the same length");
+                }
+            } else if (type == "int128") {
+                wide1 = read_int128(request.at("arg1"));
+                wide2 = read_int128(request.at("arg2"));
+            } else {
+                arg1 = read_int64(request.at("arg1"));
+                arg2 = read_int64(request.at("arg2"));
+            }
+        }
+    } catch (std::exception &) {
+        m_stats.add(Counter::PARSE_ERRORS);
+        throw;
     }
-    if (!request.contains("action") || !request.contains("arg1") || !request.contains("arg2")) {
-        throw std::runtime_error("Invalid input. Missing fields 'action', 'arg1', or 'arg2'");
+    if (!shm.empty()) {
+        return open_shm(shm);
     }
 
-    std::string action = request.at("action").get<std::string>();
-    int arg1 = request.at("arg1").get<int>();
-    int arg2 = request.at("arg2").get<int>();
-    int result = 0;
+    op = parse_action(action);
+    count_action(op);
+    if (op == OP::OP_UNSPEC) {
+        throw std::runtime_error("Invalid action. Supported actions are " + supported_actions());
+    }
 
-    if (action == "add") {
-        result = arg1 + arg2;
-    } else if (action == "sub") {
-        result = arg1 - arg2;
-    } else if (action == "mul") {
-        result = arg1 * arg2;
+    nlohmann::json response;
+    if (array) {
+        // Массивы вычисляются по модулю 2^64 векторными инструкциями, деление не векторизуется
+        if (!find_operation(op)->bulk) {
+            throw std::runtime_error("Invalid action. Arrays support " + supported_actions(true));
+        }
+        m_stats.add(Counter::REQUESTS_ARRAY);
+        m_stats.add(Counter::ARRAY_ELEMENTS, array1.size());
+        BulkEngine::compute(op, array1.data(), array2.data(), array1.data(), array1.size());
+        response["result"] = std::move(array1);
+    } else if (type == "int128") {
+        CheckedResult<Int128> const result = calculate(op, wide1, wide2);
+        if (result.error != 0) {
+            m_stats.add(Counter::ARITHMETIC_ERRORS);
+            return arithmetic_error(result.error);
+        }
+        response["result"] = to_string(result.value);
     } else {
-        throw std::runtime_error("Invalid action. Supported actions are 'add', 'sub', 'mul'");
+        BinaryResult const result = calculate(op, arg1, arg2);
+        if (result.error != 0) {
+            m_stats.add(Counter::ARITHMETIC_ERRORS);
+            return arithmetic_error(result.error);
+        }
+        response["result"] = result.value;
+    }
+    return response;
+}
+
+nlohmann::json netlink::server::Server::arithmetic_error(int error) {
+    nlohmann::json response;
+    response["errno"] = error;
+    response["error"] = arithmetic_error_text(error);
+    return response;
+}
+
+std::size_t netlink::server::Server::format_arithmetic_error(int error, char *buffer, std::size_t size) {
+    common::JsonWriter writer(buffer, size);
+    writer.begin_object().key("errno").value(int64_t{error}).key("error").value(arithmetic_error_text(error)).end_object();
+    return writer.ok() ? writer.size() : 0;
+}
+
+const char *netlink::server::Server::arithmetic_error_text(int error) {
+    return error == EDOM ? "division by zero" : error == ERANGE ? "overflow" : strerror(error);
+}
+
+nlohmann::json netlink::server::Server::open_shm(std::string const &name) {
+    std::erase_if(m_shm_sessions, [](std::unique_ptr<ShmSession> const &session) { return session->finished(); });
+    if (m_shm_sessions.size() >= M_MAX_SHM_SESSIONS) {
+        // У каждой сессии свой поток: лишние клиенты работают через Netlink
+        throw std::runtime_error("Too many shared memory channels");
     }
+    m_shm_sessions.push_back(std::make_unique<ShmSession>(transport::ShmChannel::open(name)));
+    m_stats.add(Counter::SHM_CHANNELS);
 
     nlohmann::json response;
-    response["result"] = result;
+    response["result"] = 0;
     return response;
 }
 
+void netlink::server::Server::count_action(OP op) {
+    Operation const *operation = find_operation(op);
+    m_stats.add(operation ? operation->counter : Counter::REQUESTS_INVALID);
+}
+
+netlink::server::OP netlink::server::Server::parse_action(std::string_view action) {
+    Operation const *operation = find_operation(action);
+    return operation ? operation->op : OP::OP_UNSPEC;
+}
+
+netlink::server::BinaryResult netlink::server::Server::process_binary(struct nlattr **attrs) {
+    if (!attrs[static_cast<int>(ATTR::ATTR_OP)] || !attrs[static_cast<int>(ATTR::ATTR_ARG1)] || !attrs[static_cast<int>(ATTR::ATTR_ARG2)]) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Invalid binary request. Missing attributes 'op', 'arg1', or 'arg2'");
+        return {EINVAL, 0};
+    }
+
+    auto const op = static_cast<OP>(nla_get_u8(attrs[static_cast<int>(ATTR::ATTR_OP)]));
+    count_action(op);
+    Operation const *operation = find_operation(op);
+    if (!operation) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Invalid binary request. Unsupported operation %d", static_cast<int>(op));
+        return {EINVAL, 0};
+    }
+
+    int64_t arg1 = nla_get_s64(attrs[static_cast<int>(ATTR::ATTR_ARG1)]);
+    int64_t arg2 = nla_get_s64(attrs[static_cast<int>(ATTR::ATTR_ARG2)]);
+    BinaryResult const result = operation->int64(arg1, arg2);
+    if (result.error != 0) {
+        m_stats.add(Counter::ARITHMETIC_ERRORS);
+    }
+    return result;
+}
+
+void netlink::server::Server::process_array(struct nlattr **attrs, uint32_t seq) {
+    auto const op = static_cast<OP>(nla_get_u8(attrs[static_cast<int>(ATTR::ATTR_OP)]));
+    count_action(op);
+    struct nlattr *array1 = attrs[static_cast<int>(ATTR::ATTR_ARRAY1)];
+    struct nlattr *array2 = attrs[static_cast<int>(ATTR::ATTR_ARRAY2)];
+    Operation const *operation = find_operation(op);
+    if (!operation || !operation->bulk || !array1 || !array2 || nla_len(array1) != nla_len(array2) ||
+        nla_len(array1) % sizeof(int64_t) != 0) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Invalid array request. Operation %d, arrays of %d and %d bytes", static_cast<int>(op),
+                                array1 ? nla_len(array1) : -1, array2 ? nla_len(array2) : -1);
+        send_result({EINVAL, 0}, seq);
+        return;
+    }
+
+    // Данные атрибутов выровнены на 4 байта: аргументы копируются в выровненный буфер
+    std::size_t const count = static_cast<std::size_t>(nla_len(array1)) / sizeof(int64_t);
+    m_array_args.resize(count * 2);
+    m_array_results.resize(count);
+    std::memcpy(m_array_args.data(), nla_data(array1), count * sizeof(int64_t));
+    std::memcpy(m_array_args.data() + count, nla_data(array2), count * sizeof(int64_t));
+    BulkEngine::compute(op, m_array_args.data(), m_array_args.data() + count, m_array_results.data(), count);
+    m_stats.add(Counter::ARRAY_ELEMENTS, count);
+
+    send_array(m_array_results.data(), count, seq);
+}
+
+void netlink::server::Server::send_array(int64_t const *results, std::size_t count, uint32_t seq) {
+    std::size_t offset = 0;
+    do {
+        std::size_t const part = std::min(M_ARRAY_PART, count - offset);
+        bool const last = offset + part == count;
+        struct nl_msg *msg = prepare_reply(seq, last ? 0 : NLM_F_MULTI);
+        if (nla_put_u32(msg, static_cast<int>(ATTR::ATTR_OFFSET), static_cast<uint32_t>(offset)) ||
+            nla_put(msg, static_cast<int>(ATTR::ATTR_RESULTS), static_cast<int>(part * sizeof(int64_t)), results + offset)) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach the array result");
+            throw std::runtime_error("Failed to attach the array result");
+        }
+        send_reply();
+        offset += part;
+    } while (offset < count);
+}
+
+void netlink::server::Server::send_json_array(nlohmann::json const &results, uint32_t seq) {
+    std::size_t offset = 0;
+    do {
+        std::size_t const part = std::min(M_JSON_ARRAY_PART, results.size() - offset);
+        bool const last = offset + part == results.size();
+        // Часть записывается прямо в сообщение: {"offset":N,"result":[...]}, как nlohmann::json::dump
+        common::StringAttribute reply = prepare_message(seq, M_JSON_ARRAY_REPLY_SIZE, last ? 0 : NLM_F_MULTI);
+        common::JsonWriter writer(reply.data(), reply.capacity());
+        writer.begin_object().key("offset").value(static_cast<int64_t>(offset)).key("result").begin_array();
+        for (std::size_t i = offset; i < offset + part; ++i) {
+            writer.value(results[i].get<int64_t>());
+        }
+        writer.end_array().end_object();
+        if (!writer.ok()) {
+            NETLINK_LOG(LOG_ERR, "Array reply part exceeds %zu bytes", M_JSON_ARRAY_REPLY_SIZE);
+            throw std::runtime_error("Array reply part exceeds the reply size");
+        }
+        reply.finish(writer.size());
+        send_reply();
+        offset += part;
+    } while (offset < results.size());
+}
+
+void netlink::server::Server::process_stream(struct nlattr **attrs, uint32_t seq) {
+    uint32_t const id = nla_get_u32(attrs[static_cast<int>(ATTR::ATTR_STREAM)]);
+    uint32_t const chunk = attrs[static_cast<int>(ATTR::ATTR_CHUNK)] ? nla_get_u32(attrs[static_cast<int>(ATTR::ATTR_CHUNK)]) : 0;
+    bool const eos = attrs[static_cast<int>(ATTR::ATTR_EOS)] != nullptr;
+    struct nlattr *data = attrs[static_cast<int>(ATTR::ATTR_DATA)];
+    m_stats.add(Counter::STREAM_CHUNKS);
+
+    auto it = m_streams.find(id);
+    if (chunk == 0) {
+        if (it == m_streams.end() && m_streams.size() >= M_MAX_STREAMS) {
+            // Клиент, не завершивший поток, не должен занимать память бесконечно
+            auto oldest = std::min_element(m_streams.begin(), m_streams.end(),
+                                           [](auto const &a, auto const &b) { return a.second.last_used < b.second.last_used; });
+            NETLINK_LOG_RATELIMITED(LOG_WARNING, "Too many open streams, stream %u dropped", oldest->first);
+            m_stream_bytes -= oldest->second.data.size();
+            m_streams.erase(oldest);
+        }
+        if (it != m_streams.end()) {
+            m_stream_bytes -= it->second.data.size();
+        }
+        it = m_streams.insert_or_assign(id, Stream{}).first;
+    } else if (it == m_streams.end()) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Chunk %u of unknown stream %u", chunk, id);
+        send_result({ENOENT, 0}, seq);
+        return;
+    }
+
+    Stream &stream = it->second;
+    stream.last_used = ++m_stream_clock;
+    if (stream.error == 0) {
+        std::size_t const size = data ? static_cast<std::size_t>(nla_len(data)) : 0;
+        if (chunk != stream.next_chunk) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Stream %u expected chunk %u, received %u", id, stream.next_chunk, chunk);
+            stream.error = EPROTO;
+        } else if (stream.data.size() + size > M_STREAM_MAX_SIZE) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Stream %u exceeds %zu bytes", id, M_STREAM_MAX_SIZE);
+            stream.error = EMSGSIZE;
+        } else if (m_stream_bytes + size > M_STREAM_BUDGET) {
+            // Память всех собираемых потоков рабочего потока ограничена, а не только каждого из них
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Stream %u rejected: open streams hold %zu bytes", id, m_stream_bytes);
+            stream.error = ENOBUFS;
+        } else if (size > 0) {
+            stream.data.append(static_cast<const char *>(nla_data(data)), size);
+            m_stream_bytes += size;
+        }
+        // Память под отклоненный поток освобождается сразу, до ATTR_EOS
+        if (stream.error != 0) {
+            m_stream_bytes -= stream.data.size();
+            std::string().swap(stream.data);
+        }
+    }
+    stream.next_chunk = chunk + 1;
+
+    if (!eos) {
+        if (stream.error != 0) {
+            send_result({stream.error, 0}, seq);
+            return;
+        }
+        struct nl_msg *msg = prepare_reply(seq);
+        if (nla_put_u32(msg, static_cast<int>(ATTR::ATTR_STREAM), id) || nla_put_u32(msg, static_cast<int>(ATTR::ATTR_CHUNK), chunk)) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach the stream acknowledgement");
+            throw std::runtime_error("Failed to attach the stream acknowledgement");
+        }
+        send_reply();
+        return;
+    }
+
+    Stream finished = std::move(stream);
+    m_streams.erase(it);
+    m_stream_bytes -= finished.data.size();
+    if (finished.error != 0) {
+        send_result({finished.error, 0}, seq);
+        return;
+    }
+    m_stats.add(Counter::REQUESTS_STREAM);
+    NETLINK_LOG(LOG_DEBUG, "Stream %u assembled: %zu bytes in %u chunks", id, finished.data.size(), finished.next_chunk);
+
+    std::string response;
+    try {
+        response = process_request(finished.data).dump();
+    } catch (std::exception &ex) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Error occurred: %s", ex.what());
+        response = ex.what();
+    }
+    send_stream(response, id, seq);
+}
+
+void netlink::server::Server::send_stream(std::string_view payload, uint32_t stream, uint32_t seq) {
+    std::size_t offset = 0;
+    uint32_t chunk = 0;
+    do {
+        std::size_t const part = std::min(M_STREAM_PART, payload.size() - offset);
+        bool const last = offset + part == payload.size();
+        struct nl_msg *msg = prepare_reply(seq, last ? 0 : NLM_F_MULTI);
+        if (nla_put_u32(msg, static_cast<int>(ATTR::ATTR_STREAM), stream) || nla_put_u32(msg, static_cast<int>(ATTR::ATTR_CHUNK), chunk) ||
+            nla_put(msg, static_cast<int>(ATTR::ATTR_DATA), static_cast<int>(part), payload.data() + offset) ||
+            (last && nla_put_flag(msg, static_cast<int>(ATTR::ATTR_EOS)))) {
+            NETLINK_LOG(LOG_ERR, "Failed to attach the stream response");
+            throw std::runtime_error("Failed to attach the stream response");
+        }
+        send_reply();
+        offset += part;
+        ++chunk;
+    } while (offset < payload.size());
+}
+
+void netlink::server::Server::send_result(BinaryResult const &result, uint32_t seq) {
+    struct nl_msg *msg = prepare_reply(seq);
+    int ret = result.error != 0 ? nla_put_s32(msg, static_cast<int>(ATTR::ATTR_ERRNO), result.error)
+                                : nla_put_s64(msg, static_cast<int>(ATTR::ATTR_RESULT), result.value);
+    if (ret) {
+        NETLINK_LOG(LOG_ERR, "Failed to attach the binary result");
+        throw std::runtime_error("Failed to attach the binary result");
+    }
+    send_reply();
+}
+
 void netlink::server::Server::wait_for_response() {
-    syslog(LOG_DEBUG, "Waiting for responses from the kernel");
+    NETLINK_LOG(LOG_DEBUG, "Waiting for responses from the kernel");
     while (true) {
-        int ret = nl_recvmsgs_default(m_sock);
-        if (ret < 0) {
-            syslog(LOG_ERR, "An error occurred while receiving the message: %s", nl_geterror(ret));
+        ReceiveStatus status = receive_datagrams();
+        if (status == ReceiveStatus::AGAIN) {
+            // Транспорт в неблокирующем режиме: ждем готовности дескриптора
+            struct pollfd pfd = {m_transport->fd(), POLLIN, 0};
+            if (pfd.fd >= 0 && (poll(&pfd, 1, -1) >= 0 || errno == EINTR)) {
+                continue;
+            }
+            status = ReceiveStatus::FAILED;
+        }
+        if (status != ReceiveStatus::OK) {
             break;
         }
     }
-    syslog(LOG_DEBUG, "Client operations completed");
+    NETLINK_LOG(LOG_DEBUG, "Client operations completed");
+}
+
+void netlink::server::Server::attach(common::EventLoop &loop) {
+    detach();
+    int const fd = m_transport->fd();
+    int ret = fd < 0 ? -EOPNOTSUPP : m_transport->set_nonblocking(true);
+    if (ret < 0) {
+        NETLINK_LOG(LOG_ERR, "The transport can not be used with an event loop: %s", strerror(-ret));
+        throw std::runtime_error("The transport can not be used with an event loop");
+    }
+    loop.add(fd, EPOLLIN, [this](uint32_t) {
+        ReceiveStatus status = ReceiveStatus::OK;
+        while ((status = receive_datagrams()) == ReceiveStatus::OK) {
+        }
+        if (status != ReceiveStatus::AGAIN) {
+            detach();
+        }
+    });
+    m_loop = &loop;
+}
+
+void netlink::server::Server::detach() {
+    if (!m_loop) {
+        return;
+    }
+    m_loop->remove(m_transport->fd());
+    m_transport->set_nonblocking(false);
+    m_loop = nullptr;
+}
+
+netlink::server::Server::ReceiveStatus netlink::server::Server::receive_datagrams() {
+    int received = m_transport->receive_batch(m_rx_datagrams.data(), m_rx_datagrams.size());
+    if (received == -EAGAIN) {
+        return ReceiveStatus::AGAIN;
+    }
+    if (received == 0) {
+        NETLINK_LOG(LOG_INFO, "The transport was closed by the other side");
+        return ReceiveStatus::CLOSED;
+    }
+    if (received < 0) {
+        if (received == -ENOBUFS) {
+            // Сокет остается пригодным: потерянные запросы учитываются, прием продолжается
+            m_stats.add(Counter::RECEIVE_OVERFLOWS);
+            NETLINK_LOG_RATELIMITED(LOG_WARNING, "Netlink receive buffer overflow, some requests were dropped");
+            return ReceiveStatus::OK;
+        }
+        NETLINK_LOG(LOG_ERR, "An error occurred while receiving the message: %s", strerror(-received));
+        return ReceiveStatus::FAILED;
+    }
+    m_stats.add(Counter::RECEIVE_CALLS);
+
+    uint64_t messages = 0;
+    for (int i = 0; i < received; ++i) {
+        messages += handle_datagram(static_cast<char *>(m_rx_datagrams[i].data), m_rx_datagrams[i].length);
+    }
+    m_stats.add(Counter::MESSAGES_IN, messages);
+    m_stats.queue_depth().record(messages);
+    return ReceiveStatus::OK;
+}
+
+uint64_t netlink::server::Server::handle_datagram(char *data, ssize_t length) {
+    if (static_cast<std::size_t>(length) > M_RX_BUFFER_SIZE) {
+        m_stats.add(Counter::TRUNCATED);
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "Dropping truncated message of %zd bytes", length);
+        return 0;
+    }
+    m_stats.add(Counter::DATAGRAMS_IN);
+    m_stats.add(Counter::BYTES_IN, static_cast<uint64_t>(length));
+
+    uint64_t messages = 0;
+    int remaining = static_cast<int>(length);
+    for (auto *nlh = reinterpret_cast<struct nlmsghdr *>(data); nlmsg_ok(nlh, remaining); nlh = nlmsg_next(nlh, &remaining)) {
+        auto const start = std::chrono::steady_clock::now();
+        try {
+            receive_message(nlh);
+        } catch (std::exception &ex) {
+            NETLINK_LOG_RATELIMITED(LOG_ERR, "Failed to handle message with sequence number %u: %s", nlh->nlmsg_seq, ex.what());
+        }
+        m_stats.processing_time().record(
+            static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()));
+        ++messages;
+    }
+    return messages;
 }
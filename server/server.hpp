@@ -2,73 +2,249 @@
 #include <netlink/genl/ctrl.h>
 #include <netlink/genl/genl.h>
 #include <netlink/netlink.h>
-#include <syslog.h>
 #include <unistd.h>
 
+#include <array>
+#include <cerrno>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "../common/event_loop.hpp"
+#include "../common/logger.hpp"
+#include "../common/string_attribute.hpp"
+#include "../transport/transport.hpp"
+#include "operations.hpp"
+#include "request_parser.hpp"
+#include "result_cache.hpp"
+#include "stats.hpp"
 
 static_assert(sizeof(int) == 4);
 
 //@todo: по хорошему надо сделать свои исключения
-//@todo: по хорошему надо сделать свой логгер
 
 /* для тестов, так себе решение */
 namespace tests {
 class ServerTest_Friend;
-}
+class ServerAllocation_Friend;
+} // namespace tests
+namespace bench {
+class ServerBench_Friend;
+} // namespace bench
 
 namespace netlink::server {
 
+class ShmSession;
+
 enum class ATTR : int {
     ATTR_UNSPEC,
     ATTR_MSG,
+    ATTR_BATCH,
+    ATTR_OP,
+    ATTR_ARG1,
+    ATTR_ARG2,
+    ATTR_RESULT,
+    ATTR_ERRNO,
+    ATTR_ARRAY1,
+    ATTR_ARRAY2,
+    ATTR_RESULTS,
+    ATTR_OFFSET,
+    ATTR_STREAM,
+    ATTR_CHUNK,
+    ATTR_EOS,
+    ATTR_DATA,
+    ATTR_CREDITS,
+    ATTR_TOPIC,
     ATTR_MAX,
 };
 
-
-
 class Server final {
    public:
+    static constexpr uint8_t LIFECYCLE_PROTOCOL_VERSION = 5;    /**< Версия семейства с командами регистрации и ее отмены. */
+    static constexpr uint8_t BACKPRESSURE_PROTOCOL_VERSION = 6; /**< Версия семейства, в которой сервер сообщает емкость. */
+    /**
+     * @brief Емкость сервера по умолчанию: столько наибольших запросов (64 КиБ в очереди сокета)
+     * помещается в буфер приема GenlTransport::DEFAULT_BUFFER_SIZE.
+     */
+    static constexpr uint32_t DEFAULT_CREDITS = 128;
+
     /**
      * @brief Конструктор класса Netlink-сервера.
      *
-     * Инициализирует Netlink-сервер, выделяет сокет, устанавливает соединение с Netlink,
-     * разрешает имя семейства Netlink и отправляет тестовое сообщение.
+     * Инициализирует Netlink-сервер поверх транспорта Generic Netlink (GenlTransport)
+     * и регистрируется в модуле ядра (командой регистрации или, для версий семейства ниже
+     * LIFECYCLE_PROTOCOL_VERSION, тестовым сообщением) с емкостью DEFAULT_CREDITS.
      *
      * @throw std::runtime_error Если не удалось выделить сокет, установить соединение или определить семейство.
      */
     Server();
+    /**
+     * @brief Конструктор Netlink-сервера поверх заданного транспорта.
+     *
+     * Тестовое сообщение для регистрации отправляется только транспортам с ретранслятором.
+     * Начиная с версии семейства BACKPRESSURE_PROTOCOL_VERSION команда регистрации сообщает
+     * ретранслятору емкость: запросы сверх нее он отклоняет с EBUSY, а не ставит в очередь сокета.
+     *
+     * @param transport Транспорт для приема запросов и отправки ответов.
+     * @param credits Наибольшее число запросов в полете на этом сервере (0 - без ограничения).
+     *
+     * @throw std::runtime_error Если не удалось выделить буферы или отправить тестовое сообщение.
+     */
+    explicit Server(std::unique_ptr<transport::Transport> transport, uint32_t credits = DEFAULT_CREDITS);
     Server(Server const &) = delete;
     Server(Server &&) = delete;
     Server &operator=(Server const &) = delete;
     Server &operator=(Server &&) = delete;
     ~Server();
     friend class tests::ServerTest_Friend;
+    friend class tests::ServerAllocation_Friend;
+    friend class bench::ServerBench_Friend;
+    friend class ShmSession;
     /**
      * @brief Ожидает ответы от ядра.
      *
-     * Этот метод блокируется и принимает входящие сообщения от ядра, обрабатывая их.
-     * Останавливается в случае возникновения ошибки.
+     * Этот метод блокируется и принимает входящие сообщения из транспорта, обрабатывая их.
+     * Сообщения читаются в заранее выделенный буфер, без выделения памяти на каждое сообщение.
+     * Останавливается в случае возникновения ошибки или закрытия транспорта другой стороной.
      */
     void wait_for_response();
+    /**
+     * @brief Подключает сервер к циклу событий.
+     *
+     * Транспорт переводится в неблокирующий режим, запросы обрабатываются циклом по готовности
+     * дескриптора. Когда другая сторона закрывает транспорт, сервер отключается от цикла.
+     * Цикл должен пережить сервер или отключение через detach.
+     *
+     * @throw std::runtime_error Если у транспорта нет дескриптора или его не удалось перевести в неблокирующий режим.
+     */
+    void attach(common::EventLoop &loop);
+    /**
+     * @brief Отключает сервер от цикла событий.
+     */
+    void detach();
+    /**
+     * @brief Статистика сервера.
+     *
+     * Обновляется потоком, вызвавшим wait_for_response; читать можно из любого потока.
+     */
+    Stats const &stats() const { return m_stats; }
+    /**
+     * @brief Подключает кэш ответов на одиночные JSON-запросы (nullptr - отключает).
+     *
+     * Один кэш может разделяться серверами всех рабочих потоков. Вызывается до запуска обработки.
+     */
+    void set_result_cache(std::shared_ptr<ResultCache> cache) { m_cache = std::move(cache); }
+    /**
+     * @brief Отменяет регистрацию сервера в ретрансляторе.
+     *
+     * Модуль перестает направлять серверу новые запросы, а ответы на принятые по-прежнему
+     * пересылает клиентам. Сообщение собирается отдельно от буфера ответов, поэтому метод можно
+     * вызывать из другого потока, пока рабочий поток обслуживает сервер.
+     *
+     * @return true, если команда отправлена (транспорт с ретранслятором версии LIFECYCLE_PROTOCOL_VERSION и выше).
+     */
+    bool unregister();
 
    private:
     /**
-     * @brief Обработчик для получения сообщений из подсистемы Netlink.
+     * @brief Результат приема одной датаграммы.
+     */
+    enum class ReceiveStatus {
+        OK,     /**< Датаграмма обработана или отброшена, можно принимать следующую. */
+        AGAIN,  /**< Датаграмм нет (неблокирующий режим). */
+        CLOSED, /**< Другая сторона закрыла транспорт. */
+        FAILED, /**< Ошибка приема. */
+    };
+
+    /**
+     * @brief Принимает до M_RX_BATCH датаграмм за один вызов транспорта и обрабатывает все их сообщения.
+     */
+    ReceiveStatus receive_datagrams();
+    /**
+     * @brief Обрабатывает сообщения одной принятой датаграммы.
      *
-     * Разбирает полученные сообщения, обрабатывает запросы и отправляет ответы
-     * на основе содержимого сообщений.
+     * @return Количество сообщений в датаграмме.
+     */
+    uint64_t handle_datagram(char *data, ssize_t length);
+    /**
+     * @brief Обработчик сообщения из подсистемы Netlink.
      *
-     * @note Этот метод регистрируется как callback для обработки входящих сообщений.
+     * Разбирает полученное сообщение, обрабатывает запрос и отправляет ответ
+     * на основе содержимого сообщения. Одиночные JSON-запросы и бинарные запросы
+     * обрабатываются без выделения памяти в куче.
      *
-     * @param msg Структура сообщения Netlink.
-     * @param arg Пользовательский аргумент, содержащий указатель на текущий экземпляр Server.
+     * @param nlh Заголовок сообщения Netlink в буфере приема.
+     */
+    void receive_message(struct nlmsghdr *nlh);
+    /**
+     * @brief Обрабатывает одиночный JSON-запрос без выделения памяти.
+     *
+     * Использует RequestParser и форматирует ответ в буфер на стеке.
+     *
+     * @param request_json Текст запроса.
+     * @param seq Номер последовательности запроса.
+     *
+     * @return true если ответ отправлен, false если запрос нужно обработать через process_request.
+     *
+     * @throw std::runtime_error Если не удалось отправить ответ.
+     */
+    bool process_request_fast(std::string_view request_json, uint32_t seq);
+    /**
+     * @brief Готовит переиспользуемое сообщение для ответа.
+     *
+     * Сбрасывает длину заранее выделенного сообщения и записывает заголовок Generic Netlink.
+     *
+     * @param seq Номер последовательности сообщения.
+     * @param flags Дополнительные флаги заголовка (NLM_F_MULTI для части потокового ответа).
+     *
+     * @return Сообщение, в которое можно добавлять атрибуты.
+     *
+     * @throw std::runtime_error Если не удалось создать заголовок.
+     */
+    struct nl_msg *prepare_reply(uint32_t seq, int flags = 0);
+    /**
+     * @brief Готовит ответ с атрибутом ATTR_MSG, текст которого записывается прямо в сообщение.
+     *
+     * После записи текста вызываются StringAttribute::finish и send_reply.
+     *
+     * @param capacity Наибольшая длина ответа.
+     *
+     * @throw std::runtime_error Если не удалось создать заголовок или зарезервировать атрибут.
+     */
+    common::StringAttribute prepare_message(uint32_t seq, std::size_t capacity, int flags = 0);
+    /**
+     * @brief Отправляет сообщение, подготовленное prepare_reply.
      *
-     * @return NL_OK при успешной обработке сообщения или код ошибки в противном случае.
+     * @throw std::runtime_error Если отправка завершилась ошибкой.
      */
-    static int receive_message(struct nl_msg *msg, void *arg);
+    void send_reply();
+    /**
+     * @brief Отправляет готовое сообщение через транспорт.
+     *
+     * @param msg Сообщение Netlink.
+     * @param what Описание сообщения для журнала и текста исключения.
+     *
+     * @throw std::runtime_error Если отправка завершилась ошибкой.
+     */
+    void transmit(struct nl_msg *msg, const char *what);
+    /**
+     * @brief Отправляет ретранслятору команду регистрации или ее отмены.
+     *
+     * Не использует буфер ответов и статистику сервера.
+     *
+     * @param command Команда семейства.
+     * @param credits Емкость сервера для ATTR_CREDITS (0 - без атрибута).
+     *
+     * @return 0 или отрицательный код ошибки.
+     */
+    int send_command(int command, uint32_t credits = 0);
     /**
      * @brief Отправляет сообщение Netlink в ядро.
      *
@@ -76,29 +252,266 @@ class Server final {
      * Используется как для запросов, так и для ответов.
      *
      * @param payload JSON-строка, которая будет отправлена.
+     * @param seq Номер последовательности сообщения. Для ответа передается номер запроса,
+     *            чтобы клиент мог сопоставить ответ со своим запросом.
+     * @param flags Дополнительные флаги заголовка (NLM_F_MULTI для части потокового ответа).
      *
      * @throw std::runtime_error Если невозможно создать сообщение, прикрепить JSON или отправить.
      */
-    void send_message(const std::string &payload);
+    void send_message(const char *payload, uint32_t seq = 0, int flags = 0);
+    /**
+     * @brief Отправляет ответ на пакет операций.
+     *
+     * Упаковывает ответы во вложенный атрибут ATTR_BATCH в том же порядке, в котором
+     * операции пришли в запросе. Буфер сообщения выделяется по суммарному размеру ответов.
+     *
+     * @param payloads Ответы на операции пакета.
+     * @param seq Номер последовательности запроса.
+     *
+     * @throw std::runtime_error Если невозможно создать сообщение, прикрепить ответы или отправить.
+     */
+    void send_batch(std::vector<std::string> const &payloads, uint32_t seq);
+    /**
+     * @brief Обрабатывает пакет операций.
+     *
+     * Каждая операция пакета (элемент ATTR_MSG) обрабатывается через process_request.
+     * Ошибка в одной операции не прерывает обработку пакета: вместо результата
+     * в ответ попадает текст ошибки.
+     *
+     * @param batch Вложенный атрибут ATTR_BATCH.
+     *
+     * @return Ответы на операции в порядке следования в пакете.
+     */
+    std::vector<std::string> process_batch(struct nlattr *batch);
+    /**
+     * @brief Отправляет ответ бинарного протокола.
+     *
+     * При успехе сообщение содержит ATTR_RESULT, при ошибке - ATTR_ERRNO.
+     *
+     * @param result Результат операции.
+     * @param seq Номер последовательности запроса.
+     *
+     * @throw std::runtime_error Если невозможно создать сообщение, прикрепить атрибуты или отправить.
+     */
+    void send_result(BinaryResult const &result, uint32_t seq);
+    /**
+     * @brief Обрабатывает запрос бинарного протокола.
+     *
+     * Читает операцию и аргументы из атрибутов ATTR_OP, ATTR_ARG1, ATTR_ARG2 без разбора JSON.
+     *
+     * @param attrs Атрибуты сообщения, разобранные по политике M_POLICY.
+     *
+     * @return Результат операции или EINVAL, если атрибутов не хватает или операция неизвестна.
+     */
+    BinaryResult process_binary(struct nlattr **attrs);
+    /**
+     * @brief Обрабатывает запрос над массивами бинарного протокола.
+     *
+     * ATTR_ARRAY1 и ATTR_ARRAY2 содержат массивы int64 одинаковой длины. Результат вычисляется
+     * BulkEngine и отправляется частями (send_array). Некорректный запрос получает ответ с ATTR_ERRNO.
+     *
+     * @throw std::runtime_error Если не удалось отправить ответ.
+     */
+    void process_array(struct nlattr **attrs, uint32_t seq);
+    /**
+     * @brief Отправляет результат над массивами частями до M_ARRAY_PART элементов.
+     *
+     * Каждая часть содержит ATTR_OFFSET (индекс первого элемента) и ATTR_RESULTS. Все части,
+     * кроме последней, помечаются NLM_F_MULTI: ретранслятор сохраняет маршрут запроса до последней части.
+     *
+     * @throw std::runtime_error Если не удалось отправить часть.
+     */
+    void send_array(int64_t const *results, std::size_t count, uint32_t seq);
+    /**
+     * @brief Отправляет результат JSON-запроса над массивами частями {"offset":N,"result":[...]}.
+     *
+     * Части не длиннее M_JSON_ARRAY_PART элементов, чтобы строка помещалась в ограничение ATTR_MSG модуля.
+     *
+     * @throw std::runtime_error Если не удалось отправить часть.
+     */
+    void send_json_array(nlohmann::json const &results, uint32_t seq);
+    /**
+     * @brief Обрабатывает фрагмент потокового запроса (ATTR_STREAM, ATTR_CHUNK, ATTR_DATA, ATTR_EOS).
+     *
+     * Фрагменты одного потока приходят по порядку (ретранслятор направляет их одному серверу)
+     * и дописываются к запросу потока. Фрагмент без ATTR_EOS подтверждается ответом
+     * с ATTR_STREAM и ATTR_CHUNK, после последнего фрагмента запрос обрабатывается как JSON
+     * и ответ отправляется send_stream. Пропущенный фрагмент (EPROTO), превышение M_STREAM_MAX_SIZE
+     * (EMSGSIZE), превышение M_STREAM_BUDGET всеми собираемыми потоками (ENOBUFS) или неизвестный
+     * поток (ENOENT) завершают поток ошибкой: фрагменты до ATTR_EOS получают ATTR_ERRNO.
+     *
+     * @throw std::runtime_error Если не удалось отправить ответ.
+     */
+    void process_stream(struct nlattr **attrs, uint32_t seq);
+    /**
+     * @brief Отправляет ответ на потоковый запрос частями ATTR_DATA до M_STREAM_PART байт.
+     *
+     * Части нумеруются в ATTR_CHUNK, все части кроме последней помечаются NLM_F_MULTI,
+     * последняя содержит ATTR_EOS.
+     *
+     * @throw std::runtime_error Если не удалось отправить часть.
+     */
+    void send_stream(std::string_view payload, uint32_t stream, uint32_t seq);
+    /**
+     * @brief Учитывает операцию в статистике запросов по действиям.
+     */
+    void count_action(OP op);
+    /**
+     * @brief Определяет операцию по имени действия JSON-запроса.
+     *
+     * Имя ищется совершенной хеш-функцией реестра (M_ACTIONS), построенной при компиляции.
+     *
+     * @return Операция или OP_UNSPEC, если действие не поддерживается.
+     */
+    static OP parse_action(std::string_view action);
+    /**
+     * @brief Выполняет операцию калькулятора с проверкой переполнения.
+     *
+     * Вычисление берется из реестра M_OPERATIONS по коду операции, без сравнения имен.
+     *
+     * @param op Операция.
+     *
+     * @return Результат или ERANGE (переполнение), EDOM (деление на ноль), EINVAL (неизвестная операция).
+     */
+    template <typename T>
+    static CheckedResult<T> calculate(OP op, T arg1, T arg2) {
+        Operation const *operation = find_operation(op);
+        if (!operation) {
+            return {EINVAL, T{}};
+        }
+        if constexpr (std::is_same_v<T, Int128>) {
+            return operation->int128(arg1, arg2);
+        } else {
+            return operation->int64(arg1, arg2);
+        }
+    }
+    /**
+     * @brief Ответ JSON-запроса с ошибкой вычисления: {"errno": код, "error": описание}.
+     */
+    static nlohmann::json arithmetic_error(int error);
+    /**
+     * @brief Записывает ответ с ошибкой вычисления, совпадающий с arithmetic_error(error).dump().
+     *
+     * @return Длина ответа или 0, если буфер слишком мал.
+     */
+    static std::size_t format_arithmetic_error(int error, char *buffer, std::size_t size);
+    /**
+     * @brief Описание ошибки вычисления для поля "error".
+     */
+    static const char *arithmetic_error_text(int error);
     /**
      * @brief Обрабатывает JSON-запрос.
      *
      * Разбирает JSON-запрос, проверяет наличие нужных полей, выполняет требуемое действие
-     * и возвращает результат в формате JSON.
+     * и возвращает результат в формате JSON. Поле "type" выбирает тип операндов: "int64"
+     * (по умолчанию) или "int128" - аргументы числами или десятичными строками, результат
+     * десятичной строкой.
      *
      * @param request_json JSON-строка с запросом.
      *
-     * @return JSON с вычисленным результатом или пустой JSON-объект для других сообщений.
+     * @return JSON с вычисленным результатом, arithmetic_error при переполнении или делении на ноль,
+     *         ответ open_shm для запроса {"shm": имя} или пустой JSON-объект для других сообщений.
      *
      * @throw std::runtime_error Если входной JSON некорректен или запрошено неподдерживаемое действие.
      */
-    nlohmann::json process_request(std::string const &request_json);
+    nlohmann::json process_request(std::string const &request_json) {
+        OP op = OP::OP_UNSPEC;
+        return process_request(request_json, op);
+    }
+    /**
+     * @brief Обрабатывает JSON-запрос и сообщает его операцию.
+     *
+     * @param op Операция запроса или OP_UNSPEC (запросы {"shm": имя} и другие сообщения).
+     */
+    nlohmann::json process_request(std::string const &request_json, OP &op);
+    /**
+     * @brief Отправляет ответ на JSON-запрос из кэша.
+     *
+     * @return true если ответ найден и отправлен.
+     *
+     * @throw std::runtime_error Если не удалось отправить ответ.
+     */
+    bool reply_from_cache(std::string_view request_json, uint32_t seq);
+    /**
+     * @brief Запоминает ответ на JSON-запрос в кэше, если кэш подключен.
+     */
+    void cache_reply(std::string_view request_json, std::string_view reply, OP op, bool error);
+    /**
+     * @brief Открывает канал в общей памяти, созданный клиентом, и запускает его обслуживание.
+     *
+     * Вызывается для JSON-запроса {"shm": имя}. Сессии клиентов, закрывших свои каналы, удаляются.
+     *
+     * @return JSON {"result": 0}.
+     *
+     * @throw std::runtime_error Если канал не удалось открыть или открыто M_MAX_SHM_SESSIONS сессий
+     *                           (клиент продолжит работать через Netlink).
+     */
+    nlohmann::json open_shm(std::string const &name);
+
+    /**
+     * @brief Собираемый потоковый запрос.
+     */
+    struct Stream {
+        std::string data;        // 32 полученные фрагменты
+        uint64_t last_used = 0;  // 8 для вытеснения давно не обновлявшихся потоков
+        uint32_t next_chunk = 0; // 4 номер ожидаемого фрагмента
+        int error = 0;           // 4 ошибка потока (фрагменты до ATTR_EOS отклоняются)
+    };
+
+    /**
+     * @brief Политика проверки атрибутов (типы повторяют calc_policy модуля ядра, длину строк проверяет модуль).
+     */
+    static constexpr std::array<nla_policy, static_cast<int>(ATTR::ATTR_MAX) + 1> M_POLICY = [] {
+        std::array<nla_policy, static_cast<int>(ATTR::ATTR_MAX) + 1> policy{};
+        policy[static_cast<int>(ATTR::ATTR_MSG)] = {NLA_STRING, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_BATCH)] = {NLA_NESTED, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_OP)] = {NLA_U8, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARG1)] = {NLA_S64, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARG2)] = {NLA_S64, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_RESULT)] = {NLA_S64, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ERRNO)] = {NLA_S32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARRAY1)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_ARRAY2)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_RESULTS)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_OFFSET)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_STREAM)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_CHUNK)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_EOS)] = {NLA_FLAG, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_DATA)] = {NLA_UNSPEC, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_CREDITS)] = {NLA_U32, 0, 0};
+        policy[static_cast<int>(ATTR::ATTR_TOPIC)] = {NLA_U32, 0, 0};
+        return policy;
+    }();
 
-    struct nl_sock *m_sock = nullptr;                                 // 8
-    static constexpr const char *const M_FAMILY_NAME = "calc_family"; // 8
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> m_reply{nullptr, nlmsg_free}; // 16
+    static constexpr std::size_t M_RX_BATCH = 16;                     // 8 датаграмм за один вызов приема
+    std::vector<char> m_rx_buffer;                                    // 24 M_RX_BATCH буферов по M_RX_BUFFER_SIZE
+    std::array<transport::Datagram, M_RX_BATCH> m_rx_datagrams;       // 384
+    std::vector<int64_t> m_array_args;                                // 24 аргументы запроса над массивами (выровненная копия)
+    std::vector<int64_t> m_array_results;                             // 24
+    std::unique_ptr<transport::Transport> m_transport;                // 8
+    std::shared_ptr<ResultCache> m_cache;                             // 16 общий для рабочих потоков, может отсутствовать
+    Stats m_stats;                                                    // 30976
+    common::EventLoop *m_loop = nullptr;                              // 8
+    std::vector<std::unique_ptr<ShmSession>> m_shm_sessions;          // 24
+    std::unordered_map<uint32_t, Stream> m_streams;                   // 56 собираемые потоковые запросы
+    uint64_t m_stream_clock = 0;                                      // 8
+    std::size_t m_stream_bytes = 0;                                   // 8 сумма размеров Stream::data всех собираемых потоков
+    static constexpr std::size_t M_REPLY_SIZE = 32768;                // 8 вмещает часть из M_ARRAY_PART элементов или M_STREAM_PART байт
+    static constexpr std::size_t M_ARRAY_PART = 1024;                 // 8 элементов в части ответа над массивами
+    static constexpr std::size_t M_JSON_ARRAY_PART = 32;              // 8
+    static constexpr std::size_t M_JSON_ARRAY_REPLY_SIZE = 64 + M_JSON_ARRAY_PART * 21; // 8 число int64 - до 20 знаков и запятая
+    static constexpr std::size_t M_SCALAR_REPLY_SIZE = ResultCache::M_VALUE_SIZE; // 8 ответ на одиночную операцию
+    static constexpr std::size_t M_STREAM_PART = 16384;               // 8 байт в части потокового ответа (DATA_MAX_LEN модуля)
+    static constexpr std::size_t M_STREAM_MAX_SIZE = 16 << 20;        // 8 предел размера потокового запроса
+    static constexpr std::size_t M_STREAM_BUDGET = 32 << 20;          // 8 предел памяти всех собираемых потоков рабочего потока
+    static constexpr std::size_t M_MAX_STREAMS = 64;                  // 8 одновременно собираемых потоков
+    static constexpr std::size_t M_MAX_SHM_SESSIONS = 16;             // 8 каналов общей памяти (потоков обслуживания) на рабочий поток
+    static constexpr std::size_t M_RX_BUFFER_SIZE = 65536;            // 8
     void *data = nullptr;                                             // 8
-    int m_family_id = 0;                                              // 4
     static constexpr int M_COMMAND_SERVER = 2;                        // 4
+    static constexpr int M_COMMAND_REGISTER = 3;                      // 4
+    static constexpr int M_COMMAND_UNREGISTER = 4;                    // 4
 };
 
 } // namespace netlink::server
\ No newline at end of file
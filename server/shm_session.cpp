@@ -0,0 +1,54 @@
+#include "shm_session.hpp"
+
+#include <cerrno>
+#include <chrono>
+
+#include "../common/logger.hpp"
+#include "server.hpp"
+
+netlink::server::ShmSession::ShmSession(std::unique_ptr<transport::ShmChannel> channel)
+    : m_channel(std::move(channel)), m_thread([this]() { run(); }) {}
+
+netlink::server::ShmSession::~ShmSession() {
+    // Поток проверяет флаг не реже одного таймаута ожидания канала
+    m_stop.store(true, std::memory_order_relaxed);
+    m_thread.join();
+}
+
+void netlink::server::ShmSession::run() {
+    NETLINK_LOG(LOG_INFO, "Serving shared memory channel %s", m_channel->name().c_str());
+    while (!m_stop.load(std::memory_order_relaxed)) {
+        std::size_t const count = m_channel->pop_requests(m_requests.data(), m_requests.size());
+        if (count == 0) {
+            if (m_channel->peer_closed()) {
+                break;
+            }
+            m_channel->wait(std::chrono::milliseconds(100));
+            continue;
+        }
+
+        for (std::size_t i = 0; i < count; ++i) {
+            m_replies[i] = execute(m_requests[i]);
+        }
+        // Клиент держит в полете не больше операций, чем вмещает очередь, поэтому ответы помещаются сразу
+        std::size_t pushed = m_channel->push_replies(m_replies.data(), count);
+        while (pushed < count && !m_channel->peer_closed() && !m_stop.load(std::memory_order_relaxed)) {
+            std::this_thread::yield();
+            pushed += m_channel->push_replies(m_replies.data() + pushed, count - pushed);
+        }
+        // Единственный писатель: без read-modify-write, как в Stats
+        m_operations.store(m_operations.load(std::memory_order_relaxed) + count, std::memory_order_relaxed);
+    }
+    NETLINK_LOG(LOG_INFO, "Shared memory channel %s closed after %lu operations", m_channel->name().c_str(),
+                static_cast<unsigned long>(operations()));
+    m_finished.store(true, std::memory_order_release);
+}
+
+netlink::transport::ShmReply netlink::server::ShmSession::execute(transport::ShmRequest const &request) {
+    transport::ShmReply reply;
+    reply.id = request.id;
+    BinaryResult const result = Server::calculate(static_cast<OP>(request.op), request.arg1, request.arg2);
+    reply.error = result.error;
+    reply.result = result.value;
+    return reply;
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+
+#include "../transport/shm_channel.hpp"
+
+namespace netlink::server {
+
+/**
+ * @brief Обслуживание канала в общей памяти, открытого клиентом.
+ *
+ * Отдельный поток забирает запросы из очереди канала порциями, выполняет операции
+ * и кладет ответы в том же порядке. Пока запросы идут, поток их опрашивает, без запросов
+ * засыпает на futex канала. Поток завершается, когда клиент закрывает канал.
+ */
+class ShmSession final {
+   public:
+    /**
+     * @brief Запускает поток обслуживания канала.
+     */
+    explicit ShmSession(std::unique_ptr<transport::ShmChannel> channel);
+    ShmSession(ShmSession const &) = delete;
+    ShmSession(ShmSession &&) = delete;
+    ShmSession &operator=(ShmSession const &) = delete;
+    ShmSession &operator=(ShmSession &&) = delete;
+    /**
+     * @brief Останавливает поток и закрывает канал (клиент получит ECONNRESET для операций без ответа).
+     */
+    ~ShmSession();
+
+    /**
+     * @brief Завершился ли поток (клиент закрыл канал).
+     */
+    bool finished() const { return m_finished.load(std::memory_order_acquire); }
+    /**
+     * @brief Количество выполненных операций. Читать можно из любого потока.
+     */
+    uint64_t operations() const { return m_operations.load(std::memory_order_relaxed); }
+
+   private:
+    void run();
+    /**
+     * @brief Выполняет одну операцию; ошибки - как у Server::calculate (EINVAL, ERANGE, EDOM).
+     */
+    static transport::ShmReply execute(transport::ShmRequest const &request);
+
+    static constexpr std::size_t M_BATCH = 64;                // 8 записей за одно извлечение
+    std::array<transport::ShmRequest, M_BATCH> m_requests{};  // 1536
+    std::array<transport::ShmReply, M_BATCH> m_replies{};     // 1024
+    std::unique_ptr<transport::ShmChannel> m_channel;         // 8
+    std::atomic<uint64_t> m_operations{0};                    // 8
+    std::atomic<bool> m_stop{false};                          // 1
+    std::atomic<bool> m_finished{false};                      // 1
+    std::thread m_thread;                                     // 8 запускается последним
+};
+
+} // namespace netlink::server
@@ -0,0 +1,44 @@
+#include "stats.hpp"
+
+namespace {
+
+nlohmann::json histogram_json(netlink::common::Histogram const &histogram) {
+    return {
+        {"count", histogram.count()},         {"mean", histogram.mean()},           {"p50", histogram.percentile(50)},
+        {"p99", histogram.percentile(99)},    {"p999", histogram.percentile(99.9)}, {"max", histogram.max()},
+    };
+}
+
+} // namespace
+
+nlohmann::json netlink::server::Stats::to_json(std::vector<Stats const *> const &workers) {
+    std::array<uint64_t, static_cast<std::size_t>(Counter::COUNT)> totals{};
+    common::Histogram processing_time;
+    common::Histogram queue_depth;
+    nlohmann::json per_worker = nlohmann::json::array();
+
+    for (Stats const *stats : workers) {
+        nlohmann::json counters = nlohmann::json::object();
+        for (std::size_t i = 0; i < totals.size(); ++i) {
+            uint64_t const value = stats->m_counters[i].load(std::memory_order_relaxed);
+            totals[i] += value;
+            counters[M_COUNTER_NAMES[i]] = value;
+        }
+        per_worker.push_back(std::move(counters));
+        processing_time.merge(stats->m_processing_time);
+        queue_depth.merge(stats->m_queue_depth);
+    }
+
+    nlohmann::json counters = nlohmann::json::object();
+    for (std::size_t i = 0; i < totals.size(); ++i) {
+        counters[M_COUNTER_NAMES[i]] = totals[i];
+    }
+
+    return {
+        {"workers", workers.size()},
+        {"counters", std::move(counters)},
+        {"processing_time_ns", histogram_json(processing_time)},
+        {"queue_depth", histogram_json(queue_depth)},
+        {"per_worker", std::move(per_worker)},
+    };
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+#include <vector>
+
+#include "../common/histogram.hpp"
+
+namespace netlink::server {
+
+/**
+ * @brief Счетчики сервера.
+ */
+enum class Counter : std::size_t {
+    REQUESTS_ADD,      /**< Операции add. */
+    REQUESTS_SUB,      /**< Операции sub. */
+    REQUESTS_MUL,      /**< Операции mul. */
+    REQUESTS_DIV,      /**< Операции div. */
+    REQUESTS_MOD,      /**< Операции mod. */
+    REQUESTS_INVALID,  /**< Операции с неизвестным действием. */
+    REQUESTS_JSON,     /**< Сообщения с JSON-запросом (ATTR_MSG). */
+    REQUESTS_BINARY,   /**< Сообщения бинарного протокола (ATTR_OP). */
+    REQUESTS_BATCH,    /**< Сообщения с пакетом операций (ATTR_BATCH). */
+    REQUESTS_ARRAY,    /**< Запросы над массивами (бинарные ATTR_ARRAY1/ATTR_ARRAY2 и JSON). */
+    ARRAY_ELEMENTS,    /**< Элементы, вычисленные в запросах над массивами. */
+    REQUESTS_STREAM,   /**< Запросы, переданные потоком фрагментов (ATTR_STREAM) и собранные полностью. */
+    STREAM_CHUNKS,     /**< Принятые фрагменты потоковых запросов. */
+    ARITHMETIC_ERRORS, /**< Операции, завершившиеся переполнением или делением на ноль. */
+    PARSE_ERRORS,      /**< Сообщения и JSON-запросы, которые не удалось разобрать. */
+    SEND_FAILURES,     /**< Ответы, которые не удалось отправить. */
+    RECEIVE_OVERFLOWS, /**< Переполнения буфера приема (ENOBUFS), запросы потеряны. */
+    TRUNCATED,         /**< Датаграммы, не поместившиеся в буфер приема. */
+    RECEIVE_CALLS,     /**< Вызовы приема (за один вызов принимается несколько датаграмм). */
+    DATAGRAMS_IN,      /**< Принятые датаграммы. */
+    MESSAGES_IN,       /**< Принятые сообщения Netlink. */
+    MESSAGES_OUT,      /**< Отправленные сообщения Netlink. */
+    BYTES_IN,          /**< Принятые байты. */
+    BYTES_OUT,         /**< Отправленные байты. */
+    SHM_CHANNELS,      /**< Открытые каналы в общей памяти (операции по ним выполняют потоки ShmSession). */
+    CACHE_HITS,        /**< JSON-запросы, ответ на которые взят из кэша (без разбора). */
+    CACHE_MISSES,      /**< JSON-запросы, не найденные в кэше. */
+    CACHE_EVICTIONS,   /**< Ответы, вытесненные из кэша этим рабочим потоком. */
+    COUNT,
+};
+
+/**
+ * @brief Статистика одного рабочего потока сервера.
+ *
+ * Пишет в статистику только поток своего сервера: счетчики увеличиваются relaxed-записью
+ * без read-modify-write и без блокировок, поэтому учет не замедляет обработку запросов.
+ * Читать статистику (снимок для экспорта) можно из любого потока.
+ */
+class Stats final {
+   public:
+    Stats() = default;
+    Stats(Stats const &) = delete;
+    Stats &operator=(Stats const &) = delete;
+
+    /**
+     * @brief Увеличивает счетчик.
+     */
+    void add(Counter counter, uint64_t value = 1) {
+        auto &slot = m_counters[static_cast<std::size_t>(counter)];
+        slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+    }
+    /**
+     * @brief Текущее значение счетчика.
+     */
+    uint64_t get(Counter counter) const { return m_counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed); }
+    /**
+     * @brief Время обработки одного сообщения (разбор, вычисление, отправка ответа) в наносекундах.
+     */
+    common::Histogram &processing_time() { return m_processing_time; }
+    common::Histogram const &processing_time() const { return m_processing_time; }
+    /**
+     * @brief Количество сообщений, принятых за один вызов приема (глубина очереди, разобранной за один прием).
+     */
+    common::Histogram &queue_depth() { return m_queue_depth; }
+    common::Histogram const &queue_depth() const { return m_queue_depth; }
+
+    /**
+     * @brief Сводная статистика нескольких рабочих потоков в компактном JSON.
+     *
+     * Счетчики и гистограммы суммируются, для гистограмм выводятся количество, среднее,
+     * p50/p99/p999 и максимум. Дополнительно выводятся счетчики каждого потока.
+     */
+    static nlohmann::json to_json(std::vector<Stats const *> const &workers);
+
+   private:
+    /**
+     * @brief Имена счетчиков в JSON, в порядке Counter.
+     */
+    static constexpr std::array<const char *, static_cast<std::size_t>(Counter::COUNT)> M_COUNTER_NAMES = {
+        "requests_add", "requests_sub", "requests_mul", "requests_div", "requests_mod", "requests_invalid",
+        "requests_json", "requests_binary", "requests_batch", "requests_array", "array_elements", "requests_stream",
+        "stream_chunks", "arithmetic_errors", "parse_errors", "send_failures", "receive_overflows", "truncated",
+        "receive_calls", "datagrams_in", "messages_in", "messages_out", "bytes_in", "bytes_out",
+        "shm_channels", "cache_hits", "cache_misses", "cache_evictions",
+    };
+
+    std::array<std::atomic<uint64_t>, static_cast<std::size_t>(Counter::COUNT)> m_counters{}; // 224
+    common::Histogram m_processing_time;                                                      // 15392
+    common::Histogram m_queue_depth;                                                          // 15392
+};
+
+} // namespace netlink::server
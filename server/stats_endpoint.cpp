@@ -0,0 +1,76 @@
+#include "stats_endpoint.hpp"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "../common/logger.hpp"
+
+netlink::server::StatsEndpoint::StatsEndpoint(std::string path, Snapshot snapshot) : m_path(std::move(path)), m_snapshot(std::move(snapshot)) {
+    struct sockaddr_un addr {};
+    addr.sun_family = AF_UNIX;
+    if (m_path.empty() || m_path.size() >= sizeof(addr.sun_path)) {
+        NETLINK_LOG(LOG_ERR, "Invalid stats socket path: %s", m_path.c_str());
+        throw std::runtime_error("Invalid stats socket path");
+    }
+    std::memcpy(addr.sun_path, m_path.c_str(), m_path.size() + 1);
+
+    m_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (m_fd < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to create the stats socket: %s", strerror(errno));
+        throw std::runtime_error("Failed to create the stats socket");
+    }
+
+    // Файл мог остаться после предыдущего запуска
+    unlink(m_path.c_str());
+    if (bind(m_fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) < 0 || listen(m_fd, 16) < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to listen on the stats socket %s: %s", m_path.c_str(), strerror(errno));
+        close(m_fd);
+        throw std::runtime_error("Failed to listen on the stats socket");
+    }
+
+    m_thread = std::thread([this]() { serve(); });
+    NETLINK_LOG(LOG_INFO, "Stats are available on %s", m_path.c_str());
+}
+
+netlink::server::StatsEndpoint::~StatsEndpoint() {
+    // shutdown будит поток, заблокированный в accept
+    shutdown(m_fd, SHUT_RDWR);
+    m_thread.join();
+    close(m_fd);
+    unlink(m_path.c_str());
+}
+
+void netlink::server::StatsEndpoint::serve() {
+    while (true) {
+        int client = accept4(m_fd, nullptr, nullptr, SOCK_CLOEXEC);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            break;
+        }
+
+        std::string payload;
+        try {
+            payload = m_snapshot().dump() + "\n";
+        } catch (std::exception &ex) {
+            NETLINK_LOG(LOG_ERR, "Failed to build the stats snapshot: %s", ex.what());
+        }
+        for (std::size_t sent = 0; sent < payload.size();) {
+            ssize_t ret = send(client, payload.data() + sent, payload.size() - sent, MSG_NOSIGNAL);
+            if (ret < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                break;
+            }
+            sent += static_cast<std::size_t>(ret);
+        }
+        close(client);
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <functional>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <thread>
+
+namespace netlink::server {
+
+/**
+ * @brief Локальный Unix-сокет для выгрузки статистики.
+ *
+ * Каждому подключившемуся клиенту отправляется одна строка компактного JSON со снимком
+ * статистики, после чего соединение закрывается (например, `socat - UNIX-CONNECT:<path>`).
+ * Обслуживается отдельным потоком и не затрагивает рабочие потоки сервера.
+ */
+class StatsEndpoint final {
+   public:
+    using Snapshot = std::function<nlohmann::json()>;
+
+    /**
+     * @brief Создает сокет и запускает поток обслуживания.
+     *
+     * @param path Путь к Unix-сокету (существующий файл сокета заменяется).
+     * @param snapshot Функция, возвращающая текущий снимок статистики.
+     *
+     * @throw std::runtime_error Если не удалось создать или привязать сокет.
+     */
+    StatsEndpoint(std::string path, Snapshot snapshot);
+    StatsEndpoint(StatsEndpoint const &) = delete;
+    StatsEndpoint(StatsEndpoint &&) = delete;
+    StatsEndpoint &operator=(StatsEndpoint const &) = delete;
+    StatsEndpoint &operator=(StatsEndpoint &&) = delete;
+    /**
+     * @brief Останавливает поток обслуживания и удаляет файл сокета.
+     */
+    ~StatsEndpoint();
+
+   private:
+    /**
+     * @brief Цикл приема подключений.
+     */
+    void serve();
+
+    std::string m_path;   // 32
+    Snapshot m_snapshot;  // 32
+    std::thread m_thread; // 8
+    int m_fd = -1;        // 4
+};
+
+} // namespace netlink::server
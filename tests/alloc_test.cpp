@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+
+#include "test_server.hpp"
+
+/*
+ * Подсчет выделений памяти: malloc/calloc/realloc подменяются в исполняемом файле тестов
+ * и передаются в реализацию glibc. Считаются и выделения libnl (C), и operator new.
+ */
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+}
+
+namespace {
+// Считаются только выделения потока, выполняющего запрос: фоновые потоки (журнал) не в счет
+thread_local bool g_count_allocations = false;
+std::atomic<std::size_t> g_allocations{0};
+
+void count_allocation() {
+    if (g_count_allocations) {
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/* Считает выделения памяти, сделанные функцией в вызывающем потоке. */
+template <typename F>
+std::size_t count_allocations(F &&f) {
+    g_allocations = 0;
+    g_count_allocations = true;
+    f();
+    g_count_allocations = false;
+    return g_allocations;
+}
+} // namespace
+
+extern "C" {
+void *malloc(size_t size) {
+    count_allocation();
+    return __libc_malloc(size);
+}
+void *calloc(size_t count, size_t size) {
+    count_allocation();
+    return __libc_calloc(count, size);
+}
+void *realloc(void *ptr, size_t size) {
+    count_allocation();
+    return __libc_realloc(ptr, size);
+}
+}
+
+namespace tests {
+class ServerAllocation_Friend {
+   public:
+    static void receive(netlink::server::Server &server, struct nlmsghdr *nlh) { server.receive_message(nlh); }
+};
+} // namespace tests
+
+// Тест: После прогрева обработка JSON-запроса (прием, вычисление, ответ) не выделяет память
+TEST(AllocationTests, JsonRequestIsAllocationFree) {
+    tests::TestServer server;
+
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(msg.get(), NL_AUTO_PORT, 1, 0x20, 0, 0, 2, 1);
+    nla_put_string(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), R"({"action": "add", "arg1": 3, "arg2": 5})");
+
+    for (int i = 0; i < 16; ++i) {
+        tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(msg.get()));
+    }
+    auto allocations = count_allocations([&] {
+        for (int i = 0; i < 1000; ++i) {
+            tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(msg.get()));
+        }
+    });
+    EXPECT_EQ(allocations, 0u);
+}
+
+// Тест: После прогрева обработка бинарного запроса не выделяет память
+TEST(AllocationTests, BinaryRequestIsAllocationFree) {
+    tests::TestServer server;
+
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(msg.get(), NL_AUTO_PORT, 1, 0x20, 0, 0, 2, 2);
+    nla_put_u8(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_OP), static_cast<uint8_t>(netlink::server::OP::OP_MUL));
+    nla_put_s64(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_ARG1), 6);
+    nla_put_s64(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_ARG2), 7);
+
+    for (int i = 0; i < 16; ++i) {
+        tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(msg.get()));
+    }
+    auto allocations = count_allocations([&] {
+        for (int i = 0; i < 1000; ++i) {
+            tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(msg.get()));
+        }
+    });
+    EXPECT_EQ(allocations, 0u);
+}
+
+// Тест: Ответы с ошибкой вычисления и ответы из кэша тоже формируются без выделения памяти
+TEST(AllocationTests, ErrorAndCachedRepliesAreAllocationFree) {
+    tests::TestServer server;
+    static_cast<netlink::server::Server &>(server).set_result_cache(std::make_shared<netlink::server::ResultCache>(64));
+
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> division(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(division.get(), NL_AUTO_PORT, 1, 0x20, 0, 0, 2, 1);
+    nla_put_string(division.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), R"({"action": "div", "arg1": 3, "arg2": 0})");
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> wide(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(wide.get(), NL_AUTO_PORT, 2, 0x20, 0, 0, 2, 1);
+    nla_put_string(wide.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), R"({"action": "add", "type": "int128", "arg1": 3, "arg2": 5})");
+
+    // Первый запрос int128 проходит полный разбор и попадает в кэш
+    for (int i = 0; i < 16; ++i) {
+        tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(division.get()));
+        tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(wide.get()));
+    }
+    auto allocations = count_allocations([&] {
+        for (int i = 0; i < 1000; ++i) {
+            tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(division.get()));
+            tests::ServerAllocation_Friend::receive(server, nlmsg_hdr(wide.get()));
+        }
+    });
+    EXPECT_EQ(allocations, 0u);
+}
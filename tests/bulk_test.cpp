@@ -0,0 +1,182 @@
+#include <gtest/gtest.h>
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../server/bulk_engine.hpp"
+#include "test_server.hpp"
+
+namespace {
+
+using netlink::server::BulkEngine;
+
+/**
+ * @brief Сервер в отдельном потоке и клиент поверх внутрипроцессного транспорта заданной версии.
+ */
+class BulkTest : public ::testing::Test {
+   protected:
+    void start(uint8_t version) {
+        m_peer = std::make_unique<tests::ServerThread>(version);
+        m_client = &m_peer->connect(16);
+    }
+
+    /**
+     * @brief Выполняет операцию над массивами и ждет результат.
+     */
+    std::vector<int64_t> calc(netlink::client::OP op, std::vector<int64_t> const &arg1, std::vector<int64_t> const &arg2, int &error) {
+        std::vector<int64_t> results;
+        int calls = 0;
+        m_client->calc_array_async(op, arg1, arg2, [&](int code, std::vector<int64_t> const &values) {
+            error = code;
+            results = values;
+            ++calls;
+        });
+        m_client->wait_for_response();
+        EXPECT_EQ(calls, 1);
+        EXPECT_EQ(m_client->in_flight(), 0u);
+        return results;
+    }
+
+    std::unique_ptr<tests::ServerThread> m_peer;
+    netlink::client::Client *m_client = nullptr;
+};
+
+std::vector<int64_t> random_values(std::size_t count, std::mt19937_64 &random) {
+    std::vector<int64_t> values(count);
+    for (auto &value : values) {
+        value = static_cast<int64_t>(random());
+    }
+    // Граничные значения для проверки переполнения
+    if (count >= 4) {
+        values[0] = std::numeric_limits<int64_t>::max();
+        values[1] = std::numeric_limits<int64_t>::min();
+        values[2] = -1;
+        values[3] = 0;
+    }
+    return values;
+}
+
+/**
+ * @brief Ожидаемый результат: арифметика по модулю 2^64.
+ */
+int64_t reference(netlink::server::OP op, int64_t arg1, int64_t arg2) {
+    auto const a = static_cast<uint64_t>(arg1);
+    auto const b = static_cast<uint64_t>(arg2);
+    switch (op) {
+        case netlink::server::OP::OP_ADD:
+            return static_cast<int64_t>(a + b);
+        case netlink::server::OP::OP_SUB:
+            return static_cast<int64_t>(a - b);
+        default:
+            return static_cast<int64_t>(a * b);
+    }
+}
+
+} // namespace
+
+// Тест: Каждая поддерживаемая реализация совпадает со скалярной, включая переполнение и хвосты массивов
+TEST(BulkEngineTests, ImplementationsMatchScalar) {
+    std::mt19937_64 random(42);
+    for (std::size_t count : {0u, 1u, 3u, 4u, 7u, 64u, 1001u}) {
+        std::vector<int64_t> const arg1 = random_values(count, random);
+        std::vector<int64_t> const arg2 = random_values(count, random);
+        for (auto op : {netlink::server::OP::OP_ADD, netlink::server::OP::OP_SUB, netlink::server::OP::OP_MUL}) {
+            std::vector<int64_t> expected(count);
+            BulkEngine::compute(BulkEngine::Isa::SCALAR, op, arg1.data(), arg2.data(), expected.data(), count);
+            for (std::size_t i = 0; i < count; ++i) {
+                EXPECT_EQ(expected[i], reference(op, arg1[i], arg2[i]));
+            }
+            for (auto isa : BulkEngine::supported()) {
+                std::vector<int64_t> result(count);
+                BulkEngine::compute(isa, op, arg1.data(), arg2.data(), result.data(), count);
+                EXPECT_EQ(result, expected) << BulkEngine::name(isa) << " count " << count;
+            }
+        }
+    }
+    EXPECT_NE(BulkEngine::name(BulkEngine::isa()), nullptr);
+}
+
+// Тест: Результат может записываться на место аргумента
+TEST(BulkEngineTests, InPlace) {
+    std::vector<int64_t> arg1 = {1, 2, 3, 4, 5};
+    std::vector<int64_t> const arg2 = {10, 20, 30, 40, 50};
+    BulkEngine::compute(netlink::server::OP::OP_ADD, arg1.data(), arg2.data(), arg1.data(), arg1.size());
+    EXPECT_EQ(arg1, (std::vector<int64_t>{11, 22, 33, 44, 55}));
+}
+
+// Тест: Большой массив делится на запросы, ответы приходят частями и собираются по смещениям
+TEST_F(BulkTest, BinaryArrays) {
+    start(netlink::client::Client::ARRAY_PROTOCOL_VERSION);
+    std::mt19937_64 random(7);
+    std::vector<int64_t> const arg1 = random_values(100000, random);
+    std::vector<int64_t> const arg2 = random_values(100000, random);
+
+    int error = -1;
+    std::vector<int64_t> const results = calc(netlink::client::OP::OP_SUB, arg1, arg2, error);
+    EXPECT_EQ(error, 0);
+    ASSERT_EQ(results.size(), arg1.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        ASSERT_EQ(results[i], reference(netlink::server::OP::OP_SUB, arg1[i], arg2[i])) << i;
+    }
+
+    auto const &stats = m_peer->server().stats();
+    EXPECT_EQ(stats.get(netlink::server::Counter::ARRAY_ELEMENTS), 100000u);
+    // 100000 элементов по 2048 в запросе
+    EXPECT_EQ(stats.get(netlink::server::Counter::MESSAGES_IN), 49u);
+    EXPECT_GT(stats.get(netlink::server::Counter::MESSAGES_OUT), 49u);
+
+    // Пустые массивы завершаются без запросов
+    EXPECT_TRUE(calc(netlink::client::OP::OP_ADD, {}, {}, error).empty());
+    EXPECT_EQ(error, 0);
+}
+
+// Тест: Семейство без поддержки массивов - запросы JSON с массивами в arg1 и arg2
+TEST_F(BulkTest, JsonFallback) {
+    start(netlink::client::Client::BINARY_PROTOCOL_VERSION);
+    std::vector<int64_t> arg1(100), arg2(100);
+    for (std::size_t i = 0; i < arg1.size(); ++i) {
+        arg1[i] = static_cast<int64_t>(i);
+        arg2[i] = static_cast<int64_t>(i) - 50;
+    }
+
+    int error = -1;
+    std::vector<int64_t> const results = calc(netlink::client::OP::OP_MUL, arg1, arg2, error);
+    EXPECT_EQ(error, 0);
+    ASSERT_EQ(results.size(), arg1.size());
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        EXPECT_EQ(results[i], arg1[i] * arg2[i]);
+    }
+    EXPECT_EQ(m_peer->server().stats().get(netlink::server::Counter::ARRAY_ELEMENTS), 100u);
+}
+
+// Тест: JSON-запрос над массивами разной длины и с нечисловыми элементами отклоняется сервером
+TEST_F(BulkTest, JsonErrors) {
+    start(netlink::client::Client::ARRAY_PROTOCOL_VERSION);
+    std::vector<std::string> payloads;
+    auto collect = [&payloads](netlink::client::Response const &response) { payloads.push_back(response.payload); };
+    m_client->send_request_async({{"action", "add"}, {"arg1", {1, 2}}, {"arg2", {1}}}, collect);
+    m_client->send_request_async({{"action", "add"}, {"arg1", {1, "x"}}, {"arg2", {1, 2}}}, collect);
+    m_client->send_request_async({{"action", "add"}, {"arg1", {1, 2}}, {"arg2", {3, 4}}}, collect);
+    m_client->wait_for_response();
+
+    ASSERT_EQ(payloads.size(), 3u);
+    EXPECT_EQ(payloads[0], "Invalid input. Arrays 'arg1' and 'arg2' must have the same length");
+    // Текст ошибки разбора JSON, как и для скалярных аргументов неверного типа
+    EXPECT_EQ(payloads[1].find("result"), std::string::npos);
+    EXPECT_EQ(payloads[2], R"({"offset":0,"result":[4,6]})");
+}
+
+// Тест: Клиент отклоняет массивы разной длины и неизвестную операцию до отправки
+TEST_F(BulkTest, ClientRejectsInvalidInput) {
+    start(netlink::client::Client::ARRAY_PROTOCOL_VERSION);
+    std::vector<int64_t> const arg1 = {1, 2, 3};
+    std::vector<int64_t> const arg2 = {1, 2};
+    auto ignore = [](int, std::vector<int64_t> const &) {};
+    EXPECT_THROW(m_client->calc_array_async(netlink::client::OP::OP_ADD, arg1, arg2, ignore), std::runtime_error);
+    EXPECT_THROW(m_client->calc_array_async(netlink::client::OP::OP_MAX, arg1, arg1, ignore), std::runtime_error);
+    EXPECT_EQ(m_client->in_flight(), 0u);
+}
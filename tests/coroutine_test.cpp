@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <stdexcept>
+
+#include "../client/coroutine.hpp"
+#include "test_server.hpp"
+
+namespace {
+
+using netlink::client::Response;
+using netlink::client::Scheduler;
+using netlink::client::Task;
+
+/**
+ * @brief Сервер в отдельном потоке и клиент поверх внутрипроцессного транспорта.
+ */
+class CoroutineTest : public ::testing::Test {
+   protected:
+    tests::ServerThread m_peer;
+    netlink::client::Client &m_client = m_peer.connect(64);
+};
+
+/**
+ * @brief Вычисляет (a + b) * 2 - b двумя последовательными запросами и одной вложенной задачей.
+ */
+Task<int64_t> compute(Scheduler &scheduler, int64_t a, int64_t b) {
+    Response sum = co_await scheduler.add(a, b);
+    if (sum.error != 0) {
+        throw std::runtime_error("add failed");
+    }
+    Response doubled = co_await scheduler.mul(sum.result, 2);
+    Response result = co_await scheduler.sub(doubled.result, b);
+    co_return result.result;
+}
+
+Task<void> check(Scheduler &scheduler, int64_t a, int64_t b, int &completed) {
+    int64_t result = co_await compute(scheduler, a, b);
+    EXPECT_EQ(result, (a + b) * 2 - b);
+    ++completed;
+}
+
+Task<void> fail(Scheduler &scheduler) {
+    co_await scheduler.add(1, 1);
+    throw std::logic_error("task failed");
+}
+
+} // namespace
+
+// Тест: Корутины получают ответы на свои запросы, запросы одной итерации уходят одной датаграммой
+TEST_F(CoroutineTest, AwaitsReplies) {
+    int completed = 0;
+    {
+        Scheduler scheduler(m_client);
+        for (int i = 0; i < 200; ++i) {
+            scheduler.spawn(check(scheduler, i, 1000 - i, completed));
+        }
+        EXPECT_EQ(scheduler.active(), 200u);
+        scheduler.run();
+        EXPECT_EQ(scheduler.active(), 0u);
+    }
+    EXPECT_EQ(completed, 200);
+    EXPECT_EQ(m_client.in_flight(), 0u);
+
+    auto const &stats = m_peer.server().stats();
+    EXPECT_EQ(stats.get(netlink::server::Counter::MESSAGES_IN), 600u);
+    // Окно в 64 запроса: не меньше 600 / 64 датаграмм, но намного меньше, чем сообщений
+    EXPECT_LT(stats.get(netlink::server::Counter::DATAGRAMS_IN), 100u);
+}
+
+// Тест: Исключение задачи пробрасывается из run, остальные задачи продолжают работу
+TEST_F(CoroutineTest, PropagatesExceptions) {
+    int completed = 0;
+    Scheduler scheduler(m_client);
+    scheduler.spawn(fail(scheduler));
+    scheduler.spawn(check(scheduler, 2, 3, completed));
+    EXPECT_THROW(scheduler.run(), std::logic_error);
+    scheduler.run();
+    EXPECT_EQ(completed, 1);
+}
+
+// Тест: Уничтожение планировщика с ожидающими задачами отменяет их запросы
+TEST_F(CoroutineTest, DestroyCancelsPending) {
+    int completed = 0;
+    {
+        Scheduler scheduler(m_client);
+        scheduler.spawn(check(scheduler, 1, 2, completed));
+        EXPECT_EQ(scheduler.poll(), 1u);
+        EXPECT_EQ(m_client.in_flight(), 1u);
+    }
+    EXPECT_EQ(m_client.in_flight(), 0u);
+    EXPECT_EQ(completed, 0);
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "../client/client.hpp"
+#include "../common/event_loop.hpp"
+#include "../server/server.hpp"
+#include "../transport/socketpair_transport.hpp"
+
+using namespace std::chrono_literals;
+
+namespace {
+
+/**
+ * @brief Крутит цикл событий, пока условие не выполнится или не истечет время ожидания.
+ */
+template <typename Predicate>
+bool run_until(netlink::common::EventLoop &loop, Predicate done, std::chrono::milliseconds limit = 5s) {
+    auto const deadline = std::chrono::steady_clock::now() + limit;
+    while (!done()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        loop.run_once(10);
+    }
+    return true;
+}
+
+} // namespace
+
+// Тест: Таймеры срабатывают в порядке сроков, отмененный таймер не срабатывает
+TEST(EventLoopTests, TimersFireInOrder) {
+    netlink::common::EventLoop loop;
+    std::vector<int> fired;
+    loop.add_timer(30ms, [&]() { fired.push_back(3); });
+    loop.add_timer(1ms, [&]() { fired.push_back(1); });
+    auto cancelled = loop.add_timer(5ms, [&]() { fired.push_back(0); });
+    loop.add_timer(10ms, [&]() { fired.push_back(2); });
+    // Таймер дальше одного оборота колеса
+    loop.add_timer(600ms, [&]() { fired.push_back(4); });
+    EXPECT_TRUE(loop.cancel_timer(cancelled));
+    EXPECT_FALSE(loop.cancel_timer(cancelled));
+
+    auto const start = std::chrono::steady_clock::now();
+    ASSERT_TRUE(run_until(loop, [&]() { return fired.size() == 4; }));
+    EXPECT_GE(std::chrono::steady_clock::now() - start, 600ms);
+    EXPECT_EQ(fired, (std::vector<int>{1, 2, 3, 4}));
+}
+
+// Тест: stop из другого потока прерывает ожидание в run
+TEST(EventLoopTests, StopFromAnotherThread) {
+    netlink::common::EventLoop loop;
+    std::thread stopper([&loop]() {
+        std::this_thread::sleep_for(20ms);
+        loop.stop();
+    });
+    loop.run();
+    stopper.join();
+    EXPECT_TRUE(loop.stopped());
+}
+
+// Тест: Запрос без ответа завершается ошибкой ETIMEDOUT
+TEST(EventLoopTests, ClientRequestTimesOut) {
+    auto [client_transport, server_transport] = netlink::transport::SocketpairTransport::create_pair();
+    netlink::common::EventLoop loop;
+    netlink::client::Client client(std::move(client_transport));
+    client.attach(loop);
+    client.set_timeout(50ms);
+
+    int error = 0;
+    client.calc_async(netlink::client::OP::OP_ADD, 1, 2, [&](netlink::client::Response const &response) { error = response.error; });
+    EXPECT_EQ(client.in_flight(), 1u);
+    ASSERT_TRUE(run_until(loop, [&]() { return client.in_flight() == 0; }));
+    EXPECT_EQ(error, ETIMEDOUT);
+}
+
+// Тест: Клиент и сервер обслуживаются одним циклом событий, сервер отключается при закрытии клиента
+TEST(EventLoopTests, ServerAndClientShareLoop) {
+    auto [client_transport, server_transport] = netlink::transport::SocketpairTransport::create_pair();
+    netlink::common::EventLoop loop;
+    netlink::server::Server server(std::move(server_transport));
+    server.attach(loop);
+
+    auto client = std::make_unique<netlink::client::Client>(std::move(client_transport));
+    client->attach(loop);
+    client->set_timeout(1s);
+
+    int64_t sum = 0;
+    for (int64_t i = 1; i <= 100; ++i) {
+        client->calc_async(netlink::client::OP::OP_MUL, i, 2, [&](netlink::client::Response const &response) {
+            EXPECT_EQ(response.error, 0);
+            sum += response.result;
+        });
+    }
+    ASSERT_TRUE(run_until(loop, [&]() { return client->in_flight() == 0; }));
+    EXPECT_EQ(sum, 10100);
+
+    EXPECT_EQ(server.stats().get(netlink::server::Counter::MESSAGES_IN), 100u);
+
+    // Сервер читает закрытие и удаляет свой дескриптор из цикла, иначе событие повторялось бы
+    client.reset();
+    EXPECT_EQ(loop.run_once(100), 1u);
+    EXPECT_EQ(loop.run_once(20), 0u);
+}
+
+// Тест: Сервер в цикле событий другого потока завершается по stop
+TEST(EventLoopTests, ServerLoopStops) {
+    auto [client_transport, server_transport] = netlink::transport::SocketpairTransport::create_pair();
+    netlink::server::Server server(std::move(server_transport));
+    netlink::common::EventLoop loop;
+    server.attach(loop);
+    std::thread worker([&loop]() { loop.run(); });
+
+    netlink::client::Client client(std::move(client_transport));
+    int64_t result = 0;
+    client.calc_async(netlink::client::OP::OP_SUB, 10, 4, [&](netlink::client::Response const &response) { result = response.result; });
+    client.wait_for_response();
+    EXPECT_EQ(result, 6);
+
+    loop.stop();
+    worker.join();
+    server.detach();
+}
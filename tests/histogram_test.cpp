@@ -0,0 +1,40 @@
+#include <gtest/gtest.h>
+
+#include "../common/histogram.hpp"
+
+// Тест: Малые значения хранятся точно, перцентили считаются по рангу
+TEST(HistogramTests, ExactSmallValues) {
+    netlink::common::Histogram histogram;
+    for (uint64_t value = 1; value <= 10; ++value) {
+        histogram.record(value);
+    }
+    EXPECT_EQ(histogram.count(), 10u);
+    EXPECT_EQ(histogram.min(), 1u);
+    EXPECT_EQ(histogram.max(), 10u);
+    EXPECT_DOUBLE_EQ(histogram.mean(), 5.5);
+    EXPECT_EQ(histogram.percentile(50), 5u);
+    EXPECT_EQ(histogram.percentile(99), 10u);
+    EXPECT_EQ(histogram.percentile(0), 1u);
+}
+
+// Тест: Погрешность больших значений не превышает 1/2^SUB_BITS, объединение складывает счетчики
+TEST(HistogramTests, RelativeErrorAndMerge) {
+    netlink::common::Histogram first;
+    netlink::common::Histogram second;
+    for (uint64_t value = 1; value <= 100000; ++value) {
+        (value % 2 ? first : second).record(value * 1000);
+    }
+    first.merge(second);
+    EXPECT_EQ(first.count(), 100000u);
+
+    for (double percentile : {50.0, 99.0, 99.9}) {
+        double const exact = percentile / 100.0 * 100000.0 * 1000.0;
+        double const error = std::abs(static_cast<double>(first.percentile(percentile)) - exact) / exact;
+        EXPECT_LE(error, 1.0 / (1 << netlink::common::Histogram::SUB_BITS)) << percentile;
+    }
+    EXPECT_EQ(first.percentile(100), 100000000u);
+
+    netlink::common::Histogram extreme;
+    extreme.record(UINT64_MAX);
+    EXPECT_EQ(extreme.percentile(50), UINT64_MAX);
+}
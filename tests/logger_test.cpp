@@ -0,0 +1,131 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../common/logger.hpp"
+
+namespace {
+
+/**
+ * @brief Перехватывает вывод журнала на время теста.
+ */
+class CapturedLog {
+   public:
+    CapturedLog() : m_level(netlink::common::Logger::level()) {
+        netlink::common::Logger::instance().set_sink([this](int level, const char *message) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_messages.emplace_back(level, message);
+        });
+    }
+    ~CapturedLog() {
+        netlink::common::Logger::instance().set_sink({});
+        netlink::common::Logger::set_level(m_level);
+    }
+
+    std::vector<std::pair<int, std::string>> messages() {
+        netlink::common::Logger::instance().flush();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_messages;
+    }
+
+   private:
+    std::mutex m_mutex;
+    std::vector<std::pair<int, std::string>> m_messages;
+    int m_level;
+};
+
+int evaluated = 0;
+
+const char *count_evaluation() {
+    ++evaluated;
+    return "argument";
+}
+
+} // namespace
+
+// Тест: Сообщения нескольких потоков доходят до приемника, отключенный уровень не вычисляет аргументы
+TEST(LoggerTests, WritesAndFiltersLevels) {
+    CapturedLog log;
+    netlink::common::Logger::set_level(LOG_INFO);
+
+    evaluated = 0;
+    NETLINK_LOG(LOG_DEBUG, "debug %s", count_evaluation());
+    EXPECT_EQ(evaluated, 0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i) {
+        threads.emplace_back([i]() {
+            for (int j = 0; j < 10; ++j) {
+                NETLINK_LOG(LOG_INFO, "thread %d message %d", i, j);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    NETLINK_LOG(LOG_ERR, "error %s", count_evaluation());
+    EXPECT_EQ(evaluated, 1);
+
+    auto messages = log.messages();
+    ASSERT_EQ(messages.size(), 41u);
+    EXPECT_EQ(messages.back(), std::make_pair(LOG_ERR, std::string("error argument")));
+    for (std::size_t i = 0; i + 1 < messages.size(); ++i) {
+        EXPECT_EQ(messages[i].first, LOG_INFO);
+    }
+}
+
+// Тест: Переполнение буфера потока не блокирует запись, потерянные сообщения учитываются
+TEST(LoggerTests, DropsWhenRingIsFull) {
+    CapturedLog log;
+    netlink::common::Logger::set_level(LOG_INFO);
+
+    std::thread writer([]() {
+        for (std::size_t i = 0; i < netlink::common::Logger::RING_SIZE * 4; ++i) {
+            NETLINK_LOG(LOG_INFO, "message %zu", i);
+        }
+    });
+    writer.join();
+
+    auto messages = log.messages();
+    ASSERT_FALSE(messages.empty());
+    EXPECT_LE(messages.size(), netlink::common::Logger::RING_SIZE * 4 + 1);
+    std::size_t written = 0;
+    bool reported = false;
+    for (auto const &[level, text] : messages) {
+        if (text.find("log messages dropped") != std::string::npos) {
+            reported = true;
+        } else {
+            ++written;
+        }
+    }
+    EXPECT_GE(written, netlink::common::Logger::RING_SIZE);
+    EXPECT_EQ(reported, written < netlink::common::Logger::RING_SIZE * 4);
+}
+
+// Тест: Место вызова выводит не больше DEFAULT_BURST сообщений за интервал
+TEST(LoggerTests, RateLimitsErrorStorms) {
+    CapturedLog log;
+    netlink::common::Logger::set_level(LOG_INFO);
+
+    for (int i = 0; i < 100; ++i) {
+        NETLINK_LOG_RATELIMITED(LOG_ERR, "storm %d", i);
+    }
+    // Не больше одного интервала: DEFAULT_BURST сообщений и, возможно, сводка о подавленных
+    EXPECT_LE(log.messages().size(), netlink::common::RateLimiter::DEFAULT_BURST + 1);
+
+    netlink::common::RateLimiter limiter(2, 1000000);
+    uint64_t suppressed = 0;
+    EXPECT_TRUE(limiter.allow(suppressed));
+    EXPECT_TRUE(limiter.allow(suppressed));
+    EXPECT_FALSE(limiter.allow(suppressed));
+    EXPECT_FALSE(limiter.allow(suppressed));
+
+    // В новом интервале сообщения снова выводятся и сообщается количество подавленных
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_TRUE(limiter.allow(suppressed));
+    EXPECT_EQ(suppressed, 2u);
+}
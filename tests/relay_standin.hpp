@@ -0,0 +1,301 @@
+#pragma once
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "../kernel_module/calc_ops.h"
+#include "../kernel_module/calc_route.h"
+#include "../kernel_module/calc_server.h"
+
+namespace tests {
+
+/**
+ * @brief Userspace-замена ретранслятора calc_module.
+ *
+ * Повторяет последовательность вызовов calc_cmd_client/calc_cmd_server поверх тех же таблицы
+ * маршрутов (kernel_module/calc_route.h) и реестра серверов (kernel_module/calc_server.h),
+ * но вместо отправки через Netlink возвращает адресата сообщения. Позволяет тестировать
+ * маршрутизацию, выбор наименее загруженного сервера, емкость серверов, отмену регистрации и
+ * завершение серверов без загрузки модуля ядра. Замена не потокобезопасна.
+ */
+class RelayStandIn final {
+   public:
+    /**
+     * @brief Адресат пересылаемого сообщения.
+     */
+    struct Delivery {
+        int error = 0;            /**< 0 или код ошибки, который вернул бы обработчик модуля. */
+        uint32_t pid = 0;         /**< PID получателя. */
+        uint32_t seq = 0;         /**< Номер последовательности пересылаемого сообщения. */
+        uint32_t stream = 0;      /**< Идентификатор потока ретранслятора (для фрагментов потока). */
+        bool offloaded = false;   /**< Ответ вычислен ретранслятором и отправлен клиенту (pid, seq). */
+        calc_ops_result result{}; /**< Ответ ретранслятора (если offloaded). */
+        uint32_t topic = 0;       /**< Ответ сервера также рассылается подписчикам этой темы (0 - не рассылается). */
+    };
+
+    RelayStandIn() : m_routes(std::make_unique<calc_route_table>()), m_streams(std::make_unique<calc_stream_table>()) {
+        calc_route_init(m_routes.get());
+        calc_stream_init(m_streams.get());
+    }
+
+    ~RelayStandIn() {
+        for (int i = 0; i < m_registry->count; ++i) {
+            delete m_registry->list[i];
+        }
+    }
+    RelayStandIn(RelayStandIn const &) = delete;
+    RelayStandIn &operator=(RelayStandIn const &) = delete;
+
+    /**
+     * @brief Регистрирует сервер (COMMAND_REGISTER или сообщение сервера с незнакомого PID).
+     *
+     * Как register_server модуля, сначала дожидается удаления завершившихся серверов (flush_work):
+     * port id закрытого сокета мог достаться новому серверу. Сервер, отменивший регистрацию, снова
+     * получает запросы.
+     *
+     * @param credits Емкость сервера ATTR_CREDITS (0 - без ограничения).
+     */
+    void register_server(uint32_t pid, uint32_t credits = 0) {
+        run_reap();
+        m_closed.erase(pid);
+        int const limited = static_cast<int>(std::min<uint32_t>(credits, INT32_MAX));
+        if (calc_server *server = calc_server_lookup(m_registry.get(), pid)) {
+            calc_server_renew(server, limited);
+            return;
+        }
+        auto *server = new calc_server;
+        calc_server_init(server, pid, limited);
+        Registry updated = allocate(m_registry->count + 1);
+        calc_servers_add(m_registry.get(), updated.get(), server);
+        m_registry = std::move(updated);
+    }
+
+    /**
+     * @brief Отменяет регистрацию (COMMAND_UNREGISTER): новые запросы серверу не направляются.
+     *
+     * @return 0 или -ENOENT, если сервер не зарегистрирован.
+     */
+    int unregister_server(uint32_t pid) {
+        calc_server *server = calc_server_lookup(m_registry.get(), pid);
+        if (!server) {
+            return -ENOENT;
+        }
+        calc_write_once(server->draining, true);
+        return 0;
+    }
+
+    /**
+     * @brief Сокет сервера закрыт (NETLINK_URELEASE): сервер помечается завершившимся (mark_server_dead).
+     *
+     * Помеченный сервер сразу перестает получать запросы; из реестра его удаляет reap().
+     *
+     * @return true, если сервер был зарегистрирован.
+     */
+    bool server_died(uint32_t pid) {
+        m_closed.insert(pid);
+        return calc_server_mark_dead(m_registry.get(), pid);
+    }
+
+    /**
+     * @brief Сокет сервера закрыт, но уведомление еще не обработано: пересылка ему завершается -ECONNREFUSED.
+     */
+    void close_socket(uint32_t pid) { m_closed.insert(pid); }
+
+    /**
+     * @brief Выполняет задание reap_work: удаляет завершившиеся серверы и завершает их запросы ошибкой.
+     *
+     * @return Ответы ECONNRESET клиентам запросов, на которые серверы не ответили, в том числе
+     *         отправленные при удалении перед регистрацией (register_server).
+     */
+    std::vector<Delivery> reap() {
+        run_reap();
+        return std::exchange(m_failed, {});
+    }
+
+    /**
+     * @brief Запрос клиента: выбор сервера и назначение идентификатора запроса.
+     *
+     * @param topic Тема рассылки ответа ATTR_TOPIC (0 - без рассылки).
+     */
+    Delivery client_request(uint32_t client_pid, uint32_t client_seq, uint32_t topic = 0) {
+        uint32_t server_pid = 0;
+        int error = pick_server(&server_pid);
+        if (error) {
+            return error == -EBUSY ? Delivery{-EBUSY, 0, 0} : Delivery{0, client_pid, client_seq};
+        }
+        Delivery delivery = route_request(client_pid, client_seq, server_pid, topic);
+        // Как calc_cmd_client: сокет сервера закрыт, а уведомление еще не обработано - запрос получает другой сервер
+        if (delivery.error == -ECONNREFUSED && pick_server(&server_pid) == 0) {
+            delivery = route_request(client_pid, client_seq, server_pid, topic);
+        }
+        return delivery;
+    }
+
+    /**
+     * @brief Режим offload: простые бинарные операции вычисляются ретранслятором (параметр модуля offload).
+     */
+    void set_offload(bool offload) { m_offload = offload; }
+
+    /**
+     * @brief Бинарный запрос клиента: в режиме offload ответ вычисляется сразу, иначе запрос идет серверу.
+     */
+    Delivery client_binary(uint32_t client_pid, uint32_t client_seq, uint8_t op, int64_t arg1, int64_t arg2) {
+        Delivery delivery{0, client_pid, client_seq};
+        if (m_offload && calc_ops_compute(op, arg1, arg2, &delivery.result) == 0) {
+            delivery.offloaded = true;
+            return delivery;
+        }
+        return client_request(client_pid, client_seq);
+    }
+
+    /**
+     * @brief Фрагмент потока клиента: первый фрагмент выбирает сервер, остальные идут ему же.
+     */
+    Delivery client_chunk(uint32_t client_pid, uint32_t client_seq, uint32_t client_stream, uint32_t chunk, bool eos) {
+        calc_stream stream{};
+        if (chunk != 0) {
+            if (calc_stream_find(m_streams.get(), client_pid, client_stream, &stream)) {
+                return {-ENOENT, 0, 0};
+            }
+            // Емкость проверяется при открытии потока
+            calc_server_track(m_registry.get(), stream.server_pid, 1);
+        } else {
+            int error = pick_server(&stream.server_pid);
+            if (error) {
+                return error == -EBUSY ? Delivery{-EBUSY, 0, 0} : Delivery{0, client_pid, client_seq};
+            }
+            stream.id = calc_stream_open(m_streams.get(), client_pid, client_stream, stream.server_pid);
+        }
+        Delivery delivery = route_request(client_pid, client_seq, stream.server_pid, 0);
+        if (delivery.error != 0 || eos) {
+            calc_stream_close(m_streams.get(), stream.id);
+        }
+        if (delivery.error == 0) {
+            delivery.stream = stream.id;
+        }
+        return delivery;
+    }
+
+    /**
+     * @brief Количество открытых потоков.
+     */
+    uint32_t streams() const { return m_streams->count; }
+
+    /**
+     * @brief Ответ сервера: поиск клиента по идентификатору запроса и темы рассылки.
+     *
+     * @param more Промежуточная часть ответа (NLM_F_MULTI): маршрут остается до последней части.
+     * @param server_pid PID отвечающего сервера (0 - сервер, которому передан запрос).
+     */
+    Delivery server_reply(uint32_t id, bool more = false, uint32_t server_pid = 0) {
+        calc_route route;
+        if (calc_route_find(m_routes.get(), id, &route) || (server_pid != 0 && route.server_pid != server_pid) ||
+            (!more && calc_route_take(m_routes.get(), id, &route))) {
+            return {-ENOENT, 0, 0};
+        }
+        if (!more) {
+            calc_server_track(m_registry.get(), route.server_pid, -1);
+        }
+        Delivery delivery{0, route.client_pid, route.client_seq};
+        delivery.topic = route.topic;
+        return delivery;
+    }
+
+    /**
+     * @brief Запросы в полете на сервере (0, если сервер не зарегистрирован).
+     */
+    uint32_t outstanding(uint32_t pid) const {
+        calc_server const *server = calc_server_lookup(m_registry.get(), pid);
+        return server ? static_cast<uint32_t>(calc_atomic_read(&server->outstanding)) : 0;
+    }
+
+    /**
+     * @brief Количество запросов в полете.
+     */
+    uint32_t in_flight() const { return calc_route_count(m_routes.get()); }
+
+   private:
+    /**
+     * @brief Освобождает снимок реестра (в модуле - kfree_rcu).
+     */
+    struct FreeRegistry {
+        void operator()(calc_servers *registry) const { std::free(registry); }
+    };
+    using Registry = std::unique_ptr<calc_servers, FreeRegistry>;
+
+    /**
+     * @brief Выделяет пустой снимок на count серверов.
+     */
+    static Registry allocate(int count) {
+        return Registry(static_cast<calc_servers *>(std::calloc(1, sizeof(calc_servers) + count * sizeof(calc_server *))));
+    }
+
+    /**
+     * @brief Выбор сервера (pick_server модуля); индекс начала просмотра сдвигается на каждый запрос.
+     *
+     * @return 0 (место на сервере pid занято), -ESRCH если серверов нет, -EBUSY если места нет ни на одном.
+     */
+    int pick_server(uint32_t *pid) { return calc_server_pick(m_registry.get(), m_next_server++, pid); }
+
+    /**
+     * @brief Создает маршрут и "пересылает" запрос серверу (route_request модуля).
+     *
+     * Место на сервере уже занято; если запрос не передан, оно освобождается. Пересылка на закрытый
+     * сокет возвращает -ECONNREFUSED и помечает сервер завершившимся.
+     */
+    Delivery route_request(uint32_t client_pid, uint32_t client_seq, uint32_t server_pid, uint32_t topic) {
+        uint32_t id = calc_route_add(m_routes.get(), &m_cursor, calc_route_base(0), client_pid, client_seq, server_pid, topic);
+        if (id == 0) {
+            calc_server_track(m_registry.get(), server_pid, -1);
+            return {-EBUSY, 0, 0};
+        }
+        if (m_closed.count(server_pid) != 0) {
+            calc_route route;
+            if (calc_route_take(m_routes.get(), id, &route) == 0) {
+                calc_server_track(m_registry.get(), server_pid, -1);
+            }
+            calc_server_mark_dead(m_registry.get(), server_pid);
+            return {-ECONNREFUSED, 0, 0};
+        }
+        return {0, server_pid, id};
+    }
+
+    /**
+     * @brief Задание reap_work (reap_servers модуля): ответы ECONNRESET накапливаются в m_failed.
+     */
+    void run_reap() {
+        calc_server *dead[CALC_MAX_SERVERS];
+        Registry updated = allocate(m_registry->count);
+        int const n_dead = calc_servers_remove_dead(m_registry.get(), updated.get(), dead);
+        if (n_dead == 0) {
+            return;
+        }
+        m_registry = std::move(updated);
+        for (int i = 0; i < n_dead; ++i) {
+            calc_server_fail_routes(
+                m_routes.get(), dead[i]->pid,
+                [](calc_route const *route, void *context) {
+                    static_cast<std::vector<Delivery> *>(context)->push_back({ECONNRESET, route->client_pid, route->client_seq});
+                },
+                &m_failed);
+            calc_stream_close_server(m_streams.get(), dead[i]->pid);
+            delete dead[i];
+        }
+    }
+
+    std::unique_ptr<calc_route_table> m_routes;   // 8
+    std::unique_ptr<calc_stream_table> m_streams; // 8
+    Registry m_registry = allocate(0);            // 8 текущий снимок реестра серверов
+    std::vector<Delivery> m_failed;               // 24 ответы ECONNRESET, отправленные reap_work
+    std::set<uint32_t> m_closed;                  // 48 PID серверов с закрытым сокетом
+    unsigned int m_next_server = 0;               // 4 индекс начала просмотра (в модуле - свой на каждом CPU)
+    uint32_t m_cursor = 0;                        // 4 курсор идентификаторов (в модуле - свой на каждом CPU)
+    bool m_offload = false;                       // 1
+};
+
+} // namespace tests
@@ -0,0 +1,494 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "../server/operations.hpp"
+#include "relay_standin.hpp"
+
+// Тест: Ответы двух клиентов с одинаковыми номерами последовательности доходят до своих клиентов
+TEST(RelayTests, RoutesRepliesToTheirClients) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    auto first = relay.client_request(1, 7);
+    auto second = relay.client_request(2, 7);
+    ASSERT_EQ(first.error, 0);
+    ASSERT_EQ(second.error, 0);
+    EXPECT_EQ(first.pid, 100u);
+    EXPECT_NE(first.seq, second.seq);
+    EXPECT_EQ(relay.in_flight(), 2u);
+
+    // Сервер отвечает в обратном порядке
+    auto reply_second = relay.server_reply(second.seq);
+    auto reply_first = relay.server_reply(first.seq);
+    ASSERT_EQ(reply_second.error, 0);
+    ASSERT_EQ(reply_first.error, 0);
+    EXPECT_EQ(reply_second.pid, 2u);
+    EXPECT_EQ(reply_second.seq, 7u);
+    EXPECT_EQ(reply_first.pid, 1u);
+    EXPECT_EQ(reply_first.seq, 7u);
+    EXPECT_EQ(relay.in_flight(), 0u);
+}
+
+// Тест: Повторный или неизвестный ответ сервера отклоняется
+TEST(RelayTests, RejectsUnknownReply) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    auto request = relay.client_request(1, 1);
+    EXPECT_EQ(relay.server_reply(request.seq).error, 0);
+    EXPECT_EQ(relay.server_reply(request.seq).error, -ENOENT);
+    EXPECT_EQ(relay.server_reply(0).error, -ENOENT);
+}
+
+// Тест: Запросы распределяются между серверами, переполнение таблицы возвращает -EBUSY
+TEST(RelayTests, DistributesAndLimitsRequests) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    relay.register_server(200);
+
+    std::vector<tests::RelayStandIn::Delivery> requests;
+    for (uint32_t seq = 0; seq < CALC_ROUTE_TABLE_SIZE; ++seq) {
+        requests.push_back(relay.client_request(1, seq));
+        ASSERT_EQ(requests.back().error, 0);
+    }
+    EXPECT_EQ(requests[0].pid, 100u);
+    EXPECT_EQ(requests[1].pid, 200u);
+    EXPECT_EQ(relay.client_request(1, 0).error, -EBUSY);
+
+    // После ответа слот освобождается и идентификаторы продолжают выдаваться
+    ASSERT_EQ(relay.server_reply(requests[10].seq).error, 0);
+    auto request = relay.client_request(3, 42);
+    ASSERT_EQ(request.error, 0);
+    auto reply = relay.server_reply(request.seq);
+    EXPECT_EQ(reply.pid, 3u);
+    EXPECT_EQ(reply.seq, 42u);
+}
+
+// Тест: Промежуточные части ответа (NLM_F_MULTI) пересылаются клиенту, маршрут освобождает последняя часть
+TEST(RelayTests, MultipartReply) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    auto request = relay.client_request(5, 9);
+    for (int part = 0; part < 3; ++part) {
+        auto reply = relay.server_reply(request.seq, true);
+        ASSERT_EQ(reply.error, 0);
+        EXPECT_EQ(reply.pid, 5u);
+        EXPECT_EQ(reply.seq, 9u);
+        EXPECT_EQ(relay.in_flight(), 1u);
+    }
+    EXPECT_EQ(relay.server_reply(request.seq).error, 0);
+    EXPECT_EQ(relay.in_flight(), 0u);
+    EXPECT_EQ(relay.server_reply(request.seq, true).error, -ENOENT);
+}
+
+// Тест: Фрагменты потока идут одному серверу, потоки разных клиентов с одинаковым идентификатором различаются
+TEST(RelayTests, StickyStreams) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    relay.register_server(200);
+
+    auto first = relay.client_chunk(1, 10, 7, 0, false);
+    auto second = relay.client_chunk(2, 10, 7, 0, false);
+    ASSERT_EQ(first.error, 0);
+    ASSERT_EQ(second.error, 0);
+    EXPECT_EQ(first.pid, 100u);
+    EXPECT_EQ(second.pid, 200u);
+    EXPECT_NE(first.stream, second.stream);
+    EXPECT_EQ(relay.streams(), 2u);
+
+    for (uint32_t chunk = 1; chunk < 5; ++chunk) {
+        bool const eos = chunk == 4;
+        auto a = relay.client_chunk(1, 10 + chunk, 7, chunk, eos);
+        auto b = relay.client_chunk(2, 10 + chunk, 7, chunk, eos);
+        ASSERT_EQ(a.error, 0);
+        ASSERT_EQ(b.error, 0);
+        EXPECT_EQ(a.pid, 100u);
+        EXPECT_EQ(b.pid, 200u);
+        EXPECT_EQ(a.stream, first.stream);
+        EXPECT_EQ(relay.server_reply(a.seq).seq, 10 + chunk);
+        EXPECT_EQ(relay.server_reply(b.seq).pid, 2u);
+    }
+    EXPECT_EQ(relay.streams(), 0u);
+    // Поток закрыт последним фрагментом
+    EXPECT_EQ(relay.client_chunk(1, 20, 7, 5, false).error, -ENOENT);
+}
+
+// Тест: Потоки, не получившие последний фрагмент, вытесняются при заполнении таблицы
+TEST(RelayTests, EvictsAbandonedStreams) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    auto abandoned = relay.client_chunk(1, 1, 1, 0, false);
+    ASSERT_EQ(relay.server_reply(abandoned.seq).error, 0);
+    for (uint32_t stream = 2; stream <= CALC_STREAM_TABLE_SIZE; ++stream) {
+        auto chunk = relay.client_chunk(1, stream, stream, 0, false);
+        ASSERT_EQ(relay.server_reply(chunk.seq).error, 0);
+    }
+    EXPECT_EQ(relay.streams(), static_cast<uint32_t>(CALC_STREAM_TABLE_SIZE));
+
+    auto chunk = relay.client_chunk(2, 1, 1, 0, false);
+    ASSERT_EQ(chunk.error, 0);
+    EXPECT_EQ(relay.streams(), static_cast<uint32_t>(CALC_STREAM_TABLE_SIZE));
+    EXPECT_EQ(relay.client_chunk(1, 2, 1, 1, false).error, -ENOENT);
+    EXPECT_EQ(relay.client_chunk(1, 3, 2, 1, false).error, 0);
+}
+
+// Тест: При заполнении таблицы вытесняется поток, фрагменты которого дольше всех не приходили, а не открытый первым
+TEST(RelayTests, EvictsLeastRecentlyUsedStream) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    uint32_t seq = 1;
+    for (uint32_t stream = 1; stream <= CALC_STREAM_TABLE_SIZE; ++stream) {
+        auto chunk = relay.client_chunk(1, seq++, stream, 0, false);
+        ASSERT_EQ(relay.server_reply(chunk.seq).error, 0);
+    }
+    // Первый поток активен: его фрагмент пришел после открытия остальных
+    auto active = relay.client_chunk(1, seq++, 1, 1, false);
+    ASSERT_EQ(relay.server_reply(active.seq).error, 0);
+
+    auto chunk = relay.client_chunk(2, seq++, 1, 0, false);
+    ASSERT_EQ(relay.server_reply(chunk.seq).error, 0);
+    EXPECT_EQ(relay.streams(), static_cast<uint32_t>(CALC_STREAM_TABLE_SIZE));
+    EXPECT_EQ(relay.client_chunk(1, seq++, 2, 1, false).error, -ENOENT);
+    auto next = relay.client_chunk(1, seq++, 1, 2, false);
+    ASSERT_EQ(next.error, 0);
+    EXPECT_EQ(relay.server_reply(next.seq).error, 0);
+}
+
+// Тест: Вычисления ретранслятора (kernel_module/calc_ops.h) совпадают с реестром операций сервера
+TEST(RelayTests, OffloadMatchesServer) {
+    static_assert(CALC_OP_ADD == static_cast<int>(netlink::server::OP::OP_ADD) && CALC_OP_MOD == static_cast<int>(netlink::server::OP::OP_MOD));
+    int64_t const values[] = {0, 1, -1, 2, -2, 7, -7, 1000003, INT32_MAX, INT32_MIN, INT64_MAX, INT64_MIN, INT64_MAX - 1, INT64_MIN + 1};
+    for (auto const &operation : netlink::server::M_OPERATIONS) {
+        for (int64_t arg1 : values) {
+            for (int64_t arg2 : values) {
+                calc_ops_result result{};
+                ASSERT_EQ(calc_ops_compute(static_cast<uint8_t>(operation.op), arg1, arg2, &result), 0);
+                auto const expected = operation.int64(arg1, arg2);
+                EXPECT_EQ(result.error, expected.error) << operation.name << " " << arg1 << " " << arg2;
+                EXPECT_EQ(result.value, expected.value) << operation.name << " " << arg1 << " " << arg2;
+            }
+        }
+    }
+    calc_ops_result result{};
+    EXPECT_EQ(calc_ops_compute(0, 1, 2, &result), -EOPNOTSUPP);
+    EXPECT_EQ(calc_ops_compute(static_cast<uint8_t>(netlink::server::OP::OP_MAX), 1, 2, &result), -EOPNOTSUPP);
+}
+
+// Тест: В режиме offload простые операции отвечаются ретранслятором без маршрута, неизвестные идут серверу
+TEST(RelayTests, OffloadSkipsServer) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    auto forwarded = relay.client_binary(1, 5, CALC_OP_ADD, 40, 2);
+    EXPECT_FALSE(forwarded.offloaded);
+    EXPECT_EQ(forwarded.pid, 100u);
+    ASSERT_EQ(relay.server_reply(forwarded.seq).error, 0);
+
+    relay.set_offload(true);
+    auto added = relay.client_binary(1, 6, CALC_OP_ADD, 40, 2);
+    ASSERT_TRUE(added.offloaded);
+    EXPECT_EQ(added.pid, 1u);
+    EXPECT_EQ(added.seq, 6u);
+    EXPECT_EQ(added.result.error, 0);
+    EXPECT_EQ(added.result.value, 42);
+    auto divided = relay.client_binary(1, 7, CALC_OP_DIV, 1, 0);
+    ASSERT_TRUE(divided.offloaded);
+    EXPECT_EQ(divided.result.error, EDOM);
+    EXPECT_EQ(relay.in_flight(), 0u);
+
+    auto unknown = relay.client_binary(1, 8, 42, 1, 2);
+    EXPECT_FALSE(unknown.offloaded);
+    EXPECT_EQ(unknown.pid, 100u);
+    EXPECT_EQ(relay.in_flight(), 1u);
+}
+
+// Тест: Потоки с собственными курсорами одновременно добавляют и извлекают маршруты без потерь и подмен
+TEST(RelayTests, ConcurrentRoutes) {
+    auto table = std::make_unique<calc_route_table>();
+    calc_route_init(table.get());
+    std::atomic<bool> mismatch{false};
+    std::vector<std::thread> threads;
+    for (unsigned cpu = 0; cpu < 4; ++cpu) {
+        threads.emplace_back([&, cpu]() {
+            uint32_t cursor = cpu * CALC_ROUTE_TABLE_SIZE / 4;
+            std::vector<uint32_t> ids;
+            for (uint32_t i = 0; i < 100000; ++i) {
+                uint32_t const id = calc_route_add(table.get(), &cursor, calc_route_base(cpu), cpu + 1, i, 100, 0);
+                if (id == 0) {
+                    mismatch.store(true);
+                    return;
+                }
+                ids.push_back(id);
+                // До 64 запросов в полете, затем все ответы приходят по порядку
+                if (ids.size() == 64 || i + 1 == 100000) {
+                    for (std::size_t k = 0; k < ids.size(); ++k) {
+                        calc_route route;
+                        if (calc_route_take(table.get(), ids[k], &route) || route.client_pid != cpu + 1 ||
+                            route.client_seq != i + 1 - ids.size() + k || calc_route_take(table.get(), ids[k], &route) != -ENOENT) {
+                            mismatch.store(true);
+                        }
+                    }
+                    ids.clear();
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(mismatch.load());
+    EXPECT_EQ(calc_route_count(table.get()), 0u);
+}
+
+// Тест: Запрос получает сервер с наименьшим числом запросов в полете
+TEST(RelayTests, LeastOutstanding) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    relay.register_server(200);
+
+    auto a = relay.client_request(1, 1);
+    auto b = relay.client_request(1, 2);
+    auto c = relay.client_request(1, 3);
+    EXPECT_EQ(a.pid, 100u);
+    EXPECT_EQ(b.pid, 200u);
+    EXPECT_EQ(c.pid, 100u);
+    EXPECT_EQ(relay.outstanding(100), 2u);
+
+    // Сервер 100 ответил на все запросы, сервер 200 - нет: оба следующих запроса получает 100
+    ASSERT_EQ(relay.server_reply(a.seq).error, 0);
+    ASSERT_EQ(relay.server_reply(c.seq).error, 0);
+    EXPECT_EQ(relay.client_request(1, 4).pid, 100u);
+    EXPECT_EQ(relay.client_request(1, 5).pid, 100u);
+    EXPECT_EQ(relay.outstanding(200), 1u);
+
+    // Ответ принимается только от сервера, которому передан запрос
+    EXPECT_EQ(relay.server_reply(b.seq, false, 100).error, -ENOENT);
+    EXPECT_EQ(relay.server_reply(b.seq, false, 200).pid, 1u);
+    EXPECT_EQ(relay.outstanding(200), 0u);
+}
+
+// Тест: Сервер, отменивший регистрацию, не получает новых запросов, но его ответы доходят до клиентов
+TEST(RelayTests, UnregisterDrainsServer) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    relay.register_server(200);
+
+    auto accepted = relay.client_request(1, 1);
+    ASSERT_EQ(accepted.pid, 100u);
+    EXPECT_EQ(relay.unregister_server(100), 0);
+    EXPECT_EQ(relay.unregister_server(300), -ENOENT);
+    for (uint32_t seq = 2; seq < 6; ++seq) {
+        auto request = relay.client_request(1, seq);
+        EXPECT_EQ(request.pid, 200u);
+        ASSERT_EQ(relay.server_reply(request.seq).error, 0);
+    }
+    auto reply = relay.server_reply(accepted.seq, false, 100);
+    ASSERT_EQ(reply.error, 0);
+    EXPECT_EQ(reply.pid, 1u);
+    EXPECT_EQ(reply.seq, 1u);
+
+    // Без зарегистрированных серверов клиент получает сообщение ретранслятора
+    EXPECT_EQ(relay.unregister_server(200), 0);
+    EXPECT_EQ(relay.client_request(1, 7).pid, 1u);
+    relay.register_server(100);
+    EXPECT_EQ(relay.client_request(1, 8).pid, 100u);
+}
+
+// Тест: Запросы завершившегося сервера получают ECONNRESET, его потоки закрываются, остальные серверы работают
+TEST(RelayTests, ServerDied) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    relay.register_server(200);
+
+    auto a = relay.client_request(1, 10);
+    auto b = relay.client_request(2, 20);
+    auto c = relay.client_request(3, 30);
+    auto chunk = relay.client_chunk(4, 40, 7, 0, false);
+    ASSERT_EQ(a.pid, 100u);
+    ASSERT_EQ(b.pid, 200u);
+    ASSERT_EQ(c.pid, 100u);
+    ASSERT_EQ(chunk.pid, 200u);
+    EXPECT_EQ(relay.streams(), 1u);
+
+    // Помеченный сервер сразу перестает получать запросы, его запросы завершает задание reap_work
+    EXPECT_TRUE(relay.server_died(200));
+    EXPECT_EQ(relay.client_request(5, 50).pid, 100u);
+    EXPECT_EQ(relay.outstanding(200), 0u);
+    EXPECT_EQ(relay.in_flight(), 5u);
+
+    auto failed = relay.reap();
+    ASSERT_EQ(failed.size(), 2u);
+    EXPECT_EQ(failed[0].error, ECONNRESET);
+    EXPECT_EQ(failed[0].pid + failed[1].pid, 6u);
+    EXPECT_EQ(failed[0].seq + failed[1].seq, 60u);
+    EXPECT_EQ(relay.streams(), 0u);
+    EXPECT_EQ(relay.in_flight(), 3u);
+    EXPECT_EQ(relay.client_chunk(4, 41, 7, 1, false).error, -ENOENT);
+    EXPECT_EQ(relay.server_reply(b.seq, false, 200).error, -ENOENT);
+
+    EXPECT_EQ(relay.client_request(6, 60).pid, 100u);
+    EXPECT_EQ(relay.server_reply(a.seq).pid, 1u);
+    EXPECT_FALSE(relay.server_died(300));
+    EXPECT_TRUE(relay.reap().empty());
+}
+
+// Тест: Сервер с тем же port id регистрируется только после удаления прежнего, запросы нового сервера не завершаются
+TEST(RelayTests, ReRegisterAfterDeath) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    auto old_request = relay.client_request(1, 10);
+    ASSERT_EQ(old_request.pid, 100u);
+
+    // Уведомление обработано, а reap_work еще не выполнено: регистрация сначала дожидается его
+    EXPECT_TRUE(relay.server_died(100));
+    relay.register_server(100);
+    EXPECT_EQ(relay.outstanding(100), 0u);
+    auto new_request = relay.client_request(2, 20);
+    ASSERT_EQ(new_request.pid, 100u);
+
+    auto failed = relay.reap();
+    ASSERT_EQ(failed.size(), 1u);
+    EXPECT_EQ(failed[0].pid, 1u);
+    EXPECT_EQ(failed[0].seq, 10u);
+    EXPECT_EQ(relay.server_reply(new_request.seq, false, 100).pid, 2u);
+    EXPECT_EQ(relay.in_flight(), 0u);
+}
+
+// Тест: Пересылка на закрытый сокет (-ECONNREFUSED) помечает сервер завершившимся, запрос получает другой сервер
+TEST(RelayTests, RefusedServerRetries) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+    relay.register_server(200);
+
+    relay.close_socket(100);
+    auto request = relay.client_request(1, 10);
+    ASSERT_EQ(request.error, 0);
+    EXPECT_EQ(request.pid, 200u);
+    EXPECT_EQ(relay.in_flight(), 1u);
+    EXPECT_EQ(relay.outstanding(100), 0u);
+    EXPECT_EQ(relay.outstanding(200), 1u);
+    for (uint32_t seq = 11; seq < 14; ++seq) {
+        EXPECT_EQ(relay.client_request(1, seq).pid, 200u);
+    }
+    EXPECT_TRUE(relay.reap().empty());
+
+    // Повторить негде: клиент получает -ECONNREFUSED
+    relay.close_socket(200);
+    EXPECT_EQ(relay.client_request(1, 20).error, -ECONNREFUSED);
+    EXPECT_EQ(relay.reap().size(), 4u);
+    EXPECT_EQ(relay.in_flight(), 0u);
+}
+
+// Тест: Запросы сверх емкости серверов отклоняются с -EBUSY, ответ сервера освобождает место
+TEST(RelayTests, CreditsExhausted) {
+    tests::RelayStandIn relay;
+    relay.register_server(100, 2);
+    relay.register_server(200, 1);
+
+    std::vector<tests::RelayStandIn::Delivery> accepted;
+    for (uint32_t seq = 1; seq <= 3; ++seq) {
+        accepted.push_back(relay.client_request(1, seq));
+        ASSERT_EQ(accepted.back().error, 0);
+    }
+    EXPECT_EQ(relay.outstanding(100), 2u);
+    EXPECT_EQ(relay.outstanding(200), 1u);
+    EXPECT_EQ(relay.client_request(1, 4).error, -EBUSY);
+    EXPECT_EQ(relay.client_chunk(1, 5, 7, 0, false).error, -EBUSY);
+    EXPECT_EQ(relay.in_flight(), 3u);
+
+    // Ответ сервера 200 освобождает место только на нем
+    ASSERT_EQ(relay.server_reply(accepted[1].seq, false, 200).error, 0);
+    EXPECT_EQ(relay.client_request(1, 6).pid, 200u);
+    EXPECT_EQ(relay.client_request(1, 7).error, -EBUSY);
+
+    // Повторная регистрация меняет емкость, сервер без ограничения принимает все
+    relay.register_server(100, 0);
+    EXPECT_EQ(relay.client_request(1, 8).pid, 100u);
+    EXPECT_EQ(relay.outstanding(100), 3u);
+}
+
+// Тест: Из одновременных вызовов последнее место на сервере получает один, проигравший выбирает другой сервер
+TEST(RelayTests, CreditRace) {
+    calc_server first;
+    calc_server second;
+    calc_server_init(&first, 100, 100000);
+    calc_server_init(&second, 200, 1);
+    std::unique_ptr<calc_servers, decltype(&std::free)> registry(
+        static_cast<calc_servers *>(std::calloc(1, sizeof(calc_servers) + 2 * sizeof(calc_server *))), &std::free);
+    registry->list[0] = &first;
+    registry->list[1] = &second;
+    registry->count = 1;
+
+    // Четыре потока занимают места на одном сервере: всего занято ровно credits мест
+    std::atomic<int> taken{0};
+    std::atomic<int> started{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&]() {
+            started.fetch_add(1);
+            while (started.load() < 4) {
+                std::this_thread::yield();
+            }
+            for (int i = 0; i < 50000; ++i) {
+                taken.fetch_add(calc_server_take_credit(&first) ? 1 : 0, std::memory_order_relaxed);
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(taken.load(), 100000);
+    EXPECT_EQ(calc_atomic_read(&first.outstanding), 100000);
+
+    // Оба вызова выбирают наименее загруженный сервер с последним местом: проигравший повторяет выбор
+    registry->count = 2;
+    for (int round = 0; round < 1000; ++round) {
+        calc_atomic_set(&first.outstanding, 99999);
+        calc_atomic_set(&second.outstanding, 0);
+        std::atomic<int> ready{0};
+        int results[2] = {-1, -1};
+        uint32_t pids[2] = {0, 0};
+        auto pick = [&](int caller) {
+            ready.fetch_add(1);
+            while (ready.load() < 2) {
+                std::this_thread::yield();
+            }
+            results[caller] = calc_server_pick(registry.get(), 0, &pids[caller]);
+        };
+        std::thread other(pick, 0);
+        pick(1);
+        other.join();
+        ASSERT_EQ(results[0], 0);
+        ASSERT_EQ(results[1], 0);
+        ASSERT_EQ(pids[0] + pids[1], 300u);
+    }
+    uint32_t pid = 0;
+    EXPECT_EQ(calc_server_pick(registry.get(), 0, &pid), -EBUSY);
+}
+
+// Тест: Тема запроса сохраняется в маршруте до последней части ответа, запросы без темы не рассылаются
+TEST(RelayTests, PublishedReplies) {
+    tests::RelayStandIn relay;
+    relay.register_server(100);
+
+    auto published = relay.client_request(1, 10, 42);
+    auto plain = relay.client_request(2, 20);
+    ASSERT_EQ(published.error, 0);
+
+    auto part = relay.server_reply(published.seq, true);
+    EXPECT_EQ(part.pid, 1u);
+    EXPECT_EQ(part.topic, 42u);
+    auto last = relay.server_reply(published.seq);
+    EXPECT_EQ(last.seq, 10u);
+    EXPECT_EQ(last.topic, 42u);
+    EXPECT_EQ(relay.server_reply(plain.seq).topic, 0u);
+    EXPECT_EQ(relay.in_flight(), 0u);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../server/result_cache.hpp"
+#include "test_server.hpp"
+
+namespace {
+
+using netlink::server::Counter;
+using netlink::server::OP;
+using netlink::server::ResultCache;
+
+// Тест: Найденный ответ совпадает с вставленным, другие запросы и слишком длинные записи не находятся
+TEST(ResultCacheTest, FindAndInsert) {
+    ResultCache cache(100);
+    EXPECT_EQ(cache.capacity(), 128u);
+    char value[ResultCache::M_VALUE_SIZE + 1];
+
+    EXPECT_EQ(cache.find(R"({"action":"add","arg1":1,"arg2":2})", value).size, 0u);
+    EXPECT_FALSE(cache.insert(R"({"action":"add","arg1":1,"arg2":2})", R"({"result":3})", OP::OP_ADD, false));
+    EXPECT_FALSE(cache.insert(R"({"action":"div","arg1":1,"arg2":0})", R"({"errno":33,"error":"division by zero"})", OP::OP_DIV, true));
+
+    ResultCache::Hit hit = cache.find(R"({"action":"add","arg1":1,"arg2":2})", value);
+    ASSERT_EQ(hit.size, 12u);
+    EXPECT_STREQ(value, R"({"result":3})");
+    EXPECT_EQ(hit.op, OP::OP_ADD);
+    EXPECT_FALSE(hit.error);
+    hit = cache.find(R"({"action":"div","arg1":1,"arg2":0})", value);
+    EXPECT_STREQ(value, R"({"errno":33,"error":"division by zero"})");
+    EXPECT_TRUE(hit.error);
+
+    // Ключ - точные байты запроса
+    EXPECT_EQ(cache.find(R"({"action":"add","arg1":1,"arg2":2} )", value).size, 0u);
+    EXPECT_EQ(cache.find(R"({"action":"add","arg1":1,"arg2":3})", value).size, 0u);
+
+    std::string const long_request(ResultCache::M_KEY_SIZE + 1, ' ');
+    std::string const long_value(ResultCache::M_VALUE_SIZE + 1, '1');
+    cache.insert(long_request, "{}", OP::OP_ADD, false);
+    cache.insert("{}", long_value, OP::OP_ADD, false);
+    EXPECT_EQ(cache.find(long_request, value).size, 0u);
+    EXPECT_EQ(cache.find("{}", value).size, 0u);
+}
+
+// Тест: CLOCK вытесняет запись без бита обращения, запрошенные после вставки записи остаются
+TEST(ResultCacheTest, ClockEviction) {
+    // Одна запись на набор ассоциативности: все ключи попадают в один набор
+    ResultCache cache(ResultCache::M_WAYS);
+    char value[ResultCache::M_VALUE_SIZE + 1];
+    for (std::size_t i = 0; i < ResultCache::M_WAYS; ++i) {
+        EXPECT_FALSE(cache.insert("request " + std::to_string(i), std::to_string(i), OP::OP_ADD, false));
+    }
+    ASSERT_NE(cache.find("request 0", value).size, 0u);
+    ASSERT_NE(cache.find("request 1", value).size, 0u);
+
+    EXPECT_TRUE(cache.insert("request new", "new", OP::OP_ADD, false));
+    EXPECT_EQ(cache.find("request 2", value).size, 0u);
+    EXPECT_NE(cache.find("request 0", value).size, 0u);
+    EXPECT_NE(cache.find("request 1", value).size, 0u);
+    EXPECT_NE(cache.find("request 3", value).size, 0u);
+    EXPECT_NE(cache.find("request new", value).size, 0u);
+
+    // Повторная вставка того же запроса обновляет запись, а не вытесняет другую
+    EXPECT_FALSE(cache.insert("request new", "newer", OP::OP_ADD, false));
+    cache.find("request new", value);
+    EXPECT_STREQ(value, "newer");
+}
+
+// Тест: Параллельные вставки и поиски из нескольких потоков не возвращают чужих ответов
+TEST(ResultCacheTest, Concurrent) {
+    ResultCache cache(256);
+    std::atomic<uint64_t> hits{0};
+    std::atomic<bool> mismatch{false};
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t) {
+        threads.emplace_back([&, t]() {
+            char value[ResultCache::M_VALUE_SIZE + 1];
+            for (unsigned i = 0; i < 20000; ++i) {
+                unsigned const key = (i * 7 + t * 13) % 1024;
+                std::string const request = "request " + std::to_string(key);
+                if (cache.find(request, value).size != 0) {
+                    hits.fetch_add(1, std::memory_order_relaxed);
+                    if (std::to_string(key) != value) {
+                        mismatch.store(true);
+                    }
+                } else {
+                    cache.insert(request, std::to_string(key), OP::OP_ADD, false);
+                }
+            }
+        });
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    EXPECT_FALSE(mismatch.load());
+    EXPECT_GT(hits.load(), 0u);
+}
+
+/**
+ * @brief Два сервера с общим кэшем (как рабочие потоки пула) и клиент каждого из них.
+ */
+class ResultCacheServerTest : public ::testing::Test {
+   protected:
+    /**
+     * @brief Отправляет JSON-запрос через клиента i и возвращает ответ.
+     */
+    std::string request(std::size_t i, nlohmann::json const &request) {
+        std::string payload;
+        m_clients[i]->send_request_async(request, [&](netlink::client::Response const &response) { payload = response.payload; });
+        m_clients[i]->wait_for_response();
+        return payload;
+    }
+
+    std::shared_ptr<ResultCache> m_cache = std::make_shared<ResultCache>(1024);
+    tests::ServerThread m_peers[2] = {tests::ServerThread(4, m_cache), tests::ServerThread(4, m_cache)};
+    netlink::client::Client *m_clients[2] = {&m_peers[0].connect(16), &m_peers[1].connect(16)};
+};
+
+// Тест: Повторный запрос обслуживается из кэша, в том числе другим сервером, с тем же ответом
+TEST_F(ResultCacheServerTest, RepeatedRequests) {
+    nlohmann::json const add = {{"action", "add"}, {"arg1", 40}, {"arg2", 2}};
+    nlohmann::json const wide = {{"action", "mul"}, {"type", "int128"}, {"arg1", "9223372036854775807"}, {"arg2", 4}};
+    nlohmann::json const division = {{"action", "div"}, {"arg1", 1}, {"arg2", 0}};
+    nlohmann::json const invalid = {{"action", "pow"}, {"arg1", 1}, {"arg2", 0}};
+
+    EXPECT_EQ(request(0, add), R"({"result":42})");
+    EXPECT_EQ(request(0, wide), R"({"result":"36893488147419103228"})");
+    EXPECT_EQ(request(0, division), R"({"errno":33,"error":"division by zero"})");
+    std::string const invalid_reply = request(0, invalid);
+
+    auto const &stats = m_peers[1].server().stats();
+    EXPECT_EQ(request(1, add), R"({"result":42})");
+    EXPECT_EQ(request(1, wide), R"({"result":"36893488147419103228"})");
+    EXPECT_EQ(request(1, division), R"({"errno":33,"error":"division by zero"})");
+    EXPECT_EQ(stats.get(Counter::CACHE_HITS), 3u);
+    EXPECT_EQ(stats.get(Counter::CACHE_MISSES), 0u);
+    EXPECT_EQ(stats.get(Counter::REQUESTS_ADD), 1u);
+    EXPECT_EQ(stats.get(Counter::REQUESTS_MUL), 1u);
+    EXPECT_EQ(stats.get(Counter::ARITHMETIC_ERRORS), 1u);
+
+    // Ошибки разбора и неизвестные действия не кэшируются
+    EXPECT_EQ(request(1, invalid), invalid_reply);
+    EXPECT_EQ(stats.get(Counter::CACHE_MISSES), 1u);
+    EXPECT_EQ(m_peers[0].server().stats().get(Counter::CACHE_MISSES), 4u);
+    EXPECT_EQ(m_peers[0].server().stats().get(Counter::CACHE_HITS), 0u);
+}
+
+} // namespace
@@ -0,0 +1,167 @@
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <stdexcept>
+#include <vector>
+
+#include "../client/coroutine.hpp"
+#include "../transport/shm_channel.hpp"
+#include "test_server.hpp"
+
+namespace {
+
+using netlink::client::OP;
+using netlink::client::Response;
+using netlink::transport::ShmChannel;
+using netlink::transport::ShmReply;
+using netlink::transport::ShmRequest;
+
+/**
+ * @brief Сервер в отдельном потоке и клиент поверх внутрипроцессного транспорта.
+ */
+class ShmTest : public ::testing::Test {
+   protected:
+    tests::ServerThread m_peer;
+    netlink::client::Client &m_client = m_peer.connect(64);
+};
+
+netlink::client::Task<void> chain(netlink::client::Scheduler &scheduler, int64_t value, int &completed) {
+    Response sum = co_await scheduler.add(value, 1);
+    Response product = co_await scheduler.mul(sum.result, 3);
+    EXPECT_EQ(product.result, (value + 1) * 3);
+    ++completed;
+}
+
+} // namespace
+
+// Тест: Очереди канала сохраняют порядок записей, ограничены емкостью и сообщают о закрытии другой стороны
+TEST(ShmChannelTests, Queues) {
+    auto client = ShmChannel::create(5);
+    EXPECT_EQ(client->capacity(), 8u);
+    auto server = ShmChannel::open(client->name());
+    EXPECT_EQ(server->capacity(), 8u);
+    // Имя удаляется при открытии: второй раз канал не открыть
+    EXPECT_THROW(ShmChannel::open(client->name()), std::runtime_error);
+
+    // Несколько кругов, чтобы позиции переходили через конец очереди
+    for (uint32_t round = 0; round < 5; ++round) {
+        ShmRequest requests[10];
+        for (uint32_t i = 0; i < 10; ++i) {
+            requests[i].id = round * 10 + i;
+            requests[i].arg1 = i;
+        }
+        ASSERT_EQ(client->push_requests(requests, 10), 8u);
+        ASSERT_TRUE(server->wait(std::chrono::milliseconds(0)));
+
+        ShmRequest received[10];
+        ASSERT_EQ(server->pop_requests(received, 10), 8u);
+        for (uint32_t i = 0; i < 8; ++i) {
+            EXPECT_EQ(received[i].id, round * 10 + i);
+            EXPECT_EQ(received[i].arg1, i);
+        }
+        ShmReply reply;
+        reply.id = round;
+        ASSERT_EQ(server->push_replies(&reply, 1), 1u);
+        ShmReply replies[2];
+        ASSERT_EQ(client->pop_replies(replies, 2), 1u);
+        EXPECT_EQ(replies[0].id, round);
+    }
+    EXPECT_FALSE(client->wait(std::chrono::milliseconds(1)));
+
+    EXPECT_FALSE(server->peer_closed());
+    client.reset();
+    EXPECT_TRUE(server->peer_closed());
+}
+
+// Тест: Сервер открывает только каналы с префиксом NAME_PREFIX
+TEST(ShmChannelTests, RejectsInvalidNames) {
+    EXPECT_THROW(ShmChannel::open("/dev_shm_other"), std::runtime_error);
+    EXPECT_THROW(ShmChannel::open(std::string(ShmChannel::NAME_PREFIX) + "x/y"), std::runtime_error);
+    EXPECT_THROW(ShmChannel::open(std::string(ShmChannel::NAME_PREFIX) + "missing"), std::runtime_error);
+}
+
+// Тест: После согласования операции идут через общую память, а JSON-запросы по-прежнему через транспорт
+TEST_F(ShmTest, ClientUsesSharedMemory) {
+    ASSERT_TRUE(m_client.enable_shm(16));
+    EXPECT_TRUE(m_client.shm_enabled());
+
+    int completed = 0;
+    std::string payload;
+    for (int i = 0; i < 1000; ++i) {
+        m_client.calc_async(OP::OP_SUB, i, 5, [&completed, i](Response const &response) {
+            EXPECT_EQ(response.error, 0);
+            EXPECT_EQ(response.result, i - 5);
+            ++completed;
+        });
+        if (i == 500) {
+            m_client.send_request_async({{"action", "add"}, {"arg1", 1}, {"arg2", 2}}, [&payload](Response const &response) { payload = response.payload; });
+        }
+    }
+    m_client.wait_for_response();
+
+    EXPECT_EQ(completed, 1000);
+    EXPECT_EQ(payload, "{\"result\":3}");
+    EXPECT_EQ(m_client.in_flight(), 0u);
+    auto const &stats = m_peer.server().stats();
+    EXPECT_EQ(stats.get(netlink::server::Counter::SHM_CHANNELS), 1u);
+    // Согласование канала и один JSON-запрос
+    EXPECT_EQ(stats.get(netlink::server::Counter::MESSAGES_IN), 2u);
+}
+
+// Тест: Отмененная операция в общей памяти не вызывает обработчик и не занимает окно
+TEST_F(ShmTest, Cancel) {
+    ASSERT_TRUE(m_client.enable_shm());
+    // calc_async отклоняет неизвестные операции до отправки
+    EXPECT_THROW(m_client.calc_async(OP::OP_MAX, 1, 1, [](Response const &) {}), std::runtime_error);
+
+    bool called = false;
+    uint32_t seq = m_client.calc_async(OP::OP_ADD, 1, 1, [&called](Response const &) { called = true; });
+    EXPECT_TRUE(m_client.cancel(seq));
+    EXPECT_FALSE(m_client.cancel(seq));
+    EXPECT_EQ(m_client.in_flight(), 0u);
+
+    int64_t result = 0;
+    m_client.calc_async(OP::OP_MUL, 4, 5, [&result](Response const &response) { result = response.result; });
+    m_client.wait_for_response();
+    EXPECT_EQ(result, 20);
+    EXPECT_FALSE(called);
+}
+
+// Тест: Сервер отказывает в канале с неверным именем, клиент продолжает работать через транспорт
+TEST_F(ShmTest, ServerRejectsInvalidChannel) {
+    std::string payload;
+    m_client.send_request_async({{"shm", "/not_a_channel"}}, [&payload](Response const &response) { payload = response.payload; });
+    m_client.wait_for_response();
+    EXPECT_EQ(payload, "Invalid shared memory name");
+    EXPECT_FALSE(m_client.shm_enabled());
+    EXPECT_EQ(m_peer.server().stats().get(netlink::server::Counter::SHM_CHANNELS), 0u);
+}
+
+// Тест: Сервер обслуживает не больше M_MAX_SHM_SESSIONS каналов, следующий клиент остается на транспорте
+TEST_F(ShmTest, ServerLimitsSessions) {
+    std::vector<std::unique_ptr<ShmChannel>> channels;
+    for (int i = 0; i < 16; ++i) {
+        channels.push_back(ShmChannel::create(8));
+        std::string payload;
+        m_client.send_request_async({{"shm", channels.back()->name()}}, [&payload](Response const &response) { payload = response.payload; });
+        m_client.wait_for_response();
+        ASSERT_EQ(payload, R"({"result":0})");
+    }
+    EXPECT_FALSE(m_client.enable_shm());
+    EXPECT_EQ(m_peer.server().stats().get(netlink::server::Counter::SHM_CHANNELS), 16u);
+}
+
+// Тест: Корутины ожидают ответы из общей памяти
+TEST_F(ShmTest, Coroutines) {
+    ASSERT_TRUE(m_client.enable_shm());
+    int completed = 0;
+    {
+        netlink::client::Scheduler scheduler(m_client);
+        for (int i = 0; i < 300; ++i) {
+            scheduler.spawn(chain(scheduler, i, completed));
+        }
+        scheduler.run();
+    }
+    EXPECT_EQ(completed, 300);
+    EXPECT_EQ(m_peer.server().stats().get(netlink::server::Counter::MESSAGES_IN), 1u);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <string>
+
+#include "../server/stats_endpoint.hpp"
+#include "test_server.hpp"
+
+// Тест: Счетчики и гистограммы учитывают запросы всех форматов
+TEST(StatsTests, CountsRequests) {
+    tests::ServerThread peer;
+    {
+        netlink::client::Client &client = peer.connect(netlink::client::Client::DEFAULT_MAX_IN_FLIGHT);
+        auto ignore = [](netlink::client::Response const &) {};
+        client.calc_async(netlink::client::OP::OP_ADD, 1, 2, ignore);
+        client.calc_async(netlink::client::OP::OP_MUL, 3, 4, ignore);
+        client.send_request_async({{"action", "sub"}, {"arg1", 5}, {"arg2", 6}}, ignore);
+        client.send_request_async({{"action", "pow"}, {"arg1", 5}, {"arg2", 6}}, ignore);
+        client.send_batch_async({{{"action", "add"}, {"arg1", 1}, {"arg2", 1}}, {{"arg1", 1}}}, [](std::size_t, netlink::client::Response const &) {});
+        client.wait_for_response();
+    }
+    peer.stop();
+
+    nlohmann::json stats = netlink::server::Stats::to_json({&peer.server().stats()});
+    auto const &counters = stats.at("counters");
+    EXPECT_EQ(stats.at("workers"), 1);
+    EXPECT_EQ(counters.at("requests_add"), 2);
+    EXPECT_EQ(counters.at("requests_sub"), 1);
+    EXPECT_EQ(counters.at("requests_mul"), 1);
+    EXPECT_EQ(counters.at("requests_invalid"), 1);
+    EXPECT_EQ(counters.at("requests_binary"), 2);
+    EXPECT_EQ(counters.at("requests_json"), 2);
+    EXPECT_EQ(counters.at("requests_batch"), 1);
+    EXPECT_EQ(counters.at("parse_errors"), 1);
+    EXPECT_EQ(counters.at("messages_in"), 5);
+    EXPECT_EQ(counters.at("messages_out"), 5);
+    EXPECT_GT(counters.at("bytes_in").get<uint64_t>(), 0u);
+    EXPECT_GT(counters.at("bytes_out").get<uint64_t>(), 0u);
+    EXPECT_EQ(stats.at("processing_time_ns").at("count"), 5);
+    EXPECT_EQ(stats.at("queue_depth").at("count"), counters.at("receive_calls"));
+    EXPECT_LE(counters.at("receive_calls").get<uint64_t>(), counters.at("datagrams_in").get<uint64_t>());
+    EXPECT_EQ(stats.at("per_worker").size(), 1u);
+}
+
+// Тест: Сокет статистики отдает снимок одной строкой JSON
+TEST(StatsTests, EndpointServesSnapshot) {
+    std::string const path = "/tmp/calc_stats_test_" + std::to_string(getpid()) + ".sock";
+    netlink::server::StatsEndpoint endpoint(path, []() { return nlohmann::json{{"requests", 42}}; });
+
+    for (int i = 0; i < 2; ++i) {
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        ASSERT_GE(fd, 0);
+        struct sockaddr_un addr {};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+        ASSERT_EQ(connect(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)), 0);
+
+        std::string reply;
+        char buffer[256];
+        ssize_t len = 0;
+        while ((len = read(fd, buffer, sizeof(buffer))) > 0) {
+            reply.append(buffer, static_cast<std::size_t>(len));
+        }
+        close(fd);
+        EXPECT_EQ(reply, "{\"requests\":42}\n");
+    }
+}
@@ -0,0 +1,153 @@
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "test_server.hpp"
+
+namespace {
+
+using netlink::client::ATTR;
+using netlink::client::Response;
+
+/**
+ * @brief Сервер в отдельном потоке и клиент (или сырой транспорт) поверх внутрипроцессного транспорта.
+ */
+class StreamTest : public ::testing::Test {
+   protected:
+    /**
+     * @brief Отправляет фрагмент потока напрямую через транспорт и возвращает атрибут ответа: ATTR_ERRNO или 0 для подтверждения.
+     */
+    int send_chunk(uint32_t seq, uint32_t stream, uint32_t chunk, std::string const &data, bool eos) {
+        std::size_t const size = nlmsg_total_size(GENL_HDRLEN + 3 * nla_total_size(sizeof(uint32_t)) + nla_total_size(data.size()));
+        std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc_size(size), nlmsg_free);
+        genlmsg_put(msg.get(), NL_AUTO_PORT, seq, netlink::transport::InProcessTransport::FAMILY_ID, 0, NLM_F_REQUEST, 1, 1);
+        nla_put_u32(msg.get(), static_cast<int>(ATTR::ATTR_STREAM), stream);
+        nla_put_u32(msg.get(), static_cast<int>(ATTR::ATTR_CHUNK), chunk);
+        nla_put(msg.get(), static_cast<int>(ATTR::ATTR_DATA), static_cast<int>(data.size()), data.data());
+        if (eos) {
+            nla_put_flag(msg.get(), static_cast<int>(ATTR::ATTR_EOS));
+        }
+        struct nlmsghdr *nlh = nlmsg_hdr(msg.get());
+        EXPECT_EQ(m_peer.transport().send(nlh, nlh->nlmsg_len), 0);
+
+        std::vector<char> buffer(65536);
+        ssize_t length = m_peer.transport().receive(buffer.data(), buffer.size());
+        EXPECT_GT(length, 0);
+        auto *reply = reinterpret_cast<struct nlmsghdr *>(buffer.data());
+        EXPECT_EQ(reply->nlmsg_seq, seq);
+        struct nlattr *attrs[static_cast<int>(ATTR::ATTR_MAX) + 1];
+        EXPECT_EQ(genlmsg_parse(reply, 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr), 0);
+        if (attrs[static_cast<int>(ATTR::ATTR_ERRNO)]) {
+            return nla_get_s32(attrs[static_cast<int>(ATTR::ATTR_ERRNO)]);
+        }
+        EXPECT_NE(attrs[static_cast<int>(ATTR::ATTR_STREAM)], nullptr);
+        return 0;
+    }
+
+    tests::ServerThread m_peer;
+};
+
+} // namespace
+
+// Тест: Запрос и ответ в несколько мегабайт передаются фрагментами и собираются целиком
+TEST_F(StreamTest, LargeRequest) {
+    netlink::client::Client &client = m_peer.connect(8);
+    constexpr std::size_t M_COUNT = 300000;
+    std::vector<int64_t> arg1(M_COUNT), arg2(M_COUNT);
+    for (std::size_t i = 0; i < M_COUNT; ++i) {
+        arg1[i] = static_cast<int64_t>(i) * 1000003;
+        arg2[i] = -static_cast<int64_t>(i);
+    }
+    std::string const request = nlohmann::json{{"action", "add"}, {"arg1", arg1}, {"arg2", arg2}}.dump();
+    ASSERT_GT(request.size(), 4u << 20);
+
+    Response response;
+    int calls = 0;
+    client.send_stream_async(request, [&](Response const &reply) {
+        response = reply;
+        ++calls;
+    });
+    client.wait_for_response();
+
+    EXPECT_EQ(calls, 1);
+    ASSERT_EQ(response.error, 0);
+    nlohmann::json reply = nlohmann::json::parse(response.payload);
+    ASSERT_EQ(reply["result"].size(), M_COUNT);
+    for (std::size_t i = 0; i < M_COUNT; i += 997) {
+        EXPECT_EQ(reply["result"][i].get<int64_t>(), static_cast<int64_t>(i) * 1000002);
+    }
+
+    auto const &stats = m_peer.server().stats();
+    EXPECT_EQ(stats.get(netlink::server::Counter::REQUESTS_STREAM), 1u);
+    EXPECT_EQ(stats.get(netlink::server::Counter::STREAM_CHUNKS), (request.size() + 16383) / 16384);
+    EXPECT_EQ(client.in_flight(), 0u);
+}
+
+// Тест: Короткие запросы, ошибки JSON и несколько потоков подряд
+TEST_F(StreamTest, SmallAndInvalidRequests) {
+    netlink::client::Client &client = m_peer.connect(4);
+    std::vector<std::string> payloads;
+    auto collect = [&payloads](Response const &response) {
+        EXPECT_EQ(response.error, 0);
+        payloads.push_back(response.payload);
+    };
+    client.send_stream_async(R"({"action":"mul","arg1":6,"arg2":7})", collect);
+    client.send_stream_async(R"({"action":"pow","arg1":6,"arg2":7})", collect);
+    client.send_stream_async("", collect);
+    client.wait_for_response();
+
+    ASSERT_EQ(payloads.size(), 3u);
+    EXPECT_EQ(payloads[0], R"({"result":42})");
+    EXPECT_EQ(payloads[1], "Invalid action. Supported actions are 'add', 'sub', 'mul', 'div', 'mod'");
+    EXPECT_EQ(payloads[2].find("result"), std::string::npos);
+    EXPECT_EQ(m_peer.server().stats().get(netlink::server::Counter::REQUESTS_STREAM), 3u);
+}
+
+// Тест: Пропущенный фрагмент и фрагмент неизвестного потока отклоняются, ошибка сообщается до конца потока
+TEST_F(StreamTest, ServerRejectsBrokenStreams) {
+    EXPECT_EQ(send_chunk(1, 5, 0, R"({"action":)", false), 0);
+    EXPECT_EQ(send_chunk(2, 5, 2, R"("add")", false), EPROTO);
+    EXPECT_EQ(send_chunk(3, 5, 3, R"(,"arg1":1,"arg2":2})", true), EPROTO);
+    // Поток закрыт последним фрагментом
+    EXPECT_EQ(send_chunk(4, 5, 4, "", false), ENOENT);
+    EXPECT_EQ(send_chunk(5, 9, 1, "", true), ENOENT);
+
+    // Повторный первый фрагмент начинает поток заново
+    EXPECT_EQ(send_chunk(6, 6, 0, "garbage", false), 0);
+    EXPECT_EQ(send_chunk(7, 6, 0, R"({"action":"sub",)", false), 0);
+    EXPECT_EQ(send_chunk(8, 6, 1, R"("arg1":1,)", false), 0);
+    EXPECT_EQ(m_peer.server().stats().get(netlink::server::Counter::REQUESTS_STREAM), 0u);
+}
+
+// Тест: Собираемые потоки рабочего потока вместе не занимают больше M_STREAM_BUDGET (32 МиБ)
+TEST_F(StreamTest, ServerLimitsStreamMemory) {
+    std::string const block(16384, ' ');
+    uint32_t seq = 1;
+    // Два незавершенных потока почти по 16 МиБ (M_STREAM_MAX_SIZE) занимают почти весь бюджет
+    for (uint32_t stream = 1; stream <= 2; ++stream) {
+        for (uint32_t chunk = 0; chunk < 1023; ++chunk) {
+            ASSERT_EQ(send_chunk(seq++, stream, chunk, block, false), 0);
+        }
+    }
+    EXPECT_EQ(send_chunk(seq++, 3, 0, block, false), 0);
+    EXPECT_EQ(send_chunk(seq++, 3, 1, block, false), 0);
+    EXPECT_EQ(send_chunk(seq++, 3, 2, block, false), ENOBUFS);
+    EXPECT_EQ(send_chunk(seq++, 3, 3, block, false), ENOBUFS);
+    // Память отклоненного потока освобождена: новый поток помещается в бюджет
+    EXPECT_EQ(send_chunk(seq++, 4, 0, block, false), 0);
+    EXPECT_EQ(send_chunk(seq++, 4, 1, block, false), 0);
+    EXPECT_EQ(send_chunk(seq++, 4, 2, block, false), ENOBUFS);
+}
+
+// Тест: Семейство без поддержки потоков
+TEST(StreamVersionTests, RequiresStreamVersion) {
+    auto [client_transport, server_transport] = netlink::transport::InProcessTransport::create_pair(
+        netlink::transport::InProcessTransport::DEFAULT_CAPACITY, netlink::client::Client::ARRAY_PROTOCOL_VERSION);
+    netlink::client::Client client(std::move(client_transport));
+    EXPECT_THROW(client.send_stream_async("{}", [](Response const &) {}), std::runtime_error);
+    EXPECT_EQ(client.in_flight(), 0u);
+}
@@ -1,6 +1,8 @@
 #include <gtest/gtest.h>
 
-#include "../server/server.hpp"
+#include "../common/json_writer.hpp"
+#include "../common/string_attribute.hpp"
+#include "test_server.hpp"
 
 // Дружественный тестовый класс
 namespace tests {
@@ -9,12 +11,18 @@ class ServerTest_Friend {
     static nlohmann::json test_process_request(netlink::server::Server &server, const std::string &request) {
         return server.process_request(request); // Доступ к private-методу
     }
+    static std::vector<std::string> test_process_batch(netlink::server::Server &server, struct nlattr *batch) {
+        return server.process_batch(batch);
+    }
+    static netlink::server::BinaryResult test_process_binary(netlink::server::Server &server, struct nlattr **attrs) {
+        return server.process_binary(attrs);
+    }
 };
 } // namespace tests
 
 // Тест: Проверка корректной обработки действия "add"
 TEST(ServerTests, ProcessValidAddRequest) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string valid_request = R"({"action": "add", "arg1": 3, "arg2": 5})";
     nlohmann::json expected_response = {{"result", 8}};
@@ -25,7 +33,7 @@ TEST(ServerTests, ProcessValidAddRequest) {
 
 // Тест: Проверка корректной обработки действия "sub"
 TEST(ServerTests, ProcessValidSubRequest) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string valid_request = R"({"action": "sub", "arg1": 10, "arg2": 3})";
     nlohmann::json expected_response = {{"result", 7}};
@@ -36,7 +44,7 @@ TEST(ServerTests, ProcessValidSubRequest) {
 
 // Тест: Проверка корректной обработки действия "mul"
 TEST(ServerTests, ProcessValidMulRequest) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string valid_request = R"({"action": "mul", "arg1": 4, "arg2": 5})";
     nlohmann::json expected_response = {{"result", 20}};
@@ -47,7 +55,7 @@ TEST(ServerTests, ProcessValidMulRequest) {
 
 // Тест: Некорректный запрос — отсутствует "action"
 TEST(ServerTests, ProcessMissingActionField) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string invalid_request = R"({"arg1": 3, "arg2": 5})";
 
@@ -56,16 +64,16 @@ TEST(ServerTests, ProcessMissingActionField) {
 
 // Тест: Некорректное действие (неизвестное значение "action")
 TEST(ServerTests, ProcessUnknownAction) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
-    std::string invalid_request = R"({"action": "div", "arg1": 10, "arg2": 2})";
+    std::string invalid_request = R"({"action": "pow", "arg1": 10, "arg2": 2})";
 
     EXPECT_THROW(tests::ServerTest_Friend::test_process_request(server, invalid_request), std::runtime_error);
 }
 
 // Тест: Некорректный JSON (синтаксическая ошибка)
 TEST(ServerTests, ProcessInvalidJson) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string invalid_request = R"({"action": "add", "arg1": 3, "arg2": )"; // Неполный JSON
 
@@ -74,7 +82,7 @@ TEST(ServerTests, ProcessInvalidJson) {
 
 // Тест: Некорректные аргументы (отсутствует "arg1")
 TEST(ServerTests, ProcessMissingArg1Field) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string invalid_request = R"({"action": "add", "arg2": 5})";
 
@@ -83,7 +91,7 @@ TEST(ServerTests, ProcessMissingArg1Field) {
 
 // Тест: Некорректные аргументы (отсутствует "arg2")
 TEST(ServerTests, ProcessMissingArg2Field) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string invalid_request = R"({"action": "add", "arg1": 3})";
 
@@ -92,7 +100,7 @@ TEST(ServerTests, ProcessMissingArg2Field) {
 
 // Тест: Неподдерживаемый тип аргументов (строка вместо числа)
 TEST(ServerTests, ProcessInvalidArgType) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string invalid_request = R"({"action": "add", "arg1": "three", "arg2": 5})";
 
@@ -101,7 +109,7 @@ TEST(ServerTests, ProcessInvalidArgType) {
 
 // Тест: Аргументы равны нулю (пограничный случай)
 TEST(ServerTests, ProcessZeroArguments) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string valid_request = R"({"action": "add", "arg1": 0, "arg2": 0})";
     nlohmann::json expected_response = {{"result", 0}};
@@ -112,11 +120,206 @@ TEST(ServerTests, ProcessZeroArguments) {
 
 // Тест: Аргументы с отрицательными числами
 TEST(ServerTests, ProcessNegativeArguments) {
-    netlink::server::Server server;
+    tests::TestServer server;
 
     std::string valid_request = R"({"action": "add", "arg1": -3, "arg2": -5})";
     nlohmann::json expected_response = {{"result", -8}};
 
     auto response = tests::ServerTest_Friend::test_process_request(server, valid_request);
     EXPECT_EQ(response, expected_response);
-}
\ No newline at end of file
+}
+
+// Тест: Пакет операций обрабатывается целиком, ошибка одной операции не прерывает остальные
+TEST(ServerTests, ProcessBatch) {
+    tests::TestServer server;
+
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    ASSERT_TRUE(msg);
+    struct nlattr *batch = nla_nest_start(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_BATCH));
+    ASSERT_NE(batch, nullptr);
+    ASSERT_EQ(nla_put_string(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), R"({"action": "add", "arg1": 3, "arg2": 5})"), 0);
+    ASSERT_EQ(nla_put_string(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), R"({"action": "pow", "arg1": 3, "arg2": 5})"), 0);
+    ASSERT_EQ(nla_put_string(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), R"({"action": "mul", "arg1": 4, "arg2": 5})"), 0);
+    nla_nest_end(msg.get(), batch);
+
+    auto responses = tests::ServerTest_Friend::test_process_batch(server, batch);
+    ASSERT_EQ(responses.size(), 3u);
+    EXPECT_EQ(nlohmann::json::parse(responses[0]), nlohmann::json({{"result", 8}}));
+    EXPECT_EQ(responses[1], "Invalid action. Supported actions are 'add', 'sub', 'mul', 'div', 'mod'");
+    EXPECT_EQ(nlohmann::json::parse(responses[2]), nlohmann::json({{"result", 20}}));
+}
+
+// Тест: Бинарный запрос обрабатывается без JSON, неизвестная операция возвращает EINVAL
+TEST(ServerTests, ProcessBinaryRequest) {
+    tests::TestServer server;
+    using netlink::server::ATTR;
+
+    auto make_request = [](uint8_t op, int64_t arg1, int64_t arg2) {
+        std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+        genlmsg_put(msg.get(), NL_AUTO_PORT, 1, 0x20, 0, 0, 1, 2);
+        nla_put_u8(msg.get(), static_cast<int>(ATTR::ATTR_OP), op);
+        nla_put_s64(msg.get(), static_cast<int>(ATTR::ATTR_ARG1), arg1);
+        nla_put_s64(msg.get(), static_cast<int>(ATTR::ATTR_ARG2), arg2);
+        return msg;
+    };
+    struct nlattr *attrs[static_cast<int>(ATTR::ATTR_MAX) + 1];
+
+    auto mul = make_request(static_cast<uint8_t>(netlink::server::OP::OP_MUL), 4000000000, -5);
+    ASSERT_EQ(genlmsg_parse(nlmsg_hdr(mul.get()), 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr), 0);
+    auto result = tests::ServerTest_Friend::test_process_binary(server, attrs);
+    EXPECT_EQ(result.error, 0);
+    EXPECT_EQ(result.value, -20000000000);
+
+    auto overflow = make_request(static_cast<uint8_t>(netlink::server::OP::OP_MUL), INT64_MAX, 2);
+    ASSERT_EQ(genlmsg_parse(nlmsg_hdr(overflow.get()), 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr), 0);
+    EXPECT_EQ(tests::ServerTest_Friend::test_process_binary(server, attrs).error, ERANGE);
+
+    auto division = make_request(static_cast<uint8_t>(netlink::server::OP::OP_DIV), 1, 0);
+    ASSERT_EQ(genlmsg_parse(nlmsg_hdr(division.get()), 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr), 0);
+    EXPECT_EQ(tests::ServerTest_Friend::test_process_binary(server, attrs).error, EDOM);
+
+    auto unknown = make_request(static_cast<uint8_t>(netlink::server::OP::OP_MAX), 1, 2);
+    ASSERT_EQ(genlmsg_parse(nlmsg_hdr(unknown.get()), 0, attrs, static_cast<int>(ATTR::ATTR_MAX), nullptr), 0);
+    EXPECT_EQ(tests::ServerTest_Friend::test_process_binary(server, attrs).error, EINVAL);
+}
+
+// Тест: Переполнение int64 и деление на ноль возвращаются ошибкой вычисления, а не неверным числом
+TEST(ServerTests, ProcessCheckedInt64) {
+    tests::TestServer server;
+    auto process = [&server](std::string const &request) { return tests::ServerTest_Friend::test_process_request(server, request); };
+    nlohmann::json const overflow = {{"errno", ERANGE}, {"error", "overflow"}};
+    nlohmann::json const division_by_zero = {{"errno", EDOM}, {"error", "division by zero"}};
+
+    EXPECT_EQ(process(R"({"action": "add", "arg1": 9223372036854775807, "arg2": 1})"), overflow);
+    EXPECT_EQ(process(R"({"action": "sub", "arg1": -9223372036854775808, "arg2": 1})"), overflow);
+    EXPECT_EQ(process(R"({"action": "mul", "arg1": 4294967296, "arg2": 4294967296})"), overflow);
+    EXPECT_EQ(process(R"({"action": "mul", "arg1": 3000000000, "arg2": 3})"), (nlohmann::json{{"result", 9000000000}}));
+    EXPECT_EQ(process(R"({"action": "div", "arg1": -9223372036854775808, "arg2": -1})"), overflow);
+    EXPECT_EQ(process(R"({"action": "div", "arg1": 7, "arg2": 0})"), division_by_zero);
+    EXPECT_EQ(process(R"({"action": "mod", "arg1": 7, "arg2": 0})"), division_by_zero);
+    EXPECT_EQ(process(R"({"action": "div", "arg1": -7, "arg2": 2})"), (nlohmann::json{{"result", -3}}));
+    EXPECT_EQ(process(R"({"action": "mod", "arg1": -7, "arg2": 3})"), (nlohmann::json{{"result", -1}}));
+    EXPECT_EQ(process(R"({"action": "mod", "arg1": -9223372036854775808, "arg2": -1})"), (nlohmann::json{{"result", 0}}));
+    // Аргумент вне диапазона int64 не усекается
+    EXPECT_THROW(process(R"({"action": "add", "arg1": 9223372036854775808, "arg2": 0})"), std::runtime_error);
+    EXPECT_THROW(process(R"({"action": "div", "arg1": [1], "arg2": [1]})"), std::runtime_error);
+    EXPECT_EQ(static_cast<netlink::server::Server &>(server).stats().get(netlink::server::Counter::ARITHMETIC_ERRORS), 6u);
+    EXPECT_EQ(static_cast<netlink::server::Server &>(server).stats().get(netlink::server::Counter::REQUESTS_DIV), 4u);
+}
+
+// Тест: Операции int128 принимают числа и десятичные строки, результат - десятичная строка
+TEST(ServerTests, ProcessInt128) {
+    tests::TestServer server;
+    auto process = [&server](std::string const &request) { return tests::ServerTest_Friend::test_process_request(server, request); };
+
+    EXPECT_EQ(process(R"({"action": "mul", "type": "int128", "arg1": 9223372036854775807, "arg2": 4})"),
+              (nlohmann::json{{"result", "36893488147419103228"}}));
+    EXPECT_EQ(process(R"({"action": "add", "type": "int128", "arg1": "-170141183460469231731687303715884105728", "arg2": 1})"),
+              (nlohmann::json{{"result", "-170141183460469231731687303715884105727"}}));
+    EXPECT_EQ(process(R"({"action": "sub", "type": "int128", "arg1": "-170141183460469231731687303715884105728", "arg2": 1})"),
+              (nlohmann::json{{"errno", ERANGE}, {"error", "overflow"}}));
+    EXPECT_EQ(process(R"({"action": "div", "type": "int128", "arg1": "100000000000000000000000", "arg2": 18446744073709551615})"),
+              (nlohmann::json{{"result", "5421"}}));
+    EXPECT_EQ(process(R"({"action": "mod", "type": "int128", "arg1": "0", "arg2": "0"})"),
+              (nlohmann::json{{"errno", EDOM}, {"error", "division by zero"}}));
+    EXPECT_EQ(process(R"({"action": "add", "type": "int64", "arg1": 1, "arg2": 2})"), (nlohmann::json{{"result", 3}}));
+
+    EXPECT_THROW(process(R"({"action": "add", "type": "int128", "arg1": "170141183460469231731687303715884105728", "arg2": 0})"),
+                 std::runtime_error);
+    EXPECT_THROW(process(R"({"action": "add", "type": "int128", "arg1": "12a", "arg2": 0})"), std::runtime_error);
+    EXPECT_THROW(process(R"({"action": "add", "type": "int128", "arg1": "-", "arg2": 0})"), std::runtime_error);
+    EXPECT_THROW(process(R"({"action": "add", "type": "int32", "arg1": 1, "arg2": 0})"), std::runtime_error);
+    EXPECT_THROW(process(R"({"action": "add", "type": "int128", "arg1": [1], "arg2": [0]})"), std::runtime_error);
+}
+
+// Тест: Реестр операций находит каждое действие по имени и по коду, другие имена не находит
+TEST(OperationRegistryTests, FindOperation) {
+    using netlink::server::find_operation;
+    using netlink::server::OP;
+
+    for (auto const &operation : netlink::server::M_OPERATIONS) {
+        ASSERT_EQ(find_operation(operation.name), &operation);
+        ASSERT_EQ(find_operation(operation.op), &operation);
+    }
+    static_assert(find_operation("mod")->op == OP::OP_MOD);
+    static_assert(find_operation(OP::OP_DIV)->int64(-7, 2).value == -3);
+    for (std::string_view name : {"", "ad", "addd", "Add", "pow", "adD", "mul "}) {
+        EXPECT_EQ(find_operation(name), nullptr) << name;
+    }
+    EXPECT_EQ(find_operation(OP::OP_UNSPEC), nullptr);
+    EXPECT_EQ(find_operation(OP::OP_MAX), nullptr);
+    EXPECT_EQ(find_operation(static_cast<OP>(200)), nullptr);
+    EXPECT_EQ(netlink::server::supported_actions(), "'add', 'sub', 'mul', 'div', 'mod'");
+    EXPECT_EQ(netlink::server::supported_actions(true), "'add', 'sub', 'mul'");
+}
+
+// Тест: Совершенная хеш-функция строится при компиляции и для большого набора имен
+TEST(OperationRegistryTests, PerfectHash) {
+    static constexpr std::array<std::string_view, 12> M_NAMES = {"a",  "b",  "ab", "ba", "abc", "cba", "x0",
+                                                                 "x1", "x2", "x3", "long_name", "long_namf"};
+    static constexpr netlink::server::PerfectHash<M_NAMES.size()> M_HASH{M_NAMES};
+    for (std::size_t i = 0; i < M_NAMES.size(); ++i) {
+        EXPECT_EQ(M_HASH.find(std::string(M_NAMES[i])), static_cast<int>(i));
+    }
+    EXPECT_EQ(M_HASH.find("x4"), M_HASH.M_NOT_FOUND);
+    EXPECT_EQ(M_HASH.find("long_nam"), M_HASH.M_NOT_FOUND);
+    static_assert(M_HASH.find("cba") == 5);
+}
+
+// Тест: JsonWriter пишет тот же текст, что nlohmann::json::dump, и сообщает о переполнении буфера
+TEST(JsonWriterTests, MatchesDump) {
+    char buffer[256];
+    netlink::common::JsonWriter writer(buffer, sizeof(buffer));
+    writer.begin_object().key("errno").value(int64_t{33}).key("error").value("say \"hi\"\\\n\x01").key("offset").value(INT64_MIN);
+    writer.key("result").begin_array().value(int64_t{1}).value(int64_t{-2}).begin_array().end_array().value(INT64_MAX).end_array().end_object();
+    ASSERT_TRUE(writer.ok());
+    nlohmann::json const expected = {
+        {"errno", 33}, {"error", "say \"hi\"\\\n\x01"}, {"offset", INT64_MIN}, {"result", {1, -2, nlohmann::json::array(), INT64_MAX}}};
+    EXPECT_EQ(std::string_view(buffer, writer.size()), expected.dump());
+
+    netlink::common::JsonWriter small(buffer, 8);
+    small.begin_object().key("result").value(int64_t{12345}).end_object();
+    EXPECT_FALSE(small.ok());
+    EXPECT_LE(small.size(), 8u);
+}
+
+// Тест: StringAttribute укорачивает зарезервированный атрибут, после него можно добавлять атрибуты
+TEST(JsonWriterTests, StringAttribute) {
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(msg.get(), NL_AUTO_PORT, 1, 0x20, 0, 0, 2, 1);
+    netlink::common::StringAttribute text(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), 100);
+    ASSERT_TRUE(text);
+    std::memcpy(text.data(), "{\"result\":8}", 12);
+    text.finish(12);
+    ASSERT_EQ(nla_put_u32(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_OFFSET), 7), 0);
+    EXPECT_EQ(nlmsg_hdr(msg.get())->nlmsg_len, NLMSG_HDRLEN + GENL_HDRLEN + static_cast<uint32_t>(nla_total_size(13) + nla_total_size(4)));
+
+    struct nlattr *attrs[static_cast<int>(netlink::server::ATTR::ATTR_MAX) + 1];
+    ASSERT_EQ(genlmsg_parse(nlmsg_hdr(msg.get()), 0, attrs, static_cast<int>(netlink::server::ATTR::ATTR_MAX), nullptr), 0);
+    EXPECT_STREQ(nla_get_string(attrs[static_cast<int>(netlink::server::ATTR::ATTR_MSG)]), "{\"result\":8}");
+    EXPECT_EQ(nla_len(attrs[static_cast<int>(netlink::server::ATTR::ATTR_MSG)]), 13);
+    EXPECT_EQ(nla_get_u32(attrs[static_cast<int>(netlink::server::ATTR::ATTR_OFFSET)]), 7u);
+}
+
+// Тест: Быстрый разбор запроса без выделения памяти, нестандартные запросы уходят полному парсеру
+TEST(RequestParserTests, ParseAndFallback) {
+    using netlink::server::RequestParser;
+    netlink::server::ParsedRequest request;
+
+    ASSERT_EQ(RequestParser::parse(R"({"action": "mul", "arg1": -4, "arg2": 5})", request), RequestParser::Status::OK);
+    EXPECT_EQ(request.action, "mul");
+    EXPECT_EQ(request.arg1, -4);
+    EXPECT_EQ(request.arg2, 5);
+
+    EXPECT_EQ(RequestParser::parse(R"({"action": "add", "arg1": 3.5, "arg2": 5})", request), RequestParser::Status::FALLBACK);
+    EXPECT_EQ(RequestParser::parse(R"({"action": "add", "arg1": 3})", request), RequestParser::Status::FALLBACK);
+    EXPECT_EQ(RequestParser::parse(R"({"action": "add", "arg1": 3, "arg2": 5, "x": 1})", request), RequestParser::Status::FALLBACK);
+    EXPECT_EQ(RequestParser::parse(R"({"action": "add", "arg1": 3, "arg2": )", request), RequestParser::Status::FALLBACK);
+    EXPECT_EQ(RequestParser::parse(R"({"action": "add", "arg1": 9223372036854775808, "arg2": 5})", request), RequestParser::Status::FALLBACK);
+    ASSERT_EQ(RequestParser::parse(R"({"action": "add", "arg1": 3000000000, "arg2": 5})", request), RequestParser::Status::OK);
+    EXPECT_EQ(request.arg1, 3000000000);
+
+    char buffer[RequestParser::M_RESULT_BUFFER_SIZE];
+    ASSERT_GT(RequestParser::format_result(-42, buffer, sizeof(buffer)), 0u);
+    EXPECT_EQ(std::string(buffer), nlohmann::json({{"result", -42}}).dump());
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <memory>
+#include <thread>
+
+#include "../client/client.hpp"
+#include "../server/server.hpp"
+#include "../transport/inproc_transport.hpp"
+
+namespace tests {
+
+/**
+ * @brief Сервер поверх внутрипроцессного транспорта.
+ *
+ * Хранит клиентскую сторону транспорта, чтобы ответы сервера было куда отправить,
+ * и позволяет запускать тесты сервера без модуля ядра. Приводится к Server &.
+ */
+class TestServer final {
+   public:
+    TestServer() {
+        auto [client, server] = netlink::transport::InProcessTransport::create_pair();
+        m_peer = std::move(client);
+        m_server = std::make_unique<netlink::server::Server>(std::move(server));
+    }
+
+    operator netlink::server::Server &() { return *m_server; }
+
+    /**
+     * @brief Клиентская сторона транспорта.
+     */
+    netlink::transport::InProcessTransport &peer() { return *m_peer; }
+
+   private:
+    std::unique_ptr<netlink::transport::InProcessTransport> m_peer; // 8
+    std::unique_ptr<netlink::server::Server> m_server;              // 8
+};
+
+/**
+ * @brief Сервер в отдельном потоке и клиент (или сырой транспорт) поверх внутрипроцессного транспорта.
+ *
+ * Поток сервера выходит из цикла приема, когда клиентская сторона транспорта закрыта:
+ * в stop или в деструкторе.
+ */
+class ServerThread final {
+   public:
+    /**
+     * @brief Запускает сервер.
+     *
+     * @param version Версия протокола, которую транспорт сообщает клиенту.
+     * @param cache Кэш ответов сервера (задается до запуска потока) или nullptr.
+     */
+    explicit ServerThread(uint8_t version = 4, std::shared_ptr<netlink::server::ResultCache> cache = nullptr) {
+        using netlink::transport::InProcessTransport;
+        auto [client, server] = InProcessTransport::create_pair(InProcessTransport::DEFAULT_CAPACITY, version);
+        m_transport = std::move(client);
+        m_server = std::make_unique<netlink::server::Server>(std::move(server));
+        if (cache) {
+            m_server->set_result_cache(std::move(cache));
+        }
+        m_worker = std::thread([server = m_server.get()]() { server->wait_for_response(); });
+    }
+    ServerThread(ServerThread const &) = delete;
+    ServerThread &operator=(ServerThread const &) = delete;
+    ~ServerThread() { stop(); }
+
+    netlink::server::Server &server() { return *m_server; }
+    /**
+     * @brief Создает клиента поверх клиентской стороны транспорта (после этого transport недоступен).
+     */
+    netlink::client::Client &connect(std::size_t max_in_flight) {
+        m_client = std::make_unique<netlink::client::Client>(std::move(m_transport), max_in_flight);
+        return *m_client;
+    }
+    /**
+     * @brief Клиентская сторона транспорта для обмена сырыми сообщениями (до connect).
+     */
+    netlink::transport::InProcessTransport &transport() { return *m_transport; }
+    /**
+     * @brief Закрывает клиента и транспорт и дожидается выхода потока сервера: после этого его счетчики не меняются.
+     */
+    void stop() {
+        m_client.reset();
+        m_transport.reset();
+        if (m_worker.joinable()) {
+            m_worker.join();
+        }
+    }
+
+   private:
+    std::unique_ptr<netlink::transport::InProcessTransport> m_transport; // 8
+    std::unique_ptr<netlink::server::Server> m_server;                   // 8
+    std::unique_ptr<netlink::client::Client> m_client;                   // 8
+    std::thread m_worker;                                                // 8
+};
+
+} // namespace tests
@@ -0,0 +1,424 @@
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../client/client.hpp"
+#include "../common/event_loop.hpp"
+#include "../server/server.hpp"
+#include "../transport/inproc_transport.hpp"
+#include "../transport/socketpair_transport.hpp"
+
+namespace {
+
+/**
+ * @brief Проверяет, что транспорт сохраняет границы датаграмм и сообщает о закрытии.
+ */
+template <typename Pair>
+void check_datagrams(Pair pair) {
+    auto &[left, right] = pair;
+    char buffer[64];
+
+    // Датаграммы разной длины, чтобы кольцевой буфер переходил через конец
+    for (int i = 0; i < 1000; ++i) {
+        std::string const message = "message " + std::to_string(i);
+        ASSERT_EQ(left->send(message.data(), message.size()), 0);
+        ASSERT_EQ(right->receive(buffer, sizeof(buffer)), static_cast<ssize_t>(message.size()));
+        ASSERT_EQ(std::string(buffer, message.size()), message);
+    }
+
+    // Усеченная датаграмма: возвращается полная длина
+    std::string const message(sizeof(buffer) * 2, 'x');
+    ASSERT_EQ(right->send(message.data(), message.size()), 0);
+    EXPECT_EQ(left->receive(buffer, sizeof(buffer)), static_cast<ssize_t>(message.size()));
+
+    // Закрытие: уже отправленные данные дочитываются, потом receive возвращает 0
+    ASSERT_EQ(left->send("last", 4), 0);
+    left.reset();
+    EXPECT_EQ(right->receive(buffer, sizeof(buffer)), 4);
+    EXPECT_EQ(right->receive(buffer, sizeof(buffer)), 0);
+    EXPECT_EQ(right->send("lost", 4), -ECONNREFUSED);
+}
+
+/**
+ * @brief Запускает сервер и клиент поверх пары транспортов и проверяет ответы всех форматов запросов.
+ */
+template <typename Pair>
+void check_round_trip(Pair pair) {
+    auto &[client_transport, server_transport] = pair;
+    netlink::server::Server server(std::move(server_transport));
+    std::thread worker([&server]() { server.wait_for_response(); });
+
+    {
+        netlink::client::Client client(std::move(client_transport));
+        EXPECT_EQ(client.protocol_version(), netlink::client::Client::STREAM_PROTOCOL_VERSION);
+
+        int64_t binary_result = 0;
+        client.calc_async(netlink::client::OP::OP_MUL, 6, 7, [&](netlink::client::Response const &response) {
+            EXPECT_EQ(response.error, 0);
+            binary_result = response.result;
+        });
+
+        // Ошибки вычисления: бинарный ответ ATTR_ERRNO и JSON {"errno", "error"} из быстрого разбора
+        int division_error = 0;
+        client.calc_async(netlink::client::OP::OP_DIV, 1, 0, [&](netlink::client::Response const &response) { division_error = response.error; });
+        std::string overflow_result;
+        client.send_request_async({{"action", "add"}, {"arg1", INT64_MAX}, {"arg2", 1}},
+                                  [&](netlink::client::Response const &response) { overflow_result = response.payload; });
+        std::string wide_overflow_result;
+        client.send_request_async({{"action", "mul"}, {"type", "int128"}, {"arg1", "-170141183460469231731687303715884105728"}, {"arg2", 2}},
+                                  [&](netlink::client::Response const &response) { wide_overflow_result = response.payload; });
+
+        std::string json_result;
+        client.send_request_async({{"action", "add"}, {"arg1", 3}, {"arg2", 5}}, [&](netlink::client::Response const &response) {
+            EXPECT_EQ(response.error, 0);
+            json_result = response.payload;
+        });
+
+        std::vector<std::string> batch_results(2);
+        client.send_batch_async({{{"action", "sub"}, {"arg1", 10}, {"arg2", 3}}, {{"action", "pow"}, {"arg1", 2}, {"arg2", 3}}},
+                                [&](std::size_t index, netlink::client::Response const &response) { batch_results.at(index) = response.payload; });
+
+        // Два запроса, ответ на каждый приходит несколькими частями
+        std::vector<int64_t> array1(3000), array2(3000);
+        for (std::size_t i = 0; i < array1.size(); ++i) {
+            array1[i] = static_cast<int64_t>(i);
+            array2[i] = 2;
+        }
+        std::vector<int64_t> array_results;
+        client.calc_array_async(netlink::client::OP::OP_MUL, array1, array2, [&](int error, std::vector<int64_t> const &results) {
+            EXPECT_EQ(error, 0);
+            array_results = results;
+        });
+
+        // Запрос длиннее фрагмента потока и ограничения ATTR_MSG
+        std::string stream_result;
+        client.send_stream_async(nlohmann::json{{"action", "sub"}, {"arg1", array1}, {"arg2", array2}}.dump(),
+                                 [&](netlink::client::Response const &response) {
+                                     EXPECT_EQ(response.error, 0);
+                                     stream_result = response.payload;
+                                 });
+
+        client.wait_for_response();
+        EXPECT_EQ(client.in_flight(), 0u);
+        EXPECT_EQ(binary_result, 42);
+        EXPECT_EQ(division_error, EDOM);
+        EXPECT_EQ(overflow_result, R"({"errno":34,"error":"overflow"})");
+        EXPECT_EQ(wide_overflow_result, R"({"errno":34,"error":"overflow"})");
+        ASSERT_EQ(array_results.size(), array1.size());
+        EXPECT_EQ(array_results[0], 0);
+        EXPECT_EQ(array_results[2999], 5998);
+        EXPECT_EQ(nlohmann::json::parse(stream_result)["result"][2999], 2997);
+        EXPECT_EQ(json_result, R"({"result":8})");
+        EXPECT_EQ(batch_results[0], R"({"result":7})");
+        EXPECT_EQ(batch_results[1], "Invalid action. Supported actions are 'add', 'sub', 'mul', 'div', 'mod'");
+    }
+
+    // Клиент закрыл транспорт, сервер выходит из цикла приема
+    worker.join();
+}
+
+/**
+ * @brief Проверяет пакетный прием: за вызов забираются все уже доступные датаграммы.
+ */
+template <typename Pair>
+void check_batch(Pair pair) {
+    auto &[left, right] = pair;
+    char buffers[8][16];
+    std::array<netlink::transport::Datagram, 8> datagrams;
+    for (std::size_t i = 0; i < datagrams.size(); ++i) {
+        datagrams[i] = {buffers[i], sizeof(buffers[i]), 0};
+    }
+
+    for (int i = 0; i < 5; ++i) {
+        std::string const message = "batch " + std::to_string(i);
+        ASSERT_EQ(left->send(message.data(), message.size()), 0);
+    }
+    std::string const large(64, 'x');
+    ASSERT_EQ(left->send(large.data(), large.size()), 0);
+
+    ASSERT_EQ(right->receive_batch(datagrams.data(), datagrams.size()), 6);
+    for (int i = 0; i < 5; ++i) {
+        EXPECT_EQ(std::string(buffers[i], datagrams[i].length), "batch " + std::to_string(i));
+    }
+    // Усеченная датаграмма: возвращается полная длина
+    EXPECT_EQ(datagrams[5].length, 64);
+
+    left.reset();
+    EXPECT_EQ(right->receive_batch(datagrams.data(), datagrams.size()), 0);
+}
+
+/**
+ * @brief Отправляет от имени ретранслятора разосланный ответ (номер последовательности 0) по теме.
+ */
+void publish(netlink::transport::Transport &transport, uint32_t topic, char const *payload) {
+    std::unique_ptr<nl_msg, void (*)(nl_msg *)> msg(nlmsg_alloc(), nlmsg_free);
+    genlmsg_put(msg.get(), NL_AUTO_PORT, 0, transport.family_id(), 0, 0, 1, 7);
+    nla_put_string(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_MSG), payload);
+    nla_put_u32(msg.get(), static_cast<int>(netlink::server::ATTR::ATTR_TOPIC), topic);
+    struct nlmsghdr *nlh = nlmsg_hdr(msg.get());
+    ASSERT_EQ(transport.send(nlh, nlh->nlmsg_len), 0);
+}
+
+/**
+ * @brief Транспорт, который теряет следующую принятую датаграмму и сообщает о переполнении (ENOBUFS).
+ *
+ * Рассылку принимает отдельный транспорт, заданный set_subscription (как сокет рассылки GenlTransport).
+ */
+class LossyTransport final : public netlink::transport::Transport {
+   public:
+    explicit LossyTransport(std::unique_ptr<netlink::transport::Transport> inner) : m_inner(std::move(inner)) {}
+
+    int send(void const *data, std::size_t size) override { return m_inner->send(data, size); }
+    ssize_t receive(void *buffer, std::size_t size) override { return m_inner->receive(buffer, size); }
+    int receive_batch(netlink::transport::Datagram *datagrams, std::size_t count) override {
+        if (m_drop_next) {
+            m_drop_next = false;
+            int ret = m_inner->receive_batch(datagrams, 1);
+            return ret > 0 ? -ENOBUFS : ret;
+        }
+        return m_inner->receive_batch(datagrams, count);
+    }
+    int family_id() const override { return m_inner->family_id(); }
+    uint8_t version() const override { return m_inner->version(); }
+    bool relayed() const override { return false; }
+    int fd() const override { return m_inner->fd(); }
+    int set_nonblocking(bool enable) override { return m_inner->set_nonblocking(enable); }
+    int open_subscription(std::unique_ptr<netlink::transport::Transport> &subscription) override {
+        subscription = std::move(m_subscription);
+        return 0;
+    }
+
+    void drop_next() { m_drop_next = true; }
+    void set_subscription(std::unique_ptr<netlink::transport::Transport> subscription) { m_subscription = std::move(subscription); }
+
+   private:
+    std::unique_ptr<netlink::transport::Transport> m_inner;        // 8
+    std::unique_ptr<netlink::transport::Transport> m_subscription; // 8
+    bool m_drop_next = false;                                      // 1
+};
+
+} // namespace
+
+// Тест: Внутрипроцессный транспорт передает датаграммы целиком и сообщает о закрытии
+TEST(TransportTests, InProcessDatagrams) { check_datagrams(netlink::transport::InProcessTransport::create_pair(256)); }
+
+// Тест: Транспорт socketpair передает датаграммы целиком и сообщает о закрытии
+TEST(TransportTests, SocketpairDatagrams) { check_datagrams(netlink::transport::SocketpairTransport::create_pair()); }
+
+// Тест: Датаграмма больше очереди отклоняется
+TEST(TransportTests, InProcessRejectsOversizedDatagram) {
+    auto [left, right] = netlink::transport::InProcessTransport::create_pair(256);
+    std::string const message(512, 'x');
+    EXPECT_EQ(left->send(message.data(), message.size()), -EMSGSIZE);
+}
+
+// Тест: Клиент и сервер обмениваются запросами через внутрипроцессный транспорт
+TEST(TransportTests, InProcessRoundTrip) { check_round_trip(netlink::transport::InProcessTransport::create_pair()); }
+
+// Тест: Клиент и сервер обмениваются запросами через socketpair
+TEST(TransportTests, SocketpairRoundTrip) { check_round_trip(netlink::transport::SocketpairTransport::create_pair()); }
+
+// Тест: Клиент с транспортом версии 1 использует JSON для calc_async
+TEST(TransportTests, JsonFallbackRoundTrip) {
+    auto [client_transport, server_transport] = netlink::transport::InProcessTransport::create_pair(netlink::transport::InProcessTransport::DEFAULT_CAPACITY, 1);
+    netlink::server::Server server(std::move(server_transport));
+    std::thread worker([&server]() { server.wait_for_response(); });
+    {
+        netlink::client::Client client(std::move(client_transport));
+        int64_t result = 0;
+        client.calc_async(netlink::client::OP::OP_SUB, 2, 9, [&](netlink::client::Response const &response) {
+            EXPECT_EQ(response.error, 0);
+            result = response.result;
+        });
+        int error = 0;
+        client.calc_async(netlink::client::OP::OP_MUL, INT64_MIN, -1, [&](netlink::client::Response const &response) { error = response.error; });
+        client.wait_for_response();
+        EXPECT_EQ(result, -7);
+        EXPECT_EQ(error, ERANGE);
+    }
+    worker.join();
+}
+
+// Тест: В режиме Admission::REJECT операция при заполненном окне отклоняется BusyError, а не ждет ответов
+TEST(TransportTests, ClientRejectsWhenBusy) {
+    auto [client_transport, server_transport] = netlink::transport::InProcessTransport::create_pair();
+    netlink::server::Server server(std::move(server_transport));
+    std::thread worker;
+    {
+        netlink::client::Client client(std::move(client_transport), 2);
+        client.set_admission(netlink::client::Admission::REJECT);
+        std::vector<int64_t> results;
+        auto on_response = [&results](netlink::client::Response const &response) {
+            EXPECT_EQ(response.error, 0);
+            results.push_back(response.result);
+        };
+        client.calc_async(netlink::client::OP::OP_ADD, 1, 2, on_response);
+        client.calc_async(netlink::client::OP::OP_ADD, 3, 4, on_response);
+        EXPECT_THROW(client.calc_async(netlink::client::OP::OP_ADD, 5, 6, on_response), netlink::client::BusyError);
+        EXPECT_THROW(client.send_request_async({{"action", "add"}, {"arg1", 5}, {"arg2", 6}}, on_response), netlink::client::BusyError);
+        EXPECT_EQ(client.in_flight(), 2u);
+
+        // Сервер ответил: место освободилось
+        worker = std::thread([&server]() { server.wait_for_response(); });
+        client.wait_for_response();
+        client.calc_async(netlink::client::OP::OP_ADD, 5, 6, on_response);
+        client.wait_for_response();
+        EXPECT_EQ(results, (std::vector<int64_t>{3, 7, 11}));
+    }
+    worker.join();
+}
+
+// Тест: Разосланные ответы (номер 0, ATTR_TOPIC) получает только обработчик подписанной темы
+TEST(TransportTests, ClientSubscription) {
+    auto [client_transport, server_transport] = netlink::transport::InProcessTransport::create_pair(netlink::transport::InProcessTransport::DEFAULT_CAPACITY, 7);
+    netlink::client::Client client(std::move(client_transport));
+    std::vector<std::string> payloads;
+    EXPECT_THROW(client.subscribe(0, [](netlink::client::Response const &) {}), std::runtime_error);
+    client.subscribe(42, [&payloads](netlink::client::Response const &response) {
+        EXPECT_EQ(response.error, 0);
+        payloads.push_back(response.payload);
+    });
+
+    publish(*server_transport, 42, R"({"result":3})");
+    publish(*server_transport, 7, R"({"result":4})");
+    client.process_available();
+    EXPECT_EQ(payloads, (std::vector<std::string>{R"({"result":3})"}));
+
+    EXPECT_TRUE(client.unsubscribe(42));
+    EXPECT_FALSE(client.unsubscribe(42));
+    publish(*server_transport, 42, R"({"result":5})");
+    client.process_available();
+    EXPECT_EQ(payloads.size(), 1u);
+}
+
+// Тест: Переполнение сокета рассылки теряет только разосланные ответы, запрос в полете получает свой ответ
+TEST(TransportTests, SubscriptionOverflowKeepsRequests) {
+    auto [client_transport, server_transport] = netlink::transport::SocketpairTransport::create_pair(7);
+    auto [subscription, publisher] = netlink::transport::SocketpairTransport::create_pair(7);
+    netlink::server::Server server(std::move(server_transport));
+    std::thread worker([&server]() { server.wait_for_response(); });
+    {
+        ASSERT_EQ(subscription->set_nonblocking(true), 0);
+        auto lossy_subscription = std::make_unique<LossyTransport>(std::move(subscription));
+        LossyTransport &published = *lossy_subscription;
+        auto lossy = std::make_unique<LossyTransport>(std::move(client_transport));
+        lossy->set_subscription(std::move(lossy_subscription));
+        netlink::client::Client client(std::move(lossy));
+
+        std::vector<std::string> payloads;
+        client.subscribe(42, [&payloads](netlink::client::Response const &response) { payloads.push_back(response.payload); });
+        publish(*publisher, 42, R"({"result":3})");
+        publish(*publisher, 42, R"({"result":4})");
+        published.drop_next();
+
+        int error = -1;
+        int64_t result = 0;
+        client.calc_async(netlink::client::OP::OP_ADD, 2, 3, [&error, &result](netlink::client::Response const &response) {
+            error = response.error;
+            result = response.result;
+        });
+        client.wait_for_response();
+        client.process_available();
+
+        EXPECT_EQ(error, 0);
+        EXPECT_EQ(result, 5);
+        EXPECT_EQ(client.overflows(), 0u);
+        EXPECT_EQ(client.published_overflows(), 1u);
+        EXPECT_EQ(payloads, (std::vector<std::string>{R"({"result":4})"}));
+    }
+    worker.join();
+}
+
+// Тест: Тема запроса и подписка требуют семейства с рассылкой (версия 7)
+TEST(TransportTests, SubscriptionRequiresMulticastVersion) {
+    auto [client_transport, server_transport] = netlink::transport::InProcessTransport::create_pair(netlink::transport::InProcessTransport::DEFAULT_CAPACITY, 6);
+    netlink::client::Client client(std::move(client_transport));
+    auto ignore = [](netlink::client::Response const &) {};
+    EXPECT_THROW(client.subscribe(42, ignore), std::runtime_error);
+    EXPECT_THROW(client.send_request_async({{"action", "add"}, {"arg1", 1}, {"arg2", 2}}, ignore, 42), std::runtime_error);
+    EXPECT_EQ(client.in_flight(), 0u);
+}
+
+// Тест: Внутрипроцессный транспорт принимает несколько датаграмм за вызов
+TEST(TransportTests, InProcessBatchReceive) { check_batch(netlink::transport::InProcessTransport::create_pair(4096)); }
+
+// Тест: Транспорт socketpair принимает несколько датаграмм за вызов (recvmmsg)
+TEST(TransportTests, SocketpairBatchReceive) { check_batch(netlink::transport::SocketpairTransport::create_pair()); }
+
+// Тест: Размер буферов задается только транспортам с сокетом
+TEST(TransportTests, BufferSizes) {
+    auto [left, right] = netlink::transport::SocketpairTransport::create_pair();
+    EXPECT_EQ(left->set_buffer_sizes(4 << 20, 4 << 20), 0);
+    auto [inproc, peer] = netlink::transport::InProcessTransport::create_pair(256);
+    EXPECT_EQ(inproc->set_buffer_sizes(4 << 20, 4 << 20), -EOPNOTSUPP);
+}
+
+// Тест: После переполнения клиент дочитывает очередь и завершает запросы с потерянными ответами ошибкой ENOBUFS
+TEST(TransportTests, ClientRecoversFromOverflow) {
+    auto [client_transport, server_transport] = netlink::transport::SocketpairTransport::create_pair();
+    netlink::server::Server server(std::move(server_transport));
+    std::thread worker([&server]() { server.wait_for_response(); });
+    {
+        auto lossy = std::make_unique<LossyTransport>(std::move(client_transport));
+        LossyTransport &transport = *lossy;
+        netlink::client::Client client(std::move(lossy));
+
+        std::vector<int> errors(3, -1);
+        for (int i = 0; i < 3; ++i) {
+            client.calc_async(netlink::client::OP::OP_ADD, i, i, [&errors, i](netlink::client::Response const &response) { errors[i] = response.error; });
+        }
+        // Все ответы уже в очереди сокета, первый из них будет потерян
+        while (server.stats().get(netlink::server::Counter::MESSAGES_OUT) < 3) {
+            std::this_thread::yield();
+        }
+        transport.drop_next();
+        client.wait_for_response();
+
+        EXPECT_EQ(client.in_flight(), 0u);
+        EXPECT_EQ(client.overflows(), 1u);
+        EXPECT_EQ(errors, (std::vector<int>{ENOBUFS, 0, 0}));
+    }
+    worker.join();
+}
+
+// Тест: Запрос со сроком ответа не завершается ENOBUFS после переполнения, а ждет ответа или истечения срока
+TEST(TransportTests, OverflowWaitsForDeadline) {
+    auto [client_transport, server_transport] = netlink::transport::SocketpairTransport::create_pair();
+    netlink::server::Server server(std::move(server_transport));
+    std::thread worker([&server]() { server.wait_for_response(); });
+    {
+        auto lossy = std::make_unique<LossyTransport>(std::move(client_transport));
+        LossyTransport &transport = *lossy;
+        netlink::client::Client client(std::move(lossy));
+        netlink::common::EventLoop loop;
+        client.attach(loop);
+        client.set_timeout(std::chrono::milliseconds(200));
+
+        std::vector<int> errors(3, -1);
+        for (int i = 0; i < 3; ++i) {
+            client.calc_async(netlink::client::OP::OP_ADD, i, i, [&errors, i](netlink::client::Response const &response) { errors[i] = response.error; });
+        }
+        while (server.stats().get(netlink::server::Counter::MESSAGES_OUT) < 3) {
+            std::this_thread::yield();
+        }
+        transport.drop_next();
+        loop.run_once(0);
+        // Переполнение обработано, но запрос с потерянным ответом ждет своего срока
+        EXPECT_EQ(client.overflows(), 1u);
+        EXPECT_EQ(errors, (std::vector<int>{-1, 0, 0}));
+
+        auto const deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (client.in_flight() != 0 && std::chrono::steady_clock::now() < deadline) {
+            loop.run_once(10);
+        }
+        EXPECT_EQ(errors, (std::vector<int>{ETIMEDOUT, 0, 0}));
+        client.detach();
+    }
+    worker.join();
+}
@@ -0,0 +1,130 @@
+#include "genl_transport.hpp"
+
+#include <sys/socket.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+netlink::transport::GenlTransport::GenlTransport(int buffer_size) : m_buffer_size(buffer_size) {
+    m_sock = nl_socket_alloc();
+    if (!m_sock) {
+        NETLINK_LOG(LOG_ERR, "Failed to allocate the Netlink socket");
+        throw std::runtime_error("Failed to allocate the Netlink socket");
+    }
+
+    if (genl_connect(m_sock)) {
+        nl_socket_free(m_sock);
+        NETLINK_LOG(LOG_ERR, "Failed to establish a connection to Netlink");
+        throw std::runtime_error("Failed to establish a connection to Netlink");
+    }
+
+    m_family_id = genl_ctrl_resolve(m_sock, M_FAMILY_NAME);
+    if (m_family_id < 0) {
+        nl_socket_free(m_sock);
+        NETLINK_LOG(LOG_ERR, "Failed to resolve the Netlink family");
+        throw std::runtime_error("Failed to resolve the Netlink family");
+    }
+
+    m_version = resolve_version();
+    m_results_group = genl_ctrl_resolve_grp(m_sock, M_FAMILY_NAME, M_RESULTS_GROUP);
+    if (m_results_group < 0) {
+        // Модуль без рассылки ответов (версия семейства до 7)
+        m_results_group = -1;
+        NETLINK_LOG(LOG_DEBUG, "Netlink family %s has no multicast group %s", M_FAMILY_NAME, M_RESULTS_GROUP);
+    }
+
+    int ret = set_buffer_sizes(buffer_size, buffer_size);
+    if (ret < 0) {
+        NETLINK_LOG(LOG_WARNING, "Failed to set Netlink socket buffer sizes: %s", strerror(-ret));
+    }
+
+    // Подтверждения ядра не нужны: об ошибках ядро сообщает всегда, а ответ приходит от другой стороны
+    nl_socket_disable_auto_ack(m_sock);
+    NETLINK_LOG(LOG_INFO, "Connected to Netlink family %s (id %d, version %d)", M_FAMILY_NAME, m_family_id, m_version);
+}
+
+netlink::transport::GenlTransport::~GenlTransport() {
+    //@todo: переделать на uniq
+    nl_socket_free(m_sock);
+}
+
+int netlink::transport::GenlTransport::send(void const *data, std::size_t size) {
+    // Сокет не подключен к конкретному адресату, по умолчанию сообщения уходят ядру (port id 0)
+    ssize_t ret = ::send(nl_socket_get_fd(m_sock), data, size, 0);
+    return ret < 0 ? -errno : 0;
+}
+
+ssize_t netlink::transport::GenlTransport::receive(void *buffer, std::size_t size) {
+    while (true) {
+        ssize_t len = recv(nl_socket_get_fd(m_sock), buffer, size, MSG_TRUNC);
+        if (len >= 0) {
+            return len;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
+
+netlink::transport::GenlTransport::GenlTransport(int family_id, uint8_t version, int group, int buffer_size)
+    : m_family_id(family_id), m_results_group(group), m_buffer_size(buffer_size), m_version(version) {
+    m_sock = nl_socket_alloc();
+    if (!m_sock) {
+        NETLINK_LOG(LOG_ERR, "Failed to allocate the Netlink socket");
+        throw std::runtime_error("Failed to allocate the Netlink socket");
+    }
+    if (genl_connect(m_sock)) {
+        nl_socket_free(m_sock);
+        NETLINK_LOG(LOG_ERR, "Failed to establish a connection to Netlink");
+        throw std::runtime_error("Failed to establish a connection to Netlink");
+    }
+    if (setsockopt(nl_socket_get_fd(m_sock), SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group)) < 0) {
+        int const error = errno;
+        nl_socket_free(m_sock);
+        NETLINK_LOG(LOG_ERR, "Failed to join multicast group %d: %s", group, strerror(error));
+        throw std::runtime_error("Failed to join the multicast group");
+    }
+    int ret = set_buffer_sizes(buffer_size, 0);
+    if (ret < 0) {
+        NETLINK_LOG(LOG_WARNING, "Failed to set Netlink socket buffer sizes: %s", strerror(-ret));
+    }
+    // Сокет только принимает рассылку и никогда не блокируется на приеме
+    ret = set_nonblocking(true);
+    if (ret < 0) {
+        nl_socket_free(m_sock);
+        NETLINK_LOG(LOG_ERR, "Failed to switch the subscription socket to non-blocking mode: %s", strerror(-ret));
+        throw std::runtime_error("Failed to switch the subscription socket to non-blocking mode");
+    }
+}
+
+int netlink::transport::GenlTransport::open_subscription(std::unique_ptr<Transport> &subscription) {
+    if (m_results_group < 0) {
+        NETLINK_LOG(LOG_ERR, "Netlink family %s has no multicast group %s", M_FAMILY_NAME, M_RESULTS_GROUP);
+        return -ENOENT;
+    }
+    try {
+        subscription.reset(new GenlTransport(m_family_id, m_version, m_results_group, m_buffer_size));
+    } catch (std::exception &) {
+        return -ECONNREFUSED;
+    }
+    NETLINK_LOG(LOG_INFO, "Joined multicast group %s (id %d) on a dedicated socket", M_RESULTS_GROUP, m_results_group);
+    return 0;
+}
+
+uint8_t netlink::transport::GenlTransport::resolve_version() {
+    struct nl_cache *cache = nullptr;
+    if (genl_ctrl_alloc_cache(m_sock, &cache) < 0) {
+        NETLINK_LOG(LOG_WARNING, "Failed to query the Generic Netlink controller, assuming family version 1");
+        return 1;
+    }
+
+    uint8_t version = 1;
+    struct genl_family *family = genl_ctrl_search_by_name(cache, M_FAMILY_NAME);
+    if (family) {
+        version = genl_family_get_version(family);
+        genl_family_put(family);
+    }
+    nl_cache_free(cache);
+    return version;
+}
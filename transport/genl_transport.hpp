@@ -0,0 +1,77 @@
+#pragma once
+#include <netlink/genl/ctrl.h>
+#include <netlink/genl/family.h>
+#include <netlink/genl/genl.h>
+#include <netlink/netlink.h>
+
+#include "../common/logger.hpp"
+#include "transport.hpp"
+
+namespace netlink::transport {
+
+/**
+ * @brief Транспорт через семейство Generic Netlink модуля ядра calc_module.
+ */
+class GenlTransport final : public Transport {
+   public:
+    /**
+     * @brief Размер буферов приема и отправки сокета по умолчанию.
+     *
+     * Стандартных 208 КиБ хватает лишь на несколько тысяч ответов, при всплесках нагрузки
+     * ядро отбрасывает остальные (ENOBUFS).
+     */
+    static constexpr int DEFAULT_BUFFER_SIZE = 8 << 20;
+
+    /**
+     * @brief Конструктор транспорта.
+     *
+     * Выделяет сокет Netlink, подключается к Generic Netlink, разрешает имя семейства,
+     * определяет его версию и идентификатор группы рассылки. Запросы к контроллеру
+     * выполняются до отправки запросов, поэтому не могут прочитать и отбросить ответы на них.
+     *
+     * @param buffer_size Размер буферов приема и отправки сокета (0 - системный размер по умолчанию).
+     *
+     * @throw std::runtime_error Если не удалось выделить сокет, установить соединение или разрешить имя семейства.
+     */
+    explicit GenlTransport(int buffer_size = DEFAULT_BUFFER_SIZE);
+    ~GenlTransport() override;
+
+    int send(void const *data, std::size_t size) override;
+    ssize_t receive(void *buffer, std::size_t size) override;
+    int receive_batch(Datagram *datagrams, std::size_t count) override { return receive_socket_batch(nl_socket_get_fd(m_sock), datagrams, count); }
+    int family_id() const override { return m_family_id; }
+    uint8_t version() const override { return m_version; }
+    bool relayed() const override { return true; }
+    int fd() const override { return nl_socket_get_fd(m_sock); }
+    int open_subscription(std::unique_ptr<Transport> &subscription) override;
+
+   private:
+    /**
+     * @brief Конструктор сокета рассылки: подключается к Generic Netlink и вступает в группу без запросов к контроллеру.
+     *
+     * @param family_id Идентификатор семейства.
+     * @param version Версия семейства.
+     * @param group Идентификатор группы рассылки.
+     * @param buffer_size Размер буферов сокета (0 - системный размер по умолчанию).
+     *
+     * @throw std::runtime_error Если не удалось выделить сокет, установить соединение или вступить в группу.
+     */
+    GenlTransport(int family_id, uint8_t version, int group, int buffer_size);
+
+    /**
+     * @brief Запрашивает у контроллера Generic Netlink версию семейства.
+     *
+     * @return Версия семейства или 1, если её не удалось определить.
+     */
+    uint8_t resolve_version();
+
+    struct nl_sock *m_sock = nullptr;                                 // 8
+    static constexpr const char *const M_FAMILY_NAME = "calc_family"; // 8
+    static constexpr const char *const M_RESULTS_GROUP = "results";   // 8
+    int m_family_id = 0;                                              // 4
+    int m_results_group = -1;                                         // 4 (-1 - у семейства нет группы рассылки)
+    int m_buffer_size = 0;                                            // 4
+    uint8_t m_version = 1;                                            // 1
+};
+
+} // namespace netlink::transport
@@ -0,0 +1,127 @@
+#include "inproc_transport.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+
+namespace {
+
+std::size_t record_size(std::size_t size, std::size_t align) {
+    return (sizeof(uint32_t) + size + align - 1) & ~(align - 1);
+}
+
+} // namespace
+
+netlink::transport::InProcessTransport::Ring::Ring(std::size_t capacity) : m_data(std::bit_ceil(capacity < 64 ? 64 : capacity)), m_mask(m_data.size() - 1) {}
+
+std::pair<std::unique_ptr<netlink::transport::InProcessTransport>, std::unique_ptr<netlink::transport::InProcessTransport>>
+netlink::transport::InProcessTransport::create_pair(std::size_t capacity, uint8_t version) {
+    auto to_server = std::make_shared<Ring>(capacity);
+    auto to_client = std::make_shared<Ring>(capacity);
+    return {std::unique_ptr<InProcessTransport>(new InProcessTransport(to_client, to_server, version)),
+            std::unique_ptr<InProcessTransport>(new InProcessTransport(to_server, to_client, version))};
+}
+
+netlink::transport::InProcessTransport::InProcessTransport(std::shared_ptr<Ring> rx, std::shared_ptr<Ring> tx, uint8_t version)
+    : m_rx(std::move(rx)), m_tx(std::move(tx)), m_version(version) {}
+
+netlink::transport::InProcessTransport::~InProcessTransport() {
+    // Будим другую сторону, если она ждет данных или места в очереди
+    m_tx->m_head.fetch_or(M_CLOSED, std::memory_order_release);
+    m_tx->m_head.notify_all();
+    m_rx->m_tail.fetch_or(M_CLOSED, std::memory_order_release);
+    m_rx->m_tail.notify_all();
+}
+
+int netlink::transport::InProcessTransport::send(void const *data, std::size_t size) {
+    Ring &ring = *m_tx;
+    std::size_t const needed = record_size(size, M_RECORD_ALIGN);
+    if (needed > ring.m_data.size()) {
+        return -EMSGSIZE;
+    }
+
+    std::size_t const head = ring.m_head.load(std::memory_order_relaxed);
+    std::size_t tail = ring.m_tail.load(std::memory_order_acquire);
+    for (int spin = 0;; ++spin) {
+        if (tail & M_CLOSED) {
+            return -ECONNREFUSED;
+        }
+        if (head + needed - tail <= ring.m_data.size()) {
+            break;
+        }
+        if (spin < M_SPIN_COUNT) {
+            std::this_thread::yield();
+        } else {
+            ring.m_tail.wait(tail, std::memory_order_acquire);
+        }
+        tail = ring.m_tail.load(std::memory_order_acquire);
+    }
+
+    uint32_t const length = static_cast<uint32_t>(size);
+    copy_in(ring, head, &length, sizeof(length));
+    copy_in(ring, head + sizeof(length), data, size);
+    ring.m_head.store(head + needed, std::memory_order_release);
+    ring.m_head.notify_one();
+    return 0;
+}
+
+ssize_t netlink::transport::InProcessTransport::receive(void *buffer, std::size_t size) {
+    Ring &ring = *m_rx;
+    std::size_t const tail = ring.m_tail.load(std::memory_order_relaxed);
+    std::size_t head = ring.m_head.load(std::memory_order_acquire);
+    for (int spin = 0; (head & ~M_CLOSED) == tail; ++spin) {
+        // Записи, положенные до закрытия, дочитываются
+        if (head & M_CLOSED) {
+            return 0;
+        }
+        if (m_nonblocking) {
+            return -EAGAIN;
+        }
+        if (spin < M_SPIN_COUNT) {
+            std::this_thread::yield();
+        } else {
+            ring.m_head.wait(head, std::memory_order_acquire);
+        }
+        head = ring.m_head.load(std::memory_order_acquire);
+    }
+
+    uint32_t length = 0;
+    copy_out(ring, tail, &length, sizeof(length));
+    copy_out(ring, tail + sizeof(length), buffer, length < size ? length : size);
+    ring.m_tail.store(tail + record_size(length, M_RECORD_ALIGN), std::memory_order_release);
+    ring.m_tail.notify_one();
+    return static_cast<ssize_t>(length);
+}
+
+int netlink::transport::InProcessTransport::receive_batch(Datagram *datagrams, std::size_t count) {
+    ssize_t length = receive(datagrams[0].data, datagrams[0].size);
+    if (length <= 0) {
+        return static_cast<int>(length);
+    }
+    datagrams[0].length = length;
+
+    // Следующие записи забираются, только если они уже в очереди
+    Ring &ring = *m_rx;
+    std::size_t received = 1;
+    while (received < count && (ring.m_head.load(std::memory_order_acquire) & ~M_CLOSED) != ring.m_tail.load(std::memory_order_relaxed)) {
+        datagrams[received].length = receive(datagrams[received].data, datagrams[received].size);
+        ++received;
+    }
+    return static_cast<int>(received);
+}
+
+void netlink::transport::InProcessTransport::copy_in(Ring &ring, std::size_t pos, void const *data, std::size_t size) {
+    std::size_t const offset = pos & ring.m_mask;
+    std::size_t const first = std::min(size, ring.m_data.size() - offset);
+    std::memcpy(ring.m_data.data() + offset, data, first);
+    std::memcpy(ring.m_data.data(), static_cast<char const *>(data) + first, size - first);
+}
+
+void netlink::transport::InProcessTransport::copy_out(Ring const &ring, std::size_t pos, void *data, std::size_t size) {
+    std::size_t const offset = pos & ring.m_mask;
+    std::size_t const first = std::min(size, ring.m_data.size() - offset);
+    std::memcpy(data, ring.m_data.data() + offset, first);
+    std::memcpy(static_cast<char *>(data) + first, ring.m_data.data(), size - first);
+}
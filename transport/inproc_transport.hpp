@@ -0,0 +1,100 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "transport.hpp"
+
+namespace netlink::transport {
+
+/**
+ * @brief Внутрипроцессный транспорт на паре lock-free SPSC очередей.
+ *
+ * Позволяет запускать клиент и сервер в одном процессе без модуля ядра: для тестов
+ * и для измерения стоимости вычислений отдельно от системных вызовов. Каждая сторона
+ * пары пишет только в свою очередь и читает только из очереди другой стороны,
+ * поэтому каждой стороной должен пользоваться один поток.
+ */
+class InProcessTransport final : public Transport {
+   public:
+    /**
+     * @brief Идентификатор семейства в заголовках сообщений (ретранслятора нет, значение условное).
+     */
+    static constexpr int FAMILY_ID = 0x20;
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 20;
+
+    /**
+     * @brief Создает пару связанных транспортов.
+     *
+     * @param capacity Емкость очереди каждого направления в байтах (округляется вверх до степени двойки).
+     * @param version Версия протокола, которую транспорт сообщает клиенту.
+     *
+     * @return Пара (клиентская сторона, серверная сторона).
+     */
+    static std::pair<std::unique_ptr<InProcessTransport>, std::unique_ptr<InProcessTransport>> create_pair(std::size_t capacity = DEFAULT_CAPACITY,
+                                                                                                           uint8_t version = 4);
+
+    ~InProcessTransport() override;
+
+    /**
+     * @brief Кладет датаграмму в очередь другой стороны, ожидая освобождения места если очередь заполнена.
+     *
+     * @return 0, -EMSGSIZE если датаграмма больше очереди, -ECONNREFUSED если другая сторона закрыта.
+     */
+    int send(void const *data, std::size_t size) override;
+    ssize_t receive(void *buffer, std::size_t size) override;
+    int receive_batch(Datagram *datagrams, std::size_t count) override;
+    int family_id() const override { return FAMILY_ID; }
+    uint8_t version() const override { return m_version; }
+    bool relayed() const override { return false; }
+    int fd() const override { return -1; }
+    /**
+     * @brief Неблокирующий прием без дескриптора: receive возвращает -EAGAIN, если очередь пуста (отправка по-прежнему ждет места).
+     */
+    int set_nonblocking(bool enable) override {
+        m_nonblocking = enable;
+        return 0;
+    }
+
+   private:
+    /**
+     * @brief Кольцевой буфер одного направления.
+     *
+     * Записи хранятся как [uint32_t длина][данные], выровненные на 8 байт. Позиции head и tail
+     * монотонно растут и лежат в разных кэш-линиях, чтобы писатель и читатель не мешали друг другу.
+     * Младший бит позиции свободен из-за выравнивания и отмечает, что её владелец закрыт:
+     * так ожидание на позиции просыпается и при новых данных, и при закрытии.
+     */
+    struct Ring {
+        explicit Ring(std::size_t capacity);
+
+        std::vector<char> m_data;                        // 24
+        std::size_t m_mask;                              // 8
+        alignas(64) std::atomic<std::size_t> m_head = 0; // 8 позиция записи
+        alignas(64) std::atomic<std::size_t> m_tail = 0; // 8 позиция чтения
+    };
+
+    InProcessTransport(std::shared_ptr<Ring> rx, std::shared_ptr<Ring> tx, uint8_t version);
+
+    /**
+     * @brief Копирует данные в кольцо начиная с позиции pos с учетом перехода через конец.
+     */
+    static void copy_in(Ring &ring, std::size_t pos, void const *data, std::size_t size);
+    /**
+     * @brief Копирует данные из кольца начиная с позиции pos с учетом перехода через конец.
+     */
+    static void copy_out(Ring const &ring, std::size_t pos, void *data, std::size_t size);
+
+    static constexpr std::size_t M_RECORD_ALIGN = 8;
+    static constexpr std::size_t M_CLOSED = 1;
+    static constexpr int M_SPIN_COUNT = 1024;
+
+    std::shared_ptr<Ring> m_rx; // 16
+    std::shared_ptr<Ring> m_tx; // 16
+    uint8_t m_version;          // 1
+    bool m_nonblocking = false; // 1
+};
+
+} // namespace netlink::transport
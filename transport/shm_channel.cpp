@@ -0,0 +1,214 @@
+#include "shm_channel.hpp"
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+
+#include "../common/logger.hpp"
+
+namespace {
+
+/**
+ * @brief futex без FUTEX_PRIVATE_FLAG: слово лежит в общей памяти разных процессов.
+ */
+long futex(std::atomic<uint32_t> &word, int op, uint32_t value, struct timespec const *timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t *>(&word), op, value, timeout, nullptr, 0);
+}
+
+std::size_t round_up_pow2(std::size_t value) {
+    std::size_t result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+} // namespace
+
+std::size_t netlink::transport::ShmChannel::memory_size(std::size_t capacity) {
+    return sizeof(Header) + capacity * (sizeof(ShmRequest) + sizeof(ShmReply));
+}
+
+std::unique_ptr<netlink::transport::ShmChannel> netlink::transport::ShmChannel::create(std::size_t capacity) {
+    static std::atomic<uint32_t> counter{0};
+    capacity = round_up_pow2(std::max<std::size_t>(capacity, 2));
+    if (capacity > (1u << 24)) {
+        throw std::runtime_error("Shared memory channel capacity is too large");
+    }
+    std::string name = std::string(NAME_PREFIX) + std::to_string(getpid()) + "_" + std::to_string(counter.fetch_add(1));
+
+    // Права только для владельца: сервер должен работать от того же пользователя (или root)
+    int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to create shared memory %s: %s", name.c_str(), strerror(errno));
+        throw std::runtime_error("Failed to create shared memory");
+    }
+    std::size_t const size = memory_size(capacity);
+    void *memory = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    int const error = errno;
+    close(fd);
+    if (memory == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        NETLINK_LOG(LOG_ERR, "Failed to map shared memory %s: %s", name.c_str(), strerror(error));
+        throw std::runtime_error("Failed to map shared memory");
+    }
+
+    // ftruncate заполняет объект нулями: позиции очередей и флаги уже нулевые
+    auto *header = new (memory) Header{};
+    header->capacity = static_cast<uint32_t>(capacity);
+    header->version = M_VERSION;
+    header->magic = M_MAGIC;
+    return std::unique_ptr<ShmChannel>(new ShmChannel(std::move(name), memory, size, false));
+}
+
+std::unique_ptr<netlink::transport::ShmChannel> netlink::transport::ShmChannel::open(std::string const &name) {
+    std::string_view const prefix = NAME_PREFIX;
+    if (name.size() <= prefix.size() || name.compare(0, prefix.size(), prefix) != 0 || name.find('/', 1) != std::string::npos) {
+        NETLINK_LOG(LOG_WARNING, "Rejected shared memory name %s", name.c_str());
+        throw std::runtime_error("Invalid shared memory name");
+    }
+    int fd = shm_open(name.c_str(), O_RDWR | O_CLOEXEC, 0);
+    if (fd < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to open shared memory %s: %s", name.c_str(), strerror(errno));
+        throw std::runtime_error("Failed to open shared memory");
+    }
+    // Имя больше не нужно: объект живет, пока его отображают клиент и сервер
+    shm_unlink(name.c_str());
+
+    struct stat st{};
+    void *memory = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(Header)) {
+        memory = mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    close(fd);
+    if (memory == MAP_FAILED) {
+        NETLINK_LOG(LOG_ERR, "Failed to map shared memory %s", name.c_str());
+        throw std::runtime_error("Failed to map shared memory");
+    }
+
+    auto size = static_cast<std::size_t>(st.st_size);
+    auto const *header = static_cast<Header const *>(memory);
+    std::size_t const capacity = header->capacity;
+    if (header->magic != M_MAGIC || header->version != M_VERSION || capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+        memory_size(capacity) != size) {
+        munmap(memory, size);
+        NETLINK_LOG(LOG_ERR, "Shared memory %s has invalid format", name.c_str());
+        throw std::runtime_error("Invalid shared memory format");
+    }
+    auto channel = std::unique_ptr<ShmChannel>(new ShmChannel(name, memory, size, true));
+    channel->m_unlinked = true;
+    return channel;
+}
+
+netlink::transport::ShmChannel::ShmChannel(std::string name, void *memory, std::size_t size, bool server)
+    : m_name(std::move(name)), m_header(static_cast<Header *>(memory)), m_size(size), m_capacity(m_header->capacity), m_server(server) {
+    auto *records = static_cast<char *>(memory) + sizeof(Header);
+    m_requests = reinterpret_cast<ShmRequest *>(records);
+    m_replies = reinterpret_cast<ShmReply *>(records + m_capacity * sizeof(ShmRequest));
+}
+
+netlink::transport::ShmChannel::~ShmChannel() {
+    m_header->closed.fetch_or(m_server ? M_SERVER_SIDE : M_CLIENT_SIDE);
+    // Другая сторона может спать на futex своей входящей очереди
+    wake(m_server ? m_header->replies.head : m_header->requests.head);
+    if (!m_unlinked) {
+        // Сервер не открыл канал (например, старая версия): имя удаляет сам клиент
+        shm_unlink(m_name.c_str());
+    }
+    munmap(m_header, m_size);
+}
+
+template <typename Record>
+std::size_t netlink::transport::ShmChannel::push(Ring &ring, Record *records, std::size_t mask, Record const *data, std::size_t count) {
+    uint32_t const head = ring.head.load(std::memory_order_relaxed);
+    uint32_t const tail = ring.tail.load(std::memory_order_acquire);
+    std::size_t const free = mask + 1 - (head - tail);
+    count = std::min(count, free);
+    if (count == 0) {
+        return 0;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        records[(head + i) & mask] = data[i];
+    }
+    // seq_cst: запись позиции упорядочена с чтением флага ожидания (потребитель делает наоборот)
+    ring.head.store(head + static_cast<uint32_t>(count), std::memory_order_seq_cst);
+    if (ring.waiting.load(std::memory_order_seq_cst) != 0) {
+        ring.waiting.store(0, std::memory_order_relaxed);
+        wake(ring.head);
+    }
+    return count;
+}
+
+template <typename Record>
+std::size_t netlink::transport::ShmChannel::pop(Ring &ring, Record const *records, std::size_t mask, Record *data, std::size_t count) {
+    uint32_t const tail = ring.tail.load(std::memory_order_relaxed);
+    uint32_t const head = ring.head.load(std::memory_order_acquire);
+    count = std::min<std::size_t>(count, head - tail);
+    for (std::size_t i = 0; i < count; ++i) {
+        data[i] = records[(tail + i) & mask];
+    }
+    if (count != 0) {
+        ring.tail.store(tail + static_cast<uint32_t>(count), std::memory_order_release);
+    }
+    return count;
+}
+
+void netlink::transport::ShmChannel::wake(std::atomic<uint32_t> &word) { futex(word, FUTEX_WAKE, 1, nullptr); }
+
+std::size_t netlink::transport::ShmChannel::push_requests(ShmRequest const *requests, std::size_t count) {
+    return push(m_header->requests, m_requests, m_capacity - 1, requests, count);
+}
+
+std::size_t netlink::transport::ShmChannel::pop_replies(ShmReply *replies, std::size_t count) {
+    return pop(m_header->replies, m_replies, m_capacity - 1, replies, count);
+}
+
+std::size_t netlink::transport::ShmChannel::pop_requests(ShmRequest *requests, std::size_t count) {
+    return pop(m_header->requests, m_requests, m_capacity - 1, requests, count);
+}
+
+std::size_t netlink::transport::ShmChannel::push_replies(ShmReply const *replies, std::size_t count) {
+    return push(m_header->replies, m_replies, m_capacity - 1, replies, count);
+}
+
+bool netlink::transport::ShmChannel::wait(std::chrono::milliseconds timeout) {
+    Ring &ring = m_server ? m_header->requests : m_header->replies;
+    for (int i = 0; i < M_SPIN_COUNT; ++i) {
+        if (ring.head.load(std::memory_order_acquire) != ring.tail.load(std::memory_order_relaxed)) {
+            return true;
+        }
+        if ((i & 63) == 63) {
+            std::this_thread::yield();
+        }
+    }
+
+    ring.waiting.store(1, std::memory_order_seq_cst);
+    uint32_t const head = ring.head.load(std::memory_order_seq_cst);
+    if (head == ring.tail.load(std::memory_order_relaxed) && !peer_closed()) {
+        // Закрытие другой стороной не меняет head, поэтому ожидание ограничено таймаутом
+        struct timespec ts{};
+        ts.tv_sec = static_cast<time_t>(timeout.count() / 1000);
+        ts.tv_nsec = static_cast<long>(timeout.count() % 1000) * 1000000L;
+        futex(ring.head, FUTEX_WAIT, head, &ts);
+    }
+    ring.waiting.store(0, std::memory_order_relaxed);
+    return ring.head.load(std::memory_order_acquire) != ring.tail.load(std::memory_order_relaxed);
+}
+
+bool netlink::transport::ShmChannel::peer_closed() const {
+    return (m_header->closed.load(std::memory_order_acquire) & (m_server ? M_CLIENT_SIDE : M_SERVER_SIDE)) != 0;
+}
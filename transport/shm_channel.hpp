@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace netlink::transport {
+
+/**
+ * @brief Запрос операции в общей памяти (фиксированный размер, без разбора атрибутов).
+ */
+struct ShmRequest {
+    uint32_t id = 0;          /**< Номер запроса клиента. */
+    uint8_t op = 0;           /**< Операция (значения OP бинарного протокола). */
+    uint8_t reserved[3] = {}; /**< Выравнивание. */
+    int64_t arg1 = 0;         /**< Первый аргумент. */
+    int64_t arg2 = 0;         /**< Второй аргумент. */
+};
+
+/**
+ * @brief Ответ на операцию в общей памяти.
+ */
+struct ShmReply {
+    uint32_t id = 0;    /**< Номер запроса клиента. */
+    int32_t error = 0;  /**< 0 или код ошибки (errno). */
+    int64_t result = 0; /**< Результат операции. */
+};
+
+/**
+ * @brief Канал в общей памяти между клиентом и сервером на одной машине.
+ *
+ * Объект POSIX shared memory содержит две очереди SPSC с записями фиксированного размера:
+ * запросы клиента и ответы сервера. Клиент создает канал и передает его имя серверу по
+ * обычному пути Netlink; после этого операции идут напрямую через общую память, минуя ядро.
+ *
+ * Потребитель сначала опрашивает очередь, а перед сном взводит флаг ожидания и засыпает
+ * на futex позиции записи. Производитель будит его системным вызовом, только если флаг
+ * взведен, поэтому под нагрузкой обмен обходится без системных вызовов.
+ *
+ * Каждая сторона канала используется одним потоком.
+ */
+class ShmChannel final {
+   public:
+    /**
+     * @brief Префикс имени объекта общей памяти (сервер открывает только такие имена).
+     */
+    static constexpr const char *NAME_PREFIX = "/netlink_calc_";
+    static constexpr std::size_t DEFAULT_CAPACITY = 1024;
+
+    /**
+     * @brief Создает канал (сторона клиента).
+     *
+     * @param capacity Емкость каждой очереди в записях (округляется вверх до степени двойки).
+     *
+     * @throw std::runtime_error Если не удалось создать или отобразить объект общей памяти.
+     */
+    static std::unique_ptr<ShmChannel> create(std::size_t capacity = DEFAULT_CAPACITY);
+    /**
+     * @brief Открывает канал, созданный клиентом (сторона сервера), и удаляет его имя.
+     *
+     * @throw std::runtime_error Если имя не подходит, объект не найден или его формат неверен.
+     */
+    static std::unique_ptr<ShmChannel> open(std::string const &name);
+
+    ShmChannel(ShmChannel const &) = delete;
+    ShmChannel(ShmChannel &&) = delete;
+    ShmChannel &operator=(ShmChannel const &) = delete;
+    ShmChannel &operator=(ShmChannel &&) = delete;
+    /**
+     * @brief Отмечает свою сторону закрытой, будит другую сторону и освобождает отображение.
+     */
+    ~ShmChannel();
+
+    /**
+     * @brief Имя объекта общей памяти.
+     */
+    std::string const &name() const { return m_name; }
+    /**
+     * @brief Емкость каждой очереди в записях.
+     */
+    std::size_t capacity() const { return m_capacity; }
+
+    /**
+     * @brief Кладет запросы в очередь сервера (только клиент).
+     *
+     * @return Количество записей, поместившихся в очередь.
+     */
+    std::size_t push_requests(ShmRequest const *requests, std::size_t count);
+    /**
+     * @brief Забирает ответы сервера (только клиент).
+     *
+     * @return Количество принятых записей.
+     */
+    std::size_t pop_replies(ShmReply *replies, std::size_t count);
+    /**
+     * @brief Забирает запросы клиента (только сервер).
+     */
+    std::size_t pop_requests(ShmRequest *requests, std::size_t count);
+    /**
+     * @brief Кладет ответы в очередь клиента (только сервер).
+     */
+    std::size_t push_replies(ShmReply const *replies, std::size_t count);
+
+    /**
+     * @brief Ожидает записей во входящей очереди своей стороны.
+     *
+     * Сначала опрашивает очередь M_SPIN_COUNT раз, затем спит на futex не дольше timeout.
+     *
+     * @return true если во входящей очереди есть записи.
+     */
+    bool wait(std::chrono::milliseconds timeout);
+    /**
+     * @brief Закрыла ли канал другая сторона.
+     */
+    bool peer_closed() const;
+
+   private:
+    /**
+     * @brief Позиции одной очереди. Лежат в общей памяти, каждая в своей кэш-линии.
+     */
+    struct Ring {
+        alignas(64) std::atomic<uint32_t> head;    /**< Позиция записи (futex, на котором спит потребитель). */
+        alignas(64) std::atomic<uint32_t> tail;    /**< Позиция чтения. */
+        alignas(64) std::atomic<uint32_t> waiting; /**< Потребитель собирается спать или спит. */
+    };
+    /**
+     * @brief Заголовок объекта общей памяти, за ним следуют массивы запросов и ответов.
+     */
+    struct Header {
+        uint32_t magic;
+        uint32_t version;
+        uint32_t capacity;
+        std::atomic<uint32_t> closed; /**< Биты закрытых сторон: M_CLIENT_SIDE, M_SERVER_SIDE. */
+        Ring requests;
+        Ring replies;
+    };
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "atomics in shared memory must be lock-free");
+
+    ShmChannel(std::string name, void *memory, std::size_t size, bool server);
+
+    template <typename Record>
+    static std::size_t push(Ring &ring, Record *records, std::size_t mask, Record const *data, std::size_t count);
+    template <typename Record>
+    static std::size_t pop(Ring &ring, Record const *records, std::size_t mask, Record *data, std::size_t count);
+    static std::size_t memory_size(std::size_t capacity);
+    static void wake(std::atomic<uint32_t> &word);
+
+    static constexpr uint32_t M_MAGIC = 0x43414c43; // "CALC"
+    static constexpr uint32_t M_VERSION = 1;
+    static constexpr uint32_t M_CLIENT_SIDE = 1;
+    static constexpr uint32_t M_SERVER_SIDE = 2;
+    static constexpr int M_SPIN_COUNT = 4096;
+
+    std::string m_name;               // 32
+    Header *m_header = nullptr;       // 8
+    ShmRequest *m_requests = nullptr; // 8
+    ShmReply *m_replies = nullptr;    // 8
+    std::size_t m_size = 0;           // 8 размер отображения
+    std::size_t m_capacity = 0;       // 8
+    bool m_server = false;            // 1
+    bool m_unlinked = false;          // 1
+};
+
+} // namespace netlink::transport
@@ -0,0 +1,64 @@
+#include "socketpair_transport.hpp"
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include "../common/logger.hpp"
+
+std::pair<std::unique_ptr<netlink::transport::SocketpairTransport>, std::unique_ptr<netlink::transport::SocketpairTransport>>
+netlink::transport::SocketpairTransport::create_pair(uint8_t version) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0, fds) < 0) {
+        NETLINK_LOG(LOG_ERR, "Failed to create a socket pair: %m");
+        throw std::runtime_error("Failed to create a socket pair");
+    }
+
+    std::pair<std::unique_ptr<SocketpairTransport>, std::unique_ptr<SocketpairTransport>> pair = {
+        std::unique_ptr<SocketpairTransport>(new SocketpairTransport(fds[0], version)),
+        std::unique_ptr<SocketpairTransport>(new SocketpairTransport(fds[1], version))};
+    for (auto *transport : {pair.first.get(), pair.second.get()}) {
+        // Не критично: без увеличения буферов большие пачки просто не поместятся
+        int ret = transport->set_buffer_sizes(M_SOCKET_BUFFER_SIZE, M_SOCKET_BUFFER_SIZE);
+        if (ret < 0) {
+            NETLINK_LOG(LOG_WARNING, "Failed to enlarge socket pair buffers: %s", strerror(-ret));
+        }
+    }
+    return pair;
+}
+
+netlink::transport::SocketpairTransport::SocketpairTransport(int fd, uint8_t version) : m_fd(fd), m_version(version) {}
+
+netlink::transport::SocketpairTransport::~SocketpairTransport() { close(m_fd); }
+
+int netlink::transport::SocketpairTransport::send(void const *data, std::size_t size) {
+    while (true) {
+        if (::send(m_fd, data, size, MSG_NOSIGNAL) >= 0) {
+            return 0;
+        }
+        if (errno != EINTR) {
+            // Для единообразия с Netlink закрытая другая сторона сообщается как ECONNREFUSED
+            return errno == EPIPE ? -ECONNREFUSED : -errno;
+        }
+    }
+}
+
+ssize_t netlink::transport::SocketpairTransport::receive(void *buffer, std::size_t size) {
+    while (true) {
+        ssize_t len = recv(m_fd, buffer, size, MSG_TRUNC);
+        if (len >= 0) {
+            return len;
+        }
+        if (errno != EINTR) {
+            return errno == ECONNRESET ? 0 : -errno;
+        }
+    }
+}
+
+int netlink::transport::SocketpairTransport::receive_batch(Datagram *datagrams, std::size_t count) {
+    int ret = receive_socket_batch(m_fd, datagrams, count);
+    return ret == -ECONNRESET ? 0 : ret;
+}
@@ -0,0 +1,56 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+#include "transport.hpp"
+
+namespace netlink::transport {
+
+/**
+ * @brief Транспорт через пару сокетов AF_UNIX/SOCK_SEQPACKET.
+ *
+ * Сохраняет границы датаграмм и стоимость системных вызовов, как Netlink, но не требует
+ * модуля ядра. Стороны пары можно передать в разные потоки или, после fork, в разные процессы.
+ */
+class SocketpairTransport final : public Transport {
+   public:
+    /**
+     * @brief Идентификатор семейства в заголовках сообщений (ретранслятора нет, значение условное).
+     */
+    static constexpr int FAMILY_ID = 0x21;
+
+    /**
+     * @brief Создает пару связанных транспортов.
+     *
+     * @param version Версия протокола, которую транспорт сообщает клиенту.
+     *
+     * @return Пара (клиентская сторона, серверная сторона).
+     *
+     * @throw std::runtime_error Если не удалось создать пару сокетов.
+     */
+    static std::pair<std::unique_ptr<SocketpairTransport>, std::unique_ptr<SocketpairTransport>> create_pair(uint8_t version = 4);
+
+    ~SocketpairTransport() override;
+
+    int send(void const *data, std::size_t size) override;
+    ssize_t receive(void *buffer, std::size_t size) override;
+    int receive_batch(Datagram *datagrams, std::size_t count) override;
+    int family_id() const override { return FAMILY_ID; }
+    uint8_t version() const override { return m_version; }
+    bool relayed() const override { return false; }
+    int fd() const override { return m_fd; }
+
+   private:
+    SocketpairTransport(int fd, uint8_t version);
+
+    /**
+     * @brief Размер буферов сокета: пачка запросов клиента должна помещаться в одну датаграмму.
+     */
+    static constexpr int M_SOCKET_BUFFER_SIZE = 1 << 20;
+
+    int m_fd;          // 4
+    uint8_t m_version; // 1
+};
+
+} // namespace netlink::transport
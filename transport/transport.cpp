@@ -0,0 +1,80 @@
+#include "transport.hpp"
+
+#include <sys/socket.h>
+
+#include <algorithm>
+#include <cstring>
+
+#include "../common/logger.hpp"
+
+namespace {
+
+constexpr std::size_t MAX_BATCH = 64;
+
+/**
+ * @brief Устанавливает размер буфера сокета, при необходимости через FORCE-вариант опции.
+ */
+int set_socket_buffer(int fd, int option, int force_option, int size, const char *name) {
+    if (setsockopt(fd, SOL_SOCKET, option, &size, sizeof(size)) < 0) {
+        return -errno;
+    }
+    // Ядро удваивает запрошенное значение (учет служебных данных) и ограничивает его rmem_max/wmem_max
+    int actual = 0;
+    socklen_t len = sizeof(actual);
+    if (getsockopt(fd, SOL_SOCKET, option, &actual, &len) == 0 && actual / 2 >= size) {
+        return 0;
+    }
+    if (setsockopt(fd, SOL_SOCKET, force_option, &size, sizeof(size)) < 0) {
+        NETLINK_LOG(LOG_WARNING, "Socket %s buffer is limited to %d bytes (requested %d): %s", name, actual / 2, size, strerror(errno));
+    }
+    return 0;
+}
+
+} // namespace
+
+int netlink::transport::Transport::set_buffer_sizes(int receive_size, int send_size) {
+    int const fd = this->fd();
+    if (fd < 0) {
+        return -EOPNOTSUPP;
+    }
+    if (receive_size > 0) {
+        int ret = set_socket_buffer(fd, SO_RCVBUF, SO_RCVBUFFORCE, receive_size, "receive");
+        if (ret < 0) {
+            return ret;
+        }
+    }
+    if (send_size > 0) {
+        return set_socket_buffer(fd, SO_SNDBUF, SO_SNDBUFFORCE, send_size, "send");
+    }
+    return 0;
+}
+
+int netlink::transport::Transport::receive_socket_batch(int fd, Datagram *datagrams, std::size_t count) {
+    count = std::min(count, MAX_BATCH);
+    struct mmsghdr messages[MAX_BATCH];
+    struct iovec iov[MAX_BATCH];
+    std::memset(messages, 0, sizeof(struct mmsghdr) * count);
+    for (std::size_t i = 0; i < count; ++i) {
+        iov[i] = {datagrams[i].data, datagrams[i].size};
+        messages[i].msg_hdr.msg_iov = &iov[i];
+        messages[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    while (true) {
+        // MSG_WAITFORONE: ждать только первую датаграмму; MSG_TRUNC: msg_len - полная длина датаграммы
+        int received = recvmmsg(fd, messages, static_cast<unsigned int>(count), MSG_WAITFORONE | MSG_TRUNC, nullptr);
+        if (received >= 0) {
+            for (int i = 0; i < received; ++i) {
+                // Датаграмма нулевой длины - закрытие сокета; оно повторится при следующем вызове
+                if (messages[i].msg_len == 0) {
+                    return i;
+                }
+                datagrams[i].length = static_cast<ssize_t>(messages[i].msg_len);
+            }
+            return received;
+        }
+        if (errno != EINTR) {
+            return -errno;
+        }
+    }
+}
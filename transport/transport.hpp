@@ -0,0 +1,149 @@
+#pragma once
+#include <fcntl.h>
+#include <sys/types.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace netlink::transport {
+
+/**
+ * @brief Буфер одной датаграммы для пакетного приема (Transport::receive_batch).
+ */
+struct Datagram {
+    void *data = nullptr;  /**< Буфер. */
+    std::size_t size = 0;  /**< Размер буфера. */
+    ssize_t length = 0;    /**< Полный размер принятой датаграммы (если он больше size, датаграмма усечена). */
+};
+
+/**
+ * @brief Транспорт сообщений Netlink между клиентом и сервером.
+ *
+ * Транспорт передает готовые сообщения Netlink (одно или несколько сообщений, записанных
+ * подряд) целыми датаграммами. Формирование и разбор сообщений остаются в Client и Server,
+ * поэтому одинаково работают поверх Generic Netlink, внутрипроцессной очереди и socketpair.
+ *
+ * Методы send и receive возвращают коды ошибок так же, как системные вызовы Linux
+ * (отрицательный errno), чтобы на горячем пути не было исключений.
+ */
+class Transport {
+   public:
+    Transport() = default;
+    Transport(Transport const &) = delete;
+    Transport(Transport &&) = delete;
+    Transport &operator=(Transport const &) = delete;
+    Transport &operator=(Transport &&) = delete;
+    virtual ~Transport() = default;
+
+    /**
+     * @brief Отправляет датаграмму.
+     *
+     * @param data Сообщения Netlink.
+     * @param size Размер данных в байтах.
+     *
+     * @return 0 при успехе или отрицательный errno.
+     */
+    virtual int send(void const *data, std::size_t size) = 0;
+    /**
+     * @brief Принимает датаграмму, блокируясь до её появления.
+     *
+     * @param buffer Буфер для датаграммы.
+     * @param size Размер буфера.
+     *
+     * @return Полный размер датаграммы (если он больше size, датаграмма усечена),
+     *         0 если другая сторона закрыла транспорт, или отрицательный errno
+     *         (-ENOBUFS означает, что часть сообщений была потеряна при переполнении).
+     */
+    virtual ssize_t receive(void *buffer, std::size_t size) = 0;
+    /**
+     * @brief Принимает несколько датаграмм за один вызов.
+     *
+     * Ожидает первую датаграмму так же, как receive, а следующие принимает, только если
+     * они уже доступны. Ошибка, случившаяся после первой датаграммы, сообщается следующим вызовом.
+     * Реализация по умолчанию принимает одну датаграмму.
+     *
+     * @param datagrams Буферы датаграмм, у принятых заполняется Datagram::length.
+     * @param count Количество буферов (не меньше 1).
+     *
+     * @return Количество принятых датаграмм, 0 если другая сторона закрыла транспорт,
+     *         или отрицательный errno, как у receive.
+     */
+    virtual int receive_batch(Datagram *datagrams, std::size_t count) {
+        (void)count;
+        ssize_t const length = receive(datagrams[0].data, datagrams[0].size);
+        if (length <= 0) {
+            return static_cast<int>(length);
+        }
+        datagrams[0].length = length;
+        return 1;
+    }
+    /**
+     * @brief Идентификатор семейства Generic Netlink для заголовков сообщений.
+     */
+    virtual int family_id() const = 0;
+    /**
+     * @brief Версия протокола, которую поддерживает другая сторона.
+     */
+    virtual uint8_t version() const = 0;
+    /**
+     * @brief Передаются ли сообщения через ретранслятор (модуль ядра).
+     *
+     * Серверу, подключенному через ретранслятор, нужно зарегистрироваться в нем.
+     */
+    virtual bool relayed() const = 0;
+    /**
+     * @brief Файловый дескриптор для ожидания готовности (poll/epoll) или -1.
+     */
+    virtual int fd() const = 0;
+    /**
+     * @brief Переключает прием в неблокирующий режим, в котором receive возвращает -EAGAIN, если датаграмм нет.
+     *
+     * @return 0 или отрицательный errno (-EOPNOTSUPP, если у транспорта нет дескриптора).
+     */
+    virtual int set_nonblocking(bool enable) {
+        int const fd = this->fd();
+        if (fd < 0) {
+            return -EOPNOTSUPP;
+        }
+        int flags = fcntl(fd, F_GETFL);
+        if (flags < 0 || fcntl(fd, F_SETFL, enable ? flags | O_NONBLOCK : flags & ~O_NONBLOCK) < 0) {
+            return -errno;
+        }
+        return 0;
+    }
+    /**
+     * @brief Задает размеры буферов приема и отправки сокета (0 - не менять).
+     *
+     * Если обычная установка упирается в net.core.rmem_max/wmem_max, используется
+     * SO_RCVBUFFORCE/SO_SNDBUFFORCE (требует CAP_NET_ADMIN). Если и это не удалось,
+     * в журнал пишется предупреждение с фактическим размером.
+     *
+     * @return 0 или отрицательный errno (-EOPNOTSUPP, если у транспорта нет дескриптора).
+     */
+    virtual int set_buffer_sizes(int receive_size, int send_size);
+    /**
+     * @brief Открывает транспорт, который принимает рассылку ответов ретранслятора (группа results).
+     *
+     * Рассылка принимается отдельным сокетом: переполнение его буфера (ENOBUFS) не затрагивает
+     * ответы на запросы в полете. Транспорт без ретранслятора и так принимает все сообщения
+     * другой стороны, поэтому реализация по умолчанию оставляет subscription пустым.
+     *
+     * @param subscription Транспорт рассылки или nullptr, если рассылка приходит в этот транспорт.
+     *
+     * @return 0 или отрицательный errno (-ENOENT, если у семейства нет группы рассылки).
+     */
+    virtual int open_subscription(std::unique_ptr<Transport> &subscription) {
+        subscription.reset();
+        return 0;
+    }
+
+   protected:
+    /**
+     * @brief Пакетный прием из сокета датаграмм через recvmmsg.
+     */
+    static int receive_socket_batch(int fd, Datagram *datagrams, std::size_t count);
+};
+
+} // namespace netlink::transport